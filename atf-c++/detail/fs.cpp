@@ -170,14 +170,14 @@ impl::path
 impl::path::branch_path(void)
     const
 {
+    const atf_fs_path_view_t view = atf_fs_path_branch_view(&m_path);
     atf_fs_path_t bp;
-    atf_error_t err;
 
-    err = atf_fs_path_branch_path(&m_path, &bp);
+    atf_error_t err = atf_fs_path_init_raw(&bp, view.m_data, view.m_length);
     if (atf_is_error(err))
         throw_atf_error(err);
 
-    path p(atf_fs_path_cstring(&bp));
+    path p(&bp);
     atf_fs_path_fini(&bp);
     return p;
 }
@@ -186,16 +186,7 @@ std::string
 impl::path::leaf_name(void)
     const
 {
-    atf_dynstr_t ln;
-    atf_error_t err;
-
-    err = atf_fs_path_leaf_name(&m_path, &ln);
-    if (atf_is_error(err))
-        throw_atf_error(err);
-
-    std::string s(atf_dynstr_cstring(&ln));
-    atf_dynstr_fini(&ln);
-    return s;
+    return atf_fs_path_leaf_cstring(&m_path);
 }
 
 impl::path
@@ -208,7 +199,7 @@ impl::path::to_absolute(void)
     if (atf_is_error(err))
         throw_atf_error(err);
 
-    path p(atf_fs_path_cstring(&pa));
+    path p(&pa);
     atf_fs_path_fini(&pa);
     return p;
 }
@@ -218,7 +209,7 @@ impl::path::operator=(const path& p)
 {
     atf_fs_path_t tmp;
 
-    atf_error_t err = atf_fs_path_init_fmt(&tmp, "%s", p.c_str());
+    atf_error_t err = atf_fs_path_copy(&tmp, &p.m_path);
     if (atf_is_error(err))
         throw_atf_error(err);
     else {
@@ -262,8 +253,7 @@ impl::path::operator/(const path& p)
 {
     path p2 = *this;
 
-    atf_error_t err = atf_fs_path_append_fmt(&p2.m_path, "%s",
-                                             atf_fs_path_cstring(&p.m_path));
+    atf_error_t err = atf_fs_path_append_path(&p2.m_path, &p.m_path);
     if (atf_is_error(err))
         throw_atf_error(err);
 
@@ -292,121 +282,253 @@ const int impl::file_info::reg_type = atf_fs_stat_reg_type;
 const int impl::file_info::sock_type = atf_fs_stat_sock_type;
 const int impl::file_info::wht_type = atf_fs_stat_wht_type;
 
-impl::file_info::file_info(const path& p)
+impl::file_info::file_info(const path& p) :
+    m_have_stat(true)
 {
     atf_error_t err;
 
     err = atf_fs_stat_init(&m_stat, p.c_path());
     if (atf_is_error(err))
         throw_atf_error(err);
+    m_type = atf_fs_stat_get_type(&m_stat);
+}
+
+impl::file_info::file_info(const atf_fs_stat_t& st) :
+    m_have_stat(true),
+    m_type(atf_fs_stat_get_type(&st))
+{
+    atf_fs_stat_copy(&m_stat, &st);
 }
 
-impl::file_info::file_info(const file_info& fi)
+impl::file_info::file_info(const path& p, const int type) :
+    m_have_stat(false),
+    m_type(type),
+    m_path(p.str())
 {
-    atf_fs_stat_copy(&m_stat, &fi.m_stat);
+}
+
+impl::file_info::file_info(const file_info& fi) :
+    m_have_stat(fi.m_have_stat),
+    m_type(fi.m_type),
+    m_path(fi.m_path)
+{
+    if (m_have_stat)
+        atf_fs_stat_copy(&m_stat, &fi.m_stat);
 }
 
 impl::file_info::~file_info(void)
 {
-    atf_fs_stat_fini(&m_stat);
+    if (m_have_stat)
+        atf_fs_stat_fini(&m_stat);
+}
+
+const atf_fs_stat_t*
+impl::file_info::get_stat(void)
+    const
+{
+    if (!m_have_stat) {
+        atf_fs_path_t p;
+
+        atf_error_t err = atf_fs_path_init_fmt(&p, "%s", m_path.c_str());
+        if (atf_is_error(err))
+            throw_atf_error(err);
+        err = atf_fs_stat_init(&m_stat, &p);
+        atf_fs_path_fini(&p);
+        if (atf_is_error(err))
+            throw_atf_error(err);
+        m_have_stat = true;
+    }
+    return &m_stat;
 }
 
 dev_t
 impl::file_info::get_device(void)
     const
 {
-    return atf_fs_stat_get_device(&m_stat);
+    return atf_fs_stat_get_device(get_stat());
 }
 
 ino_t
 impl::file_info::get_inode(void)
     const
 {
-    return atf_fs_stat_get_inode(&m_stat);
+    return atf_fs_stat_get_inode(get_stat());
 }
 
 mode_t
 impl::file_info::get_mode(void)
     const
 {
-    return atf_fs_stat_get_mode(&m_stat);
+    return atf_fs_stat_get_mode(get_stat());
 }
 
 off_t
 impl::file_info::get_size(void)
     const
 {
-    return atf_fs_stat_get_size(&m_stat);
+    return atf_fs_stat_get_size(get_stat());
 }
 
 int
 impl::file_info::get_type(void)
     const
 {
-    return atf_fs_stat_get_type(&m_stat);
+    return m_type;
 }
 
 bool
 impl::file_info::is_owner_readable(void)
     const
 {
-    return atf_fs_stat_is_owner_readable(&m_stat);
+    return atf_fs_stat_is_owner_readable(get_stat());
 }
 
 bool
 impl::file_info::is_owner_writable(void)
     const
 {
-    return atf_fs_stat_is_owner_writable(&m_stat);
+    return atf_fs_stat_is_owner_writable(get_stat());
 }
 
 bool
 impl::file_info::is_owner_executable(void)
     const
 {
-    return atf_fs_stat_is_owner_executable(&m_stat);
+    return atf_fs_stat_is_owner_executable(get_stat());
 }
 
 bool
 impl::file_info::is_group_readable(void)
     const
 {
-    return atf_fs_stat_is_group_readable(&m_stat);
+    return atf_fs_stat_is_group_readable(get_stat());
 }
 
 bool
 impl::file_info::is_group_writable(void)
     const
 {
-    return atf_fs_stat_is_group_writable(&m_stat);
+    return atf_fs_stat_is_group_writable(get_stat());
 }
 
 bool
 impl::file_info::is_group_executable(void)
     const
 {
-    return atf_fs_stat_is_group_executable(&m_stat);
+    return atf_fs_stat_is_group_executable(get_stat());
 }
 
 bool
 impl::file_info::is_other_readable(void)
     const
 {
-    return atf_fs_stat_is_other_readable(&m_stat);
+    return atf_fs_stat_is_other_readable(get_stat());
 }
 
 bool
 impl::file_info::is_other_writable(void)
     const
 {
-    return atf_fs_stat_is_other_writable(&m_stat);
+    return atf_fs_stat_is_other_writable(get_stat());
 }
 
 bool
 impl::file_info::is_other_executable(void)
     const
 {
-    return atf_fs_stat_is_other_executable(&m_stat);
+    return atf_fs_stat_is_other_executable(get_stat());
+}
+
+// ------------------------------------------------------------------------
+// The "directory_iterator" class.
+// ------------------------------------------------------------------------
+
+namespace {
+
+int
+dirent_type(const struct dirent* dep)
+{
+#if defined(DT_UNKNOWN)
+    switch (dep->d_type) {
+    case DT_BLK: return impl::file_info::blk_type;
+    case DT_CHR: return impl::file_info::chr_type;
+    case DT_DIR: return impl::file_info::dir_type;
+    case DT_FIFO: return impl::file_info::fifo_type;
+    case DT_LNK: return impl::file_info::lnk_type;
+    case DT_REG: return impl::file_info::reg_type;
+    case DT_SOCK: return impl::file_info::sock_type;
+#if defined(DT_WHT)
+    case DT_WHT: return impl::file_info::wht_type;
+#endif
+    default: return -1;
+    }
+#else
+    return -1;
+#endif
+}
+
+} // anonymous namespace
+
+impl::directory_iterator::directory_iterator(const path& p) :
+    m_path(p),
+    m_entry(NULL)
+{
+    m_dir = ::opendir(p.c_str());
+    if (m_dir == NULL)
+        throw system_error(IMPL_NAME "::directory_iterator::"
+                           "directory_iterator(" + p.str() + ")",
+                           "opendir(3) failed", errno);
+}
+
+impl::directory_iterator::~directory_iterator(void)
+{
+    ::closedir(static_cast< DIR* >(m_dir));
+}
+
+bool
+impl::directory_iterator::next(void)
+{
+    // readdir(3) already fetches the entries from the kernel in batches.
+    errno = 0;
+    m_entry = ::readdir(static_cast< DIR* >(m_dir));
+    if (m_entry == NULL && errno != 0)
+        throw system_error(IMPL_NAME "::directory_iterator::next(" +
+                           m_path.str() + ")", "readdir(3) failed", errno);
+    return m_entry != NULL;
+}
+
+const char*
+impl::directory_iterator::name(void)
+    const
+{
+    PRE(m_entry != NULL);
+    return static_cast< const struct dirent* >(m_entry)->d_name;
+}
+
+int
+impl::directory_iterator::type(void)
+    const
+{
+    PRE(m_entry != NULL);
+    const int t = dirent_type(static_cast< const struct dirent* >(m_entry));
+    return t != -1 ? t : info().get_type();
+}
+
+impl::file_info
+impl::directory_iterator::info(void)
+    const
+{
+    PRE(m_entry != NULL);
+
+    atf_fs_stat_t st;
+    atf_error_t err = atf_fs_stat_init_at(&st,
+        ::dirfd(static_cast< DIR* >(m_dir)), name());
+    if (atf_is_error(err))
+        throw_atf_error(err);
+
+    file_info fi(st);
+    atf_fs_stat_fini(&st);
+    return fi;
 }
 
 // ------------------------------------------------------------------------
@@ -415,20 +537,14 @@ impl::file_info::is_other_executable(void)
 
 impl::directory::directory(const path& p)
 {
-    DIR* dp = ::opendir(p.c_str());
-    if (dp == NULL)
-        throw system_error(IMPL_NAME "::directory::directory(" +
-                           p.str() + ")", "opendir(3) failed", errno);
-
-    struct dirent* dep;
-    while ((dep = ::readdir(dp)) != NULL) {
-        path entryp = p / dep->d_name;
-        insert(value_type(dep->d_name, file_info(entryp)));
-    }
+    // The files are stat'ed lazily, by which time the working directory
+    // may have changed.
+    const path base = p.is_absolute() ? p : p.to_absolute();
 
-    if (::closedir(dp) == -1)
-        throw system_error(IMPL_NAME "::directory::directory(" +
-                           p.str() + ")", "closedir(3) failed", errno);
+    directory_iterator iter(p);
+    while (iter.next())
+        insert(value_type(iter.name(),
+                          file_info(base / iter.name(), iter.type())));
 }
 
 std::set< std::string >
@@ -511,3 +627,19 @@ impl::rmdir(const path& p)
     if (atf_is_error(err))
         throw_atf_error(err);
 }
+
+void
+impl::rmtree(const path& p)
+{
+    atf_error_t err = atf_fs_rmtree(p.c_path());
+    if (atf_is_error(err))
+        throw_atf_error(err);
+}
+
+void
+impl::rmtree_parallel(const path& p, const unsigned int jobs)
+{
+    atf_error_t err = atf_fs_rmtree_parallel(p.c_path(), jobs);
+    if (atf_is_error(err))
+        throw_atf_error(err);
+}
@@ -200,6 +200,7 @@ public:
 // ------------------------------------------------------------------------
 
 class directory;
+class directory_iterator;
 
 //!
 //! \brief A class that contains information about a file.
@@ -207,8 +208,22 @@ class directory;
 //! The file_info class holds information about an specific file that
 //! exists in the file system.
 //!
+//! The objects created by the directory class only know the type of the
+//! file when they are constructed; the rest of the information is queried
+//! the first time it is needed.
+//!
 class file_info {
-    atf_fs_stat_t m_stat;
+    mutable atf_fs_stat_t m_stat;
+    mutable bool m_have_stat;
+    int m_type;
+    std::string m_path;
+
+    file_info(const atf_fs_stat_t&);
+    file_info(const path&, const int);
+    const atf_fs_stat_t* get_stat(void) const;
+
+    friend class directory;
+    friend class directory_iterator;
 
 public:
     //!
@@ -319,6 +334,64 @@ public:
     bool is_other_executable(void) const;
 };
 
+// ------------------------------------------------------------------------
+// The "directory_iterator" class.
+// ------------------------------------------------------------------------
+
+//!
+//! \brief A class to read the entries of a directory one by one.
+//!
+//! Entries are read on demand, so looking for a single file does not
+//! require reading the whole directory.  The type of each entry is taken
+//! from the directory itself when the file system provides it; the rest
+//! of the information is only queried if requested with info().
+//!
+class directory_iterator {
+    path m_path;
+    void* m_dir;
+    void* m_entry;
+
+    // Not copyable.
+    directory_iterator(const directory_iterator&);
+    directory_iterator& operator=(const directory_iterator&);
+
+public:
+    //!
+    //! \brief Opens the given directory for reading.
+    //!
+    explicit directory_iterator(const path&);
+
+    //!
+    //! \brief Closes the directory.
+    //!
+    ~directory_iterator(void);
+
+    //!
+    //! \brief Moves to the next entry.
+    //!
+    //! Returns false once there are no more entries.  This must be called
+    //! once before accessing the first entry.
+    //!
+    bool next(void);
+
+    //!
+    //! \brief Returns the name of the current entry.
+    //!
+    const char* name(void) const;
+
+    //!
+    //! \brief Returns the type of the current entry.
+    //!
+    //! The returned value is one of the file_info type constants.
+    //!
+    int type(void) const;
+
+    //!
+    //! \brief Returns all the information about the current entry.
+    //!
+    file_info info(void) const;
+};
+
 // ------------------------------------------------------------------------
 // The "directory" class.
 // ------------------------------------------------------------------------
@@ -336,7 +409,8 @@ public:
     //!
     //! Constructs a new directory object representing the given path.
     //! The directory must exist at creation time as the contents of the
-    //! class are gathered from it.
+    //! class are gathered from it.  The files are not stat'ed until their
+    //! information other than the type is queried.
     //!
     directory(const path&);
 
@@ -381,6 +455,22 @@ void remove(const path&);
 //!
 void rmdir(const path&);
 
+//!
+//! \brief Removes a file or a directory and all of its contents.
+//!
+//! Directories that are not readable or writable by their owner are
+//! made accessible before removing them.
+//!
+void rmtree(const path&);
+
+//!
+//! \brief Removes a directory tree using several processes.
+//!
+//! The subdirectories of the given directory are distributed among the
+//! given number of processes.  Only worth it for large trees.
+//!
+void rmtree_parallel(const path&, const unsigned int);
+
 } // namespace fs
 } // namespace atf
 
@@ -28,6 +28,7 @@
 extern "C" {
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <unistd.h>
 }
 
 #include <fstream>
@@ -334,6 +335,81 @@ ATF_TEST_CASE_BODY(directory_names)
     ATF_REQUIRE(ns.find("reg") != ns.end());
 }
 
+ATF_TEST_CASE(directory_lazy_file_info);
+ATF_TEST_CASE_HEAD(directory_lazy_file_info)
+{
+    set_md_var("descr", "Tests that the file_info objects attached to the "
+               "directory only query the file when needed");
+}
+ATF_TEST_CASE_BODY(directory_lazy_file_info)
+{
+    using atf::fs::directory;
+    using atf::fs::file_info;
+    using atf::fs::path;
+
+    create_files();
+    {
+        std::ofstream os("files/reg2");
+        os << "contents";
+    }
+
+    directory d(path("files"));
+    ATF_REQUIRE(::unlink("files/reg") != -1);
+
+    const file_info& fi = (*d.find("reg")).second;
+    ATF_REQUIRE(fi.get_type() == file_info::reg_type);
+    ATF_REQUIRE_THROW(atf::system_error, fi.get_size());
+
+    ATF_REQUIRE(::chdir("files/dir") != -1);
+    const file_info& fi2 = (*d.find("reg2")).second;
+    ATF_REQUIRE_EQ(8, fi2.get_size());
+}
+
+// ------------------------------------------------------------------------
+// Test cases for the "directory_iterator" class.
+// ------------------------------------------------------------------------
+
+ATF_TEST_CASE(directory_iterator);
+ATF_TEST_CASE_HEAD(directory_iterator)
+{
+    set_md_var("descr", "Tests the directory_iterator class");
+}
+ATF_TEST_CASE_BODY(directory_iterator)
+{
+    using atf::fs::directory_iterator;
+    using atf::fs::file_info;
+    using atf::fs::path;
+
+    create_files();
+    ATF_REQUIRE(::symlink("reg", "files/lnk") != -1);
+
+    std::set< std::string > names;
+    directory_iterator iter(path("files"));
+    while (iter.next()) {
+        const std::string name = iter.name();
+        names.insert(name);
+        if (name == "dir") {
+            ATF_REQUIRE(iter.type() == file_info::dir_type);
+            ATF_REQUIRE(iter.info().get_type() == file_info::dir_type);
+        } else if (name == "reg") {
+            ATF_REQUIRE(iter.type() == file_info::reg_type);
+            ATF_REQUIRE_EQ(0, iter.info().get_size());
+        } else if (name == "lnk") {
+            ATF_REQUIRE(iter.type() == file_info::lnk_type);
+            ATF_REQUIRE(iter.info().get_type() == file_info::lnk_type);
+        }
+    }
+    ATF_REQUIRE(!iter.next());
+
+    ATF_REQUIRE_EQ(names.size(), 5);
+    ATF_REQUIRE(names.find("dir") != names.end());
+    ATF_REQUIRE(names.find("reg") != names.end());
+    ATF_REQUIRE(names.find("lnk") != names.end());
+
+    ATF_REQUIRE_THROW(atf::system_error,
+                      directory_iterator(path("files/missing")));
+}
+
 // ------------------------------------------------------------------------
 // Test cases for the "file_info" class.
 // ------------------------------------------------------------------------
@@ -508,6 +584,34 @@ ATF_TEST_CASE_BODY(remove)
     ATF_REQUIRE( exists(path("files/dir")));
 }
 
+ATF_TEST_CASE(rmtree);
+ATF_TEST_CASE_HEAD(rmtree)
+{
+    set_md_var("descr", "Tests the rmtree and rmtree_parallel functions");
+}
+ATF_TEST_CASE_BODY(rmtree)
+{
+    using atf::fs::exists;
+    using atf::fs::path;
+    using atf::fs::rmtree;
+    using atf::fs::rmtree_parallel;
+
+    create_files();
+    ::mkdir("files/dir/sub", 0755);
+    std::ofstream os("files/dir/sub/reg");
+    os.close();
+    ATF_REQUIRE(::chmod("files/dir", 0555) != -1);
+
+    rmtree(path("files"));
+    ATF_REQUIRE(!exists(path("files")));
+    ATF_REQUIRE_THROW(atf::system_error, rmtree(path("files")));
+
+    create_files();
+    ::mkdir("files/dir2", 0755);
+    rmtree_parallel(path("files"), 2);
+    ATF_REQUIRE(!exists(path("files")));
+}
+
 // ------------------------------------------------------------------------
 // Main.
 // ------------------------------------------------------------------------
@@ -534,9 +638,14 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, directory_read);
     ATF_ADD_TEST_CASE(tcs, directory_names);
     ATF_ADD_TEST_CASE(tcs, directory_file_info);
+    ATF_ADD_TEST_CASE(tcs, directory_lazy_file_info);
+
+    // Add the tests for the "directory_iterator" class.
+    ATF_ADD_TEST_CASE(tcs, directory_iterator);
 
     // Add the tests for the free functions.
     ATF_ADD_TEST_CASE(tcs, exists);
     ATF_ADD_TEST_CASE(tcs, is_executable);
     ATF_ADD_TEST_CASE(tcs, remove);
+    ATF_ADD_TEST_CASE(tcs, rmtree);
 }
@@ -72,6 +72,18 @@
     atfu_tc_ ## name::atfu_tc_ ## name(void) : atf::tests::tc(#name, true) {} \
     }
 
+#define ATF_BENCHMARK_CASE(name) \
+    namespace { \
+    class atfu_tc_ ## name : public atf::tests::bench_tc { \
+        void head(void); \
+        void bench(const std::size_t) const; \
+    public: \
+        atfu_tc_ ## name(void); \
+    }; \
+    static atfu_tc_ ## name* atfu_tcptr_ ## name; \
+    atfu_tc_ ## name::atfu_tc_ ## name(void) : atf::tests::bench_tc(#name) {} \
+    }
+
 #define ATF_TEST_CASE_NAME(name) atfu_tc_ ## name
 #define ATF_TEST_CASE_USE(name) (atfu_tcptr_ ## name) = NULL
 
@@ -89,6 +101,12 @@
     atfu_tc_ ## name::cleanup(void) \
         const
 
+#define ATF_BENCHMARK_CASE_BODY(name, iters) \
+    void \
+    atfu_tc_ ## name::bench(const std::size_t iters \
+                            ATF_DEFS_ATTRIBUTE_UNUSED) \
+        const
+
 #define ATF_FAIL(reason) atf::tests::tc::fail(reason)
 
 #define ATF_SKIP(reason) atf::tests::tc::skip(reason)
@@ -188,6 +206,23 @@
         } \
     } while (false)
 
+#define ATF_REQUIRE_ALLOCS_LE(max, statement) \
+    do { \
+        std::size_t atfu_allocs = atf::tests::tc::alloc_count(); \
+        statement; \
+        atfu_allocs = atf::tests::tc::alloc_count() - atfu_allocs; \
+        if (atfu_allocs > static_cast< std::size_t >(max)) { \
+            std::ostringstream atfu_ss; \
+            atfu_ss << "Line " << __LINE__ << ": " #statement " made " \
+                    << atfu_allocs << " heap allocations; expected at most " \
+                    << static_cast< std::size_t >(max); \
+            atf::tests::tc::fail(atfu_ss.str()); \
+        } \
+    } while (false)
+
+#define ATF_REQUIRE_NO_ALLOC(statement) \
+    ATF_REQUIRE_ALLOCS_LE(0, statement)
+
 #define ATF_CHECK_ERRNO(expected_errno, bool_expr) \
     atf::tests::tc::check_errno(__FILE__, __LINE__, expected_errno, \
                                 #bool_expr, bool_expr)
@@ -200,11 +235,11 @@
     namespace atf { \
         namespace tests { \
             int run_tp(int, char**, \
-                       void (*)(std::vector< atf::tests::tc * >&)); \
+                       void (*)(atf::tests::detail::tc_registry&)); \
         } \
     } \
     \
-    static void atfu_init_tcs(std::vector< atf::tests::tc * >&); \
+    static void atfu_init_tcs(atf::tests::detail::tc_registry&); \
     \
     int \
     main(int argc, char** argv) \
@@ -214,12 +249,13 @@
     \
     static \
     void \
-    atfu_init_tcs(std::vector< atf::tests::tc * >& tcs)
+    atfu_init_tcs(atf::tests::detail::tc_registry& tcs)
 
 #define ATF_ADD_TEST_CASE(tcs, tcname) \
     do { \
-        atfu_tcptr_ ## tcname = new atfu_tc_ ## tcname(); \
-        (tcs).push_back(atfu_tcptr_ ## tcname); \
+        atfu_tcptr_ ## tcname = NULL; \
+        (tcs).add(#tcname, \
+                  atf::tests::detail::make_tc< atfu_tc_ ## tcname >); \
     } while (0);
 
 #endif // !defined(ATF_CXX_MACROS_HPP)
@@ -26,6 +26,7 @@
 #include <atf-c++/macros.hpp>
 
 #include <stdexcept>
+#include <string>
 
 void
 atf_check_errno_semicolons(void)
@@ -93,11 +94,34 @@ atf_require_errno_semicolons(void)
     ATF_REQUIRE_ERRNO(2, 2 == 2);
 }
 
+void
+atf_require_allocs_inside_if(void)
+{
+    // Make sure that the allocation macros can be used inside an if
+    // statement that does not have braces.
+    if (true)
+        ATF_REQUIRE_NO_ALLOC((void)1);
+    else
+        ATF_REQUIRE_ALLOCS_LE(1, (void)2);
+}
+
+void
+atf_do_not_optimize(void)
+{
+    // Make sure that do_not_optimize accepts both lvalues and rvalues of
+    // any type.
+    std::string str("foo");
+    atf::tests::do_not_optimize(str);
+    atf::tests::do_not_optimize(str.length() * 2);
+    atf::tests::compiler_barrier();
+}
+
 // Test case names should not be expanded during instatiation so that they
 // can have the exact same name as macros.
 #define TEST_MACRO_1 invalid + name
 #define TEST_MACRO_2 invalid + name
 #define TEST_MACRO_3 invalid + name
+#define TEST_MACRO_4 invalid + name
 ATF_TEST_CASE(TEST_MACRO_1);
 ATF_TEST_CASE_HEAD(TEST_MACRO_1) { }
 ATF_TEST_CASE_BODY(TEST_MACRO_1) { }
@@ -124,3 +148,11 @@ void instatiate_3(void) {
     atf::tests::tc* the_test = new ATF_TEST_CASE_NAME(TEST_MACRO_3)();
     delete the_test;
 }
+ATF_BENCHMARK_CASE(TEST_MACRO_4);
+ATF_TEST_CASE_HEAD(TEST_MACRO_4) { }
+ATF_BENCHMARK_CASE_BODY(TEST_MACRO_4, iters) { }
+void instatiate_4(void) {
+    ATF_TEST_CASE_USE(TEST_MACRO_4);
+    atf::tests::tc* the_test = new ATF_TEST_CASE_NAME(TEST_MACRO_4)();
+    delete the_test;
+}
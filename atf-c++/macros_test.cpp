@@ -34,9 +34,11 @@ extern "C" {
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
 #include <atf-c++.hpp>
 
+#include "atf-c++/detail/env.hpp"
 #include "atf-c++/detail/fs.hpp"
 #include "atf-c++/detail/process.hpp"
 #include "atf-c++/detail/sanity.hpp"
@@ -222,6 +224,38 @@ ATF_TEST_CASE_BODY(h_require_throw_re)
     create_ctl_file("after");
 }
 
+static void
+alloc_stub(const int count)
+{
+    for (int i = 0; i < count; i++) {
+        int* volatile ptr = new int(i);
+        delete ptr;
+    }
+}
+
+ATF_TEST_CASE(h_require_allocs);
+ATF_TEST_CASE_HEAD(h_require_allocs)
+{
+    set_md_var("descr", "Helper test case");
+}
+ATF_TEST_CASE_BODY(h_require_allocs)
+{
+    create_ctl_file("before");
+
+    if (get_config_var("what") == "le_ok")
+        ATF_REQUIRE_ALLOCS_LE(2, alloc_stub(2));
+    else if (get_config_var("what") == "le_fail")
+        ATF_REQUIRE_ALLOCS_LE(2, alloc_stub(3));
+    else if (get_config_var("what") == "none_ok")
+        ATF_REQUIRE_NO_ALLOC(alloc_stub(0));
+    else if (get_config_var("what") == "none_fail")
+        ATF_REQUIRE_NO_ALLOC(alloc_stub(1));
+    else
+        UNREACHABLE;
+
+    create_ctl_file("after");
+}
+
 static int
 errno_fail_stub(const int raised_errno)
 {
@@ -277,6 +311,24 @@ ATF_TEST_CASE_BODY(h_require_errno)
     create_ctl_file("after");
 }
 
+ATF_BENCHMARK_CASE(h_bench);
+ATF_TEST_CASE_HEAD(h_bench)
+{
+    set_md_var("descr", "Helper test case");
+    set_md_var("X-bench.samples", "4");
+    set_md_var("X-bench.sample_time", "1");
+}
+ATF_BENCHMARK_CASE_BODY(h_bench, iters)
+{
+    std::string str;
+    for (std::size_t i = 0; i < iters; i++) {
+        str = "foo";
+        atf::tests::do_not_optimize(str);
+    }
+    atf::tests::compiler_barrier();
+    create_ctl_file("ran");
+}
+
 // ------------------------------------------------------------------------
 // Test cases for the macros.
 // ------------------------------------------------------------------------
@@ -655,6 +707,62 @@ ATF_TEST_CASE_BODY(require_throw_re)
     }
 }
 
+ATF_TEST_CASE(require_allocs);
+ATF_TEST_CASE_HEAD(require_allocs)
+{
+    set_md_var("descr", "Tests the ATF_REQUIRE_ALLOCS_LE and "
+               "ATF_REQUIRE_NO_ALLOC macros");
+}
+ATF_TEST_CASE_BODY(require_allocs)
+{
+    struct test {
+        const char *what;
+        bool ok;
+        const char *msg;
+    } *t, tests[] = {
+        { "le_ok", true, NULL },
+        { "le_fail", false,
+          "alloc_stub\\(3\\) made 3 heap allocations; expected at most 2" },
+        { "none_ok", true, NULL },
+        { "none_fail", false,
+          "alloc_stub\\(1\\) made 1 heap allocations; expected at most 0" },
+        { NULL, false, NULL }
+    };
+
+    const std::size_t count = atf::tests::tc::alloc_count();
+    alloc_stub(1);
+    if (atf::tests::tc::alloc_count() == count)
+        ATF_SKIP("Heap allocations cannot be counted on this platform");
+
+    const atf::fs::path before("before");
+    const atf::fs::path after("after");
+
+    for (t = &tests[0]; t->what != NULL; t++) {
+        atf::tests::vars_map config;
+        config["what"] = t->what;
+
+        std::cout << "Checking with " << t->what << " and expecting "
+                  << (t->ok ? "true" : "false") << "\n";
+
+        ATF_TEST_CASE_USE(h_require_allocs);
+        run_h_tc< ATF_TEST_CASE_NAME(h_require_allocs) >(config);
+
+        ATF_REQUIRE(atf::fs::exists(before));
+        if (t->ok) {
+            ATF_REQUIRE(atf::utils::grep_file("^passed", "result"));
+            ATF_REQUIRE(atf::fs::exists(after));
+        } else {
+            std::string exp_result = std::string("^failed: .*") + t->msg;
+            ATF_REQUIRE(atf::utils::grep_file(exp_result.c_str(), "result"));
+            ATF_REQUIRE(!atf::fs::exists(after));
+        }
+
+        atf::fs::remove(before);
+        if (t->ok)
+            atf::fs::remove(after);
+    }
+}
+
 ATF_TEST_CASE(check_errno);
 ATF_TEST_CASE_HEAD(check_errno)
 {
@@ -751,6 +859,33 @@ ATF_TEST_CASE_BODY(require_errno)
     }
 }
 
+ATF_TEST_CASE(benchmark_case);
+ATF_TEST_CASE_HEAD(benchmark_case)
+{
+    set_md_var("descr", "Tests the ATF_BENCHMARK_CASE macro");
+}
+ATF_TEST_CASE_BODY(benchmark_case)
+{
+    ATF_TEST_CASE_USE(h_bench);
+
+    {
+        ATF_TEST_CASE_NAME(h_bench) h_tc;
+        h_tc.init(atf::tests::vars_map());
+        ATF_REQUIRE_EQ("true", h_tc.get_md_var("X-bench"));
+        ATF_REQUIRE_EQ("true", h_tc.get_md_var("is.exclusive"));
+        ATF_REQUIRE_EQ("4", h_tc.get_md_var("X-bench.samples"));
+    }
+
+    atf::env::set("ATF_RECORDS", "records.json");
+    run_h_tc< ATF_TEST_CASE_NAME(h_bench) >();
+    ATF_REQUIRE(atf::utils::grep_file("^passed$", "result"));
+    ATF_REQUIRE(atf::fs::exists(atf::fs::path("ran")));
+    atf::utils::cat_file("records.json", "");
+    ATF_REQUIRE(atf::utils::grep_file("^\\{\"tc\":\"h_bench\",\"bench\":"
+        "\\{\"iterations\":[0-9]+,\"samples\":4,\"ns_per_op\":[0-9.]+,",
+        "records.json"));
+}
+
 // ------------------------------------------------------------------------
 // Tests cases for the header file.
 // ------------------------------------------------------------------------
@@ -803,7 +938,9 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, require_not_in);
     ATF_ADD_TEST_CASE(tcs, require_throw);
     ATF_ADD_TEST_CASE(tcs, require_throw_re);
+    ATF_ADD_TEST_CASE(tcs, require_allocs);
     ATF_ADD_TEST_CASE(tcs, require_errno);
+    ATF_ADD_TEST_CASE(tcs, benchmark_case);
 
     // Add the test cases for the header file.
     ATF_ADD_TEST_CASE(tcs, use);
@@ -52,6 +52,8 @@ extern "C" {
 #include <vector>
 
 extern "C" {
+#include "atf-c/detail/shard.h"
+#include "atf-c/detail/trace.h"
 #include "atf-c/error.h"
 #include "atf-c/tc.h"
 #include "atf-c/utils.h"
@@ -89,12 +91,17 @@ detail::atf_tp_writer::atf_tp_writer(std::ostream& os) :
 }
 
 void
-detail::atf_tp_writer::start_tc(const std::string& ident)
+detail::atf_tp_writer::start_tc(const char* ident)
 {
     if (!m_is_first)
         m_os << "\n";
     m_os << "ident: " << ident << "\n";
-    m_os.flush();
+}
+
+void
+detail::atf_tp_writer::start_tc(const std::string& ident)
+{
+    start_tc(ident.c_str());
 }
 
 void
@@ -104,13 +111,18 @@ detail::atf_tp_writer::end_tc(void)
         m_is_first = false;
 }
 
+void
+detail::atf_tp_writer::tc_meta_data(const char* name, const char* value)
+{
+    PRE(std::strcmp(name, "ident") != 0);
+    m_os << name << ": " << value << "\n";
+}
+
 void
 detail::atf_tp_writer::tc_meta_data(const std::string& name,
                                     const std::string& value)
 {
-    PRE(name != "ident");
-    m_os << name << ": " << value << "\n";
-    m_os.flush();
+    tc_meta_data(name.c_str(), value.c_str());
 }
 
 // ------------------------------------------------------------------------
@@ -155,11 +167,19 @@ public:
     std::string m_ident;
     atf_tc_t m_tc;
     bool m_has_cleanup;
+    bool m_initialized;
 
     tc_impl(const std::string& ident, const bool has_cleanup) :
         m_ident(ident),
-        m_has_cleanup(has_cleanup)
+        m_has_cleanup(has_cleanup),
+        m_initialized(false)
+    {
+    }
+
+    static const std::string&
+    get_ident(const impl::tc* tc)
     {
+        return tc->pimpl->m_ident;
     }
 
     static void
@@ -167,6 +187,8 @@ public:
     {
         std::map< atf_tc_t*, impl::tc* >::iterator iter = wraps.find(tc);
         INV(iter != wraps.end());
+        if (dynamic_cast< impl::bench_tc* >((*iter).second) != NULL)
+            atf_tc_bench_head(tc);
         (*iter).second->head();
     }
 
@@ -179,6 +201,16 @@ public:
         (*iter).second->body();
     }
 
+    static void
+    wrap_bench(const atf_tc_t *tc, const size_t iterations)
+    {
+        std::map< const atf_tc_t*, const impl::tc* >::const_iterator iter =
+            cwraps.find(tc);
+        INV(iter != cwraps.end());
+        static_cast< const impl::bench_tc* >((*iter).second)->bench(
+            iterations);
+    }
+
     static void
     wrap_cleanup(const atf_tc_t *tc)
     {
@@ -199,7 +231,10 @@ impl::tc::~tc(void)
     cwraps.erase(&pimpl->m_tc);
     wraps.erase(&pimpl->m_tc);
 
-    atf_tc_fini(&pimpl->m_tc);
+    // Test cases are only initialized when they are selected, so some may
+    // be destroyed without ever having been initialized.
+    if (pimpl->m_initialized)
+        atf_tc_fini(&pimpl->m_tc);
 }
 
 void
@@ -225,6 +260,7 @@ impl::tc::init(const vars_map& config)
         array.get());
     if (atf_is_error(err))
         throw_atf_error(err);
+    pimpl->m_initialized = true;
 }
 
 bool
@@ -262,23 +298,39 @@ impl::tc::get_md_var(const std::string& var)
     return atf_tc_get_md_var(&pimpl->m_tc, var.c_str());
 }
 
+static
+atf_error_t
+append_var_ref(const char* name, const char* value, void* arg)
+{
+    impl::vars_view* view = static_cast< impl::vars_view* >(arg);
+    try {
+        view->push_back(impl::var_ref(name, value));
+        return atf_no_error();
+    } catch (const std::bad_alloc&) {
+        return atf_no_memory_error();
+    }
+}
+
 const impl::vars_map
 impl::tc::get_md_vars(void)
     const
 {
-    vars_map vars;
+    const vars_view view = get_md_vars_view();
+    return vars_map(view.begin(), view.end());
+}
 
-    char **array = atf_tc_get_md_vars(&pimpl->m_tc);
-    try {
-        char **ptr;
-        for (ptr = array; *ptr != NULL; ptr += 2)
-            vars[*ptr] = *(ptr + 1);
-    } catch (...) {
-        atf_utils_free_charpp(array);
-        throw;
-    }
+const impl::vars_view
+impl::tc::get_md_vars_view(void)
+    const
+{
+    vars_view view;
+
+    atf_error_t err = atf_tc_visit_md_vars(&pimpl->m_tc, append_var_ref,
+                                           &view);
+    if (atf_is_error(err))
+        throw_atf_error(err);
 
-    return vars;
+    return view;
 }
 
 void
@@ -325,6 +377,12 @@ impl::tc::require_prog(const std::string& prog)
     atf_tc_require_prog(prog.c_str());
 }
 
+const void*
+impl::tc::get_data(const std::string& name, std::size_t* length)
+{
+    return atf_tc_get_data(name.c_str(), length);
+}
+
 void
 impl::tc::pass(void)
 {
@@ -363,6 +421,12 @@ impl::tc::require_errno(const char* file, const int line, const int exp_errno,
     atf_tc_require_errno(file, line, exp_errno, expr_str, result);
 }
 
+std::size_t
+impl::tc::alloc_count(void)
+{
+    return atf_tc_alloc_count();
+}
+
 void
 impl::tc::expect_pass(void)
 {
@@ -399,6 +463,136 @@ impl::tc::expect_timeout(const std::string& reason)
     atf_tc_expect_timeout("%s", reason.c_str());
 }
 
+// ------------------------------------------------------------------------
+// The "bench_tc" class.
+// ------------------------------------------------------------------------
+
+impl::bench_tc::bench_tc(const std::string& ident) :
+    tc(ident, false)
+{
+}
+
+impl::bench_tc::~bench_tc(void)
+{
+}
+
+void
+impl::bench_tc::body(void)
+    const
+{
+    atf_tc_bench(&pimpl->m_tc, tc_impl::wrap_bench);
+}
+
+// ------------------------------------------------------------------------
+// The "tc_registry" class.
+// ------------------------------------------------------------------------
+
+const std::size_t detail::tc_registry::npos = static_cast< std::size_t >(-1);
+
+detail::tc_registry::tc_registry(void)
+{
+}
+
+detail::tc_registry::~tc_registry(void)
+{
+    for (std::size_t i = 0; i < m_entries.size(); i++)
+        delete m_entries[i].m_tc;
+}
+
+//
+// Registers a test case that will be constructed by the given factory
+// the first time it is needed.
+//
+void
+detail::tc_registry::add(const char* ident, factory make)
+{
+    PRE(ident != NULL);
+    PRE(make != NULL);
+
+    entry e;
+    e.m_ident = ident;
+    e.m_factory = make;
+    e.m_tc = NULL;
+    m_entries.push_back(e);
+}
+
+//
+// Registers an already-constructed test case and takes ownership of it.
+//
+void
+detail::tc_registry::push_back(tc* t)
+{
+    PRE(t != NULL);
+
+    entry e;
+    e.m_ident = impl::tc_impl::get_ident(t).c_str();
+    e.m_factory = NULL;
+    e.m_tc = t;
+    m_entries.push_back(e);
+}
+
+std::size_t
+detail::tc_registry::size(void)
+    const
+{
+    return m_entries.size();
+}
+
+const char*
+detail::tc_registry::ident(const std::size_t index)
+    const
+{
+    PRE(index < m_entries.size());
+    return m_entries[index].m_ident;
+}
+
+//
+// Looks for a test case by its identifier, without instantiating any of
+// them.  Returns npos if there is no such test case.
+//
+std::size_t
+detail::tc_registry::find(const std::string& name)
+    const
+{
+    const char* cname = name.c_str();
+    for (std::size_t i = 0; i < m_entries.size(); i++) {
+        if (std::strcmp(m_entries[i].m_ident, cname) == 0)
+            return i;
+    }
+    return npos;
+}
+
+//
+// Returns the given test case, constructing it if necessary.  The returned
+// object remains owned by the registry.
+//
+impl::tc*
+detail::tc_registry::get(const std::size_t index)
+{
+    PRE(index < m_entries.size());
+    entry& e = m_entries[index];
+    if (e.m_tc == NULL) {
+        INV(e.m_factory != NULL);
+        e.m_tc = e.m_factory();
+    }
+    return e.m_tc;
+}
+
+//
+// Destroys the given test case if it was constructed.  Test cases that can
+// be constructed again on demand are the only ones that can be released.
+//
+void
+detail::tc_registry::release(const std::size_t index)
+{
+    PRE(index < m_entries.size());
+    entry& e = m_entries[index];
+    if (e.m_factory != NULL) {
+        delete e.m_tc;
+        e.m_tc = NULL;
+    }
+}
+
 // ------------------------------------------------------------------------
 // Test program main code.
 // ------------------------------------------------------------------------
@@ -409,6 +603,81 @@ typedef std::vector< impl::tc * > tc_vector;
 
 enum tc_part { BODY, CLEANUP };
 
+//
+// Records the lifetime of a scope as a span of the trace, closing it even
+// if an exception leaves the scope.
+//
+class trace_span {
+public:
+    trace_span(const char* name, const char* arg = NULL,
+               const char* value = NULL)
+    {
+        ATF_TRACE_BEGIN(name, arg, value);
+    }
+
+    ~trace_span(void)
+    {
+        ATF_TRACE_END();
+    }
+};
+
+//
+// Owns the shard selection given with -S, if any.
+//
+class shard_selection {
+    bool m_enabled;
+    atf_shard_t m_shard;
+
+    // Not copyable.
+    shard_selection(const shard_selection&);
+    shard_selection& operator=(const shard_selection&);
+
+public:
+    shard_selection(const char* argv0, const std::string& spec,
+                    const std::string& durations) :
+        m_enabled(!spec.empty())
+    {
+        if (!m_enabled)
+            return;
+
+        atf_error_t err = atf_shard_init(&m_shard, spec.c_str(), argv0,
+                                         Program_Name.c_str(),
+                                         durations.empty() ? NULL :
+                                         durations.c_str());
+        if (atf_is_error(err)) {
+            char buf[4096];
+            atf_error_format(err, buf, sizeof(buf));
+            atf_error_free(err);
+            throw usage_error("%s", buf);
+        }
+    }
+
+    ~shard_selection(void)
+    {
+        if (m_enabled)
+            atf_shard_fini(&m_shard);
+    }
+
+    bool
+    selects(const std::string& ident)
+        const
+    {
+        return !m_enabled || atf_shard_selects(&m_shard, ident.c_str());
+    }
+
+    // Returns the "index/count" of the shard of the test case if every
+    // test case has to be annotated with it, or an empty string.
+    std::string
+    annotation(const std::string& ident)
+        const
+    {
+        if (!m_enabled || m_shard.m_index != 0)
+            return "";
+        return atf::text::to_string(atf_shard_of(&m_shard, ident.c_str())) +
+            "/" + atf::text::to_string(m_shard.m_count);
+    }
+};
+
 static void
 parse_vflag(const std::string& str, atf::tests::vars_map& vars)
 {
@@ -449,58 +718,81 @@ handle_srcdir(const char* argv0, const std::string& srcdir_arg)
     return srcdir;
 }
 
-static void
-init_tcs(void (*add_tcs)(tc_vector&), tc_vector& tcs,
-         const atf::tests::vars_map& vars)
+static bool
+var_ref_less(const impl::var_ref& v1, const impl::var_ref& v2)
 {
-    add_tcs(tcs);
-    for (tc_vector::iterator iter = tcs.begin(); iter != tcs.end(); iter++) {
-        impl::tc* tc = *iter;
+    return std::strcmp(v1.first, v2.first) < 0;
+}
 
-        tc->init(vars);
+static void
+write_all(const int fd, const std::string& data)
+{
+    const char* ptr = data.data();
+    std::string::size_type length = data.length();
+    while (length > 0) {
+        const ssize_t written = ::write(fd, ptr, length);
+        if (written == -1) {
+            if (errno == EINTR)
+                continue;
+            throw atf::system_error(IMPL_NAME "::write_all",
+                                    "Failed to write the list of test cases",
+                                    errno);
+        }
+        ptr += written;
+        length -= written;
     }
 }
 
 static int
-list_tcs(const tc_vector& tcs)
+list_tcs(detail::tc_registry& tcs, const atf::tests::vars_map& vars,
+         const shard_selection& shard)
 {
-    detail::atf_tp_writer writer(std::cout);
+    // Build the whole list in memory and write it in one go, as printing a
+    // test program with many test cases line by line is costly.
+    std::ostringstream out;
+    detail::atf_tp_writer writer(out);
 
-    for (tc_vector::const_iterator iter = tcs.begin();
-         iter != tcs.end(); iter++) {
-        const impl::vars_map vars = (*iter)->get_md_vars();
+    for (std::size_t i = 0; i < tcs.size(); i++) {
+        // Test cases of other shards are skipped before constructing them.
+        const std::string ident = tcs.ident(i);
+        if (!shard.selects(ident))
+            continue;
 
-        {
-            impl::vars_map::const_iterator iter2 = vars.find("ident");
-            INV(iter2 != vars.end());
-            writer.start_tc((*iter2).second);
-        }
+        impl::tc* tc = tcs.get(i);
+        tc->init(vars);
 
-        for (impl::vars_map::const_iterator iter2 = vars.begin();
-             iter2 != vars.end(); iter2++) {
-            const std::string& key = (*iter2).first;
-            if (key != "ident")
-                writer.tc_meta_data(key, (*iter2).second);
-        }
+        impl::vars_view md = tc->get_md_vars_view();
+        std::sort(md.begin(), md.end(), var_ref_less);
 
+        writer.start_tc(ident);
+        for (impl::vars_view::const_iterator iter = md.begin();
+             iter != md.end(); iter++) {
+            if (std::strcmp((*iter).first, "ident") != 0)
+                writer.tc_meta_data((*iter).first, (*iter).second);
+        }
+        const std::string annotation = shard.annotation(ident);
+        if (!annotation.empty())
+            writer.tc_meta_data("X-shard", annotation);
         writer.end_tc();
+
+        // Listing only needs the meta-data of each test case, so there is no
+        // need to keep them all alive at once.
+        tcs.release(i);
     }
 
+    std::cout.flush();
+    write_all(STDOUT_FILENO, out.str());
+
     return EXIT_SUCCESS;
 }
 
 static impl::tc*
-find_tc(tc_vector tcs, const std::string& name)
+find_tc(detail::tc_registry& tcs, const std::string& name)
 {
-    std::vector< std::string > ids;
-    for (tc_vector::iterator iter = tcs.begin();
-         iter != tcs.end(); iter++) {
-        impl::tc* tc = *iter;
-
-        if (tc->get_md_var("ident") == name)
-            return tc;
-    }
-    throw usage_error("Unknown test case `%s'", name.c_str());
+    const std::size_t index = tcs.find(name);
+    if (index == detail::tc_registry::npos)
+        throw usage_error("Unknown test case `%s'", name.c_str());
+    return tcs.get(index);
 }
 
 static std::pair< std::string, tc_part >
@@ -524,11 +816,13 @@ process_tcarg(const std::string& tcarg)
 }
 
 static int
-run_tc(tc_vector& tcs, const std::string& tcarg, const atf::fs::path& resfile)
+run_tc(detail::tc_registry& tcs, const std::string& tcarg,
+       const atf::tests::vars_map& vars, const atf::fs::path& resfile)
 {
     const std::pair< std::string, tc_part > fields = process_tcarg(tcarg);
 
     impl::tc* tc = find_tc(tcs, fields.first);
+    tc->init(vars);
 
     if (!atf::env::has("__RUNNING_INSIDE_ATF_RUN") || atf::env::get(
         "__RUNNING_INSIDE_ATF_RUN") != "internal-yes-value")
@@ -554,13 +848,15 @@ run_tc(tc_vector& tcs, const std::string& tcarg, const atf::fs::path& resfile)
 }
 
 static int
-safe_main(int argc, char** argv, void (*add_tcs)(tc_vector&))
+safe_main(int argc, char** argv, detail::tc_registry& tcs)
 {
     const char* argv0 = argv[0];
 
     bool lflag = false;
     atf::fs::path resfile("/dev/stdout");
     std::string srcdir_arg;
+    std::string shard_arg;
+    std::string durations_arg;
     atf::tests::vars_map vars;
 
     int ch;
@@ -568,8 +864,12 @@ safe_main(int argc, char** argv, void (*add_tcs)(tc_vector&))
 
     old_opterr = opterr;
     ::opterr = 0;
-    while ((ch = ::getopt(argc, argv, GETOPT_POSIX ":lr:s:v:")) != -1) {
+    while ((ch = ::getopt(argc, argv, GETOPT_POSIX ":D:lr:S:s:v:")) != -1) {
         switch (ch) {
+        case 'D':
+            durations_arg = ::optarg;
+            break;
+
         case 'l':
             lflag = true;
             break;
@@ -578,6 +878,10 @@ safe_main(int argc, char** argv, void (*add_tcs)(tc_vector&))
             resfile = atf::fs::path(::optarg);
             break;
 
+        case 'S':
+            shard_arg = ::optarg;
+            break;
+
         case 's':
             srcdir_arg = ::optarg;
             break;
@@ -605,17 +909,25 @@ safe_main(int argc, char** argv, void (*add_tcs)(tc_vector&))
     ::optreset = 1;
 #endif
 
-    vars["srcdir"] = handle_srcdir(argv0, srcdir_arg).str();
+    if (!durations_arg.empty() && shard_arg.empty())
+        throw usage_error("-D requires -S");
+    else if (!shard_arg.empty() && !lflag)
+        throw usage_error("-S can only be used with -l");
+
+    {
+        trace_span span("handle_srcdir");
+        vars["srcdir"] = handle_srcdir(argv0, srcdir_arg).str();
+    }
 
     int errcode;
 
-    tc_vector tcs;
     if (lflag) {
         if (argc > 0)
             throw usage_error("Cannot provide test case names with -l");
 
-        init_tcs(add_tcs, tcs, vars);
-        errcode = list_tcs(tcs);
+        const shard_selection shard(argv0, shard_arg, durations_arg);
+        trace_span list_span("list_tcs");
+        errcode = list_tcs(tcs, vars, shard);
     } else {
         if (argc == 0)
             throw usage_error("Must provide a test case name");
@@ -623,13 +935,8 @@ safe_main(int argc, char** argv, void (*add_tcs)(tc_vector&))
             throw usage_error("Cannot provide more than one test case name");
         INV(argc == 1);
 
-        init_tcs(add_tcs, tcs, vars);
-        errcode = run_tc(tcs, argv[0], resfile);
-    }
-    for (tc_vector::iterator iter = tcs.begin(); iter != tcs.end(); iter++) {
-        impl::tc* tc = *iter;
-
-        delete tc;
+        trace_span run_span("run_tc", "tc", argv[0]);
+        errcode = run_tc(tcs, argv[0], vars, resfile);
     }
 
     return errcode;
@@ -639,16 +946,49 @@ safe_main(int argc, char** argv, void (*add_tcs)(tc_vector&))
 
 namespace atf {
     namespace tests {
+        int run_tp(int, char**, void (*)(detail::tc_registry&));
         int run_tp(int, char**, void (*)(tc_vector&));
     }
 }
 
+int
+impl::run_tp(int argc, char** argv, void (*add_tcs)(detail::tc_registry&))
+{
+    try {
+        set_program_name(argv[0]);
+        detail::tc_registry tcs;
+        {
+            trace_span span("add_tcs");
+            add_tcs(tcs);
+        }
+        return ::safe_main(argc, argv, tcs);
+    } catch (const usage_error& e) {
+        std::cerr
+            << Program_Name << ": ERROR: " << e.what() << '\n'
+            << Program_Name << ": See atf-test-program(1) for usage details.\n";
+        return EXIT_FAILURE;
+    }
+}
+
+//
+// Entry point used by test programs built against older versions of the
+// library, which construct all of their test cases upfront.
+//
 int
 impl::run_tp(int argc, char** argv, void (*add_tcs)(tc_vector&))
 {
     try {
         set_program_name(argv[0]);
-        return ::safe_main(argc, argv, add_tcs);
+        tc_vector vtcs;
+        {
+            trace_span span("add_tcs");
+            add_tcs(vtcs);
+        }
+        detail::tc_registry tcs;
+        for (tc_vector::iterator iter = vtcs.begin(); iter != vtcs.end();
+             iter++)
+            tcs.push_back(*iter);
+        return ::safe_main(argc, argv, tcs);
     } catch (const usage_error& e) {
         std::cerr
             << Program_Name << ": ERROR: " << e.what() << '\n'
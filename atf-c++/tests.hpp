@@ -26,12 +26,16 @@
 #if !defined(ATF_CXX_TESTS_HPP)
 #define ATF_CXX_TESTS_HPP
 
+#include <cstddef>
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 extern "C" {
 #include <atf-c/defs.h>
+#include <atf-c/tc.h>
 }
 
 namespace atf {
@@ -47,8 +51,10 @@ class atf_tp_writer {
 public:
     atf_tp_writer(std::ostream&);
 
+    void start_tc(const char*);
     void start_tc(const std::string&);
     void end_tc(void);
+    void tc_meta_data(const char*, const char*);
     void tc_meta_data(const std::string&, const std::string&);
 };
 
@@ -56,12 +62,78 @@ bool match(const std::string&, const std::string&);
 
 } // namespace
 
+class tc;
+
+namespace detail {
+
+// ------------------------------------------------------------------------
+// The "tc_registry" class.
+// ------------------------------------------------------------------------
+
+//
+// Collection of the test cases provided by a test program.
+//
+// Test cases are registered by identifier together with a function that
+// constructs them, so that only the test cases that are actually needed are
+// instantiated.  The registry owns all the instantiated test cases.
+//
+class tc_registry {
+public:
+    typedef tc* (*factory)(void);
+
+    static const std::size_t npos;
+
+private:
+    // Non-copyable.
+    tc_registry(const tc_registry&);
+    tc_registry& operator=(const tc_registry&);
+
+    struct entry {
+        const char* m_ident;
+        factory m_factory;
+        tc* m_tc;
+    };
+    std::vector< entry > m_entries;
+
+public:
+    tc_registry(void);
+    ~tc_registry(void);
+
+    void add(const char*, factory);
+    void push_back(tc*);
+
+    std::size_t size(void) const;
+    const char* ident(const std::size_t) const;
+    std::size_t find(const std::string&) const;
+
+    tc* get(const std::size_t);
+    void release(const std::size_t);
+};
+
+template< class TC >
+tc*
+make_tc(void)
+{
+    return new TC();
+}
+
+} // namespace detail
+
 // ------------------------------------------------------------------------
 // The "vars_map" class.
 // ------------------------------------------------------------------------
 
 typedef std::map< std::string, std::string > vars_map;
 
+// ------------------------------------------------------------------------
+// The "vars_view" class.
+// ------------------------------------------------------------------------
+
+// Non-owning list of (name, value) pairs.  The strings belong to the object
+// the view was obtained from and are only valid until it is modified.
+typedef std::pair< const char*, const char* > var_ref;
+typedef std::vector< var_ref > vars_view;
+
 // ------------------------------------------------------------------------
 // The "tc" class.
 // ------------------------------------------------------------------------
@@ -83,6 +155,7 @@ protected:
     void require_prog(const std::string&) const;
 
     friend struct tc_impl;
+    friend class bench_tc;
 
 public:
     tc(const std::string&, const bool);
@@ -95,6 +168,7 @@ public:
         const;
     const std::string get_md_var(const std::string&) const;
     const vars_map get_md_vars(void) const;
+    const vars_view get_md_vars_view(void) const;
     bool has_config_var(const std::string&) const;
     bool has_md_var(const std::string&) const;
     void set_md_var(const std::string&, const std::string&);
@@ -103,6 +177,7 @@ public:
     void run_cleanup(void) const;
 
     // To be called from the child process only.
+    static const void* get_data(const std::string&, std::size_t*);
     static void pass(void) ATF_DEFS_ATTRIBUTE_NORETURN;
     static void fail(const std::string&) ATF_DEFS_ATTRIBUTE_NORETURN;
     static void fail_nonfatal(const std::string&);
@@ -111,6 +186,7 @@ public:
                             const bool);
     static void require_errno(const char*, const int, const int, const char*,
                               const bool);
+    static std::size_t alloc_count(void);
     static void expect_pass(void);
     static void expect_fail(const std::string&);
     static void expect_exit(const int, const std::string&);
@@ -119,6 +195,58 @@ public:
     static void expect_timeout(const std::string&);
 };
 
+// ------------------------------------------------------------------------
+// The "bench_tc" class.
+// ------------------------------------------------------------------------
+
+//
+// A test case whose body is a benchmark.
+//
+// The body is replaced by the bench method, which receives the number of
+// iterations it has to run and is timed by the framework.
+//
+class bench_tc : public tc {
+    void body(void) const;
+
+protected:
+    virtual void bench(const std::size_t) const = 0;
+
+    friend struct tc_impl;
+
+public:
+    bench_tc(const std::string&);
+    virtual ~bench_tc(void);
+};
+
+//
+// Keeps the compiler from optimizing away the computation of a value
+// that a benchmark does not otherwise use.
+//
+template< class T >
+inline void
+do_not_optimize(const T& value)
+{
+#if defined(__GNUC__)
+    __asm__ __volatile__("" : : "r,m"(value) : "memory");
+#else
+    atf_tc_bench_escape(&value);
+#endif
+}
+
+//
+// Keeps the compiler from reordering or eliding memory accesses across
+// this point.
+//
+inline void
+compiler_barrier(void)
+{
+#if defined(__GNUC__)
+    __asm__ __volatile__("" : : : "memory");
+#else
+    atf_tc_bench_escape(NULL);
+#endif
+}
+
 } // namespace tests
 } // namespace atf
 
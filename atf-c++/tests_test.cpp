@@ -179,6 +179,147 @@ ATF_TEST_CASE_BODY(atf_tp_writer)
 #undef RESET
 }
 
+// ------------------------------------------------------------------------
+// Tests for the "tc_registry" class.
+// ------------------------------------------------------------------------
+
+ATF_TEST_CASE_WITHOUT_HEAD(h_registry_a);
+ATF_TEST_CASE_BODY(h_registry_a)
+{
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(h_registry_b);
+ATF_TEST_CASE_BODY(h_registry_b)
+{
+}
+
+static int h_registry_b_count = 0;
+
+static
+atf::tests::tc*
+make_h_registry_b(void)
+{
+    h_registry_b_count++;
+    return new ATF_TEST_CASE_NAME(h_registry_b)();
+}
+
+ATF_TEST_CASE(tc_registry_find);
+ATF_TEST_CASE_HEAD(tc_registry_find)
+{
+    set_md_var("descr", "Verifies that tc_registry looks up test cases by "
+               "identifier without constructing them");
+}
+ATF_TEST_CASE_BODY(tc_registry_find)
+{
+    using atf::tests::detail::make_tc;
+    using atf::tests::detail::tc_registry;
+
+    ATF_TEST_CASE_USE(h_registry_a);
+    ATF_TEST_CASE_USE(h_registry_b);
+
+    h_registry_b_count = 0;
+    tc_registry tcs;
+    tcs.add("h_registry_a", make_tc< ATF_TEST_CASE_NAME(h_registry_a) >);
+    tcs.add("h_registry_b", make_h_registry_b);
+    ATF_REQUIRE_EQ(2, tcs.size());
+    ATF_REQUIRE_EQ(std::string("h_registry_a"), tcs.ident(0));
+    ATF_REQUIRE_EQ(std::string("h_registry_b"), tcs.ident(1));
+
+    ATF_REQUIRE_EQ(1, tcs.find("h_registry_b"));
+    ATF_REQUIRE_EQ(0, tcs.find("h_registry_a"));
+    ATF_REQUIRE_EQ(tc_registry::npos, tcs.find("h_registry"));
+    ATF_REQUIRE_EQ(tc_registry::npos, tcs.find("h_registry_c"));
+    ATF_REQUIRE_EQ(0, h_registry_b_count);
+}
+
+ATF_TEST_CASE(tc_registry_get);
+ATF_TEST_CASE_HEAD(tc_registry_get)
+{
+    set_md_var("descr", "Verifies that tc_registry constructs test cases "
+               "on demand and only once");
+}
+ATF_TEST_CASE_BODY(tc_registry_get)
+{
+    using atf::tests::detail::tc_registry;
+
+    h_registry_b_count = 0;
+    tc_registry tcs;
+    tcs.add("h_registry_b", make_h_registry_b);
+
+    atf::tests::tc* t = tcs.get(0);
+    ATF_REQUIRE_EQ(1, h_registry_b_count);
+    ATF_REQUIRE(t == tcs.get(0));
+    ATF_REQUIRE_EQ(1, h_registry_b_count);
+
+    t->init(atf::tests::vars_map());
+    ATF_REQUIRE_EQ("h_registry_b", t->get_md_var("ident"));
+
+    tcs.release(0);
+    tcs.get(0);
+    ATF_REQUIRE_EQ(2, h_registry_b_count);
+}
+
+ATF_TEST_CASE(tc_registry_push_back);
+ATF_TEST_CASE_HEAD(tc_registry_push_back)
+{
+    set_md_var("descr", "Verifies that tc_registry accepts test cases that "
+               "are already constructed");
+}
+ATF_TEST_CASE_BODY(tc_registry_push_back)
+{
+    using atf::tests::detail::tc_registry;
+
+    tc_registry tcs;
+    atf::tests::tc* t = new ATF_TEST_CASE_NAME(h_registry_a)();
+    tcs.push_back(t);
+    ATF_REQUIRE_EQ(std::string("h_registry_a"), tcs.ident(0));
+    ATF_REQUIRE_EQ(0, tcs.find("h_registry_a"));
+    ATF_REQUIRE(t == tcs.get(0));
+
+    tcs.release(0);
+    ATF_REQUIRE(t == tcs.get(0));
+}
+
+// ------------------------------------------------------------------------
+// Tests for the "tc" class.
+// ------------------------------------------------------------------------
+
+ATF_TEST_CASE(h_md_vars_view);
+ATF_TEST_CASE_HEAD(h_md_vars_view)
+{
+    set_md_var("descr", "Helper test case");
+    set_md_var("X-custom", "value");
+}
+ATF_TEST_CASE_BODY(h_md_vars_view)
+{
+}
+
+ATF_TEST_CASE(get_md_vars_view);
+ATF_TEST_CASE_HEAD(get_md_vars_view)
+{
+    set_md_var("descr", "Verifies that get_md_vars_view exposes the same "
+               "meta-data as get_md_vars");
+}
+ATF_TEST_CASE_BODY(get_md_vars_view)
+{
+    ATF_TEST_CASE_USE(h_md_vars_view);
+
+    ATF_TEST_CASE_NAME(h_md_vars_view) t;
+    t.init(atf::tests::vars_map());
+
+    const atf::tests::vars_map vars = t.get_md_vars();
+    const atf::tests::vars_view view = t.get_md_vars_view();
+    ATF_REQUIRE_EQ(vars.size(), view.size());
+    for (atf::tests::vars_view::const_iterator iter = view.begin();
+         iter != view.end(); iter++) {
+        const atf::tests::vars_map::const_iterator iter2 =
+            vars.find((*iter).first);
+        ATF_REQUIRE(iter2 != vars.end());
+        ATF_REQUIRE_EQ((*iter2).second, (*iter).second);
+    }
+    ATF_REQUIRE_EQ("value", vars.find("X-custom")->second);
+}
+
 // ------------------------------------------------------------------------
 // Main.
 // ------------------------------------------------------------------------
@@ -187,4 +328,12 @@ ATF_INIT_TEST_CASES(tcs)
 {
     // Add tests for the "atf_tp_writer" class.
     ATF_ADD_TEST_CASE(tcs, atf_tp_writer);
+
+    // Add tests for the "tc_registry" class.
+    ATF_ADD_TEST_CASE(tcs, tc_registry_find);
+    ATF_ADD_TEST_CASE(tcs, tc_registry_get);
+    ATF_ADD_TEST_CASE(tcs, tc_registry_push_back);
+
+    // Add tests for the "tc" class.
+    ATF_ADD_TEST_CASE(tcs, get_md_vars_view);
 }
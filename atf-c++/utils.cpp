@@ -26,11 +26,106 @@
 #include "atf-c++/utils.hpp"
 
 extern "C" {
+#include "atf-c/detail/cache.h"
+#include "atf-c/detail/fs.h"
+#include "atf-c/error.h"
+#include "atf-c/tc.h"
 #include "atf-c/utils.h"
 }
 
 #include <cstdlib>
 #include <iostream>
+#include <stdexcept>
+
+namespace {
+
+// Fails the calling test case with the description of an error, if any.
+static void
+check_error(atf_error_t error)
+{
+    if (atf_is_error(error)) {
+        char buf[4096];
+
+        atf_error_format(error, buf, sizeof(buf));
+        atf_error_free(error);
+        atf_tc_fail("%s", buf);
+    }
+}
+
+// Runs a C++ generator on behalf of the cache, which is written in C.
+static atf_error_t
+run_fixture_generator(const char* dir, const char* inputs, void* data)
+{
+    const atf::utils::fixture_generator* generator =
+        static_cast< const atf::utils::fixture_generator* >(data);
+
+    try {
+        (*generator)(dir, inputs);
+        return atf_no_error();
+    } catch (const std::exception& e) {
+        return atf_error_new_fmt("cache", "Fixture generator failed: %s",
+                                 e.what());
+    } catch (...) {
+        return atf_error_new_fmt("cache", "Fixture generator failed");
+    }
+}
+
+// Runs a C++ timed block on behalf of atf_utils_check_baseline.
+static void
+run_timed_block(void* data)
+{
+    const atf::utils::timed_block* block =
+        static_cast< const atf::utils::timed_block* >(data);
+
+    try {
+        (*block)();
+    } catch (const std::exception& e) {
+        atf_tc_fail("Timed block failed: %s", e.what());
+    } catch (...) {
+        atf_tc_fail("Timed block failed");
+    }
+}
+
+static void
+get_cached_fixture(const std::string& key, const std::string& inputs,
+                   atf::utils::fixture_generator generator,
+                   atf_fs_path_t* path)
+{
+    atf_fs_path_t dir;
+    check_error(atf_cache_default_dir(&dir));
+
+    const atf_error_t error = atf_cache_fixture(
+        atf_fs_path_cstring(&dir), key.c_str(), inputs.c_str(),
+        run_fixture_generator, &generator, path);
+    atf_fs_path_fini(&dir);
+    check_error(error);
+}
+
+} // anonymous namespace
+
+std::string
+atf::utils::cached_fixture(const std::string& key, const std::string& inputs,
+                           fixture_generator generator)
+{
+    atf_fs_path_t path;
+    get_cached_fixture(key, inputs, generator, &path);
+    const std::string result = atf_fs_path_cstring(&path);
+    atf_fs_path_fini(&path);
+    return result;
+}
+
+void
+atf::utils::cached_fixture_clone(const std::string& key,
+                                 const std::string& inputs,
+                                 fixture_generator generator,
+                                 const std::string& destination)
+{
+    atf_fs_path_t path;
+    get_cached_fixture(key, inputs, generator, &path);
+    const atf_error_t error = atf_cache_clone(&path, destination.c_str());
+    atf_fs_path_fini(&path);
+    check_error(error);
+}
 
 void
 atf::utils::cat_file(const std::string& path, const std::string& prefix)
@@ -38,6 +133,19 @@ atf::utils::cat_file(const std::string& path, const std::string& prefix)
     atf_utils_cat_file(path.c_str(), prefix.c_str());
 }
 
+void
+atf::utils::check_baseline(const std::string& name, timed_block block)
+{
+    atf_utils_check_baseline(name.c_str(), run_timed_block, &block);
+}
+
+void
+atf::utils::clone_tree(const std::string& source,
+                       const std::string& destination, const bool hardlinks)
+{
+    atf_utils_clone_tree(source.c_str(), destination.c_str(), hardlinks);
+}
+
 void
 atf::utils::copy_file(const std::string& source, const std::string& destination)
 {
@@ -56,6 +164,20 @@ atf::utils::create_file(const std::string& path, const std::string& contents)
     atf_utils_create_file(path.c_str(), "%s", contents.c_str());
 }
 
+void
+atf::utils::create_tree(const std::string& root, const std::string& spec)
+{
+    atf_utils_create_tree(root.c_str(), "%s", spec.c_str());
+}
+
+void
+atf::utils::create_tree_parallel(const std::string& root,
+                                 const unsigned int jobs,
+                                 const std::string& spec)
+{
+    atf_utils_create_tree_parallel(root.c_str(), jobs, "%s", spec.c_str());
+}
+
 bool
 atf::utils::file_exists(const std::string& path)
 {
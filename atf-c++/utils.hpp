@@ -35,10 +35,22 @@ extern "C" {
 namespace atf {
 namespace utils {
 
+typedef void (*fixture_generator)(const std::string&, const std::string&);
+typedef void (*timed_block)(void);
+
+std::string cached_fixture(const std::string&, const std::string&,
+                           fixture_generator);
+void cached_fixture_clone(const std::string&, const std::string&,
+                          fixture_generator, const std::string&);
 void cat_file(const std::string&, const std::string&);
+void check_baseline(const std::string&, timed_block);
+void clone_tree(const std::string&, const std::string&, const bool);
 bool compare_file(const std::string&, const std::string&);
 void copy_file(const std::string&, const std::string&);
 void create_file(const std::string&, const std::string&);
+void create_tree(const std::string&, const std::string&);
+void create_tree_parallel(const std::string&, const unsigned int,
+                          const std::string&);
 bool file_exists(const std::string&);
 pid_t fork(void);
 bool grep_file(const std::string&, const std::string&);
@@ -34,6 +34,7 @@ extern "C" {
 }
 
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <sstream>
@@ -42,6 +43,8 @@ extern "C" {
 
 #include <atf-c++.hpp>
 
+#include "atf-c++/detail/test_helpers.hpp"
+
 static std::string
 read_file(const std::string& path)
 {
@@ -60,10 +63,34 @@ read_file(const std::string& path)
     return buffer;
 }
 
+static void
+generate_fixture(const std::string& dir, const std::string& inputs)
+{
+    std::ofstream generations("generations", std::ios::app);
+    generations << "x";
+    atf::utils::create_file(dir + "/file", inputs);
+}
+
 // ------------------------------------------------------------------------
 // Tests cases for the free functions.
 // ------------------------------------------------------------------------
 
+ATF_TEST_CASE_WITHOUT_HEAD(cached_fixture);
+ATF_TEST_CASE_BODY(cached_fixture)
+{
+    ATF_REQUIRE(setenv("ATF_CACHE_DIR", "cache", 1) == 0);
+
+    const std::string path = atf::utils::cached_fixture("v1", "foo",
+                                                        generate_fixture);
+    ATF_REQUIRE_EQ(path, atf::utils::cached_fixture("v1", "foo",
+                                                    generate_fixture));
+    ATF_REQUIRE_EQ("foo", read_file(path + "/file"));
+
+    atf::utils::cached_fixture_clone("v1", "foo", generate_fixture, "copy");
+    ATF_REQUIRE_EQ("foo", read_file("copy/file"));
+    ATF_REQUIRE_EQ("x", read_file("generations"));
+}
+
 ATF_TEST_CASE_WITHOUT_HEAD(cat_file__empty);
 ATF_TEST_CASE_BODY(cat_file__empty)
 {
@@ -113,6 +140,40 @@ ATF_TEST_CASE_BODY(cat_file__no_newline_eof)
     ATF_REQUIRE_EQ("PREFIXFoo\nPREFIX bar baz", read_file("captured.txt"));
 }
 
+static void
+timed_loop(void)
+{
+    static volatile unsigned long sum = 0;
+
+    for (unsigned long i = 0; i < 100; i++)
+        sum += i;
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(h_check_baseline);
+ATF_TEST_CASE_BODY(h_check_baseline)
+{
+    atf::utils::check_baseline("loop", timed_loop);
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(check_baseline);
+ATF_TEST_CASE_BODY(check_baseline)
+{
+    atf::tests::vars_map config;
+    config["srcdir"] = ".";
+    config["baseline.samples"] = "5";
+    config["baseline.update"] = "true";
+    ATF_TEST_CASE_USE(h_check_baseline);
+    run_h_tc< ATF_TEST_CASE_NAME(h_check_baseline) >(config);
+    ATF_REQUIRE(atf::utils::compare_file("result", "passed\n"));
+    ATF_REQUIRE(atf::utils::grep_file("^atf-baseline 1$", "loop.baseline"));
+
+    atf::utils::create_file("loop.baseline", "atf-baseline 1\n"
+                            "0.001 0.001 0.001 0.001 0.001\n");
+    config["baseline.update"] = "false";
+    run_h_tc< ATF_TEST_CASE_NAME(h_check_baseline) >(config);
+    ATF_REQUIRE(atf::utils::grep_file("^failed: loop regressed", "result"));
+}
+
 ATF_TEST_CASE_WITHOUT_HEAD(compare_file__empty__match);
 ATF_TEST_CASE_BODY(compare_file__empty__match)
 {
@@ -206,6 +267,17 @@ ATF_TEST_CASE_BODY(create_file)
     ATF_REQUIRE_EQ("This is a %d test", read_file("test.txt"));
 }
 
+ATF_TEST_CASE_WITHOUT_HEAD(create_tree);
+ATF_TEST_CASE_BODY(create_tree)
+{
+    atf::utils::create_tree("root", "a/b%d content=x\nc/\n");
+    atf::utils::create_tree_parallel("root", 2, "c/d{1..4} content=y\n");
+    atf::utils::clone_tree("root", "clone", true);
+
+    ATF_REQUIRE_EQ("x", read_file("clone/a/b%d"));
+    ATF_REQUIRE_EQ("y", read_file("clone/c/d4"));
+}
+
 ATF_TEST_CASE_WITHOUT_HEAD(file_exists);
 ATF_TEST_CASE_BODY(file_exists)
 {
@@ -469,11 +541,15 @@ ATF_TEST_CASE_BODY(wait__save_stderr)
 ATF_INIT_TEST_CASES(tcs)
 {
     // Add the test for the free functions.
+    ATF_ADD_TEST_CASE(tcs, cached_fixture);
+
     ATF_ADD_TEST_CASE(tcs, cat_file__empty);
     ATF_ADD_TEST_CASE(tcs, cat_file__one_line);
     ATF_ADD_TEST_CASE(tcs, cat_file__several_lines);
     ATF_ADD_TEST_CASE(tcs, cat_file__no_newline_eof);
 
+    ATF_ADD_TEST_CASE(tcs, check_baseline);
+
     ATF_ADD_TEST_CASE(tcs, compare_file__empty__match);
     ATF_ADD_TEST_CASE(tcs, compare_file__empty__not_match);
     ATF_ADD_TEST_CASE(tcs, compare_file__short__match);
@@ -485,6 +561,7 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, copy_file__some_contents);
 
     ATF_ADD_TEST_CASE(tcs, create_file);
+    ATF_ADD_TEST_CASE(tcs, create_tree);
 
     ATF_ADD_TEST_CASE(tcs, file_exists);
 
@@ -34,11 +34,16 @@ dnl argument must be something like '>= 0.14' and accepts any version
 dnl specification supported by pkg-config.
 dnl
 dnl Defines and substitutes ATF_C_CFLAGS and ATF_C_LIBS with the compiler
-dnl and linker flags need to build against atf-c.
+dnl and linker flags need to build against atf-c, and ATF_C_EMBED_DATA with
+dnl the full path to the atf-embed-data tool.
 AC_DEFUN([ATF_CHECK_C], [
     spec="atf-c[]m4_default_nblank([ $1], [])"
     _ATF_CHECK_ARG_WITH(
         [PKG_CHECK_MODULES([ATF_C], [${spec}],
-                           [found=yes found_atf_c=yes], [found=no])],
+                           [found=yes found_atf_c=yes], [found=no])
+         if test "${found}" = yes; then
+             ATF_C_EMBED_DATA="$(${PKG_CONFIG} --variable=embed_data atf-c)"
+             AC_SUBST([ATF_C_EMBED_DATA], [${ATF_C_EMBED_DATA}])
+         fi],
         [required ${spec} not found])
 ])
@@ -0,0 +1,159 @@
+#! __ATF_SHELL__
+# Copyright (c) 2026 The NetBSD Foundation, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+# CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+# INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+# IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+# DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+# GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+# IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+# IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Generates a C source file that embeds a set of data files into a test
+# program.  See atf-embed-data(1) for details.
+
+Prog_Name=${0##*/}
+Dump_File=
+
+# Prints an error message and exits.
+err() {
+    echo "${Prog_Name}: ${*}" 1>&2
+    exit 1
+}
+
+# Prints an error message about the command line and exits.
+usage_error() {
+    echo "${Prog_Name}: ${*}" 1>&2
+    echo "Usage: ${Prog_Name} [-C directory] -o output file1 [.. fileN]" 1>&2
+    exit 1
+}
+
+# Escapes a string so that it can be placed within a C string literal.
+c_string() {
+    echo "${1}" | sed -e 's,\\,\\\\,g' -e 's,",\\",g'
+}
+
+# Prints the C initializer for the contents of a file.  The contents are
+# followed by a nul byte that is not accounted for in the length of the
+# data, so that text files can be used as strings and so that empty files
+# do not yield empty arrays.  The dump goes through a temporary file so
+# that a failure of od is not masked by the pipeline.
+c_bytes() {
+    od -An -v -tx1 "${1}" >"${Dump_File}" || return 1
+    sed -e 's, *\([0-9a-f][0-9a-f]\),0x\1\, ,g' -e 's,^,    ,' \
+        -e 's, $,,' "${Dump_File}" || return 1
+    echo "    0x00"
+}
+
+# Generates the source file for the given files, relative to the current
+# directory.
+generate() {
+    echo "/* Generated by ${Prog_Name}; do not edit. */"
+    echo
+    echo "#if defined(__cplusplus)"
+    echo "extern \"C\" {"
+    echo "#endif"
+    echo
+    echo "#include <atf-c/tc.h>"
+    echo
+    echo "#if !defined(__GNUC__)"
+    echo "#   error \"${Prog_Name} requires a compiler that supports" \
+        "constructors\""
+    echo "#endif"
+
+    i=0
+    for file in "${@}"; do
+        [ -f "${file}" ] || err "Cannot find data file ${file}"
+        echo
+        echo "static const unsigned char atf_embedded_data_${i}[] = {"
+        c_bytes "${file}" || err "Cannot read data file ${file}"
+        echo "};"
+        i=$((${i} + 1))
+    done
+
+    echo
+    echo "static const struct atf_tc_data atf_embedded_entries[] = {"
+    i=0
+    for file in "${@}"; do
+        echo "    { \"$(c_string "${file}")\", atf_embedded_data_${i},"
+        echo "      sizeof(atf_embedded_data_${i}) - 1 },"
+        i=$((${i} + 1))
+    done
+    echo "};"
+    echo
+    echo "static struct atf_tc_data_table atf_embedded_table = {"
+    echo "    atf_embedded_entries,"
+    echo "    sizeof(atf_embedded_entries) / sizeof(atf_embedded_entries[0]),"
+    echo "    0"
+    echo "};"
+    echo
+    echo "static void atf_embedded_register(void)"
+    echo "    __attribute__((constructor));"
+    echo
+    echo "static void"
+    echo "atf_embedded_register(void)"
+    echo "{"
+    echo "    atf_tc_register_data(&atf_embedded_table);"
+    echo "}"
+    echo
+    echo "#if defined(__cplusplus)"
+    echo "}"
+    echo "#endif"
+}
+
+main() {
+    directory=.
+    output=
+    while getopts ':C:o:' arg; do
+        case "${arg}" in
+            C)
+                directory="${OPTARG}"
+                ;;
+            o)
+                output="${OPTARG}"
+                ;;
+            :)
+                usage_error "Option -${OPTARG} requires an argument"
+                ;;
+            \?)
+                usage_error "Unknown option -${OPTARG}"
+                ;;
+        esac
+    done
+    shift $((${OPTIND} - 1))
+
+    [ -n "${output}" ] || usage_error "No output file specified"
+    [ ${#} -gt 0 ] || usage_error "No data files specified"
+
+    case "${output}" in
+        /*) ;;
+        *) output="$(pwd)/${output}" ;;
+    esac
+
+    Dump_File="${output}.od"
+    ( cd "${directory}" && generate "${@}" ) >"${output}.tmp" || {
+        rm -f "${output}.tmp" "${Dump_File}"
+        exit 1
+    }
+    rm -f "${Dump_File}"
+    mv "${output}.tmp" "${output}"
+}
+
+main "${@}"
+
+# vim: syntax=sh:expandtab:shiftwidth=4:softtabstop=4
@@ -49,7 +49,9 @@ append_config_var(const char *var, const char *default_value, atf_list_t *argv)
     if (atf_is_error(err))
         goto out;
 
-    atf_list_append_list(argv, &words);
+    err = atf_list_append_list(argv, &words);
+    if (atf_is_error(err))
+        atf_list_fini(&words);
 
 out:
     return err;
@@ -114,28 +116,8 @@ static
 atf_error_t
 list_to_array(const atf_list_t *l, char ***ap)
 {
-    atf_error_t err;
-    char **a;
-
-    a = (char **)malloc((atf_list_size(l) + 1) * sizeof(char *));
-    if (a == NULL)
-        err = atf_no_memory_error();
-    else {
-        char **aiter;
-        atf_list_citer_t liter;
-
-        aiter = a;
-        atf_list_for_each_c(liter, l) {
-            *aiter = strdup((const char *)atf_list_citer_data(liter));
-            aiter++;
-        }
-        *aiter = NULL;
-
-        err = atf_no_error();
-    }
-    *ap = a; /* Shut up warnings in the caller about uninitialized *ap. */
-
-    return err;
+    *ap = atf_list_to_charpp(l);
+    return *ap == NULL ? atf_no_memory_error() : atf_no_error();
 }
 
 /* ---------------------------------------------------------------------
@@ -42,6 +42,7 @@
 #include "atf-c/detail/list.h"
 #include "atf-c/detail/process.h"
 #include "atf-c/detail/sanity.h"
+#include "atf-c/detail/trace.h"
 #include "atf-c/error.h"
 #include "atf-c/utils.h"
 
@@ -158,6 +159,7 @@ exec_child(void *v)
 {
     struct exec_data *ea = v;
 
+    ATF_TRACE_EXEC(ea->m_argv);
     const_execvp(ea->m_argv[0], ea->m_argv);
     fprintf(stderr, "execvp(%s) failed: %s\n", ea->m_argv[0], strerror(errno));
     exit(127);
@@ -224,11 +226,18 @@ atf_error_t
 array_to_list(const char *const *a, atf_list_t *l)
 {
     atf_error_t err;
+    const char *const *iter;
 
     err = atf_list_init(l);
     if (atf_is_error(err))
         goto out;
 
+    for (iter = a; *iter != NULL; iter++)
+        ;
+    err = atf_list_reserve(l, iter - a);
+    if (atf_is_error(err))
+        goto out;
+
     while (*a != NULL) {
         char *item = strdup(*a);
         if (item == NULL) {
@@ -0,0 +1,125 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/alloc.h"
+
+#include <inttypes.h>
+
+#include "atf-c/detail/alloc_hooks.h"
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/sanity.h"
+#include "atf-c/error.h"
+
+/* The allocations are counted by libatf-c-alloc, which interposes the
+ * allocation functions of the C library and is only present when the test
+ * program links against it or has it preloaded.  The reference to its
+ * counters is weak so that this library works without it; the counters
+ * are then unavailable and the functions below say so. */
+#if defined(__GNUC__)
+#   pragma weak atf_alloc_counters
+#endif
+
+static
+struct atf_alloc_counters *
+counters(void)
+{
+#if defined(__GNUC__)
+    return &atf_alloc_counters;
+#else
+    return NULL;
+#endif
+}
+
+/** Gets the number of heap allocations made so far by the program.
+ *
+ * \return True if allocations can be counted; false otherwise, in which
+ * case the count is set to zero. */
+bool
+atf_alloc_count(size_t *count)
+{
+    struct atf_alloc_counters *c = counters();
+
+    if (c == NULL) {
+        *count = 0;
+        return false;
+    }
+    *count = __atomic_load_n(&c->m_allocs, __ATOMIC_RELAXED);
+    return true;
+}
+
+static size_t StartAllocs;
+
+/** Starts keeping the detailed statistics of the heap.
+ *
+ * The peak is relative to the memory in use when tracking begins.
+ *
+ * \return True if the statistics can be kept; false otherwise. */
+bool
+atf_alloc_stats_start(void)
+{
+    struct atf_alloc_counters *c = counters();
+
+    if (c == NULL)
+        return false;
+    PRE(!__atomic_load_n(&c->m_tracking, __ATOMIC_RELAXED));
+
+    __atomic_store_n(&c->m_frees, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->m_bytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->m_inuse, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->m_peak, 0, __ATOMIC_RELAXED);
+    StartAllocs = __atomic_load_n(&c->m_allocs, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->m_tracking, true, __ATOMIC_SEQ_CST);
+    return true;
+}
+
+/** Stops keeping the detailed statistics of the heap and returns them.
+ *
+ * This is a no-op that leaves the statistics untouched if they were not
+ * being kept, so that it can be called more than once. */
+void
+atf_alloc_stats_stop(struct atf_alloc_stats *stats)
+{
+    struct atf_alloc_counters *c = counters();
+
+    if (c == NULL || !__atomic_exchange_n(&c->m_tracking, false,
+                                          __ATOMIC_SEQ_CST))
+        return;
+
+    stats->m_allocs = __atomic_load_n(&c->m_allocs, __ATOMIC_RELAXED) -
+        StartAllocs;
+    stats->m_frees = __atomic_load_n(&c->m_frees, __ATOMIC_RELAXED);
+    stats->m_bytes = __atomic_load_n(&c->m_bytes, __ATOMIC_RELAXED);
+    stats->m_peak = (uint64_t)__atomic_load_n(&c->m_peak, __ATOMIC_RELAXED);
+}
+
+/** Formats the statistics of the heap as a JSON object. */
+atf_error_t
+atf_alloc_format(const struct atf_alloc_stats *stats, atf_dynstr_t *dest)
+{
+    return atf_dynstr_append_fmt(dest, "{\"allocs\":%" PRIu64 ",\"frees\":%"
+                                 PRIu64 ",\"bytes\":%" PRIu64 ",\"peak\":%"
+                                 PRIu64 "}", stats->m_allocs, stats->m_frees,
+                                 stats->m_bytes, stats->m_peak);
+}
@@ -0,0 +1,211 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+/* Interposer for the allocation functions of the C library.
+ *
+ * This file makes up libatf-c-alloc, which test programs link against or
+ * preload to have their heap allocations counted, including those made by
+ * the libraries they use.  It is kept out of libatf-c so that linking
+ * against the latter never replaces the allocator of a program.
+ *
+ * Interposing is only possible with the GNU C library, which exports the
+ * real implementations under other names.  Elsewhere this library is
+ * empty and libatf-c reports that allocations cannot be counted.
+ *
+ * Counting allocations costs a single atomic increment.  The detailed
+ * statistics, which need the size of every block that comes and goes, are
+ * only kept while libatf-c sets the tracking flag; the rest of the time
+ * the cost of the hooks is the check of that flag.  Sizes are those
+ * reported by malloc_usable_size, which is what the blocks really take
+ * from the heap. */
+
+#include "atf-c/detail/alloc_hooks.h"
+
+#if defined(__GLIBC__)
+#include <errno.h>
+#include <malloc.h>
+#include <stdlib.h>
+
+struct atf_alloc_counters atf_alloc_counters;
+
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+extern void __libc_free(void *);
+extern void *__libc_memalign(size_t, size_t);
+extern void *__libc_valloc(size_t);
+extern void *__libc_pvalloc(size_t);
+
+static
+void
+track_alloc(void *ptr)
+{
+    struct atf_alloc_counters *c = &atf_alloc_counters;
+    int64_t size, inuse, peak;
+
+    if (ptr == NULL)
+        return;
+
+    size = (int64_t)malloc_usable_size(ptr);
+    __atomic_fetch_add(&c->m_bytes, (uint64_t)size, __ATOMIC_RELAXED);
+    inuse = __atomic_add_fetch(&c->m_inuse, size, __ATOMIC_RELAXED);
+
+    peak = __atomic_load_n(&c->m_peak, __ATOMIC_RELAXED);
+    while (inuse > peak &&
+           !__atomic_compare_exchange_n(&c->m_peak, &peak, inuse, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        continue;
+}
+
+static
+void
+track_free(void *ptr)
+{
+    if (ptr == NULL)
+        return;
+
+    __atomic_fetch_add(&atf_alloc_counters.m_frees, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_sub(&atf_alloc_counters.m_inuse,
+                       (int64_t)malloc_usable_size(ptr), __ATOMIC_RELAXED);
+}
+
+static
+bool
+tracking(void)
+{
+    return __atomic_load_n(&atf_alloc_counters.m_tracking, __ATOMIC_RELAXED);
+}
+
+/* Accounts for a call to one of the functions that allocate a new block,
+ * whether it succeeded or not, and returns the block. */
+static
+void *
+counted(void *ptr)
+{
+    __atomic_fetch_add(&atf_alloc_counters.m_allocs, 1, __ATOMIC_RELAXED);
+    if (tracking())
+        track_alloc(ptr);
+    return ptr;
+}
+
+void *
+malloc(size_t size)
+{
+    return counted(__libc_malloc(size));
+}
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+    return counted(__libc_calloc(nmemb, size));
+}
+
+void *
+memalign(size_t alignment, size_t size)
+{
+    return counted(__libc_memalign(alignment, size));
+}
+
+void *
+aligned_alloc(size_t alignment, size_t size)
+{
+    return counted(__libc_memalign(alignment, size));
+}
+
+/* The C library does not export the real posix_memalign under another
+ * name, so it is rebuilt on top of memalign. */
+int
+posix_memalign(void **memptr, size_t alignment, size_t size)
+{
+    const int original_errno = errno;
+    void *ptr;
+
+    if (alignment % sizeof(void *) != 0 ||
+        (alignment & (alignment - 1)) != 0 || alignment == 0)
+        return EINVAL;
+
+    ptr = counted(__libc_memalign(alignment, size));
+    if (ptr == NULL) {
+        errno = original_errno;
+        return ENOMEM;
+    }
+    *memptr = ptr;
+    return 0;
+}
+
+void *
+valloc(size_t size)
+{
+    return counted(__libc_valloc(size));
+}
+
+void *
+pvalloc(size_t size)
+{
+    return counted(__libc_pvalloc(size));
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+    void *newptr;
+    size_t oldsize;
+
+    __atomic_fetch_add(&atf_alloc_counters.m_allocs, 1, __ATOMIC_RELAXED);
+    if (!tracking())
+        return __libc_realloc(ptr, size);
+
+    /* The old block is accounted as released up front because realloc
+     * may hand it back to the heap. */
+    oldsize = ptr == NULL ? 0 : malloc_usable_size(ptr);
+    newptr = __libc_realloc(ptr, size);
+    if (newptr != NULL || size == 0) {
+        __atomic_fetch_sub(&atf_alloc_counters.m_inuse, (int64_t)oldsize,
+                           __ATOMIC_RELAXED);
+        track_alloc(newptr);
+    }
+    return newptr;
+}
+
+void *
+reallocarray(void *ptr, size_t nmemb, size_t size)
+{
+    size_t total;
+
+    if (__builtin_mul_overflow(nmemb, size, &total)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return realloc(ptr, total);
+}
+
+void
+free(void *ptr)
+{
+    if (tracking())
+        track_free(ptr);
+    __libc_free(ptr);
+}
+#endif
@@ -0,0 +1,356 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/alloc.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__GLIBC__)
+#   include <malloc.h>
+#endif
+
+#include <atf-c.h>
+
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/env.h"
+#include "atf-c/detail/test_helpers.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+/* Skips the test case if the allocations of this platform cannot be
+ * tracked. */
+static
+void
+require_tracking(void)
+{
+    size_t count;
+
+    if (!atf_alloc_count(&count))
+        atf_tc_skip("Heap allocations cannot be counted on this platform");
+}
+
+static
+void
+h_alloc_head(atf_tc_t *tc)
+{
+    atf_tc_set_md_var(tc, "X-alloc.stats", "true");
+}
+
+static
+void
+h_alloc_body(const atf_tc_t *tc ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+    void *volatile ptr;
+
+    ptr = malloc(1000);
+    free(ptr);
+    ptr = calloc(10, 10);
+    free(ptr);
+}
+
+static
+void
+h_bogus_head(atf_tc_t *tc)
+{
+    atf_tc_set_md_var(tc, "X-alloc.stats", "sometimes");
+}
+
+static
+void
+h_disabled_head(atf_tc_t *tc)
+{
+    atf_tc_set_md_var(tc, "X-alloc.stats", "false");
+}
+
+static
+void
+h_fail_body(const atf_tc_t *tc ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+    atf_tc_fail("Out of luck");
+}
+
+/* ---------------------------------------------------------------------
+ * Test cases.
+ * --------------------------------------------------------------------- */
+
+ATF_TC_WITHOUT_HEAD(count);
+ATF_TC_BODY(count, tc)
+{
+    size_t before, after;
+    void *volatile ptr;
+
+    require_tracking();
+
+    ATF_REQUIRE(atf_alloc_count(&before));
+    ptr = malloc(10);
+    ptr = realloc(ptr, 20);
+    free(ptr);
+    ptr = calloc(1, 10);
+    free(ptr);
+    ATF_REQUIRE(atf_alloc_count(&after));
+    ATF_REQUIRE_EQ(3, after - before);
+}
+
+ATF_TC_WITHOUT_HEAD(count__family);
+ATF_TC_BODY(count__family, tc)
+{
+    struct atf_alloc_stats stats;
+    size_t before, after, expected;
+    volatile size_t huge = SIZE_MAX;
+    void *ptr;
+
+    require_tracking();
+
+    ATF_REQUIRE(atf_alloc_stats_start());
+    ATF_REQUIRE(atf_alloc_count(&before));
+    ATF_REQUIRE_EQ(0, posix_memalign(&ptr, 64, 100));
+    ATF_REQUIRE(((uintptr_t)ptr % 64) == 0);
+    free(ptr);
+    ATF_REQUIRE_EQ(EINVAL, posix_memalign(&ptr, 3, 100));
+    ptr = aligned_alloc(128, 256);
+    ATF_REQUIRE(ptr != NULL && ((uintptr_t)ptr % 128) == 0);
+    free(ptr);
+    expected = 2;
+#if defined(__GLIBC__)
+    ptr = memalign(32, 100);
+    ATF_REQUIRE(ptr != NULL);
+    free(ptr);
+    ptr = valloc(100);
+    ATF_REQUIRE(ptr != NULL);
+    free(ptr);
+    ptr = reallocarray(NULL, 10, 10);
+    ATF_REQUIRE(ptr != NULL);
+    ptr = reallocarray(ptr, 20, 10);
+    ATF_REQUIRE(ptr != NULL);
+    ATF_REQUIRE(reallocarray(ptr, huge, 2) == NULL);
+    free(ptr);
+    expected += 4;
+#endif
+    ATF_REQUIRE(atf_alloc_count(&after));
+    atf_alloc_stats_stop(&stats);
+
+    ATF_REQUIRE_EQ(expected, after - before);
+    ATF_REQUIRE_EQ(expected, stats.m_allocs);
+    ATF_REQUIRE_EQ(expected - 1, stats.m_frees);
+}
+
+ATF_TC_WITHOUT_HEAD(stats);
+ATF_TC_BODY(stats, tc)
+{
+    struct atf_alloc_stats stats;
+    void *volatile big;
+    void *volatile small;
+
+    require_tracking();
+
+    ATF_REQUIRE(atf_alloc_stats_start());
+    big = malloc(1000);
+    free(big);
+    small = malloc(100);
+    atf_alloc_stats_stop(&stats);
+    free(small);
+
+    printf("allocs %ju, frees %ju, bytes %ju, peak %ju\n",
+           (uintmax_t)stats.m_allocs, (uintmax_t)stats.m_frees,
+           (uintmax_t)stats.m_bytes, (uintmax_t)stats.m_peak);
+    ATF_REQUIRE_EQ(2, stats.m_allocs);
+    ATF_REQUIRE_EQ(1, stats.m_frees);
+    ATF_REQUIRE(stats.m_bytes >= 1100);
+    ATF_REQUIRE(stats.m_peak >= 1000);
+    ATF_REQUIRE(stats.m_peak < stats.m_bytes);
+}
+
+ATF_TC_WITHOUT_HEAD(stats__realloc);
+ATF_TC_BODY(stats__realloc, tc)
+{
+    struct atf_alloc_stats stats;
+    void *volatile ptr;
+
+    require_tracking();
+
+    ATF_REQUIRE(atf_alloc_stats_start());
+    ptr = realloc(NULL, 100);
+    ptr = realloc(ptr, 2000);
+    ptr = realloc(ptr, 50);
+    free(ptr);
+    atf_alloc_stats_stop(&stats);
+
+    ATF_REQUIRE_EQ(3, stats.m_allocs);
+    ATF_REQUIRE_EQ(1, stats.m_frees);
+    ATF_REQUIRE(stats.m_peak >= 2000);
+    ATF_REQUIRE(stats.m_peak < 4000);
+}
+
+ATF_TC_WITHOUT_HEAD(stats__preexisting);
+ATF_TC_BODY(stats__preexisting, tc)
+{
+    struct atf_alloc_stats stats;
+    void *volatile ptr;
+
+    require_tracking();
+
+    /* Releasing memory obtained before the statistics were started must
+     * not leave a bogus peak behind. */
+    ptr = malloc(5000);
+    ATF_REQUIRE(atf_alloc_stats_start());
+    free(ptr);
+    ptr = malloc(100);
+    free(ptr);
+    atf_alloc_stats_stop(&stats);
+
+    ATF_REQUIRE_EQ(1, stats.m_allocs);
+    ATF_REQUIRE_EQ(2, stats.m_frees);
+    ATF_REQUIRE(stats.m_peak < 5000);
+}
+
+ATF_TC_WITHOUT_HEAD(stop__idempotent);
+ATF_TC_BODY(stop__idempotent, tc)
+{
+    struct atf_alloc_stats stats;
+    void *volatile ptr;
+
+    require_tracking();
+
+    ATF_REQUIRE(atf_alloc_stats_start());
+    ptr = malloc(10);
+    free(ptr);
+    atf_alloc_stats_stop(&stats);
+    ATF_REQUIRE_EQ(1, stats.m_allocs);
+
+    ptr = malloc(10);
+    free(ptr);
+    atf_alloc_stats_stop(&stats);
+    ATF_REQUIRE_EQ(1, stats.m_allocs);
+    ATF_REQUIRE_EQ(1, stats.m_frees);
+}
+
+ATF_TC_WITHOUT_HEAD(format);
+ATF_TC_BODY(format, tc)
+{
+    struct atf_alloc_stats stats;
+    atf_dynstr_t out;
+
+    stats.m_allocs = 4;
+    stats.m_frees = 3;
+    stats.m_bytes = 1024;
+    stats.m_peak = 512;
+
+    RE(atf_dynstr_init(&out));
+    RE(atf_alloc_format(&stats, &out));
+    ATF_REQUIRE_STREQ("{\"allocs\":4,\"frees\":3,\"bytes\":1024,"
+                      "\"peak\":512}", atf_dynstr_cstring(&out));
+    atf_dynstr_fini(&out);
+}
+
+ATF_TC_WITHOUT_HEAD(tc__record);
+ATF_TC_BODY(tc__record, tc)
+{
+    const char *const config[] = { NULL };
+    atf_tc_t h_tc;
+
+    require_tracking();
+
+    RE(atf_env_set("ATF_RECORDS", "records.json"));
+    RE(atf_tc_init(&h_tc, "h_alloc", h_alloc_head, h_alloc_body, NULL,
+                   config));
+    run_h_tc(&h_tc, "output", "error", "result");
+    atf_tc_fini(&h_tc);
+    RE(atf_tc_init(&h_tc, "h_fail", h_alloc_head, h_fail_body, NULL,
+                   config));
+    run_h_tc(&h_tc, "output", "error", "result");
+    atf_tc_fini(&h_tc);
+
+    atf_utils_cat_file("records.json", "records: ");
+    ATF_REQUIRE(atf_utils_grep_file("^\\{\"tc\":\"h_alloc\",\"result\":"
+                                    "\"passed\",\"alloc\":\\{\"allocs\":2,"
+                                    "\"frees\":2,\"bytes\":[0-9]+,"
+                                    "\"peak\":[0-9]+\\}\\}$",
+                                    "records.json"));
+    ATF_REQUIRE(atf_utils_grep_file("^\\{\"tc\":\"h_fail\",\"result\":"
+                                    "\"failed\",\"alloc\":\\{",
+                                    "records.json"));
+    ATF_REQUIRE(atf_utils_compare_file("result", "failed: Out of luck\n"));
+}
+
+ATF_TC_WITHOUT_HEAD(tc__no_record);
+ATF_TC_BODY(tc__no_record, tc)
+{
+    const char *const config[] = { NULL };
+    atf_tc_t h_tc;
+
+    RE(atf_env_set("ATF_RECORDS", "records.json"));
+    RE(atf_tc_init(&h_tc, "h_plain", NULL, h_alloc_body, NULL, config));
+    run_h_tc(&h_tc, "output", "error", "result");
+    atf_tc_fini(&h_tc);
+    RE(atf_tc_init(&h_tc, "h_disabled", h_disabled_head, h_alloc_body, NULL,
+                   config));
+    run_h_tc(&h_tc, "output", "error", "result");
+    atf_tc_fini(&h_tc);
+
+    ATF_REQUIRE(!atf_utils_file_exists("records.json"));
+    ATF_REQUIRE(atf_utils_compare_file("result", "passed\n"));
+}
+
+ATF_TC_WITHOUT_HEAD(tc__invalid);
+ATF_TC_BODY(tc__invalid, tc)
+{
+    const char *const config[] = { NULL };
+    atf_tc_t h_tc;
+
+    RE(atf_env_set("ATF_RECORDS", "records.json"));
+    RE(atf_tc_init(&h_tc, "h_bogus", h_bogus_head, h_alloc_body, NULL,
+                   config));
+    run_h_tc(&h_tc, "output", "error", "result");
+    atf_tc_fini(&h_tc);
+
+    ATF_REQUIRE(!atf_utils_file_exists("records.json"));
+    ATF_REQUIRE(atf_utils_grep_file("^failed: Invalid X-alloc.stats: ",
+                                    "result"));
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    ATF_TP_ADD_TC(tp, count);
+    ATF_TP_ADD_TC(tp, count__family);
+    ATF_TP_ADD_TC(tp, stats);
+    ATF_TP_ADD_TC(tp, stats__realloc);
+    ATF_TP_ADD_TC(tp, stats__preexisting);
+    ATF_TP_ADD_TC(tp, stop__idempotent);
+    ATF_TP_ADD_TC(tp, format);
+    ATF_TP_ADD_TC(tp, tc__record);
+    ATF_TP_ADD_TC(tp, tc__no_record);
+    ATF_TP_ADD_TC(tp, tc__invalid);
+
+    return atf_no_error();
+}
@@ -0,0 +1,230 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/arena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "atf-c/detail/sanity.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+struct atf_arena_chunk {
+    struct atf_arena_chunk *m_next;
+    size_t m_size;
+};
+
+/* Bounds of the size of the chunks.  The first chunk is sized from the
+ * first request, so that arenas that only ever hold a few small objects,
+ * like the keys of most maps, stay small; later ones double up to
+ * chunk_max_size. */
+static const size_t chunk_min_size = 64;
+static const size_t chunk_max_size = 64 * 1024;
+
+/* Alignment of the returned pointers; good enough for any scalar. */
+#define ARENA_ALIGN (sizeof(void *) > sizeof(double) ? \
+                     sizeof(void *) : sizeof(double))
+
+static
+size_t
+align(const size_t size)
+{
+    return (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
+static
+struct atf_arena_chunk *
+new_chunk(atf_arena_t *a, size_t size)
+{
+    struct atf_arena_chunk *c;
+
+    if (size > SIZE_MAX - align(sizeof(*c)))
+        return NULL;
+
+    c = (struct atf_arena_chunk *)malloc(align(sizeof(*c)) + size);
+    if (c != NULL) {
+        c->m_next = a->m_chunks;
+        c->m_size = size;
+        a->m_chunks = c;
+
+        a->m_usage.m_chunks++;
+        a->m_usage.m_reserved += align(sizeof(*c)) + size;
+    }
+    return c;
+}
+
+static
+char *
+chunk_data(struct atf_arena_chunk *c)
+{
+    return (char *)c + align(sizeof(*c));
+}
+
+static atf_arena_t *program_arena = NULL;
+
+/* ---------------------------------------------------------------------
+ * The "atf_arena" type.
+ * --------------------------------------------------------------------- */
+
+/*
+ * Constructors and destructors.
+ */
+
+void
+atf_arena_init(atf_arena_t *a)
+{
+    a->m_chunks = NULL;
+    a->m_next = NULL;
+    a->m_avail = 0;
+
+    a->m_usage.m_allocs = 0;
+    a->m_usage.m_requested = 0;
+    a->m_usage.m_reserved = 0;
+    a->m_usage.m_chunks = 0;
+}
+
+void
+atf_arena_fini(atf_arena_t *a)
+{
+    struct atf_arena_chunk *c;
+
+    c = a->m_chunks;
+    while (c != NULL) {
+        struct atf_arena_chunk *next = c->m_next;
+        free(c);
+        c = next;
+    }
+}
+
+/*
+ * Getters.
+ */
+
+atf_arena_usage_t
+atf_arena_get_usage(const atf_arena_t *a)
+{
+    return a->m_usage;
+}
+
+void
+atf_arena_print_usage(const atf_arena_t *a, const char *name, FILE *f)
+{
+    fprintf(f, "%s: %zu allocations, %zu bytes requested, %zu bytes "
+            "reserved in %zu chunks\n", name, a->m_usage.m_allocs,
+            a->m_usage.m_requested, a->m_usage.m_reserved,
+            a->m_usage.m_chunks);
+}
+
+/*
+ * Modifiers.
+ */
+
+/* Returns 'size' bytes of uninitialized memory, or NULL if there is not
+ * enough memory.  Requests bigger than a chunk get a chunk of their own
+ * so that they do not waste the remainder of the current one. */
+void *
+atf_arena_alloc(atf_arena_t *a, size_t size)
+{
+    struct atf_arena_chunk *c;
+    void *ptr;
+
+    if (size > SIZE_MAX - ARENA_ALIGN)
+        return NULL;
+    a->m_usage.m_allocs++;
+    a->m_usage.m_requested += size;
+    size = align(size);
+
+    if (size > a->m_avail) {
+        size_t chunk_size;
+
+        if (a->m_chunks == NULL) {
+            chunk_size = chunk_min_size;
+            while (chunk_size < size * 4 && chunk_size < chunk_max_size)
+                chunk_size *= 2;
+        } else
+            chunk_size = a->m_chunks->m_size * 2;
+        if (chunk_size > chunk_max_size)
+            chunk_size = chunk_max_size;
+
+        if (size > chunk_size / 4) {
+            struct atf_arena_chunk *current = a->m_chunks;
+
+            c = new_chunk(a, size);
+            if (c == NULL)
+                return NULL;
+            /* Keep allocating from the current chunk. */
+            if (current != NULL) {
+                a->m_chunks = current;
+                c->m_next = current->m_next;
+                current->m_next = c;
+            }
+            return chunk_data(c);
+        }
+
+        c = new_chunk(a, chunk_size);
+        if (c == NULL)
+            return NULL;
+        a->m_next = chunk_data(c);
+        a->m_avail = chunk_size;
+    }
+
+    INV(size <= a->m_avail);
+    ptr = a->m_next;
+    a->m_next += size;
+    a->m_avail -= size;
+    return ptr;
+}
+
+char *
+atf_arena_strdup(atf_arena_t *a, const char *str)
+{
+    const size_t length = strlen(str) + 1;
+    char *copy;
+
+    copy = (char *)atf_arena_alloc(a, length);
+    if (copy != NULL)
+        memcpy(copy, str, length);
+    return copy;
+}
+
+/* ---------------------------------------------------------------------
+ * Free functions.
+ * --------------------------------------------------------------------- */
+
+atf_arena_t *
+atf_arena_get_program(void)
+{
+    return program_arena;
+}
+
+void
+atf_arena_set_program(atf_arena_t *a)
+{
+    program_arena = a;
+}
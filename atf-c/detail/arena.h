@@ -0,0 +1,80 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#if !defined(ATF_C_DETAIL_ARENA_H)
+#define ATF_C_DETAIL_ARENA_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/* ---------------------------------------------------------------------
+ * The "atf_arena" type.
+ * --------------------------------------------------------------------- */
+
+/* A bump allocator for small objects that live as long as their owner.
+ * Memory is carved out of chunks that are only released all at once by
+ * atf_arena_fini. */
+struct atf_arena_chunk;
+
+struct atf_arena_usage {
+    size_t m_allocs;
+    size_t m_requested;
+    size_t m_reserved;
+    size_t m_chunks;
+};
+typedef struct atf_arena_usage atf_arena_usage_t;
+
+struct atf_arena {
+    struct atf_arena_chunk *m_chunks;
+    char *m_next;
+    size_t m_avail;
+
+    atf_arena_usage_t m_usage;
+};
+typedef struct atf_arena atf_arena_t;
+
+/* Constructors and destructors. */
+void atf_arena_init(atf_arena_t *);
+void atf_arena_fini(atf_arena_t *);
+
+/* Getters. */
+atf_arena_usage_t atf_arena_get_usage(const atf_arena_t *);
+void atf_arena_print_usage(const atf_arena_t *, const char *, FILE *);
+
+/* Modifiers. */
+void *atf_arena_alloc(atf_arena_t *, size_t);
+char *atf_arena_strdup(atf_arena_t *, const char *);
+
+/* ---------------------------------------------------------------------
+ * Free functions.
+ * --------------------------------------------------------------------- */
+
+/* The arena of the test program being run, if any.  It is set up by
+ * atf_tp_main while the test cases are registered and holds the data of
+ * the test program and its test cases, which live until the program exits. */
+atf_arena_t *atf_arena_get_program(void);
+void atf_arena_set_program(atf_arena_t *);
+
+#endif /* !defined(ATF_C_DETAIL_ARENA_H) */
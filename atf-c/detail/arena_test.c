@@ -0,0 +1,208 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/arena.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <atf-c.h>
+
+/* ---------------------------------------------------------------------
+ * Tests for the "atf_arena" type.
+ * --------------------------------------------------------------------- */
+
+ATF_TC(alloc_small);
+ATF_TC_HEAD(alloc_small, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that small allocations are "
+                      "aligned, distinct and share chunks");
+}
+ATF_TC_BODY(alloc_small, tc)
+{
+    atf_arena_t arena;
+    char *ptrs[1000];
+    size_t i;
+
+    atf_arena_init(&arena);
+    for (i = 0; i < 1000; i++) {
+        ptrs[i] = atf_arena_alloc(&arena, i % 13 + 1);
+        ATF_REQUIRE(ptrs[i] != NULL);
+        ATF_REQUIRE_EQ((uintptr_t)ptrs[i] % sizeof(void *), 0);
+        memset(ptrs[i], (int)i, i % 13 + 1);
+    }
+    for (i = 0; i < 1000; i++)
+        ATF_REQUIRE_EQ(ptrs[i][i % 13], (char)i);
+    atf_arena_fini(&arena);
+}
+
+ATF_TC(alloc_big);
+ATF_TC_HEAD(alloc_big, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that allocations bigger than "
+                      "a chunk are supported and do not disturb the "
+                      "current chunk");
+}
+ATF_TC_BODY(alloc_big, tc)
+{
+    atf_arena_t arena;
+    char *small1, *small2, *big;
+
+    atf_arena_init(&arena);
+    small1 = atf_arena_alloc(&arena, 8);
+    ATF_REQUIRE(small1 != NULL);
+    big = atf_arena_alloc(&arena, 1024 * 1024);
+    ATF_REQUIRE(big != NULL);
+    memset(big, 'x', 1024 * 1024);
+    small2 = atf_arena_alloc(&arena, 8);
+    ATF_REQUIRE(small2 != NULL);
+    ATF_REQUIRE_EQ(small2, small1 + 8);
+    atf_arena_fini(&arena);
+}
+
+ATF_TC(strdup);
+ATF_TC_HEAD(strdup, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks the atf_arena_strdup function");
+}
+ATF_TC_BODY(strdup, tc)
+{
+    atf_arena_t arena;
+    char buf[] = "original";
+    char *copy;
+
+    atf_arena_init(&arena);
+    copy = atf_arena_strdup(&arena, buf);
+    ATF_REQUIRE(copy != NULL);
+    ATF_REQUIRE(copy != buf);
+    strcpy(buf, "modified");
+    ATF_REQUIRE_STREQ("original", copy);
+    ATF_REQUIRE_STREQ("", atf_arena_strdup(&arena, ""));
+    atf_arena_fini(&arena);
+}
+
+ATF_TC(usage);
+ATF_TC_HEAD(usage, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that the arena keeps track of "
+                      "its memory usage");
+}
+ATF_TC_BODY(usage, tc)
+{
+    atf_arena_t arena;
+    atf_arena_usage_t usage;
+    size_t i;
+
+    atf_arena_init(&arena);
+    usage = atf_arena_get_usage(&arena);
+    ATF_REQUIRE_EQ(usage.m_allocs, 0);
+    ATF_REQUIRE_EQ(usage.m_requested, 0);
+    ATF_REQUIRE_EQ(usage.m_reserved, 0);
+    ATF_REQUIRE_EQ(usage.m_chunks, 0);
+
+    for (i = 0; i < 100; i++)
+        ATF_REQUIRE(atf_arena_alloc(&arena, 3) != NULL);
+    usage = atf_arena_get_usage(&arena);
+    ATF_REQUIRE_EQ(usage.m_allocs, 100);
+    ATF_REQUIRE_EQ(usage.m_requested, 300);
+    ATF_REQUIRE(usage.m_reserved >= 100 * sizeof(void *));
+    ATF_REQUIRE(usage.m_chunks >= 1 && usage.m_chunks < 100);
+
+    atf_arena_print_usage(&arena, "test", stdout);
+    atf_arena_fini(&arena);
+}
+
+ATF_TC(first_chunk);
+ATF_TC_HEAD(first_chunk, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that the first chunk is sized "
+                      "from the first request so that small arenas stay "
+                      "small");
+}
+ATF_TC_BODY(first_chunk, tc)
+{
+    atf_arena_t arena;
+    atf_arena_usage_t usage;
+    char *big;
+
+    atf_arena_init(&arena);
+    ATF_REQUIRE(atf_arena_alloc(&arena, 8) != NULL);
+    usage = atf_arena_get_usage(&arena);
+    ATF_REQUIRE_EQ(usage.m_chunks, 1);
+    ATF_REQUIRE(usage.m_reserved < 256);
+    atf_arena_fini(&arena);
+
+    atf_arena_init(&arena);
+    big = atf_arena_alloc(&arena, 600);
+    ATF_REQUIRE(big != NULL);
+    memset(big, 'x', 600);
+    ATF_REQUIRE(atf_arena_alloc(&arena, 600) != NULL);
+    usage = atf_arena_get_usage(&arena);
+    ATF_REQUIRE_EQ(usage.m_chunks, 1);
+    atf_arena_fini(&arena);
+}
+
+ATF_TC_WITHOUT_HEAD(program);
+ATF_TC_BODY(program, tc)
+{
+    atf_arena_t arena;
+
+    /* atf_tp_main only keeps the arena while registering the test cases;
+     * anything created by the body is released on its own. */
+    ATF_REQUIRE(atf_arena_get_program() == NULL);
+
+    atf_arena_init(&arena);
+    atf_arena_set_program(&arena);
+    ATF_REQUIRE(atf_arena_get_program() == &arena);
+    atf_arena_set_program(NULL);
+    ATF_REQUIRE(atf_arena_get_program() == NULL);
+    atf_arena_fini(&arena);
+}
+
+ATF_TC_WITHOUT_HEAD(fini_empty);
+ATF_TC_BODY(fini_empty, tc)
+{
+    atf_arena_t arena;
+
+    atf_arena_init(&arena);
+    atf_arena_fini(&arena);
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    ATF_TP_ADD_TC(tp, alloc_small);
+    ATF_TP_ADD_TC(tp, alloc_big);
+    ATF_TP_ADD_TC(tp, strdup);
+    ATF_TP_ADD_TC(tp, usage);
+    ATF_TP_ADD_TC(tp, first_chunk);
+    ATF_TP_ADD_TC(tp, program);
+    ATF_TP_ADD_TC(tp, fini_empty);
+
+    return atf_no_error();
+}
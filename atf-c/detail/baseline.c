@@ -0,0 +1,282 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/baseline.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "atf-c/detail/bench.h"
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/sanity.h"
+#include "atf-c/detail/text.h"
+#include "atf-c/error.h"
+
+/* The first line of every baseline file. */
+static const char *const Header = "atf-baseline 1\n";
+
+/* Critical value of the standard normal distribution for a one-sided test
+ * at the 95% confidence level. */
+static const double Z_95 = 1.6449;
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static
+atf_error_t
+invalid_file(const char *path)
+{
+    return atf_error_new_fmt("baseline", "Invalid baseline file %s", path);
+}
+
+/* Computes the sum of t^3 - t over the groups of t tied values across the
+ * two sorted sets of samples, used to correct the variance of U. */
+static
+double
+tie_correction(const double *base, const size_t nb, const double scale,
+               const double *samples, const size_t n)
+{
+    double sum = 0.0;
+    size_t i = 0, j = 0;
+
+    while (i < nb || j < n) {
+        double value, t = 0.0;
+
+        if (j == n || (i < nb && base[i] * scale <= samples[j]))
+            value = base[i] * scale;
+        else
+            value = samples[j];
+
+        for (; i < nb && base[i] * scale == value; i++)
+            t++;
+        for (; j < n && samples[j] == value; j++)
+            t++;
+        sum += t * t * t - t;
+    }
+    return sum;
+}
+
+/* ---------------------------------------------------------------------
+ * Free functions.
+ * --------------------------------------------------------------------- */
+
+/** Reads the samples stored in a baseline file.
+ *
+ * \param path The file to read.
+ * \param samples Output pointer to a newly-allocated array with the
+ *     samples, which the caller must release with free(3).
+ * \param n Output number of samples. */
+atf_error_t
+atf_baseline_read(const char *path, double **samples, size_t *n)
+{
+    atf_error_t err;
+    char header[32];
+    double value;
+    size_t count, size;
+    double *array;
+    FILE *f;
+    int ret;
+
+    f = fopen(path, "r");
+    if (f == NULL)
+        return atf_libc_error(errno, "Cannot open baseline file %s", path);
+
+    array = NULL;
+    count = size = 0;
+    if (fgets(header, sizeof(header), f) == NULL ||
+        strcmp(header, Header) != 0) {
+        err = invalid_file(path);
+        goto out;
+    }
+
+    while ((ret = fscanf(f, "%lf", &value)) == 1) {
+        if (value < 0.0) {
+            err = invalid_file(path);
+            goto out;
+        }
+        if (count == size) {
+            double *grown;
+
+            size = size == 0 ? 32 : size * 2;
+            grown = realloc(array, size * sizeof(*array));
+            if (grown == NULL) {
+                err = atf_no_memory_error();
+                goto out;
+            }
+            array = grown;
+        }
+        array[count++] = value;
+    }
+    if (ret != EOF || ferror(f) || count == 0) {
+        err = invalid_file(path);
+        goto out;
+    }
+
+    *samples = array;
+    *n = count;
+    array = NULL;
+    err = atf_no_error();
+
+out:
+    free(array);
+    fclose(f);
+    return err;
+}
+
+/** Stores samples in a baseline file, replacing it atomically.
+ *
+ * The file is a header line followed by the samples in text form with six
+ * significant digits, which is more than the precision of any timing and
+ * keeps the file small enough to be committed along with the tests. */
+atf_error_t
+atf_baseline_write(const char *path, const double *samples, const size_t n)
+{
+    atf_error_t err;
+    atf_dynstr_t tmp;
+    size_t i;
+    FILE *f;
+
+    PRE(n > 0);
+
+    err = atf_dynstr_init_fmt(&tmp, "%s.tmp", path);
+    if (atf_is_error(err))
+        return err;
+
+    f = fopen(atf_dynstr_cstring(&tmp), "w");
+    if (f == NULL) {
+        err = atf_libc_error(errno, "Cannot create baseline file %s",
+                             atf_dynstr_cstring(&tmp));
+        goto out;
+    }
+
+    fputs(Header, f);
+    for (i = 0; i < n; i++)
+        fprintf(f, "%.6g%c", samples[i],
+                (i % 10 == 9 || i == n - 1) ? '\n' : ' ');
+    if (ferror(f)) {
+        err = atf_libc_error(errno, "Cannot write baseline file %s",
+                             atf_dynstr_cstring(&tmp));
+        fclose(f);
+        goto out_unlink;
+    }
+    if (fclose(f) == EOF) {
+        err = atf_libc_error(errno, "Cannot write baseline file %s",
+                             atf_dynstr_cstring(&tmp));
+        goto out_unlink;
+    }
+
+    if (rename(atf_dynstr_cstring(&tmp), path) == -1) {
+        err = atf_libc_error(errno, "Cannot replace baseline file %s", path);
+        goto out_unlink;
+    }
+    goto out;
+
+out_unlink:
+    unlink(atf_dynstr_cstring(&tmp));
+out:
+    atf_dynstr_fini(&tmp);
+    return err;
+}
+
+/** Checks whether a set of samples is slower than a baseline.
+ *
+ * The samples regress if they are larger than the baseline samples scaled
+ * by 1 + threshold with 95% confidence, according to a one-sided
+ * Mann-Whitney U test.  The test only relies on the ranks of the samples,
+ * so it is robust against the long tails of timing distributions, and the
+ * normal approximation of U, with corrections for ties and continuity, is
+ * accurate for the number of samples that tests take.
+ *
+ * Both arrays are sorted in place. */
+void
+atf_baseline_compare(double *base, const size_t nb, double *samples,
+                     const size_t n, const double threshold,
+                     struct atf_baseline_result *result)
+{
+    const double scale = 1.0 + threshold;
+    struct atf_bench_result summary;
+    double u, mean, variance, ties, delta;
+    size_t i, j, total;
+
+    PRE(nb > 0);
+    PRE(n > 0);
+    PRE(threshold >= 0.0);
+
+    atf_bench_summarize(base, nb, &summary);
+    result->m_base_median = summary.m_median;
+    atf_bench_summarize(samples, n, &summary);
+    result->m_median = summary.m_median;
+
+    u = 0.0;
+    for (j = 0; j < n; j++) {
+        for (i = 0; i < nb; i++) {
+            if (samples[j] > base[i] * scale)
+                u += 1.0;
+            else if (samples[j] == base[i] * scale)
+                u += 0.5;
+        }
+    }
+
+    total = n + nb;
+    ties = tie_correction(base, nb, scale, samples, n);
+    mean = (double)n * nb / 2.0;
+    variance = (double)n * nb / 12.0 *
+        ((total + 1.0) - ties / ((double)total * (total - 1)));
+    delta = u - mean - 0.5;
+
+    result->m_samples = n;
+    result->m_base_samples = nb;
+    result->m_threshold = threshold;
+    result->m_u = u;
+    result->m_regressed = delta > 0.0 && variance > 0.0 &&
+        delta * delta > Z_95 * Z_95 * variance;
+}
+
+/** Appends the result of a comparison to a string as a JSON object. */
+atf_error_t
+atf_baseline_format(const char *name, const struct atf_baseline_result *result,
+                    atf_dynstr_t *dest)
+{
+    atf_error_t err;
+
+    err = atf_dynstr_append_fmt(dest, "{\"name\":");
+    if (atf_is_error(err))
+        return err;
+    err = atf_text_append_json(dest, name);
+    if (atf_is_error(err))
+        return err;
+
+    err = atf_dynstr_append_fmt(dest, ",\"samples\":%zu,"
+        "\"baseline_samples\":%zu,\"ns_per_op\":%.3f,"
+        "\"baseline_ns_per_op\":%.3f,\"threshold\":%.4f,\"u\":%.1f,"
+        "\"regressed\":%s}", result->m_samples, result->m_base_samples,
+        result->m_median, result->m_base_median, result->m_threshold,
+        result->m_u, result->m_regressed ? "true" : "false");
+    return err;
+}
@@ -0,0 +1,63 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#if !defined(ATF_C_DETAIL_BASELINE_H)
+#define ATF_C_DETAIL_BASELINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <atf-c/error_fwd.h>
+
+struct atf_dynstr;
+
+/* ---------------------------------------------------------------------
+ * Performance baselines.
+ * --------------------------------------------------------------------- */
+
+struct atf_baseline_result {
+    size_t m_samples;
+    size_t m_base_samples;
+    double m_threshold;
+
+    /* In nanoseconds per iteration. */
+    double m_median;
+    double m_base_median;
+
+    /* Mann-Whitney statistic of the samples against the baseline scaled
+     * by the threshold, out of m_samples * m_base_samples. */
+    double m_u;
+    bool m_regressed;
+};
+
+atf_error_t atf_baseline_read(const char *, double **, size_t *);
+atf_error_t atf_baseline_write(const char *, const double *, const size_t);
+void atf_baseline_compare(double *, const size_t, double *, const size_t,
+                          const double, struct atf_baseline_result *);
+atf_error_t atf_baseline_format(const char *,
+                                const struct atf_baseline_result *,
+                                struct atf_dynstr *);
+
+#endif /* !defined(ATF_C_DETAIL_BASELINE_H) */
@@ -0,0 +1,231 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/baseline.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/test_helpers.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+#define NSAMPLES 30
+
+/* Fills an array with reproducible samples scattered around a value. */
+static
+void
+noisy_samples(double *samples, const size_t n, const double center,
+              unsigned int seed)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        seed = seed * 1103515245 + 12345;
+        samples[i] = center * (0.98 + (double)((seed >> 16) % 1000) / 25000);
+    }
+}
+
+static
+void
+compare_scaled(const double factor, const double threshold,
+               struct atf_baseline_result *result)
+{
+    double base[NSAMPLES], samples[NSAMPLES];
+
+    noisy_samples(base, NSAMPLES, 100.0, 1);
+    noisy_samples(samples, NSAMPLES, 100.0 * factor, 2);
+    atf_baseline_compare(base, NSAMPLES, samples, NSAMPLES, threshold,
+                         result);
+}
+
+static
+void
+check_invalid(const char *contents)
+{
+    atf_error_t err;
+    double *samples;
+    size_t n;
+
+    atf_utils_create_file("test.baseline", "%s", contents);
+    err = atf_baseline_read("test.baseline", &samples, &n);
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_REQUIRE(atf_error_is(err, "baseline"));
+    atf_error_free(err);
+}
+
+/* ---------------------------------------------------------------------
+ * Test cases.
+ * --------------------------------------------------------------------- */
+
+ATF_TC_WITHOUT_HEAD(compare__same);
+ATF_TC_BODY(compare__same, tc)
+{
+    struct atf_baseline_result result;
+
+    compare_scaled(1.0, 0.05, &result);
+    ATF_REQUIRE_EQ(NSAMPLES, result.m_samples);
+    ATF_REQUIRE_EQ(NSAMPLES, result.m_base_samples);
+    ATF_REQUIRE(!result.m_regressed);
+}
+
+ATF_TC_WITHOUT_HEAD(compare__within_threshold);
+ATF_TC_BODY(compare__within_threshold, tc)
+{
+    struct atf_baseline_result result;
+
+    compare_scaled(1.03, 0.05, &result);
+    ATF_REQUIRE(result.m_median > result.m_base_median);
+    ATF_REQUIRE(!result.m_regressed);
+}
+
+ATF_TC_WITHOUT_HEAD(compare__regression);
+ATF_TC_BODY(compare__regression, tc)
+{
+    struct atf_baseline_result result;
+
+    compare_scaled(1.2, 0.05, &result);
+    ATF_REQUIRE(result.m_regressed);
+
+    compare_scaled(1.2, 0.25, &result);
+    ATF_REQUIRE(!result.m_regressed);
+}
+
+ATF_TC_WITHOUT_HEAD(compare__faster);
+ATF_TC_BODY(compare__faster, tc)
+{
+    struct atf_baseline_result result;
+
+    compare_scaled(0.5, 0.0, &result);
+    ATF_REQUIRE_EQ(0.0, result.m_u);
+    ATF_REQUIRE(!result.m_regressed);
+}
+
+ATF_TC_WITHOUT_HEAD(compare__ties);
+ATF_TC_BODY(compare__ties, tc)
+{
+    double base[] = { 10, 10, 10, 10, 10 };
+    double samples[] = { 10, 10, 10 };
+    struct atf_baseline_result result;
+
+    atf_baseline_compare(base, 5, samples, 3, 0.0, &result);
+    ATF_REQUIRE_EQ(7.5, result.m_u);
+    ATF_REQUIRE(!result.m_regressed);
+}
+
+ATF_TC_WITHOUT_HEAD(write_read);
+ATF_TC_BODY(write_read, tc)
+{
+    double samples[NSAMPLES];
+    double *read;
+    size_t i, n;
+
+    noisy_samples(samples, NSAMPLES, 12345.0, 3);
+    RE(atf_baseline_write("test.baseline", samples, NSAMPLES));
+    ATF_REQUIRE(!atf_utils_file_exists("test.baseline.tmp"));
+    ATF_REQUIRE(atf_utils_grep_file("^atf-baseline 1$", "test.baseline"));
+
+    RE(atf_baseline_read("test.baseline", &read, &n));
+    ATF_REQUIRE_EQ(NSAMPLES, n);
+    for (i = 0; i < n; i++) {
+        const double delta = read[i] - samples[i];
+        ATF_CHECK_MSG(delta < 1.0 && delta > -1.0, "Sample %zu was %f, "
+                      "read back as %f", i, samples[i], read[i]);
+    }
+    free(read);
+}
+
+ATF_TC_WITHOUT_HEAD(read__missing);
+ATF_TC_BODY(read__missing, tc)
+{
+    atf_error_t err;
+    double *samples;
+    size_t n;
+
+    err = atf_baseline_read("missing.baseline", &samples, &n);
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_REQUIRE(atf_error_is(err, "libc"));
+    ATF_REQUIRE_EQ(ENOENT, atf_libc_error_code(err));
+    atf_error_free(err);
+}
+
+ATF_TC_WITHOUT_HEAD(read__invalid);
+ATF_TC_BODY(read__invalid, tc)
+{
+    check_invalid("");
+    check_invalid("atf-baseline 2\n1 2 3\n");
+    check_invalid("atf-baseline 1\n");
+    check_invalid("atf-baseline 1\n1 2 foo\n");
+    check_invalid("atf-baseline 1\n1 -2 3\n");
+}
+
+ATF_TC_WITHOUT_HEAD(format);
+ATF_TC_BODY(format, tc)
+{
+    struct atf_baseline_result result;
+    atf_dynstr_t str;
+
+    result.m_samples = 30;
+    result.m_base_samples = 20;
+    result.m_threshold = 0.05;
+    result.m_median = 120.0;
+    result.m_base_median = 100.0;
+    result.m_u = 540.0;
+    result.m_regressed = true;
+
+    RE(atf_dynstr_init(&str));
+    RE(atf_baseline_format("a\"b", &result, &str));
+    ATF_REQUIRE_STREQ("{\"name\":\"a\\\"b\",\"samples\":30,"
+                      "\"baseline_samples\":20,\"ns_per_op\":120.000,"
+                      "\"baseline_ns_per_op\":100.000,\"threshold\":0.0500,"
+                      "\"u\":540.0,\"regressed\":true}",
+                      atf_dynstr_cstring(&str));
+    atf_dynstr_fini(&str);
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    ATF_TP_ADD_TC(tp, compare__same);
+    ATF_TP_ADD_TC(tp, compare__within_threshold);
+    ATF_TP_ADD_TC(tp, compare__regression);
+    ATF_TP_ADD_TC(tp, compare__faster);
+    ATF_TP_ADD_TC(tp, compare__ties);
+    ATF_TP_ADD_TC(tp, write_read);
+    ATF_TP_ADD_TC(tp, read__missing);
+    ATF_TP_ADD_TC(tp, read__invalid);
+    ATF_TP_ADD_TC(tp, format);
+
+    return atf_no_error();
+}
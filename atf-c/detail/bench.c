@@ -0,0 +1,323 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/bench.h"
+
+#if defined(HAVE_CONFIG_H)
+#include "config.h"
+#endif
+
+#include <sys/types.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/sanity.h"
+#include "atf-c/error.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static
+uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+        return 0;
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static
+uint64_t
+time_iterations(atf_bench_func_t func, void *data, const size_t n)
+{
+    const uint64_t start = now_ns();
+    func(data, n);
+    return now_ns() - start;
+}
+
+/* Finds the number of iterations that make a sample last for at least
+ * the given time.
+ *
+ * The count grows geometrically from 1, predicting the next count from
+ * the time taken by the previous one with some margin, so that expensive
+ * bodies are not run more than needed and cheap bodies converge quickly.
+ * The runs made here also serve as warm-up. */
+static
+size_t
+calibrate(atf_bench_func_t func, void *data, const uint64_t target)
+{
+    const size_t max = SIZE_MAX / 100;
+    size_t n = 1;
+
+    for (;;) {
+        const uint64_t elapsed = time_iterations(func, data, n);
+        size_t next;
+
+        if (elapsed >= target || n >= max)
+            return n;
+
+        if (elapsed < target / 100)
+            next = n * 100;
+        else
+            next = (size_t)((double)n * target * 1.2 / elapsed);
+        if (next <= n)
+            next = n + 1;
+        n = next < max ? next : max;
+    }
+}
+
+struct run_data {
+    const atf_tc_t *m_tc;
+    atf_tc_bench_t m_func;
+};
+
+static
+void
+run_body(void *data, const size_t n)
+{
+    const struct run_data *rd = data;
+
+    rd->m_func(rd->m_tc, n);
+}
+
+static
+int
+compare_doubles(const void *a, const void *b)
+{
+    const double x = *(const double *)a;
+    const double y = *(const double *)b;
+
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static
+double
+square_root(const double x)
+{
+    double r = x > 1.0 ? x : 1.0;
+    int i;
+
+    for (i = 0; i < 64; i++)
+        r = (r + x / r) / 2.0;
+    return r;
+}
+
+/* Returns the value at a 1-based rank of the sorted samples, clamping the
+ * rank to the valid range. */
+static
+double
+at_rank(const double *samples, const size_t n, const double rank)
+{
+    long r = (long)(rank + 0.5);
+
+    if (r < 1)
+        r = 1;
+    else if ((size_t)r > n)
+        r = n;
+    return samples[r - 1];
+}
+
+/* ---------------------------------------------------------------------
+ * Free functions.
+ * --------------------------------------------------------------------- */
+
+void
+atf_bench_config_init(struct atf_bench_config *config)
+{
+    config->m_samples = 15;
+    config->m_warmup = 1;
+    config->m_sample_ns = 10000000;
+    config->m_cpu = -1;
+    config->m_bytes = 0.0;
+}
+
+/** Pins the calling process to a single CPU. */
+atf_error_t
+atf_bench_pin(const int cpu)
+{
+#if defined(__linux__) && defined(SYS_sched_setaffinity)
+    unsigned long mask[1024 / (sizeof(unsigned long) * CHAR_BIT)] = { 0 };
+    const size_t bits = sizeof(mask[0]) * CHAR_BIT;
+
+    if (cpu < 0 || (size_t)cpu >= sizeof(mask) * CHAR_BIT)
+        return atf_error_new_fmt("bench", "Invalid CPU number %d", cpu);
+
+    mask[cpu / bits] = 1UL << (cpu % bits);
+    if (syscall(SYS_sched_setaffinity, 0, sizeof(mask), mask) == -1)
+        return atf_libc_error(errno, "Cannot pin to CPU %d", cpu);
+    return atf_no_error();
+#else
+    return atf_error_new_fmt("bench", "Cannot pin to CPU %d: not supported "
+                             "on this platform", cpu);
+#endif
+}
+
+/** Takes timing samples of a function.
+ *
+ * After pinning the process if requested, the number of iterations per
+ * sample is calibrated so that every sample lasts for the configured
+ * time.  Then the function is run for the configured number of warm-up
+ * samples, whose times are discarded, and for the measured samples,
+ * whose times per iteration are stored in the given array. */
+atf_error_t
+atf_bench_sample(atf_bench_func_t func, void *data,
+                 const struct atf_bench_config *config, double *samples,
+                 size_t *iterations)
+{
+    atf_error_t err;
+    size_t i, n;
+
+    PRE(config->m_samples > 0);
+
+    if (config->m_cpu != -1) {
+        err = atf_bench_pin(config->m_cpu);
+        if (atf_is_error(err))
+            return err;
+    }
+
+    n = calibrate(func, data, config->m_sample_ns);
+    for (i = 0; i < config->m_warmup; i++)
+        (void)time_iterations(func, data, n);
+    for (i = 0; i < config->m_samples; i++)
+        samples[i] = (double)time_iterations(func, data, n) / n;
+
+    *iterations = n;
+    return atf_no_error();
+}
+
+/** Runs a benchmark body and summarizes its samples. */
+atf_error_t
+atf_bench_run(const atf_tc_t *tc, atf_tc_bench_t func,
+              const struct atf_bench_config *config,
+              struct atf_bench_result *result)
+{
+    struct run_data rd;
+    atf_error_t err;
+    double *samples;
+    size_t n;
+
+    PRE(config->m_samples > 0);
+
+    samples = malloc(config->m_samples * sizeof(*samples));
+    if (samples == NULL)
+        return atf_no_memory_error();
+
+    rd.m_tc = tc;
+    rd.m_func = func;
+    err = atf_bench_sample(run_body, &rd, config, samples, &n);
+    if (!atf_is_error(err)) {
+        result->m_iterations = n;
+        result->m_cpu = config->m_cpu;
+        result->m_bytes = config->m_bytes;
+        atf_bench_summarize(samples, config->m_samples, result);
+    }
+
+    free(samples);
+    return err;
+}
+
+/** Computes the statistics of a set of samples, sorting them.
+ *
+ * The confidence interval is the distribution-free 95% interval of the
+ * median, given by the order statistics around it, because benchmark
+ * timings are rarely normally distributed. */
+void
+atf_bench_summarize(double *samples, const size_t n,
+                    struct atf_bench_result *result)
+{
+    const double half_width = 1.96 * square_root(n) / 2.0;
+    double sum;
+    size_t i;
+
+    PRE(n > 0);
+
+    qsort(samples, n, sizeof(*samples), compare_doubles);
+
+    sum = 0.0;
+    for (i = 0; i < n; i++)
+        sum += samples[i];
+
+    result->m_samples = n;
+    if (n % 2 == 1)
+        result->m_median = samples[n / 2];
+    else
+        result->m_median = (samples[n / 2 - 1] + samples[n / 2]) / 2.0;
+    result->m_ci_low = at_rank(samples, n, n / 2.0 - half_width);
+    result->m_ci_high = at_rank(samples, n, 1.0 + n / 2.0 + half_width);
+    result->m_mean = sum / n;
+    result->m_min = samples[0];
+    result->m_max = samples[n - 1];
+}
+
+/** Appends the results of a benchmark to a string as a JSON object.
+ *
+ * Times are in nanoseconds per iteration.  The throughput is derived from
+ * the median, and is given in bytes per second too if the number of
+ * bytes processed by each iteration is known. */
+atf_error_t
+atf_bench_format(const struct atf_bench_result *result, atf_dynstr_t *dest)
+{
+    atf_error_t err;
+
+    err = atf_dynstr_append_fmt(dest, "{\"iterations\":%zu,\"samples\":%zu,"
+        "\"ns_per_op\":%.3f,\"ci95_low_ns\":%.3f,\"ci95_high_ns\":%.3f,"
+        "\"mean_ns\":%.3f,\"min_ns\":%.3f,\"max_ns\":%.3f",
+        result->m_iterations, result->m_samples, result->m_median,
+        result->m_ci_low, result->m_ci_high, result->m_mean, result->m_min,
+        result->m_max);
+    if (atf_is_error(err))
+        return err;
+
+    if (result->m_median > 0.0) {
+        const double ops = 1e9 / result->m_median;
+
+        err = atf_dynstr_append_fmt(dest, ",\"ops_per_sec\":%.1f", ops);
+        if (!atf_is_error(err) && result->m_bytes > 0.0)
+            err = atf_dynstr_append_fmt(dest, ",\"bytes_per_sec\":%.1f",
+                                        ops * result->m_bytes);
+    } else {
+        err = atf_dynstr_append_fmt(dest, ",\"ops_per_sec\":null");
+    }
+    if (atf_is_error(err))
+        return err;
+
+    if (result->m_cpu != -1)
+        err = atf_dynstr_append_fmt(dest, ",\"cpu\":%d}", result->m_cpu);
+    else
+        err = atf_dynstr_append_fmt(dest, ",\"cpu\":null}");
+    return err;
+}
@@ -0,0 +1,78 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#if !defined(ATF_C_DETAIL_BENCH_H)
+#define ATF_C_DETAIL_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atf-c/error_fwd.h>
+#include <atf-c/tc.h>
+
+struct atf_dynstr;
+
+/* ---------------------------------------------------------------------
+ * Benchmark test cases.
+ * --------------------------------------------------------------------- */
+
+typedef void (*atf_bench_func_t)(void *, const size_t);
+
+struct atf_bench_config {
+    size_t m_samples;
+    size_t m_warmup;
+    uint64_t m_sample_ns;
+    int m_cpu;
+    double m_bytes;
+};
+
+struct atf_bench_result {
+    size_t m_iterations;
+    size_t m_samples;
+    int m_cpu;
+    double m_bytes;
+
+    /* In nanoseconds per iteration. */
+    double m_median;
+    double m_ci_low;
+    double m_ci_high;
+    double m_mean;
+    double m_min;
+    double m_max;
+};
+
+void atf_bench_config_init(struct atf_bench_config *);
+atf_error_t atf_bench_pin(const int);
+atf_error_t atf_bench_sample(atf_bench_func_t, void *,
+                             const struct atf_bench_config *, double *,
+                             size_t *);
+atf_error_t atf_bench_run(const atf_tc_t *, atf_tc_bench_t,
+                          const struct atf_bench_config *,
+                          struct atf_bench_result *);
+void atf_bench_summarize(double *, const size_t, struct atf_bench_result *);
+atf_error_t atf_bench_format(const struct atf_bench_result *,
+                             struct atf_dynstr *);
+
+#endif /* !defined(ATF_C_DETAIL_BENCH_H) */
@@ -0,0 +1,189 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/test_helpers.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static size_t calls;
+static size_t last_iterations;
+
+static
+void
+count_body(const atf_tc_t *tc ATF_DEFS_ATTRIBUTE_UNUSED, const size_t n)
+{
+    volatile size_t sum = 0;
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        sum += i;
+    calls++;
+    last_iterations = n;
+}
+
+/* ---------------------------------------------------------------------
+ * Test cases.
+ * --------------------------------------------------------------------- */
+
+ATF_TC_WITHOUT_HEAD(summarize__odd);
+ATF_TC_BODY(summarize__odd, tc)
+{
+    double samples[] = { 15, 3, 9, 1, 12, 7, 5, 14, 2, 8, 11, 4, 13, 6, 10 };
+    struct atf_bench_result result;
+
+    atf_bench_summarize(samples, 15, &result);
+    ATF_REQUIRE_EQ(15, result.m_samples);
+    ATF_REQUIRE_EQ(8.0, result.m_median);
+    ATF_REQUIRE_EQ(4.0, result.m_ci_low);
+    ATF_REQUIRE_EQ(12.0, result.m_ci_high);
+    ATF_REQUIRE_EQ(8.0, result.m_mean);
+    ATF_REQUIRE_EQ(1.0, result.m_min);
+    ATF_REQUIRE_EQ(15.0, result.m_max);
+}
+
+ATF_TC_WITHOUT_HEAD(summarize__even);
+ATF_TC_BODY(summarize__even, tc)
+{
+    double samples[] = { 4, 1, 3, 2 };
+    struct atf_bench_result result;
+
+    atf_bench_summarize(samples, 4, &result);
+    ATF_REQUIRE_EQ(2.5, result.m_median);
+    ATF_REQUIRE_EQ(1.0, result.m_ci_low);
+    ATF_REQUIRE_EQ(4.0, result.m_ci_high);
+    ATF_REQUIRE_EQ(2.5, result.m_mean);
+}
+
+ATF_TC_WITHOUT_HEAD(summarize__one);
+ATF_TC_BODY(summarize__one, tc)
+{
+    double samples[] = { 7 };
+    struct atf_bench_result result;
+
+    atf_bench_summarize(samples, 1, &result);
+    ATF_REQUIRE_EQ(7.0, result.m_median);
+    ATF_REQUIRE_EQ(7.0, result.m_ci_low);
+    ATF_REQUIRE_EQ(7.0, result.m_ci_high);
+}
+
+ATF_TC_WITHOUT_HEAD(format);
+ATF_TC_BODY(format, tc)
+{
+    double samples[] = { 2, 4, 3 };
+    struct atf_bench_result result;
+    atf_dynstr_t str;
+
+    result.m_iterations = 1000;
+    result.m_cpu = -1;
+    result.m_bytes = 0.0;
+    atf_bench_summarize(samples, 3, &result);
+
+    RE(atf_dynstr_init(&str));
+    RE(atf_bench_format(&result, &str));
+    ATF_REQUIRE_STREQ("{\"iterations\":1000,\"samples\":3,"
+        "\"ns_per_op\":3.000,\"ci95_low_ns\":2.000,\"ci95_high_ns\":4.000,"
+        "\"mean_ns\":3.000,\"min_ns\":2.000,\"max_ns\":4.000,"
+        "\"ops_per_sec\":333333333.3,\"cpu\":null}",
+        atf_dynstr_cstring(&str));
+    atf_dynstr_fini(&str);
+
+    result.m_cpu = 2;
+    result.m_bytes = 3.0;
+    RE(atf_dynstr_init(&str));
+    RE(atf_bench_format(&result, &str));
+    ATF_REQUIRE(atf_utils_grep_string(",\"ops_per_sec\":333333333.3,"
+        "\"bytes_per_sec\":1000000000.0,\"cpu\":2}$",
+        atf_dynstr_cstring(&str)));
+    atf_dynstr_fini(&str);
+}
+
+ATF_TC_WITHOUT_HEAD(run);
+ATF_TC_BODY(run, tc)
+{
+    struct atf_bench_config config;
+    struct atf_bench_result result;
+    size_t calibration_calls;
+
+    atf_bench_config_init(&config);
+    config.m_samples = 5;
+    config.m_warmup = 2;
+    config.m_sample_ns = 1000000;
+
+    calls = 0;
+    RE(atf_bench_run(tc, count_body, &config, &result));
+    printf("Made %zu calls with %zu iterations\n", calls,
+           result.m_iterations);
+
+    calibration_calls = calls - config.m_warmup - config.m_samples;
+    ATF_REQUIRE(calibration_calls > 1);
+    ATF_REQUIRE(result.m_iterations > 1);
+    ATF_REQUIRE_EQ(result.m_iterations, last_iterations);
+    ATF_REQUIRE_EQ(5, result.m_samples);
+    ATF_REQUIRE(result.m_min <= result.m_ci_low);
+    ATF_REQUIRE(result.m_ci_low <= result.m_median);
+    ATF_REQUIRE(result.m_median <= result.m_ci_high);
+    ATF_REQUIRE(result.m_ci_high <= result.m_max);
+}
+
+ATF_TC_WITHOUT_HEAD(pin__invalid);
+ATF_TC_BODY(pin__invalid, tc)
+{
+    atf_error_t err;
+
+    err = atf_bench_pin(-1);
+    ATF_REQUIRE(atf_is_error(err));
+    atf_error_free(err);
+
+    err = atf_bench_pin(1 << 20);
+    ATF_REQUIRE(atf_is_error(err));
+    atf_error_free(err);
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    ATF_TP_ADD_TC(tp, summarize__odd);
+    ATF_TP_ADD_TC(tp, summarize__even);
+    ATF_TP_ADD_TC(tp, summarize__one);
+    ATF_TP_ADD_TC(tp, format);
+    ATF_TP_ADD_TC(tp, run);
+    ATF_TP_ADD_TC(tp, pin__invalid);
+
+    return atf_no_error();
+}
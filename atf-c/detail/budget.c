@@ -0,0 +1,293 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/budget.h"
+
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "atf-c/defs.h"
+#include "atf-c/detail/alloc.h"
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/sanity.h"
+#include "atf-c/detail/text.h"
+#include "atf-c/error.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static atf_error_t append_overrun(atf_dynstr_t *, const char *, ...)
+    ATF_DEFS_ATTRIBUTE_FORMAT_PRINTF(2, 3);
+
+static
+uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+        return 0;
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static
+double
+timeval_seconds(const struct timeval *tv)
+{
+    return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+/* Gets the CPU time consumed by the process and its waited-for children,
+ * in seconds, and their peak resident set size, in bytes. */
+static
+void
+get_usage(double *cpu, int64_t *rss)
+{
+    struct rusage self, children;
+    long maxrss;
+
+    if (getrusage(RUSAGE_SELF, &self) == -1)
+        memset(&self, 0, sizeof(self));
+    if (getrusage(RUSAGE_CHILDREN, &children) == -1)
+        memset(&children, 0, sizeof(children));
+
+    *cpu = timeval_seconds(&self.ru_utime) + timeval_seconds(&self.ru_stime) +
+        timeval_seconds(&children.ru_utime) +
+        timeval_seconds(&children.ru_stime);
+
+    maxrss = self.ru_maxrss > children.ru_maxrss ? self.ru_maxrss :
+        children.ru_maxrss;
+#if defined(__APPLE__)
+    *rss = maxrss;
+#else
+    *rss = (int64_t)maxrss * 1024;
+#endif
+}
+
+static
+atf_error_t
+parse_seconds(const char *str, double *value)
+{
+    char *endptr;
+    double tmp;
+
+    errno = 0;
+    tmp = strtod(str, &endptr);
+    if (str[0] == '\0' || *endptr != '\0' || errno != 0 ||
+        !(tmp >= 0.0 && tmp < 1e9))
+        return atf_error_new_fmt("budget", "'%s' is not a valid number of "
+                                 "seconds", str);
+    *value = tmp;
+    return atf_no_error();
+}
+
+/* Parses a count, which can carry a K, M, G or T suffix to multiply it by
+ * the corresponding power of 1024 as in require.memory. */
+static
+atf_error_t
+parse_count(const char *str, int64_t *value)
+{
+    atf_error_t err;
+    char number[32];
+    size_t length;
+    int shift;
+    long tmp;
+
+    length = strlen(str);
+    if (length == 0 || length >= sizeof(number))
+        return atf_error_new_fmt("budget", "'%s' is not a valid count", str);
+
+    switch (str[length - 1]) {
+    case 'k': case 'K': shift = 10; break;
+    case 'm': case 'M': shift = 20; break;
+    case 'g': case 'G': shift = 30; break;
+    case 't': case 'T': shift = 40; break;
+    default: shift = 0;
+    }
+    strcpy(number, str);
+    if (shift != 0)
+        number[length - 1] = '\0';
+
+    err = atf_text_to_long(number, &tmp);
+    if (atf_is_error(err)) {
+        atf_error_free(err);
+        return atf_error_new_fmt("budget", "'%s' is not a valid count", str);
+    }
+    if (tmp < 0 || tmp > (INT64_MAX >> shift))
+        return atf_error_new_fmt("budget", "'%s' is out of range", str);
+
+    *value = (int64_t)tmp << shift;
+    return atf_no_error();
+}
+
+static
+atf_error_t
+append_overrun(atf_dynstr_t *reason, const char *fmt, ...)
+{
+    atf_error_t err;
+    va_list ap;
+
+    if (atf_dynstr_length(reason) > 0) {
+        err = atf_dynstr_append_fmt(reason, "; ");
+        if (atf_is_error(err))
+            return err;
+    }
+
+    va_start(ap, fmt);
+    err = atf_dynstr_append_ap(reason, fmt, ap);
+    va_end(ap);
+    return err;
+}
+
+/* ---------------------------------------------------------------------
+ * Constructors/destructors.
+ * --------------------------------------------------------------------- */
+
+void
+atf_budget_init(atf_budget_t *budget)
+{
+    memset(budget, 0, sizeof(*budget));
+    budget->m_cpu = -1.0;
+    budget->m_wall = -1.0;
+    budget->m_rss = -1;
+    budget->m_allocs = -1;
+}
+
+/* ---------------------------------------------------------------------
+ * Modifiers.
+ * --------------------------------------------------------------------- */
+
+/** Sets one of the limits of a budget.
+ *
+ * \param name One of "cpu" or "wall", given in seconds, or "rss" or
+ *     "allocs", given as counts that accept size suffixes.
+ * \param value The textual limit. */
+atf_error_t
+atf_budget_set(atf_budget_t *budget, const char *name, const char *value)
+{
+    if (strcmp(name, "cpu") == 0)
+        return parse_seconds(value, &budget->m_cpu);
+    else if (strcmp(name, "wall") == 0)
+        return parse_seconds(value, &budget->m_wall);
+    else if (strcmp(name, "rss") == 0)
+        return parse_count(value, &budget->m_rss);
+    else if (strcmp(name, "allocs") == 0)
+        return parse_count(value, &budget->m_allocs);
+    else
+        return atf_error_new_fmt("budget", "Unknown budget '%s'", name);
+}
+
+void
+atf_budget_start(atf_budget_t *budget)
+{
+    int64_t rss;
+
+    PRE(!budget->m_running);
+
+    budget->m_running = true;
+    (void)atf_alloc_count(&budget->m_start_allocs);
+    get_usage(&budget->m_start_cpu, &rss);
+    budget->m_start_wall = now_ns();
+}
+
+/** Records the resources used since the budget was started.
+ *
+ * Calling this more than once has no effect, so that the measurements can
+ * be stopped both when the body returns and when it terminates the test
+ * case on its own.  The peak RSS is that of the whole process, as the
+ * system does not track it over intervals. */
+void
+atf_budget_stop(atf_budget_t *budget)
+{
+    const uint64_t wall = now_ns();
+    size_t allocs;
+    double cpu;
+
+    if (!budget->m_running)
+        return;
+    budget->m_running = false;
+
+    get_usage(&cpu, &budget->m_used_rss);
+    budget->m_used_cpu = cpu - budget->m_start_cpu;
+    budget->m_used_wall = (wall - budget->m_start_wall) / 1e9;
+    budget->m_allocs_valid = atf_alloc_count(&allocs);
+    budget->m_used_allocs = allocs - budget->m_start_allocs;
+}
+
+/* ---------------------------------------------------------------------
+ * Getters.
+ * --------------------------------------------------------------------- */
+
+bool
+atf_budget_is_set(const atf_budget_t *budget)
+{
+    return budget->m_cpu >= 0.0 || budget->m_wall >= 0.0 ||
+        budget->m_rss >= 0 || budget->m_allocs >= 0;
+}
+
+/** Describes the limits of a stopped budget that were exceeded.
+ *
+ * \param reason String to which to append the description of every
+ *     overrun, separated by semicolons.  Left untouched if the budget was
+ *     met.  The allocations limit is not enforced if allocations cannot be
+ *     counted in this platform. */
+atf_error_t
+atf_budget_check(const atf_budget_t *budget, atf_dynstr_t *reason)
+{
+    atf_error_t err = atf_no_error();
+
+    PRE(!budget->m_running);
+
+    if (budget->m_cpu >= 0.0 && budget->m_used_cpu > budget->m_cpu)
+        err = append_overrun(reason, "CPU time of %.3fs exceeds the budget "
+                             "of %gs (X-budget.cpu)", budget->m_used_cpu,
+                             budget->m_cpu);
+    if (!atf_is_error(err) && budget->m_wall >= 0.0 &&
+        budget->m_used_wall > budget->m_wall)
+        err = append_overrun(reason, "Wall time of %.3fs exceeds the budget "
+                             "of %gs (X-budget.wall)", budget->m_used_wall,
+                             budget->m_wall);
+    if (!atf_is_error(err) && budget->m_rss >= 0 &&
+        budget->m_used_rss > budget->m_rss)
+        err = append_overrun(reason, "Peak RSS of %lld bytes exceeds the "
+                             "budget of %lld bytes (X-budget.rss)",
+                             (long long)budget->m_used_rss,
+                             (long long)budget->m_rss);
+    if (!atf_is_error(err) && budget->m_allocs >= 0 &&
+        budget->m_allocs_valid && budget->m_used_allocs > budget->m_allocs)
+        err = append_overrun(reason, "%lld heap allocations exceed the "
+                             "budget of %lld (X-budget.allocs)",
+                             (long long)budget->m_used_allocs,
+                             (long long)budget->m_allocs);
+    return err;
+}
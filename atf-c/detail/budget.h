@@ -0,0 +1,73 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#if !defined(ATF_C_DETAIL_BUDGET_H)
+#define ATF_C_DETAIL_BUDGET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atf-c/error_fwd.h>
+
+struct atf_dynstr;
+
+/* ---------------------------------------------------------------------
+ * The "atf_budget" type.
+ * --------------------------------------------------------------------- */
+
+/* Limits are negative when unset. */
+struct atf_budget {
+    double m_cpu;
+    double m_wall;
+    int64_t m_rss;
+    int64_t m_allocs;
+
+    bool m_running;
+    double m_start_cpu;
+    uint64_t m_start_wall;
+    size_t m_start_allocs;
+
+    double m_used_cpu;
+    double m_used_wall;
+    int64_t m_used_rss;
+    int64_t m_used_allocs;
+    bool m_allocs_valid;
+};
+typedef struct atf_budget atf_budget_t;
+
+/* Constructors/destructors. */
+void atf_budget_init(atf_budget_t *);
+
+/* Modifiers. */
+atf_error_t atf_budget_set(atf_budget_t *, const char *, const char *);
+void atf_budget_start(atf_budget_t *);
+void atf_budget_stop(atf_budget_t *);
+
+/* Getters. */
+bool atf_budget_is_set(const atf_budget_t *);
+atf_error_t atf_budget_check(const atf_budget_t *, struct atf_dynstr *);
+
+#endif /* !defined(ATF_C_DETAIL_BUDGET_H) */
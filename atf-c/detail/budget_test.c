@@ -0,0 +1,199 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/budget.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/alloc.h"
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/test_helpers.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static
+void
+check_invalid(const char *name, const char *value)
+{
+    atf_budget_t budget;
+    atf_error_t err;
+
+    atf_budget_init(&budget);
+    err = atf_budget_set(&budget, name, value);
+    ATF_REQUIRE_MSG(atf_is_error(err), "%s accepted '%s'", name, value);
+    ATF_REQUIRE(atf_error_is(err, "budget"));
+    atf_error_free(err);
+    ATF_REQUIRE(!atf_budget_is_set(&budget));
+}
+
+/* Checks a budget against fake usage values, which the caller must set
+ * after stopping it. */
+static
+void
+check_reason(const atf_budget_t *budget, const char *exp_reason)
+{
+    atf_dynstr_t reason;
+
+    RE(atf_dynstr_init(&reason));
+    RE(atf_budget_check(budget, &reason));
+    ATF_REQUIRE_STREQ(exp_reason, atf_dynstr_cstring(&reason));
+    atf_dynstr_fini(&reason);
+}
+
+/* ---------------------------------------------------------------------
+ * Test cases.
+ * --------------------------------------------------------------------- */
+
+ATF_TC_WITHOUT_HEAD(set);
+ATF_TC_BODY(set, tc)
+{
+    atf_budget_t budget;
+
+    atf_budget_init(&budget);
+    ATF_REQUIRE(!atf_budget_is_set(&budget));
+
+    RE(atf_budget_set(&budget, "cpu", "1.5"));
+    ATF_REQUIRE(atf_budget_is_set(&budget));
+    ATF_REQUIRE_EQ(1.5, budget.m_cpu);
+    RE(atf_budget_set(&budget, "wall", "30"));
+    ATF_REQUIRE_EQ(30.0, budget.m_wall);
+    RE(atf_budget_set(&budget, "rss", "64M"));
+    ATF_REQUIRE_EQ(64 * 1024 * 1024, budget.m_rss);
+    RE(atf_budget_set(&budget, "allocs", "0"));
+    ATF_REQUIRE_EQ(0, budget.m_allocs);
+    RE(atf_budget_set(&budget, "allocs", "2k"));
+    ATF_REQUIRE_EQ(2048, budget.m_allocs);
+}
+
+ATF_TC_WITHOUT_HEAD(set__invalid);
+ATF_TC_BODY(set__invalid, tc)
+{
+    check_invalid("cpu", "");
+    check_invalid("cpu", "abc");
+    check_invalid("cpu", "-1");
+    check_invalid("cpu", "1s");
+    check_invalid("wall", "nan");
+    check_invalid("rss", "");
+    check_invalid("rss", "M");
+    check_invalid("rss", "10X");
+    check_invalid("rss", "-5");
+    check_invalid("allocs", "1.5");
+    check_invalid("allocs", "99999999999T");
+    check_invalid("disk", "1");
+}
+
+ATF_TC_WITHOUT_HEAD(check);
+ATF_TC_BODY(check, tc)
+{
+    atf_budget_t budget;
+
+    atf_budget_init(&budget);
+    RE(atf_budget_set(&budget, "cpu", "0.5"));
+    RE(atf_budget_set(&budget, "wall", "1"));
+    RE(atf_budget_set(&budget, "rss", "1K"));
+    RE(atf_budget_set(&budget, "allocs", "10"));
+
+    budget.m_used_cpu = 0.5;
+    budget.m_used_wall = 1.0;
+    budget.m_used_rss = 1024;
+    budget.m_used_allocs = 10;
+    budget.m_allocs_valid = true;
+    check_reason(&budget, "");
+
+    budget.m_used_cpu = 0.75;
+    check_reason(&budget, "CPU time of 0.750s exceeds the budget of 0.5s "
+                 "(X-budget.cpu)");
+
+    budget.m_used_wall = 2.5;
+    budget.m_used_rss = 4096;
+    budget.m_used_allocs = 11;
+    check_reason(&budget, "CPU time of 0.750s exceeds the budget of 0.5s "
+                 "(X-budget.cpu); Wall time of 2.500s exceeds the budget of "
+                 "1s (X-budget.wall); Peak RSS of 4096 bytes exceeds the "
+                 "budget of 1024 bytes (X-budget.rss); 11 heap allocations "
+                 "exceed the budget of 10 (X-budget.allocs)");
+
+    budget.m_used_cpu = 0.0;
+    budget.m_used_wall = 0.0;
+    budget.m_used_rss = 0;
+    budget.m_allocs_valid = false;
+    check_reason(&budget, "");
+}
+
+ATF_TC_WITHOUT_HEAD(start_stop);
+ATF_TC_BODY(start_stop, tc)
+{
+    const clock_t start = clock();
+    volatile unsigned long count = 0;
+    atf_budget_t budget;
+    size_t allocs;
+    int i;
+
+    atf_budget_init(&budget);
+    atf_budget_start(&budget);
+    while (clock() - start < CLOCKS_PER_SEC / 10)
+        count++;
+    for (i = 0; i < 5; i++) {
+        void *volatile p = malloc(16);
+        free(p);
+    }
+    atf_budget_stop(&budget);
+
+    printf("Used %f CPU seconds, %f wall seconds, %lld RSS bytes, %lld "
+           "allocations\n", budget.m_used_cpu, budget.m_used_wall,
+           (long long)budget.m_used_rss, (long long)budget.m_used_allocs);
+    ATF_REQUIRE(budget.m_used_cpu >= 0.05);
+    ATF_REQUIRE(budget.m_used_wall >= budget.m_used_cpu * 0.5);
+    ATF_REQUIRE(budget.m_used_rss > 0);
+    ATF_REQUIRE_EQ(atf_alloc_count(&allocs), budget.m_allocs_valid);
+    if (budget.m_allocs_valid)
+        ATF_REQUIRE(budget.m_used_allocs >= 5);
+    else
+        ATF_REQUIRE_EQ(0, budget.m_used_allocs);
+
+    budget.m_used_cpu = -1.0;
+    atf_budget_stop(&budget);
+    ATF_REQUIRE_EQ(-1.0, budget.m_used_cpu);
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    ATF_TP_ADD_TC(tp, set);
+    ATF_TP_ADD_TC(tp, set__invalid);
+    ATF_TP_ADD_TC(tp, check);
+    ATF_TP_ADD_TC(tp, start_stop);
+
+    return atf_no_error();
+}
@@ -0,0 +1,422 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/cache.h"
+
+#if defined(HAVE_CONFIG_H)
+#include "config.h"
+#endif
+
+#include <sys/types.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/env.h"
+#include "atf-c/detail/sanity.h"
+#include "atf-c/detail/tree.h"
+#include "atf-c/detail/user.h"
+#include "atf-c/error.h"
+
+/* ---------------------------------------------------------------------
+ * Cache entries.
+ * --------------------------------------------------------------------- */
+
+/* Every fixture lives in a directory of the cache named after a hash of
+ * the key and the inputs it was generated from.  Next to it, the file
+ * with the .key extension records the key and inputs themselves so that
+ * hash collisions are detected instead of silently returning the wrong
+ * fixture, and the file with the .lock extension serializes the
+ * processes that want to generate the same fixture.
+ *
+ * Fixtures are generated in a directory with the .new extension and
+ * renamed into place once complete, so the existence of the final
+ * directory is enough to know that it can be used without locking.  A
+ * .new directory left behind by a generator that crashed is removed by
+ * the next process that holds the lock. */
+
+/* Computes the 64-bit FNV-1a hash of the key and the inputs, including
+ * their terminating NUL characters so that moving characters from one
+ * to the other yields a different hash. */
+static
+uint64_t
+hash_entry(const atf_dynstr_t *id)
+{
+    const unsigned char *iter = (const unsigned char *)atf_dynstr_cstring(id);
+    const unsigned char *end = iter + atf_dynstr_length(id);
+    uint64_t hash = UINT64_C(14695981039346656037);
+
+    for (; iter != end; iter++) {
+        hash ^= *iter;
+        hash *= UINT64_C(1099511628211);
+    }
+    return hash;
+}
+
+static
+atf_error_t
+write_key(const char *path, const atf_dynstr_t *id)
+{
+    atf_error_t err;
+    const char *data = atf_dynstr_cstring(id);
+    size_t remaining = atf_dynstr_length(id);
+    int fd;
+
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, 0644);
+    if (fd == -1)
+        return atf_libc_error(errno, "Cannot create %s", path);
+
+    err = atf_no_error();
+    while (remaining > 0) {
+        const ssize_t n = write(fd, data, remaining);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            err = atf_libc_error(errno, "Cannot write to %s", path);
+            break;
+        }
+        data += n;
+        remaining -= n;
+    }
+    close(fd);
+    return err;
+}
+
+static
+atf_error_t
+check_key(const char *path, const atf_dynstr_t *id, const char *entry)
+{
+    atf_error_t err;
+    const char *expected = atf_dynstr_cstring(id);
+    size_t remaining = atf_dynstr_length(id);
+    char buf[4096];
+    ssize_t n;
+    int fd;
+
+    fd = open(path, O_RDONLY | O_NOFOLLOW);
+    if (fd == -1)
+        return atf_libc_error(errno, "Cannot open %s", path);
+
+    err = atf_no_error();
+    while ((n = read(fd, buf, sizeof(buf))) != 0) {
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            err = atf_libc_error(errno, "Cannot read %s", path);
+            goto out;
+        }
+        if ((size_t)n > remaining || memcmp(buf, expected, n) != 0)
+            break;
+        expected += n;
+        remaining -= n;
+    }
+    if (n != 0 || remaining != 0)
+        err = atf_error_new_fmt("cache", "The cached fixture %s was "
+                                "generated from a different key", entry);
+
+out:
+    close(fd);
+    return err;
+}
+
+/* Creates the cache directory if it does not exist yet and ensures that
+ * nobody else can tamper with it.  The default location is in a world
+ * writable directory, so another user could have created it first to
+ * plant fixtures or symbolic links to our files. */
+static
+atf_error_t
+prepare_dir(const char *dir)
+{
+    struct stat sb;
+
+    if (mkdir(dir, 0700) == -1 && errno != EEXIST)
+        return atf_libc_error(errno, "Cannot create cache directory %s", dir);
+
+    if (lstat(dir, &sb) == -1)
+        return atf_libc_error(errno, "Cannot stat cache directory %s", dir);
+    if (!S_ISDIR(sb.st_mode) || sb.st_uid != atf_user_euid() ||
+        (sb.st_mode & (S_IWGRP | S_IWOTH)) != 0)
+        return atf_error_new_fmt("cache", "Refusing to use the cache "
+                                 "directory %s: it must be a directory "
+                                 "owned by the current user and not "
+                                 "writable by others", dir);
+    return atf_no_error();
+}
+
+/* Looks for a complete entry in the cache and, if found, validates that
+ * it was generated for the given identifier. */
+static
+atf_error_t
+lookup(const atf_fs_path_t *entry, const char *keyfile,
+       const atf_dynstr_t *id, bool *found)
+{
+    struct stat sb;
+
+    if (stat(atf_fs_path_cstring(entry), &sb) == -1) {
+        if (errno != ENOENT)
+            return atf_libc_error(errno, "Cannot stat %s",
+                                  atf_fs_path_cstring(entry));
+        *found = false;
+        return atf_no_error();
+    }
+
+    *found = true;
+    return check_key(keyfile, id, atf_fs_path_cstring(entry));
+}
+
+static
+atf_error_t
+lock_entry(const atf_fs_path_t *entry, int *fdp)
+{
+    atf_error_t err;
+    atf_dynstr_t lockfile;
+    int fd;
+
+    err = atf_dynstr_init_fmt(&lockfile, "%s.lock",
+                              atf_fs_path_cstring(entry));
+    if (atf_is_error(err))
+        return err;
+
+    fd = open(atf_dynstr_cstring(&lockfile), O_RDWR | O_CREAT | O_NOFOLLOW,
+              0644);
+    if (fd == -1) {
+        err = atf_libc_error(errno, "Cannot open %s",
+                             atf_dynstr_cstring(&lockfile));
+        goto out;
+    }
+
+    while (flock(fd, LOCK_EX) == -1) {
+        if (errno != EINTR) {
+            err = atf_libc_error(errno, "Cannot lock %s",
+                                 atf_dynstr_cstring(&lockfile));
+            close(fd);
+            goto out;
+        }
+    }
+    *fdp = fd;
+
+out:
+    atf_dynstr_fini(&lockfile);
+    return err;
+}
+
+/* Removes the temporary directory of a failed generation and returns the
+ * error that made it fail.  Only one error can be raised at a time, so the
+ * original one is released before the removal and raised again later. */
+static
+atf_error_t
+discard_temp(const atf_fs_path_t *temp, atf_error_t err)
+{
+    const char *type = err->m_type;
+    char buf[1024];
+    atf_error_t err2;
+    int code = 0;
+
+    if (atf_error_is(err, "libc")) {
+        code = atf_libc_error_code(err);
+        snprintf(buf, sizeof(buf), "%s", atf_libc_error_msg(err));
+    } else
+        atf_error_format(err, buf, sizeof(buf));
+    atf_error_free(err);
+
+    /* The generated files may have lost their write permissions already,
+     * and these are needed to remove them. */
+    err2 = atf_tree_chmod(atf_fs_path_cstring(temp), S_IWUSR, 0);
+    if (atf_is_error(err2))
+        atf_error_free(err2);
+    err2 = atf_fs_rmtree(temp);
+    if (atf_is_error(err2))
+        atf_error_free(err2);
+
+    if (code != 0)
+        return atf_libc_error(code, "%s", buf);
+    else if (strcmp(type, "no_memory") == 0)
+        return atf_no_memory_error();
+    else
+        return atf_error_new_fmt(type, "%s", buf);
+}
+
+/* Generates a new entry.  Must be called with the lock of the entry
+ * held. */
+static
+atf_error_t
+generate(const atf_fs_path_t *entry, const char *keyfile,
+         const atf_dynstr_t *id, const char *inputs,
+         atf_cache_generator_t generator, void *data)
+{
+    atf_error_t err;
+    atf_fs_path_t temp;
+    bool exists;
+
+    err = atf_fs_path_init_fmt(&temp, "%s.new", atf_fs_path_cstring(entry));
+    if (atf_is_error(err))
+        return err;
+
+    err = atf_fs_exists(&temp, &exists);
+    if (!atf_is_error(err) && exists)
+        err = atf_fs_rmtree(&temp);
+    if (atf_is_error(err))
+        goto out;
+
+    if (mkdir(atf_fs_path_cstring(&temp), 0755) == -1) {
+        err = atf_libc_error(errno, "Cannot create %s",
+                             atf_fs_path_cstring(&temp));
+        goto out;
+    }
+
+    err = generator(atf_fs_path_cstring(&temp), inputs, data);
+    if (!atf_is_error(err)) {
+        /* The entry is shared by every test program, so it is made
+         * read-only to keep test cases from modifying it by mistake. */
+        err = atf_tree_chmod(atf_fs_path_cstring(&temp), 0,
+                             S_IWUSR | S_IWGRP | S_IWOTH);
+    }
+    if (!atf_is_error(err))
+        err = write_key(keyfile, id);
+    if (atf_is_error(err)) {
+        err = discard_temp(&temp, err);
+        goto out;
+    }
+
+    if (rename(atf_fs_path_cstring(&temp), atf_fs_path_cstring(entry)) == -1)
+        err = atf_libc_error(errno, "Cannot rename %s to %s",
+                             atf_fs_path_cstring(&temp),
+                             atf_fs_path_cstring(entry));
+
+out:
+    atf_fs_path_fini(&temp);
+    return err;
+}
+
+/* ---------------------------------------------------------------------
+ * Free functions.
+ * --------------------------------------------------------------------- */
+
+/** Computes the location of the cache of fixtures.
+ *
+ * The cache is shared by all the test programs run by the same user, so
+ * it lives outside of the work directories of the test cases: it can be
+ * set through the ATF_CACHE_DIR environment variable and defaults to a
+ * per-user directory in /var/tmp. */
+atf_error_t
+atf_cache_default_dir(atf_fs_path_t *dir)
+{
+    if (atf_env_has("ATF_CACHE_DIR"))
+        return atf_fs_path_init_fmt(dir, "%s", atf_env_get("ATF_CACHE_DIR"));
+    else
+        return atf_fs_path_init_fmt(dir, "/var/tmp/atf-cache-%ld",
+                                    (long)atf_user_euid());
+}
+
+/** Returns the location of a fixture, generating it if not yet cached.
+ *
+ * The fixture is identified by the caller-supplied key, which should
+ * change whenever the generator does, and by the inputs of the
+ * generator.  If several processes request the same missing fixture at
+ * once, only one of them runs the generator and the others wait for it
+ * to finish.  The generator writes the fixture into the directory it
+ * receives, which is renamed afterwards, so it must not record that path
+ * within the fixture.
+ *
+ * On success, 'entry' is initialized to the path of the fixture, whose
+ * write permissions are removed when it is generated. */
+atf_error_t
+atf_cache_fixture(const char *dir, const char *key, const char *inputs,
+                  atf_cache_generator_t generator, void *data,
+                  atf_fs_path_t *entry)
+{
+    atf_error_t err;
+    atf_dynstr_t id, keyfile;
+    bool found;
+    int fd = -1;
+
+    err = atf_dynstr_init(&id);
+    if (atf_is_error(err))
+        return err;
+    err = atf_dynstr_append_mem(&id, key, strlen(key) + 1);
+    if (!atf_is_error(err))
+        err = atf_dynstr_append_mem(&id, inputs, strlen(inputs) + 1);
+    if (atf_is_error(err))
+        goto out_id;
+
+    err = atf_fs_path_init_fmt(entry, "%s/%016" PRIx64, dir, hash_entry(&id));
+    if (atf_is_error(err))
+        goto out_id;
+
+    err = atf_dynstr_init_fmt(&keyfile, "%s.key", atf_fs_path_cstring(entry));
+    if (atf_is_error(err))
+        goto err_entry;
+
+    err = prepare_dir(dir);
+    if (atf_is_error(err))
+        goto out_keyfile;
+
+    err = lookup(entry, atf_dynstr_cstring(&keyfile), &id, &found);
+    if (atf_is_error(err) || found)
+        goto out_keyfile;
+
+    err = lock_entry(entry, &fd);
+    if (atf_is_error(err))
+        goto out_keyfile;
+
+    err = lookup(entry, atf_dynstr_cstring(&keyfile), &id, &found);
+    if (!atf_is_error(err) && !found)
+        err = generate(entry, atf_dynstr_cstring(&keyfile), &id, inputs,
+                       generator, data);
+
+    close(fd);
+out_keyfile:
+    atf_dynstr_fini(&keyfile);
+err_entry:
+    if (atf_is_error(err))
+        atf_fs_path_fini(entry);
+out_id:
+    atf_dynstr_fini(&id);
+    return err;
+}
+
+/** Creates a private copy of a fixture returned by atf_cache_fixture.
+ *
+ * The entries of the cache are read-only, so the owner of the copy is
+ * given write access to all of it. */
+atf_error_t
+atf_cache_clone(const atf_fs_path_t *entry, const char *destination)
+{
+    atf_error_t err;
+
+    err = atf_tree_clone(atf_fs_path_cstring(entry), destination, false);
+    if (!atf_is_error(err))
+        err = atf_tree_chmod(destination, S_IWUSR, 0);
+    return err;
+}
@@ -0,0 +1,390 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/cache.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/test_helpers.h"
+#include "atf-c/error.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+/* Generator that stores its inputs in a file and records every call in
+ * the 'generations' file of the work directory. */
+static
+atf_error_t
+generate_data(const char *dir, const char *inputs,
+              void *data ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+    char path[1024];
+    int fd;
+
+    fd = open("generations", O_WRONLY | O_CREAT | O_APPEND, 0644);
+    ATF_REQUIRE(fd != -1);
+    ATF_REQUIRE(write(fd, "x", 1) == 1);
+    close(fd);
+
+    snprintf(path, sizeof(path), "%s/data", dir);
+    atf_utils_create_file(path, "%s", inputs);
+    return atf_no_error();
+}
+
+static
+atf_error_t
+generate_slowly(const char *dir, const char *inputs, void *data)
+{
+    sleep(1);
+    return generate_data(dir, inputs, data);
+}
+
+static
+atf_error_t
+generate_error(const char *dir, const char *inputs, void *data)
+{
+    RE(generate_data(dir, inputs, data));
+    return atf_error_new_fmt("test", "Generator failed");
+}
+
+static
+void
+cached_data(const char *key, const char *inputs, atf_fs_path_t *path)
+{
+    RE(atf_cache_fixture("cache", key, inputs, generate_data,
+                         NULL, path));
+}
+
+static
+void
+require_generations(const char *expected)
+{
+    if (strlen(expected) == 0)
+        ATF_REQUIRE(!atf_utils_file_exists("generations"));
+    else
+        ATF_REQUIRE(atf_utils_compare_file("generations", expected));
+}
+
+/* ---------------------------------------------------------------------
+ * Test cases for the free functions.
+ * --------------------------------------------------------------------- */
+
+ATF_TC_WITHOUT_HEAD(default_dir);
+ATF_TC_BODY(default_dir, tc)
+{
+    atf_fs_path_t dir;
+
+    ATF_REQUIRE(setenv("ATF_CACHE_DIR", "/some/cache", 1) == 0);
+    RE(atf_cache_default_dir(&dir));
+    ATF_REQUIRE_STREQ("/some/cache", atf_fs_path_cstring(&dir));
+    atf_fs_path_fini(&dir);
+
+    ATF_REQUIRE(unsetenv("ATF_CACHE_DIR") == 0);
+    RE(atf_cache_default_dir(&dir));
+    ATF_REQUIRE(atf_utils_grep_string("^/var/tmp/atf-cache-[0-9]+$",
+                                      atf_fs_path_cstring(&dir)));
+    atf_fs_path_fini(&dir);
+}
+
+ATF_TC(fixture_reuse);
+ATF_TC_HEAD(fixture_reuse, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that a fixture is generated "
+                      "only once");
+}
+ATF_TC_BODY(fixture_reuse, tc)
+{
+    atf_fs_path_t path1, path2;
+    atf_dynstr_t data;
+
+    cached_data("v1", "some inputs", &path1);
+    require_generations("x");
+    cached_data("v1", "some inputs", &path2);
+    require_generations("x");
+
+    ATF_REQUIRE(atf_equal_fs_path_fs_path(&path1, &path2));
+    RE(atf_dynstr_init_fmt(&data, "%s/data", atf_fs_path_cstring(&path1)));
+    ATF_REQUIRE(atf_utils_compare_file(atf_dynstr_cstring(&data),
+                                       "some inputs"));
+    atf_dynstr_fini(&data);
+
+    atf_fs_path_fini(&path2);
+    atf_fs_path_fini(&path1);
+}
+
+ATF_TC(fixture_read_only);
+ATF_TC_HEAD(fixture_read_only, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that fixtures are read-only and "
+                      "that their clones are not");
+}
+ATF_TC_BODY(fixture_read_only, tc)
+{
+    atf_fs_path_t path;
+    atf_dynstr_t data;
+    struct stat sb;
+
+    cached_data("v1", "some inputs", &path);
+    RE(atf_dynstr_init_fmt(&data, "%s/data", atf_fs_path_cstring(&path)));
+    ATF_REQUIRE(stat(atf_fs_path_cstring(&path), &sb) != -1);
+    ATF_REQUIRE_EQ(0, sb.st_mode & 0222);
+    ATF_REQUIRE(stat(atf_dynstr_cstring(&data), &sb) != -1);
+    ATF_REQUIRE_EQ(0, sb.st_mode & 0222);
+    atf_dynstr_fini(&data);
+
+    RE(atf_cache_clone(&path, "copy"));
+    atf_fs_path_fini(&path);
+    ATF_REQUIRE(stat("copy", &sb) != -1);
+    ATF_REQUIRE((sb.st_mode & S_IWUSR) != 0);
+    atf_utils_create_file("copy/data", "modified");
+    atf_utils_create_file("copy/new", "created");
+
+    cached_data("v1", "some inputs", &path);
+    RE(atf_dynstr_init_fmt(&data, "%s/data", atf_fs_path_cstring(&path)));
+    ATF_REQUIRE(atf_utils_compare_file(atf_dynstr_cstring(&data),
+                                       "some inputs"));
+    atf_dynstr_fini(&data);
+    atf_fs_path_fini(&path);
+    require_generations("x");
+}
+
+ATF_TC(fixture_identity);
+ATF_TC_HEAD(fixture_identity, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that fixtures are identified "
+                      "by both their key and their inputs");
+}
+ATF_TC_BODY(fixture_identity, tc)
+{
+    atf_fs_path_t path1, path2, path3, path4;
+
+    cached_data("v1", "inputs", &path1);
+    cached_data("v2", "inputs", &path2);
+    cached_data("v1", "other inputs", &path3);
+    cached_data("v1i", "nputs", &path4);
+    require_generations("xxxx");
+
+    ATF_REQUIRE(!atf_equal_fs_path_fs_path(&path1, &path2));
+    ATF_REQUIRE(!atf_equal_fs_path_fs_path(&path1, &path3));
+    ATF_REQUIRE(!atf_equal_fs_path_fs_path(&path1, &path4));
+    ATF_REQUIRE(!atf_equal_fs_path_fs_path(&path2, &path3));
+
+    atf_fs_path_fini(&path4);
+    atf_fs_path_fini(&path3);
+    atf_fs_path_fini(&path2);
+    atf_fs_path_fini(&path1);
+}
+
+ATF_TC(fixture_concurrent);
+ATF_TC_HEAD(fixture_concurrent, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that concurrent processes wait "
+                      "for a single generation of a fixture");
+}
+ATF_TC_BODY(fixture_concurrent, tc)
+{
+    pid_t pids[4];
+    size_t i;
+
+    for (i = 0; i < sizeof(pids) / sizeof(pids[0]); i++) {
+        pids[i] = atf_utils_fork();
+        if (pids[i] == 0) {
+            atf_fs_path_t path;
+            atf_dynstr_t data;
+
+            RE(atf_cache_fixture("cache", "key", "inputs", generate_slowly,
+                                 NULL, &path));
+            RE(atf_dynstr_init_fmt(&data, "%s/data",
+                                   atf_fs_path_cstring(&path)));
+            if (!atf_utils_compare_file(atf_dynstr_cstring(&data), "inputs"))
+                exit(EXIT_FAILURE);
+            exit(EXIT_SUCCESS);
+        }
+    }
+    for (i = 0; i < sizeof(pids) / sizeof(pids[0]); i++)
+        atf_utils_wait(pids[i], EXIT_SUCCESS, "", "");
+
+    require_generations("x");
+}
+
+ATF_TC(fixture_generator_error);
+ATF_TC_HEAD(fixture_generator_error, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that a failed generation does "
+                      "not leave a fixture behind");
+}
+ATF_TC_BODY(fixture_generator_error, tc)
+{
+    atf_fs_path_t path;
+    atf_error_t err;
+
+    err = atf_cache_fixture("cache", "key", "inputs", generate_error,
+                            NULL, &path);
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_REQUIRE(atf_error_is(err, "test"));
+    atf_error_free(err);
+    require_generations("x");
+
+    cached_data("key", "inputs", &path);
+    require_generations("xx");
+    atf_fs_path_fini(&path);
+}
+
+ATF_TC(fixture_collision);
+ATF_TC_HEAD(fixture_collision, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that an entry generated for a "
+                      "different key is not returned");
+}
+ATF_TC_BODY(fixture_collision, tc)
+{
+    atf_fs_path_t path;
+    atf_dynstr_t keyfile;
+    atf_error_t err;
+
+    cached_data("key", "inputs", &path);
+    RE(atf_dynstr_init_fmt(&keyfile, "%s.key", atf_fs_path_cstring(&path)));
+    atf_utils_create_file(atf_dynstr_cstring(&keyfile), "other");
+    atf_dynstr_fini(&keyfile);
+    atf_fs_path_fini(&path);
+
+    err = atf_cache_fixture("cache", "key", "inputs", generate_data,
+                            NULL, &path);
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_REQUIRE(atf_error_is(err, "cache"));
+    atf_error_free(err);
+}
+
+ATF_TC(fixture_unsafe_dir);
+ATF_TC_HEAD(fixture_unsafe_dir, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that a cache directory that "
+                      "others could tamper with is rejected");
+}
+ATF_TC_BODY(fixture_unsafe_dir, tc)
+{
+    atf_fs_path_t path;
+    atf_error_t err;
+
+    ATF_REQUIRE(mkdir("cache", 0700) != -1);
+    ATF_REQUIRE(chmod("cache", 0777) != -1);
+    err = atf_cache_fixture("cache", "key", "inputs", generate_data,
+                            NULL, &path);
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_REQUIRE(atf_error_is(err, "cache"));
+    atf_error_free(err);
+
+    ATF_REQUIRE(chmod("cache", 0700) != -1);
+    ATF_REQUIRE(symlink("cache", "link") != -1);
+    err = atf_cache_fixture("link", "key", "inputs", generate_data,
+                            NULL, &path);
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_REQUIRE(atf_error_is(err, "cache"));
+    atf_error_free(err);
+
+    require_generations("");
+}
+
+ATF_TC(fixture_foreign_dir);
+ATF_TC_HEAD(fixture_foreign_dir, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that a cache directory owned "
+                      "by another user is rejected");
+    atf_tc_set_md_var(tc, "require.user", "root");
+}
+ATF_TC_BODY(fixture_foreign_dir, tc)
+{
+    atf_fs_path_t path;
+    atf_error_t err;
+
+    ATF_REQUIRE(mkdir("cache", 0755) != -1);
+    ATF_REQUIRE(chown("cache", 1, 1) != -1);
+    err = atf_cache_fixture("cache", "key", "inputs", generate_data,
+                            NULL, &path);
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_REQUIRE(atf_error_is(err, "cache"));
+    atf_error_free(err);
+    require_generations("");
+}
+
+ATF_TC(fixture_symlinks);
+ATF_TC_HEAD(fixture_symlinks, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that symbolic links planted in "
+                      "the cache are not followed");
+}
+ATF_TC_BODY(fixture_symlinks, tc)
+{
+    atf_fs_path_t path;
+    atf_dynstr_t keyfile;
+    atf_error_t err;
+
+    cached_data("key", "inputs", &path);
+    RE(atf_dynstr_init_fmt(&keyfile, "%s.key", atf_fs_path_cstring(&path)));
+    RE(atf_fs_rmtree(&path));
+    ATF_REQUIRE(unlink(atf_dynstr_cstring(&keyfile)) != -1);
+    atf_utils_create_file("victim", "precious\n");
+    ATF_REQUIRE(symlink("../victim", atf_dynstr_cstring(&keyfile)) != -1);
+    atf_dynstr_fini(&keyfile);
+    atf_fs_path_fini(&path);
+
+    err = atf_cache_fixture("cache", "key", "inputs", generate_data,
+                            NULL, &path);
+    ATF_REQUIRE(atf_is_error(err));
+    atf_error_free(err);
+    ATF_REQUIRE(atf_utils_compare_file("victim", "precious\n"));
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    ATF_TP_ADD_TC(tp, default_dir);
+    ATF_TP_ADD_TC(tp, fixture_reuse);
+    ATF_TP_ADD_TC(tp, fixture_read_only);
+    ATF_TP_ADD_TC(tp, fixture_identity);
+    ATF_TP_ADD_TC(tp, fixture_concurrent);
+    ATF_TP_ADD_TC(tp, fixture_generator_error);
+    ATF_TP_ADD_TC(tp, fixture_collision);
+    ATF_TP_ADD_TC(tp, fixture_unsafe_dir);
+    ATF_TP_ADD_TC(tp, fixture_foreign_dir);
+    ATF_TP_ADD_TC(tp, fixture_symlinks);
+
+    return atf_no_error();
+}
@@ -33,7 +33,6 @@
 #include <string.h>
 
 #include "atf-c/detail/sanity.h"
-#include "atf-c/detail/text.h"
 #include "atf-c/error.h"
 
 /* ---------------------------------------------------------------------
@@ -41,63 +40,154 @@
  * --------------------------------------------------------------------- */
 
 static
+char *
+data(atf_dynstr_t *ad)
+{
+    return ad->m_data != NULL ? ad->m_data : ad->m_inline;
+}
+
+static
+const char *
+const_data(const atf_dynstr_t *ad)
+{
+    return ad->m_data != NULL ? ad->m_data : ad->m_inline;
+}
+
+static
+void
+init_inline(atf_dynstr_t *ad)
+{
+    ad->m_data = NULL;
+    ad->m_datasize = sizeof(ad->m_inline);
+    ad->m_length = 0;
+    ad->m_inline[0] = '\0';
+}
+
+/* Ensures that the string can hold at least 'newsize' bytes, including the
+ * terminating nul.  The capacity grows geometrically so that a sequence of
+ * appends runs in amortized linear time. */
+static
 atf_error_t
-resize(atf_dynstr_t *ad, size_t newsize)
+grow(atf_dynstr_t *ad, size_t newsize)
 {
     char *newdata;
-    atf_error_t err;
+    size_t datasize;
 
-    PRE(newsize > ad->m_datasize);
+    if (newsize <= ad->m_datasize)
+        return atf_no_error();
 
-    newdata = (char *)malloc(newsize);
-    if (newdata == NULL) {
-        err = atf_no_memory_error();
+    datasize = ad->m_datasize;
+    while (datasize < newsize) {
+        if (datasize > SIZE_MAX / 2) {
+            datasize = newsize;
+            break;
+        }
+        datasize *= 2;
+    }
+
+    if (ad->m_data == NULL) {
+        newdata = (char *)malloc(datasize);
+        if (newdata == NULL)
+            return atf_no_memory_error();
+        memcpy(newdata, ad->m_inline, ad->m_length + 1);
     } else {
-        strcpy(newdata, ad->m_data);
-        free(ad->m_data);
-        ad->m_data = newdata;
-        ad->m_datasize = newsize;
-        err = atf_no_error();
+        newdata = (char *)realloc(ad->m_data, datasize);
+        if (newdata == NULL)
+            return atf_no_memory_error();
     }
+    ad->m_data = newdata;
+    ad->m_datasize = datasize;
 
-    return err;
+    return atf_no_error();
 }
 
 static
 atf_error_t
-prepend_or_append(atf_dynstr_t *ad, const char *fmt, va_list ap,
-                  bool prepend)
+append_mem(atf_dynstr_t *ad, const void *mem, size_t memlen)
+{
+    atf_error_t err;
+
+    if (memlen >= SIZE_MAX - ad->m_length - 1)
+        return atf_no_memory_error();
+
+    err = grow(ad, ad->m_length + memlen + 1);
+    if (atf_is_error(err))
+        return err;
+
+    memcpy(data(ad) + ad->m_length, mem, memlen);
+    ad->m_length += memlen;
+    data(ad)[ad->m_length] = '\0';
+
+    return atf_no_error();
+}
+
+/* Formats the given string straight into the free space of the buffer,
+ * retrying once with a bigger buffer if the result did not fit. */
+static
+atf_error_t
+append_ap(atf_dynstr_t *ad, const char *fmt, va_list ap)
 {
-    char *aux;
     atf_error_t err;
-    size_t newlen;
     va_list ap2;
+    int ret;
 
     va_copy(ap2, ap);
-    err = atf_text_format_ap(&aux, fmt, ap2);
+    ret = vsnprintf(data(ad) + ad->m_length, ad->m_datasize - ad->m_length,
+                    fmt, ap2);
     va_end(ap2);
-    if (atf_is_error(err))
-        goto out;
-    newlen = ad->m_length + strlen(aux);
+    if (ret < 0) {
+        data(ad)[ad->m_length] = '\0';
+        return atf_libc_error(errno, "Cannot format string");
+    }
+
+    if ((size_t)ret >= ad->m_datasize - ad->m_length) {
+        err = grow(ad, ad->m_length + (size_t)ret + 1);
+        if (atf_is_error(err)) {
+            data(ad)[ad->m_length] = '\0';
+            return err;
+        }
 
-    if (newlen + sizeof(char) > ad->m_datasize) {
-        err = resize(ad, newlen + sizeof(char));
-        if (atf_is_error(err))
-            goto out_free;
+        va_copy(ap2, ap);
+        ret = vsnprintf(data(ad) + ad->m_length,
+                        ad->m_datasize - ad->m_length, fmt, ap2);
+        va_end(ap2);
+        INV(ret >= 0 && (size_t)ret < ad->m_datasize - ad->m_length);
     }
+    ad->m_length += ret;
 
-    if (prepend) {
-        memmove(ad->m_data + strlen(aux), ad->m_data, ad->m_length + 1);
-        memcpy(ad->m_data, aux, strlen(aux));
-    } else
-        strcpy(ad->m_data + ad->m_length, aux);
-    ad->m_length = newlen;
-    err = atf_no_error();
+    return atf_no_error();
+}
 
-out_free:
-    free(aux);
-out:
-    return err;
+static
+atf_error_t
+prepend_ap(atf_dynstr_t *ad, const char *fmt, va_list ap)
+{
+    atf_error_t err;
+    va_list ap2;
+    char first;
+    int ret;
+
+    va_copy(ap2, ap);
+    ret = vsnprintf(NULL, 0, fmt, ap2);
+    va_end(ap2);
+    if (ret < 0)
+        return atf_libc_error(errno, "Cannot format string");
+
+    err = grow(ad, ad->m_length + (size_t)ret + 1);
+    if (atf_is_error(err))
+        return err;
+
+    /* vsnprintf always terminates its output, which clobbers the first
+     * character of the previous contents once they have been moved. */
+    memmove(data(ad) + ret, data(ad), ad->m_length + 1);
+    first = data(ad)[ret];
+    va_copy(ap2, ap);
+    (void)vsnprintf(data(ad), (size_t)ret + 1, fmt, ap2);
+    va_end(ap2);
+    data(ad)[ret] = first;
+    ad->m_length += ret;
+
+    return atf_no_error();
 }
 
 /* ---------------------------------------------------------------------
@@ -117,62 +207,24 @@ const size_t atf_dynstr_npos = SIZE_MAX;
 atf_error_t
 atf_dynstr_init(atf_dynstr_t *ad)
 {
-    atf_error_t err;
-
-    ad->m_data = (char *)malloc(sizeof(char));
-    if (ad->m_data == NULL) {
-        err = atf_no_memory_error();
-        goto out;
-    }
-
-    ad->m_data[0] = '\0';
-    ad->m_datasize = 1;
-    ad->m_length = 0;
-    err = atf_no_error();
-
-out:
-    return err;
+    init_inline(ad);
+    return atf_no_error();
 }
 
 atf_error_t
 atf_dynstr_init_ap(atf_dynstr_t *ad, const char *fmt, va_list ap)
 {
     atf_error_t err;
+    va_list ap2;
 
-    ad->m_datasize = strlen(fmt) + 1;
-    ad->m_length = 0;
-
-    do {
-        va_list ap2;
-        int ret;
-
-        ad->m_datasize *= 2;
-        ad->m_data = (char *)malloc(ad->m_datasize);
-        if (ad->m_data == NULL) {
-            err = atf_no_memory_error();
-            goto out;
-        }
-
-        va_copy(ap2, ap);
-        ret = vsnprintf(ad->m_data, ad->m_datasize, fmt, ap2);
-        va_end(ap2);
-        if (ret < 0) {
-            free(ad->m_data);
-            err = atf_libc_error(errno, "Cannot format string");
-            goto out;
-        }
+    init_inline(ad);
 
-        INV(ret >= 0);
-        if ((size_t)ret >= ad->m_datasize) {
-            free(ad->m_data);
-            ad->m_data = NULL;
-        }
-        ad->m_length = ret;
-    } while (ad->m_length >= ad->m_datasize);
+    va_copy(ap2, ap);
+    err = append_ap(ad, fmt, ap2);
+    va_end(ap2);
+    if (atf_is_error(err))
+        atf_dynstr_fini(ad);
 
-    err = atf_no_error();
-out:
-    POST(atf_is_error(err) || ad->m_data != NULL);
     return err;
 }
 
@@ -199,16 +251,14 @@ atf_dynstr_init_raw(atf_dynstr_t *ad, const void *mem, size_t memlen)
         goto out;
     }
 
-    ad->m_data = (char *)malloc(memlen + 1);
-    if (ad->m_data == NULL) {
-        err = atf_no_memory_error();
+    init_inline(ad);
+    err = grow(ad, memlen + 1);
+    if (atf_is_error(err))
         goto out;
-    }
 
-    ad->m_datasize = memlen + 1;
-    memcpy(ad->m_data, mem, memlen);
-    ad->m_data[memlen] = '\0';
-    ad->m_length = strlen(ad->m_data);
+    memcpy(data(ad), mem, memlen);
+    data(ad)[memlen] = '\0';
+    ad->m_length = strlen(data(ad));
     INV(ad->m_length <= memlen);
     err = atf_no_error();
 
@@ -226,15 +276,13 @@ atf_dynstr_init_rep(atf_dynstr_t *ad, size_t len, char ch)
         goto out;
     }
 
-    ad->m_datasize = (len + 1) * sizeof(char);
-    ad->m_data = (char *)malloc(ad->m_datasize);
-    if (ad->m_data == NULL) {
-        err = atf_no_memory_error();
+    init_inline(ad);
+    err = grow(ad, len + 1);
+    if (atf_is_error(err))
         goto out;
-    }
 
-    memset(ad->m_data, ch, len);
-    ad->m_data[len] = '\0';
+    memset(data(ad), ch, len);
+    data(ad)[len] = '\0';
     ad->m_length = len;
     err = atf_no_error();
 
@@ -252,7 +300,7 @@ atf_dynstr_init_substr(atf_dynstr_t *ad, const atf_dynstr_t *src,
     if (end == atf_dynstr_npos || end > src->m_length)
         end = src->m_length;
 
-    return atf_dynstr_init_raw(ad, src->m_data + beg, end - beg);
+    return atf_dynstr_init_raw(ad, const_data(src) + beg, end - beg);
 }
 
 atf_error_t
@@ -260,15 +308,10 @@ atf_dynstr_copy(atf_dynstr_t *dest, const atf_dynstr_t *src)
 {
     atf_error_t err;
 
-    dest->m_data = (char *)malloc(src->m_datasize);
-    if (dest->m_data == NULL)
-        err = atf_no_memory_error();
-    else {
-        memcpy(dest->m_data, src->m_data, src->m_datasize);
-        dest->m_datasize = src->m_datasize;
-        dest->m_length = src->m_length;
-        err = atf_no_error();
-    }
+    init_inline(dest);
+    err = append_mem(dest, const_data(src), src->m_length);
+    if (atf_is_error(err))
+        atf_dynstr_fini(dest);
 
     return err;
 }
@@ -276,15 +319,25 @@ atf_dynstr_copy(atf_dynstr_t *dest, const atf_dynstr_t *src)
 void
 atf_dynstr_fini(atf_dynstr_t *ad)
 {
-    INV(ad->m_data != NULL);
     free(ad->m_data);
 }
 
+/* Returns the contents of the string as a buffer that the caller must
+ * release with free(3).  Contents held in the inline buffer are copied to
+ * the heap, so this returns NULL if memory is exhausted; the string is
+ * released in any case. */
 char *
 atf_dynstr_fini_disown(atf_dynstr_t *ad)
 {
-    INV(ad->m_data != NULL);
-    return ad->m_data;
+    char *str;
+
+    if (ad->m_data != NULL)
+        return ad->m_data;
+
+    str = (char *)malloc(ad->m_length + 1);
+    if (str != NULL)
+        memcpy(str, ad->m_inline, ad->m_length + 1);
+    return str;
 }
 
 /*
@@ -294,7 +347,16 @@ atf_dynstr_fini_disown(atf_dynstr_t *ad)
 const char *
 atf_dynstr_cstring(const atf_dynstr_t *ad)
 {
-    return ad->m_data;
+    return const_data(ad);
+}
+
+/* Returns the buffer of the string so that it can be modified in place.
+ * Only the first atf_dynstr_length characters may be changed; use
+ * atf_dynstr_truncate if the string becomes shorter. */
+char *
+atf_dynstr_data(atf_dynstr_t *ad)
+{
+    return data(ad);
 }
 
 size_t
@@ -306,9 +368,10 @@ atf_dynstr_length(const atf_dynstr_t *ad)
 size_t
 atf_dynstr_rfind_ch(const atf_dynstr_t *ad, char ch)
 {
+    const char *str = const_data(ad);
     size_t pos;
 
-    for (pos = ad->m_length; pos > 0 && ad->m_data[pos - 1] != ch; pos--)
+    for (pos = ad->m_length; pos > 0 && str[pos - 1] != ch; pos--)
         ;
 
     return pos == 0 ? atf_dynstr_npos : pos - 1;
@@ -325,12 +388,31 @@ atf_dynstr_append_ap(atf_dynstr_t *ad, const char *fmt, va_list ap)
     va_list ap2;
 
     va_copy(ap2, ap);
-    err = prepend_or_append(ad, fmt, ap2, false);
+    err = append_ap(ad, fmt, ap2);
     va_end(ap2);
 
     return err;
 }
 
+atf_error_t
+atf_dynstr_append_char(atf_dynstr_t *ad, char ch)
+{
+    if (ad->m_length + 1 < ad->m_datasize) {
+        char *str = data(ad);
+
+        str[ad->m_length++] = ch;
+        str[ad->m_length] = '\0';
+        return atf_no_error();
+    } else
+        return append_mem(ad, &ch, 1);
+}
+
+atf_error_t
+atf_dynstr_append_cstring(atf_dynstr_t *ad, const char *str)
+{
+    return append_mem(ad, str, strlen(str));
+}
+
 atf_error_t
 atf_dynstr_append_fmt(atf_dynstr_t *ad, const char *fmt, ...)
 {
@@ -338,16 +420,24 @@ atf_dynstr_append_fmt(atf_dynstr_t *ad, const char *fmt, ...)
     atf_error_t err;
 
     va_start(ap, fmt);
-    err = prepend_or_append(ad, fmt, ap, false);
+    err = append_ap(ad, fmt, ap);
     va_end(ap);
 
     return err;
 }
 
+/* Appends 'memlen' bytes from 'mem'.  Unlike atf_dynstr_init_raw, the data
+ * is copied verbatim, so it must not contain nul characters. */
+atf_error_t
+atf_dynstr_append_mem(atf_dynstr_t *ad, const void *mem, size_t memlen)
+{
+    return append_mem(ad, mem, memlen);
+}
+
 void
 atf_dynstr_clear(atf_dynstr_t *ad)
 {
-    ad->m_data[0] = '\0';
+    data(ad)[0] = '\0';
     ad->m_length = 0;
 }
 
@@ -358,7 +448,7 @@ atf_dynstr_prepend_ap(atf_dynstr_t *ad, const char *fmt, va_list ap)
     va_list ap2;
 
     va_copy(ap2, ap);
-    err = prepend_or_append(ad, fmt, ap2, true);
+    err = prepend_ap(ad, fmt, ap2);
     va_end(ap2);
 
     return err;
@@ -371,12 +461,30 @@ atf_dynstr_prepend_fmt(atf_dynstr_t *ad, const char *fmt, ...)
     atf_error_t err;
 
     va_start(ap, fmt);
-    err = prepend_or_append(ad, fmt, ap, true);
+    err = prepend_ap(ad, fmt, ap);
     va_end(ap);
 
     return err;
 }
 
+/* Makes room for at least 'length' characters so that appends up to that
+ * length do not need to allocate memory. */
+atf_error_t
+atf_dynstr_reserve(atf_dynstr_t *ad, size_t length)
+{
+    if (length >= SIZE_MAX - 1)
+        return atf_no_memory_error();
+    return grow(ad, length + 1);
+}
+
+void
+atf_dynstr_truncate(atf_dynstr_t *ad, size_t length)
+{
+    PRE(length <= ad->m_length);
+    ad->m_length = length;
+    data(ad)[length] = '\0';
+}
+
 /*
  * Operators.
  */
@@ -384,11 +492,12 @@ atf_dynstr_prepend_fmt(atf_dynstr_t *ad, const char *fmt, ...)
 bool
 atf_equal_dynstr_cstring(const atf_dynstr_t *ad, const char *str)
 {
-    return strcmp(ad->m_data, str) == 0;
+    return strcmp(const_data(ad), str) == 0;
 }
 
 bool
 atf_equal_dynstr_dynstr(const atf_dynstr_t *s1, const atf_dynstr_t *s2)
 {
-    return strcmp(s1->m_data, s2->m_data) == 0;
+    return s1->m_length == s2->m_length &&
+        memcmp(const_data(s1), const_data(s2), s1->m_length) == 0;
 }
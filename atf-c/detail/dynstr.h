@@ -36,10 +36,18 @@
  * The "atf_dynstr" type.
  * --------------------------------------------------------------------- */
 
+/* Size of the buffer embedded in every string.  Contents that fit in it
+ * (including the terminating nul) do not require any heap allocation. */
+#define ATF_DYNSTR_INLINE_SIZE 64
+
+/* m_data is NULL while the contents live in m_inline; this keeps the
+ * structure safe to copy around by value as long as only one copy is
+ * ever used afterwards. */
 struct atf_dynstr {
     char *m_data;
     size_t m_datasize;
     size_t m_length;
+    char m_inline[ATF_DYNSTR_INLINE_SIZE];
 };
 typedef struct atf_dynstr atf_dynstr_t;
 
@@ -60,15 +68,21 @@ char *atf_dynstr_fini_disown(atf_dynstr_t *);
 
 /* Getters */
 const char *atf_dynstr_cstring(const atf_dynstr_t *);
+char *atf_dynstr_data(atf_dynstr_t *);
 size_t atf_dynstr_length(const atf_dynstr_t *);
 size_t atf_dynstr_rfind_ch(const atf_dynstr_t *, char);
 
 /* Modifiers */
 atf_error_t atf_dynstr_append_ap(atf_dynstr_t *, const char *, va_list);
+atf_error_t atf_dynstr_append_char(atf_dynstr_t *, char);
+atf_error_t atf_dynstr_append_cstring(atf_dynstr_t *, const char *);
 atf_error_t atf_dynstr_append_fmt(atf_dynstr_t *, const char *, ...);
+atf_error_t atf_dynstr_append_mem(atf_dynstr_t *, const void *, size_t);
 void atf_dynstr_clear(atf_dynstr_t *);
 atf_error_t atf_dynstr_prepend_ap(atf_dynstr_t *, const char *, va_list);
 atf_error_t atf_dynstr_prepend_fmt(atf_dynstr_t *, const char *, ...);
+atf_error_t atf_dynstr_reserve(atf_dynstr_t *, size_t);
+void atf_dynstr_truncate(atf_dynstr_t *, size_t);
 
 /* Operators */
 bool atf_equal_dynstr_cstring(const atf_dynstr_t *, const char *);
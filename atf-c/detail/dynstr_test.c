@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <atf-c.h>
 
@@ -285,7 +286,9 @@ ATF_TC_BODY(fini_disown, tc)
     char *cstr2;
     atf_dynstr_t str;
 
-    RE(atf_dynstr_init_fmt(&str, "Test string 1"));
+    /* Strings held in the inline buffer are copied out instead; see the
+     * inline_storage test. */
+    RE(atf_dynstr_init_rep(&str, ATF_DYNSTR_INLINE_SIZE * 2, 'a'));
     cstr = atf_dynstr_cstring(&str);
     cstr2 = atf_dynstr_fini_disown(&str);
 
@@ -441,6 +444,187 @@ ATF_TC_BODY(append_fmt, tc)
     check_append(atf_dynstr_append_fmt);
 }
 
+ATF_TC(append_char);
+ATF_TC_HEAD(append_char, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks appending single characters "
+                      "to a string");
+}
+ATF_TC_BODY(append_char, tc)
+{
+    const size_t maxlen = 8192;
+    char buf[maxlen + 1];
+    size_t i;
+    atf_dynstr_t str;
+
+    RE(atf_dynstr_init(&str));
+    for (i = 0; i < maxlen; i++) {
+        buf[i] = 'a' + i % 26;
+        RE(atf_dynstr_append_char(&str, buf[i]));
+        ATF_REQUIRE_EQ(atf_dynstr_length(&str), i + 1);
+    }
+    buf[maxlen] = '\0';
+    ATF_REQUIRE(strcmp(atf_dynstr_cstring(&str), buf) == 0);
+    atf_dynstr_fini(&str);
+}
+
+ATF_TC(append_cstring);
+ATF_TC_HEAD(append_cstring, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks appending plain strings to "
+                      "a string without formatting them");
+}
+ATF_TC_BODY(append_cstring, tc)
+{
+    atf_dynstr_t str;
+
+    RE(atf_dynstr_init_fmt(&str, "%s", "foo"));
+    RE(atf_dynstr_append_cstring(&str, ""));
+    ATF_REQUIRE(strcmp(atf_dynstr_cstring(&str), "foo") == 0);
+    RE(atf_dynstr_append_cstring(&str, "%s%d"));
+    ATF_REQUIRE(strcmp(atf_dynstr_cstring(&str), "foo%s%d") == 0);
+    ATF_REQUIRE_EQ(atf_dynstr_length(&str), 7);
+    atf_dynstr_fini(&str);
+}
+
+ATF_TC(append_mem);
+ATF_TC_HEAD(append_mem, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks appending raw memory to "
+                      "a string");
+}
+ATF_TC_BODY(append_mem, tc)
+{
+    const char *src = "0123456789";
+    atf_dynstr_t str;
+    size_t i;
+
+    RE(atf_dynstr_init(&str));
+    RE(atf_dynstr_append_mem(&str, src, 0));
+    ATF_REQUIRE(strcmp(atf_dynstr_cstring(&str), "") == 0);
+    RE(atf_dynstr_append_mem(&str, src, 3));
+    ATF_REQUIRE(strcmp(atf_dynstr_cstring(&str), "012") == 0);
+    for (i = 0; i < 100; i++)
+        RE(atf_dynstr_append_mem(&str, src + 3, 7));
+    ATF_REQUIRE_EQ(atf_dynstr_length(&str), 703);
+    ATF_REQUIRE(strncmp(atf_dynstr_cstring(&str) + 696, "3456789", 8) == 0);
+    atf_dynstr_fini(&str);
+}
+
+ATF_TC(append_linear);
+ATF_TC_HEAD(append_linear, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that building a 10 MB string "
+                      "one character at a time takes a logarithmic number "
+                      "of reallocations");
+}
+ATF_TC_BODY(append_linear, tc)
+{
+    const size_t total = 10 * 1024 * 1024;
+    struct timespec start, end;
+    size_t i, datasize, resizes;
+    double elapsed;
+    atf_dynstr_t str;
+
+    RE(atf_dynstr_init(&str));
+    datasize = str.m_datasize;
+    resizes = 0;
+    ATF_REQUIRE(clock_gettime(CLOCK_MONOTONIC, &start) != -1);
+    for (i = 0; i < total; i++) {
+        RE(atf_dynstr_append_char(&str, 'x'));
+        if (str.m_datasize != datasize) {
+            datasize = str.m_datasize;
+            resizes++;
+        }
+    }
+    ATF_REQUIRE(clock_gettime(CLOCK_MONOTONIC, &end) != -1);
+    ATF_REQUIRE_EQ(atf_dynstr_length(&str), total);
+    ATF_REQUIRE(strspn(atf_dynstr_cstring(&str), "x") == total);
+    atf_dynstr_fini(&str);
+
+    elapsed = (end.tv_sec - start.tv_sec) * 1e9 +
+        (end.tv_nsec - start.tv_nsec);
+    printf("Appended %zu characters in %.0f ns (%.2f ns/char) with %zu "
+           "resizes\n", total, elapsed, elapsed / total, resizes);
+    ATF_REQUIRE(resizes <= 20);
+}
+
+ATF_TC(inline_storage);
+ATF_TC_HEAD(inline_storage, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that short strings do not use "
+                      "the heap and that long ones can be disowned");
+}
+ATF_TC_BODY(inline_storage, tc)
+{
+    atf_dynstr_t str;
+    char *cstr;
+    size_t i;
+
+    RE(atf_dynstr_init_fmt(&str, "%s", "short"));
+    ATF_REQUIRE(str.m_data == NULL);
+    cstr = atf_dynstr_fini_disown(&str);
+    ATF_REQUIRE(cstr != NULL);
+    ATF_REQUIRE(strcmp(cstr, "short") == 0);
+    free(cstr);
+
+    RE(atf_dynstr_init(&str));
+    for (i = 0; i < ATF_DYNSTR_INLINE_SIZE - 1; i++)
+        RE(atf_dynstr_append_char(&str, 'a'));
+    ATF_REQUIRE(str.m_data == NULL);
+    RE(atf_dynstr_append_char(&str, 'b'));
+    ATF_REQUIRE(str.m_data != NULL);
+    ATF_REQUIRE_EQ(atf_dynstr_length(&str), ATF_DYNSTR_INLINE_SIZE);
+    ATF_REQUIRE_EQ(atf_dynstr_cstring(&str)[ATF_DYNSTR_INLINE_SIZE - 1], 'b');
+    atf_dynstr_fini(&str);
+}
+
+ATF_TC(reserve);
+ATF_TC_HEAD(reserve, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that reserving space avoids "
+                      "further reallocations");
+}
+ATF_TC_BODY(reserve, tc)
+{
+    atf_dynstr_t str;
+    const char *data;
+    size_t i;
+
+    RE(atf_dynstr_init_fmt(&str, "%s", "foo"));
+    RE(atf_dynstr_reserve(&str, 1000));
+    ATF_REQUIRE(strcmp(atf_dynstr_cstring(&str), "foo") == 0);
+    data = atf_dynstr_cstring(&str);
+    for (i = 3; i < 1000; i++)
+        RE(atf_dynstr_append_char(&str, 'a'));
+    ATF_REQUIRE(data == atf_dynstr_cstring(&str));
+    ATF_REQUIRE_EQ(atf_dynstr_length(&str), 1000);
+    atf_dynstr_fini(&str);
+}
+
+ATF_TC(truncate);
+ATF_TC_HEAD(truncate, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks truncating a string in place");
+}
+ATF_TC_BODY(truncate, tc)
+{
+    atf_dynstr_t str;
+    char *data;
+
+    RE(atf_dynstr_init_fmt(&str, "foo/bar"));
+    data = atf_dynstr_data(&str);
+    ATF_REQUIRE(data == atf_dynstr_cstring(&str));
+    data[3] = '-';
+    atf_dynstr_truncate(&str, 5);
+    ATF_REQUIRE_EQ(atf_dynstr_length(&str), 5);
+    ATF_REQUIRE(strcmp(atf_dynstr_cstring(&str), "foo-b") == 0);
+    atf_dynstr_truncate(&str, 0);
+    ATF_REQUIRE_EQ(atf_dynstr_length(&str), 0);
+    ATF_REQUIRE(strcmp(atf_dynstr_cstring(&str), "") == 0);
+    atf_dynstr_fini(&str);
+}
+
 ATF_TC(clear);
 ATF_TC_HEAD(clear, tc)
 {
@@ -622,6 +806,13 @@ ATF_TP_ADD_TCS(tp)
     /* Modifiers. */
     ATF_TP_ADD_TC(tp, append_ap);
     ATF_TP_ADD_TC(tp, append_fmt);
+    ATF_TP_ADD_TC(tp, append_char);
+    ATF_TP_ADD_TC(tp, append_cstring);
+    ATF_TP_ADD_TC(tp, append_mem);
+    ATF_TP_ADD_TC(tp, append_linear);
+    ATF_TP_ADD_TC(tp, inline_storage);
+    ATF_TP_ADD_TC(tp, reserve);
+    ATF_TP_ADD_TC(tp, truncate);
     ATF_TP_ADD_TC(tp, clear);
     ATF_TP_ADD_TC(tp, prepend_ap);
     ATF_TP_ADD_TC(tp, prepend_fmt);
@@ -35,8 +35,14 @@
 #include <sys/stat.h>
 #include <sys/wait.h>
 
+#if defined(HAVE_LINUX_FS_H)
+#   include <sys/ioctl.h>
+#   include <linux/fs.h>
+#endif
+
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <libgen.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -45,8 +51,8 @@
 #include <unistd.h>
 
 #include "atf-c/defs.h"
+#include "atf-c/detail/list.h"
 #include "atf-c/detail/sanity.h"
-#include "atf-c/detail/text.h"
 #include "atf-c/detail/user.h"
 #include "atf-c/error.h"
 
@@ -58,9 +64,9 @@ static bool check_umask(const mode_t, const mode_t);
 static atf_error_t copy_contents(const atf_fs_path_t *, char **);
 static mode_t current_umask(void);
 static atf_error_t do_mkdtemp(char *);
-static atf_error_t normalize(atf_dynstr_t *, char *);
-static atf_error_t normalize_ap(atf_dynstr_t *, const char *, va_list);
+static void normalize(atf_dynstr_t *, size_t);
 static void replace_contents(atf_fs_path_t *, const char *);
+static atf_error_t stat_set_type(atf_fs_stat_t *, const char *);
 static const char *stat_type_to_string(const int);
 
 /* ---------------------------------------------------------------------
@@ -234,62 +240,39 @@ do_mkstemp(char *tmpl, int *fdout)
     return err;
 }
 
+/* Normalizes, in place, the part of 'd' that starts at 'from' as if it
+ * were a path on its own: repeated delimiters are collapsed and trailing
+ * ones are removed, but a leading one is kept. */
 static
-atf_error_t
-normalize(atf_dynstr_t *d, char *p)
+void
+normalize(atf_dynstr_t *d, size_t from)
 {
-    const char *ptr;
-    char *last;
-    atf_error_t err;
+    char *str = atf_dynstr_data(d);
+    const size_t length = atf_dynstr_length(d);
+    size_t r, w;
     bool first;
 
-    PRE(strlen(p) > 0);
-    PRE(atf_dynstr_length(d) == 0);
+    PRE(from < length);
 
-    if (p[0] == '/')
-        err = atf_dynstr_append_fmt(d, "/");
-    else
-        err = atf_no_error();
+    r = w = from;
+    if (str[r] == '/')
+        str[w++] = '/';
 
     first = true;
-    last = NULL; /* Silence GCC warning. */
-    ptr = strtok_r(p, "/", &last);
-    while (!atf_is_error(err) && ptr != NULL) {
-        if (strlen(ptr) > 0) {
-            err = atf_dynstr_append_fmt(d, "%s%s", first ? "" : "/", ptr);
-            first = false;
-        }
-
-        ptr = strtok_r(NULL, "/", &last);
-    }
-
-    return err;
-}
-
-static
-atf_error_t
-normalize_ap(atf_dynstr_t *d, const char *p, va_list ap)
-{
-    char *str;
-    atf_error_t err;
-    va_list ap2;
-
-    err = atf_dynstr_init(d);
-    if (atf_is_error(err))
-        goto out;
-
-    va_copy(ap2, ap);
-    err = atf_text_format_ap(&str, p, ap2);
-    va_end(ap2);
-    if (atf_is_error(err))
-        atf_dynstr_fini(d);
-    else {
-        err = normalize(d, str);
-        free(str);
+    for (;;) {
+        while (r < length && str[r] == '/')
+            r++;
+        if (r == length)
+            break;
+
+        if (!first)
+            str[w++] = '/';
+        while (r < length && str[r] != '/')
+            str[w++] = str[r++];
+        first = false;
     }
 
-out:
-    return err;
+    atf_dynstr_truncate(d, w);
 }
 
 static
@@ -301,7 +284,7 @@ replace_contents(atf_fs_path_t *p, const char *buf)
     PRE(atf_dynstr_length(&p->m_data) == strlen(buf));
 
     atf_dynstr_clear(&p->m_data);
-    err = atf_dynstr_append_fmt(&p->m_data, "%s", buf);
+    err = atf_dynstr_append_cstring(&p->m_data, buf);
 
     INV(!atf_is_error(err));
 }
@@ -351,12 +334,24 @@ atf_fs_path_init_ap(atf_fs_path_t *p, const char *fmt, va_list ap)
     va_list ap2;
 
     va_copy(ap2, ap);
-    err = normalize_ap(&p->m_data, fmt, ap2);
+    err = atf_dynstr_init_ap(&p->m_data, fmt, ap2);
     va_end(ap2);
+    if (!atf_is_error(err))
+        normalize(&p->m_data, 0);
 
     return err;
 }
 
+/* Initializes a path from the first 'length' characters of 'str', which
+ * must already be normalized, such as a view returned by
+ * atf_fs_path_branch_view. */
+atf_error_t
+atf_fs_path_init_raw(atf_fs_path_t *p, const char *str, size_t length)
+{
+    PRE(length > 0);
+    return atf_dynstr_init_raw(&p->m_data, str, length);
+}
+
 atf_error_t
 atf_fs_path_init_fmt(atf_fs_path_t *p, const char *fmt, ...)
 {
@@ -389,15 +384,10 @@ atf_fs_path_fini(atf_fs_path_t *p)
 atf_error_t
 atf_fs_path_branch_path(const atf_fs_path_t *p, atf_fs_path_t *bp)
 {
-    const size_t endpos = atf_dynstr_rfind_ch(&p->m_data, '/');
+    const atf_fs_path_view_t view = atf_fs_path_branch_view(p);
     atf_error_t err;
 
-    if (endpos == atf_dynstr_npos)
-        err = atf_fs_path_init_fmt(bp, ".");
-    else if (endpos == 0)
-        err = atf_fs_path_init_fmt(bp, "/");
-    else
-        err = atf_dynstr_init_substr(&bp->m_data, &p->m_data, 0, endpos);
+    err = atf_fs_path_init_raw(bp, view.m_data, view.m_length);
 
 #if defined(HAVE_CONST_DIRNAME)
     INV(atf_equal_dynstr_cstring(&bp->m_data,
@@ -407,24 +397,48 @@ atf_fs_path_branch_path(const atf_fs_path_t *p, atf_fs_path_t *bp)
     return err;
 }
 
+/* Returns the branch path as a view of the path itself, or of a constant
+ * string for the "." case.  The view is valid until the path changes. */
+atf_fs_path_view_t
+atf_fs_path_branch_view(const atf_fs_path_t *p)
+{
+    const size_t endpos = atf_dynstr_rfind_ch(&p->m_data, '/');
+    atf_fs_path_view_t view;
+
+    if (endpos == atf_dynstr_npos) {
+        view.m_data = ".";
+        view.m_length = 1;
+    } else {
+        view.m_data = atf_dynstr_cstring(&p->m_data);
+        view.m_length = endpos == 0 ? 1 : endpos;
+    }
+
+    return view;
+}
+
 const char *
 atf_fs_path_cstring(const atf_fs_path_t *p)
 {
     return atf_dynstr_cstring(&p->m_data);
 }
 
+/* Returns the leaf name as a pointer into the path, valid until the path
+ * changes. */
+const char *
+atf_fs_path_leaf_cstring(const atf_fs_path_t *p)
+{
+    const size_t pos = atf_dynstr_rfind_ch(&p->m_data, '/');
+    const char *str = atf_dynstr_cstring(&p->m_data);
+
+    return pos == atf_dynstr_npos ? str : str + pos + 1;
+}
+
 atf_error_t
 atf_fs_path_leaf_name(const atf_fs_path_t *p, atf_dynstr_t *ln)
 {
-    size_t begpos = atf_dynstr_rfind_ch(&p->m_data, '/');
     atf_error_t err;
 
-    if (begpos == atf_dynstr_npos)
-        begpos = 0;
-    else
-        begpos++;
-
-    err = atf_dynstr_init_substr(ln, &p->m_data, begpos, atf_dynstr_npos);
+    err = atf_dynstr_init_fmt(ln, "%s", atf_fs_path_leaf_cstring(p));
 
 #if defined(HAVE_CONST_BASENAME)
     INV(atf_equal_dynstr_cstring(ln,
@@ -450,27 +464,30 @@ atf_fs_path_is_root(const atf_fs_path_t *p)
  * Modifiers.
  */
 
+/* The new component is formatted straight after a delimiter at the end of
+ * the path and only that part is normalized, so that an absolute
+ * component does not result in a double delimiter. */
 atf_error_t
 atf_fs_path_append_ap(atf_fs_path_t *p, const char *fmt, va_list ap)
 {
-    atf_dynstr_t aux;
+    const size_t oldlen = atf_dynstr_length(&p->m_data);
     atf_error_t err;
     va_list ap2;
 
+    err = atf_dynstr_append_char(&p->m_data, '/');
+    if (atf_is_error(err))
+        return err;
+
     va_copy(ap2, ap);
-    err = normalize_ap(&aux, fmt, ap2);
+    err = atf_dynstr_append_ap(&p->m_data, fmt, ap2);
     va_end(ap2);
-    if (!atf_is_error(err)) {
-        const char *auxstr = atf_dynstr_cstring(&aux);
-        const bool needslash = auxstr[0] != '/';
-
-        err = atf_dynstr_append_fmt(&p->m_data, "%s%s",
-                                    needslash ? "/" : "", auxstr);
-
-        atf_dynstr_fini(&aux);
+    if (atf_is_error(err)) {
+        atf_dynstr_truncate(&p->m_data, oldlen);
+        return err;
     }
 
-    return err;
+    normalize(&p->m_data, oldlen);
+    return atf_no_error();
 }
 
 atf_error_t
@@ -486,10 +503,20 @@ atf_fs_path_append_fmt(atf_fs_path_t *p, const char *fmt, ...)
     return err;
 }
 
+/* As p2 is already normalized, it is appended as is. */
 atf_error_t
 atf_fs_path_append_path(atf_fs_path_t *p, const atf_fs_path_t *p2)
 {
-    return atf_fs_path_append_fmt(p, "%s", atf_dynstr_cstring(&p2->m_data));
+    const char *str = atf_dynstr_cstring(&p2->m_data);
+    atf_error_t err;
+
+    if (str[0] != '/') {
+        err = atf_dynstr_append_char(&p->m_data, '/');
+        if (atf_is_error(err))
+            return err;
+    }
+    return atf_dynstr_append_mem(&p->m_data, str,
+                                 atf_dynstr_length(&p2->m_data));
 }
 
 atf_error_t
@@ -542,35 +569,54 @@ const int atf_fs_stat_wht_type  = 8;
  * Constructors/destructors.
  */
 
+/* Fills in the type of 'st' from the mode returned by the stat call
+ * on 'what'. */
+static
 atf_error_t
-atf_fs_stat_init(atf_fs_stat_t *st, const atf_fs_path_t *p)
+stat_set_type(atf_fs_stat_t *st, const char *what)
 {
-    atf_error_t err;
-    const char *pstr = atf_fs_path_cstring(p);
-
-    if (lstat(pstr, &st->m_sb) == -1) {
-        err = atf_libc_error(errno, "Cannot get information of %s; "
-                             "lstat(2) failed", pstr);
-    } else {
-        int type = st->m_sb.st_mode & S_IFMT;
-        err = atf_no_error();
-        switch (type) {
-            case S_IFBLK:  st->m_type = atf_fs_stat_blk_type;  break;
-            case S_IFCHR:  st->m_type = atf_fs_stat_chr_type;  break;
-            case S_IFDIR:  st->m_type = atf_fs_stat_dir_type;  break;
-            case S_IFIFO:  st->m_type = atf_fs_stat_fifo_type; break;
-            case S_IFLNK:  st->m_type = atf_fs_stat_lnk_type;  break;
-            case S_IFREG:  st->m_type = atf_fs_stat_reg_type;  break;
-            case S_IFSOCK: st->m_type = atf_fs_stat_sock_type; break;
+    const int type = st->m_sb.st_mode & S_IFMT;
+
+    switch (type) {
+        case S_IFBLK:  st->m_type = atf_fs_stat_blk_type;  break;
+        case S_IFCHR:  st->m_type = atf_fs_stat_chr_type;  break;
+        case S_IFDIR:  st->m_type = atf_fs_stat_dir_type;  break;
+        case S_IFIFO:  st->m_type = atf_fs_stat_fifo_type; break;
+        case S_IFLNK:  st->m_type = atf_fs_stat_lnk_type;  break;
+        case S_IFREG:  st->m_type = atf_fs_stat_reg_type;  break;
+        case S_IFSOCK: st->m_type = atf_fs_stat_sock_type; break;
 #if defined(S_IFWHT)
-            case S_IFWHT:  st->m_type = atf_fs_stat_wht_type;  break;
+        case S_IFWHT:  st->m_type = atf_fs_stat_wht_type;  break;
 #endif
-            default:
-                err = unknown_type_error(pstr, type);
-        }
+        default:
+            return unknown_type_error(what, type);
     }
 
-    return err;
+    return atf_no_error();
+}
+
+atf_error_t
+atf_fs_stat_init(atf_fs_stat_t *st, const atf_fs_path_t *p)
+{
+    const char *pstr = atf_fs_path_cstring(p);
+
+    if (lstat(pstr, &st->m_sb) == -1)
+        return atf_libc_error(errno, "Cannot get information of %s; "
+                              "lstat(2) failed", pstr);
+
+    return stat_set_type(st, pstr);
+}
+
+/* Like atf_fs_stat_init, but for the entry 'name' of the directory open
+ * at 'dirfd'. */
+atf_error_t
+atf_fs_stat_init_at(atf_fs_stat_t *st, int dirfd, const char *name)
+{
+    if (fstatat(dirfd, name, &st->m_sb, AT_SYMLINK_NOFOLLOW) == -1)
+        return atf_libc_error(errno, "Cannot get information of %s; "
+                              "fstatat(2) failed", name);
+
+    return stat_set_type(st, name);
 }
 
 void
@@ -847,6 +893,373 @@ out:
     return err;
 }
 
+/*
+ * Recursive removal of directory trees.
+ *
+ * Trees are walked with descriptors relative to the directory being
+ * emptied, so that no path has to be resolved more than once, and the
+ * type of each entry is taken from the directory itself when the file
+ * system provides it.  Directories that cannot be read, searched or
+ * modified because of their mode, and entries protected by immutable or
+ * append-only flags where the system has them, are fixed on demand: the
+ * common case pays no extra system calls.  Nothing outside of the tree is
+ * ever changed.  The path of the entry being processed is
+ * only tracked to build error messages.
+ */
+
+static
+atf_error_t
+rmtree_error(int syserrno, const char *what, const atf_dynstr_t *path)
+{
+    return atf_libc_error(syserrno, "Cannot %s %s", what,
+                          atf_dynstr_cstring(path));
+}
+
+static
+bool
+rmtree_is_dir(int dirfd, const struct dirent *de)
+{
+    struct stat st;
+
+#if defined(DT_DIR) && defined(DT_UNKNOWN)
+    if (de->d_type != DT_UNKNOWN)
+        return de->d_type == DT_DIR;
+#endif
+
+    /* If the entry vanished, its removal will fail with a good error. */
+    if (fstatat(dirfd, de->d_name, &st, AT_SYMLINK_NOFOLLOW) == -1 &&
+        (errno != EACCES || fchmod(dirfd, S_IRWXU) == -1 ||
+         fstatat(dirfd, de->d_name, &st, AT_SYMLINK_NOFOLLOW) == -1))
+        return false;
+    return S_ISDIR(st.st_mode);
+}
+
+/* Gives full access to its owner to the directory 'name' relative to
+ * 'parentfd', without following symbolic links.  Systems that cannot do
+ * the latter, like older versions of glibc, are only trusted with entries
+ * that are still directories right before the change. */
+static
+int
+rmtree_chmod(int parentfd, const char *name)
+{
+    struct stat st;
+
+    if (fchmodat(parentfd, name, S_IRWXU, AT_SYMLINK_NOFOLLOW) != -1)
+        return 0;
+    if (errno != ENOTSUP && errno != EOPNOTSUPP)
+        return -1;
+
+    if (fstatat(parentfd, name, &st, AT_SYMLINK_NOFOLLOW) == -1)
+        return -1;
+    if (!S_ISDIR(st.st_mode)) {
+        errno = ENOTDIR;
+        return -1;
+    }
+    return fchmodat(parentfd, name, S_IRWXU, 0);
+}
+
+#if defined(HAVE_LINUX_FS_H)
+static
+bool
+rmtree_clear_fd_flags(int fd)
+{
+    const int mask = FS_IMMUTABLE_FL | FS_APPEND_FL;
+    int flags;
+
+    if (ioctl(fd, FS_IOC_GETFLAGS, &flags) == -1 || (flags & mask) == 0)
+        return false;
+    flags &= ~mask;
+    return ioctl(fd, FS_IOC_SETFLAGS, &flags) != -1;
+}
+#endif
+
+/* Clears the flags that prevent the removal of the entry 'name' relative
+ * to 'dirfd' and, if 'in_tree' says that the latter is part of the tree
+ * being removed, of the directory itself.  Returns whether any flags were
+ * cleared; the system is left to decide who can do so. */
+static
+bool
+rmtree_clear_flags(int dirfd, const char *name, bool in_tree)
+{
+    bool cleared = false;
+
+#if defined(HAVE_LINUX_FS_H)
+    int fd;
+
+    fd = openat(dirfd, name, O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC);
+    if (fd != -1) {
+        cleared = rmtree_clear_fd_flags(fd);
+        close(fd);
+    }
+    if (in_tree && rmtree_clear_fd_flags(dirfd))
+        cleared = true;
+#elif defined(HAVE_CHFLAGSAT) && defined(HAVE_FCHFLAGS)
+    cleared = chflagsat(dirfd, name, 0, AT_SYMLINK_NOFOLLOW) != -1;
+    if (in_tree && fchflags(dirfd, 0) != -1)
+        cleared = true;
+#else
+    (void)dirfd;
+    (void)name;
+    (void)in_tree;
+#endif
+
+    return cleared;
+}
+
+/* Opens the directory 'name' relative to 'parentfd'.  If 'in_tree' says
+ * that the parent is part of the tree being removed, it is made searchable
+ * first when it is the reason the directory cannot be reached. */
+static
+int
+rmtree_open(int parentfd, const char *name, bool in_tree)
+{
+    const int flags = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+    int fd;
+
+    fd = openat(parentfd, name, flags);
+    if (fd == -1 && errno == EACCES && in_tree) {
+        if (fchmod(parentfd, S_IRWXU) != -1)
+            fd = openat(parentfd, name, flags);
+        else
+            errno = EACCES;
+    }
+    if (fd == -1 && errno == EACCES) {
+        if (rmtree_chmod(parentfd, name) != -1)
+            fd = openat(parentfd, name, flags);
+        else
+            errno = EACCES;
+    }
+    return fd;
+}
+
+/* Removes the entry 'name' relative to 'dirfd', fixing the mode and flags
+ * that prevent it.  Those of 'dirfd' are only touched if 'in_tree' says
+ * that it is part of the tree being removed. */
+static
+int
+rmtree_unlinkat(int dirfd, const char *name, int flags, bool in_tree)
+{
+    int ret;
+
+    ret = unlinkat(dirfd, name, flags);
+    if (ret == -1 && (errno == EACCES || errno == EPERM) && in_tree) {
+        const int olderrno = errno;
+
+        if (fchmod(dirfd, S_IRWXU) != -1)
+            ret = unlinkat(dirfd, name, flags);
+        else
+            errno = olderrno;
+    }
+    if (ret == -1 && errno == EPERM) {
+        if (rmtree_clear_flags(dirfd, name, in_tree))
+            ret = unlinkat(dirfd, name, flags);
+        else
+            errno = EPERM;
+    }
+    return ret;
+}
+
+/* Removes the contents of the directory open at 'fd', whose path is
+ * 'path', and closes the descriptor.  The path is restored to its
+ * original value on return. */
+static
+atf_error_t
+rmtree_contents(int fd, atf_dynstr_t *path)
+{
+    const size_t length = atf_dynstr_length(path);
+    atf_error_t err;
+    DIR *dir;
+    struct dirent *de;
+
+    dir = fdopendir(fd);
+    if (dir == NULL) {
+        err = rmtree_error(errno, "open directory", path);
+        close(fd);
+        return err;
+    }
+
+    err = atf_no_error();
+    while (!atf_is_error(err) && (de = readdir(dir)) != NULL) {
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+            continue;
+
+        err = atf_dynstr_append_char(path, '/');
+        if (!atf_is_error(err))
+            err = atf_dynstr_append_cstring(path, de->d_name);
+        if (atf_is_error(err))
+            break;
+
+        if (rmtree_is_dir(fd, de)) {
+            const int subfd = rmtree_open(fd, de->d_name, true);
+            if (subfd == -1)
+                err = rmtree_error(errno, "open directory", path);
+            else {
+                err = rmtree_contents(subfd, path);
+                if (!atf_is_error(err) &&
+                    rmtree_unlinkat(fd, de->d_name, AT_REMOVEDIR,
+                                    true) == -1)
+                    err = rmtree_error(errno, "remove directory", path);
+            }
+        } else {
+            if (rmtree_unlinkat(fd, de->d_name, 0, true) == -1 &&
+                errno != ENOENT)
+                err = rmtree_error(errno, "unlink file", path);
+        }
+
+        atf_dynstr_truncate(path, length);
+    }
+    closedir(dir);
+
+    return err;
+}
+
+/* Removes the file or directory 'name' relative to 'parentfd', which is
+ * part of the tree being removed if 'in_tree' is true.  The directory is
+ * scanned again if it is not empty after the first pass, as removing
+ * entries while reading a directory can make some file systems skip
+ * others. */
+static
+atf_error_t
+rmtree_at(int parentfd, const char *name, atf_dynstr_t *path, bool in_tree)
+{
+    atf_error_t err;
+    int fd, tries;
+
+    for (tries = 0; ; tries++) {
+        fd = rmtree_open(parentfd, name, in_tree);
+        if (fd == -1) {
+            if (errno != ENOTDIR && errno != ELOOP)
+                return rmtree_error(errno, "open directory", path);
+            if (rmtree_unlinkat(parentfd, name, 0, in_tree) == -1)
+                return rmtree_error(errno, "unlink file", path);
+            return atf_no_error();
+        }
+
+        err = rmtree_contents(fd, path);
+        if (atf_is_error(err))
+            return err;
+
+        if (rmtree_unlinkat(parentfd, name, AT_REMOVEDIR, in_tree) != -1)
+            return atf_no_error();
+        else if ((errno != ENOTEMPTY && errno != EEXIST) || tries > 0)
+            return rmtree_error(errno, "remove directory", path);
+    }
+}
+
+/* Forks up to 'jobs' processes and makes each remove a share of the
+ * subdirectories of 'p'.  Failures are ignored: whatever the children
+ * leave behind is removed, and reported, by the caller. */
+static
+void
+rmtree_spread(const atf_fs_path_t *p, unsigned int jobs)
+{
+    atf_list_t subdirs;
+    DIR *dir;
+    struct dirent *de;
+    pid_t *pids;
+    unsigned int i;
+
+    dir = opendir(atf_fs_path_cstring(p));
+    if (dir == NULL)
+        return;
+
+    if (atf_is_error(atf_list_init(&subdirs))) {
+        closedir(dir);
+        return;
+    }
+    while ((de = readdir(dir)) != NULL) {
+        char *name;
+
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0 ||
+            !rmtree_is_dir(dirfd(dir), de))
+            continue;
+
+        name = strdup(de->d_name);
+        if (name == NULL || atf_is_error(atf_list_append(&subdirs, name,
+                                                          true))) {
+            free(name);
+            goto out_subdirs;
+        }
+    }
+
+    if (atf_list_size(&subdirs) < 2)
+        goto out_subdirs;
+    if (jobs > atf_list_size(&subdirs))
+        jobs = atf_list_size(&subdirs);
+
+    pids = malloc(sizeof(*pids) * jobs);
+    if (pids == NULL)
+        goto out_subdirs;
+
+    for (i = 0; i < jobs; i++) {
+        pids[i] = fork();
+        if (pids[i] == 0) {
+            const int fd = dirfd(dir);
+            atf_dynstr_t path;
+            size_t j;
+
+            if (atf_is_error(atf_dynstr_init_fmt(&path, "%s",
+                                                 atf_fs_path_cstring(p))))
+                _exit(EXIT_FAILURE);
+
+            for (j = i; j < atf_list_size(&subdirs); j += jobs) {
+                const char *name = atf_list_index_c(&subdirs, j);
+                const size_t length = atf_dynstr_length(&path);
+                atf_error_t err;
+
+                err = atf_dynstr_append_fmt(&path, "/%s", name);
+                if (!atf_is_error(err))
+                    err = rmtree_at(fd, name, &path, true);
+                if (atf_is_error(err))
+                    atf_error_free(err);
+                atf_dynstr_truncate(&path, length);
+            }
+            _exit(EXIT_SUCCESS);
+        }
+    }
+
+    for (i = 0; i < jobs; i++) {
+        if (pids[i] != -1) {
+            int status;
+            while (waitpid(pids[i], &status, 0) == -1 && errno == EINTR)
+                continue;
+        }
+    }
+
+    free(pids);
+out_subdirs:
+    atf_list_fini(&subdirs);
+    closedir(dir);
+}
+
+atf_error_t
+atf_fs_rmtree(const atf_fs_path_t *p)
+{
+    atf_dynstr_t path;
+    atf_error_t err;
+
+    err = atf_dynstr_init_fmt(&path, "%s", atf_fs_path_cstring(p));
+    if (atf_is_error(err))
+        return err;
+
+    err = rmtree_at(AT_FDCWD, atf_fs_path_cstring(p), &path, false);
+
+    atf_dynstr_fini(&path);
+    return err;
+}
+
+/* Like atf_fs_rmtree, but the subdirectories of 'p' are distributed
+ * among 'jobs' processes first; worth it for large trees only. */
+atf_error_t
+atf_fs_rmtree_parallel(const atf_fs_path_t *p, unsigned int jobs)
+{
+    PRE(jobs > 0);
+
+    if (jobs > 1)
+        rmtree_spread(p, jobs);
+    return atf_fs_rmtree(p);
+}
+
 atf_error_t
 atf_fs_rmdir(const atf_fs_path_t *p)
 {
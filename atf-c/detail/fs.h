@@ -39,20 +39,32 @@
  * The "atf_fs_path" type.
  * --------------------------------------------------------------------- */
 
+/* Paths are kept normalized, so short ones fit in the inline buffer of
+ * atf_dynstr_t and never touch the heap. */
 struct atf_fs_path {
     atf_dynstr_t m_data;
 };
 typedef struct atf_fs_path atf_fs_path_t;
 
+/* A component of a path that is not a copy of it; not nul-terminated. */
+struct atf_fs_path_view {
+    const char *m_data;
+    size_t m_length;
+};
+typedef struct atf_fs_path_view atf_fs_path_view_t;
+
 /* Constructors/destructors. */
 atf_error_t atf_fs_path_init_ap(atf_fs_path_t *, const char *, va_list);
 atf_error_t atf_fs_path_init_fmt(atf_fs_path_t *, const char *, ...);
+atf_error_t atf_fs_path_init_raw(atf_fs_path_t *, const char *, size_t);
 atf_error_t atf_fs_path_copy(atf_fs_path_t *, const atf_fs_path_t *);
 void atf_fs_path_fini(atf_fs_path_t *);
 
 /* Getters. */
 atf_error_t atf_fs_path_branch_path(const atf_fs_path_t *, atf_fs_path_t *);
+atf_fs_path_view_t atf_fs_path_branch_view(const atf_fs_path_t *);
 const char *atf_fs_path_cstring(const atf_fs_path_t *);
+const char *atf_fs_path_leaf_cstring(const atf_fs_path_t *);
 atf_error_t atf_fs_path_leaf_name(const atf_fs_path_t *, atf_dynstr_t *);
 bool atf_fs_path_is_absolute(const atf_fs_path_t *);
 bool atf_fs_path_is_root(const atf_fs_path_t *);
@@ -89,6 +101,7 @@ extern const int atf_fs_stat_wht_type;
 
 /* Constructors/destructors. */
 atf_error_t atf_fs_stat_init(atf_fs_stat_t *, const atf_fs_path_t *);
+atf_error_t atf_fs_stat_init_at(atf_fs_stat_t *, int, const char *);
 void atf_fs_stat_copy(atf_fs_stat_t *, const atf_fs_stat_t *);
 void atf_fs_stat_fini(atf_fs_stat_t *);
 
@@ -123,6 +136,8 @@ atf_error_t atf_fs_getcwd(atf_fs_path_t *);
 atf_error_t atf_fs_mkdtemp(atf_fs_path_t *);
 atf_error_t atf_fs_mkstemp(atf_fs_path_t *, int *);
 atf_error_t atf_fs_rmdir(const atf_fs_path_t *);
+atf_error_t atf_fs_rmtree(const atf_fs_path_t *);
+atf_error_t atf_fs_rmtree_parallel(const atf_fs_path_t *, unsigned int);
 atf_error_t atf_fs_unlink(const atf_fs_path_t *);
 
 #endif /* !defined(ATF_C_DETAIL_FS_H) */
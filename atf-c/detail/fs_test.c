@@ -120,6 +120,11 @@ ATF_TC_BODY(path_normalize, tc)
         { "///foo///bar", "/foo/bar", }, /* NO_CHECK_STYLE */
         { "///foo///bar///", "/foo/bar", }, /* NO_CHECK_STYLE */
 
+        { "a-rather-long-directory-name//another-rather-long-directory-name"
+          "//and-a-file-name-that-does-not-fit-inline",
+          "a-rather-long-directory-name/another-rather-long-directory-name"
+          "/and-a-file-name-that-does-not-fit-inline", },
+
         { NULL, NULL }
     };
     struct test *t;
@@ -279,6 +284,43 @@ ATF_TC_BODY(path_branch_path, tc)
     }
 }
 
+ATF_TC(path_branch_view);
+ATF_TC_HEAD(path_branch_view, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that the branch view references "
+                      "the original path");
+}
+ATF_TC_BODY(path_branch_view, tc)
+{
+    struct test {
+        const char *in;
+        const char *branch;
+        bool inpath;
+    } tests[] = {
+        { ".", ".", false },
+        { "foo", ".", false },
+        { "foo/bar", "foo", true },
+        { "/foo", "/", true },
+        { "/foo/bar", "/foo", true },
+        { NULL, NULL, false },
+    };
+    struct test *t;
+
+    for (t = &tests[0]; t->in != NULL; t++) {
+        atf_fs_path_t p;
+        atf_fs_path_view_t v;
+
+        RE(atf_fs_path_init_fmt(&p, "%s", t->in));
+        v = atf_fs_path_branch_view(&p);
+        printf("Input: %s, output: %.*s\n", t->in, (int)v.m_length,
+               v.m_data);
+        ATF_REQUIRE_EQ(strlen(t->branch), v.m_length);
+        ATF_REQUIRE(strncmp(t->branch, v.m_data, v.m_length) == 0);
+        ATF_REQUIRE_EQ(t->inpath, v.m_data == atf_fs_path_cstring(&p));
+        atf_fs_path_fini(&p);
+    }
+}
+
 ATF_TC(path_leaf_name);
 ATF_TC_HEAD(path_leaf_name, tc)
 {
@@ -318,6 +360,30 @@ ATF_TC_BODY(path_leaf_name, tc)
     }
 }
 
+ATF_TC(path_leaf_cstring);
+ATF_TC_HEAD(path_leaf_cstring, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that the leaf name is returned "
+                      "as a pointer into the path");
+}
+ATF_TC_BODY(path_leaf_cstring, tc)
+{
+    atf_fs_path_t p;
+
+    RE(atf_fs_path_init_fmt(&p, "foo"));
+    ATF_REQUIRE(atf_fs_path_leaf_cstring(&p) == atf_fs_path_cstring(&p));
+    atf_fs_path_fini(&p);
+
+    RE(atf_fs_path_init_fmt(&p, "/foo/bar/"));
+    ATF_REQUIRE_STREQ("bar", atf_fs_path_leaf_cstring(&p));
+    ATF_REQUIRE(atf_fs_path_leaf_cstring(&p) == atf_fs_path_cstring(&p) + 5);
+    atf_fs_path_fini(&p);
+
+    RE(atf_fs_path_init_fmt(&p, "/"));
+    ATF_REQUIRE_STREQ("", atf_fs_path_leaf_cstring(&p));
+    atf_fs_path_fini(&p);
+}
+
 ATF_TC(path_append);
 ATF_TC_HEAD(path_append, tc)
 {
@@ -335,6 +401,8 @@ ATF_TC_BODY(path_append, tc)
         { "foo/", "/bar", "foo/bar" },
         { "foo/", "/bar/baz", "foo/bar/baz" },
         { "foo/", "///bar///baz", "foo/bar/baz" }, /* NO_CHECK_STYLE */
+        { "foo", "bar//baz/", "foo/bar/baz" }, /* NO_CHECK_STYLE */
+        { "foo", "/", "foo/" },
 
         { NULL, NULL, NULL }
     };
@@ -360,6 +428,29 @@ ATF_TC_BODY(path_append, tc)
     }
 }
 
+ATF_TC(path_append_path);
+ATF_TC_HEAD(path_append_path, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests appending a path to another");
+}
+ATF_TC_BODY(path_append_path, tc)
+{
+    atf_fs_path_t p, p2;
+
+    RE(atf_fs_path_init_fmt(&p, "foo"));
+    RE(atf_fs_path_init_fmt(&p2, "bar//baz/")); /* NO_CHECK_STYLE */
+    RE(atf_fs_path_append_path(&p, &p2));
+    ATF_REQUIRE_STREQ("foo/bar/baz", atf_fs_path_cstring(&p));
+    atf_fs_path_fini(&p2);
+
+    RE(atf_fs_path_init_fmt(&p2, "/qux"));
+    RE(atf_fs_path_append_path(&p, &p2));
+    ATF_REQUIRE_STREQ("foo/bar/baz/qux", atf_fs_path_cstring(&p));
+    atf_fs_path_fini(&p2);
+
+    atf_fs_path_fini(&p);
+}
+
 ATF_TC(path_to_absolute);
 ATF_TC_HEAD(path_to_absolute, tc)
 {
@@ -816,6 +907,177 @@ ATF_TC_CLEANUP(rmdir_eperm, tc)
     }
 }
 
+ATF_TC(rmtree_ok);
+ATF_TC_HEAD(rmtree_ok, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests the atf_fs_rmtree function");
+}
+ATF_TC_BODY(rmtree_ok, tc)
+{
+    atf_fs_path_t p;
+
+    ATF_REQUIRE(mkdir("keep", 0755) != -1);
+    create_file("keep/file", 0644);
+
+    ATF_REQUIRE(mkdir("test-dir", 0755) != -1);
+    ATF_REQUIRE(mkdir("test-dir/a", 0755) != -1);
+    ATF_REQUIRE(mkdir("test-dir/a/b", 0755) != -1);
+    ATF_REQUIRE(mkdir("test-dir/empty", 0755) != -1);
+    create_file("test-dir/file", 0644);
+    create_file("test-dir/a/file", 0644);
+    create_file("test-dir/a/b/file", 0000);
+    ATF_REQUIRE(symlink("../keep", "test-dir/a/link") != -1);
+    ATF_REQUIRE(symlink("missing", "test-dir/dangling") != -1);
+
+    RE(atf_fs_path_init_fmt(&p, "test-dir"));
+    RE(atf_fs_rmtree(&p));
+    ATF_REQUIRE(!exists(&p));
+    atf_fs_path_fini(&p);
+
+    ATF_REQUIRE(access("keep/file", F_OK) == 0);
+
+    RE(atf_fs_path_init_fmt(&p, "keep/file"));
+    RE(atf_fs_rmtree(&p));
+    ATF_REQUIRE(!exists(&p));
+    atf_fs_path_fini(&p);
+}
+
+ATF_TC(rmtree_enoent);
+ATF_TC_HEAD(rmtree_enoent, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests the atf_fs_rmtree function on a "
+                      "missing file");
+}
+ATF_TC_BODY(rmtree_enoent, tc)
+{
+    atf_fs_path_t p;
+    atf_error_t err;
+
+    RE(atf_fs_path_init_fmt(&p, "missing"));
+    err = atf_fs_rmtree(&p);
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_REQUIRE(atf_error_is(err, "libc"));
+    ATF_REQUIRE_EQ(atf_libc_error_code(err), ENOENT);
+    atf_error_free(err);
+    atf_fs_path_fini(&p);
+}
+
+ATF_TC(rmtree_protected);
+ATF_TC_HEAD(rmtree_protected, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that atf_fs_rmtree removes "
+                      "directories that are not accessible because of "
+                      "their mode");
+}
+ATF_TC_BODY(rmtree_protected, tc)
+{
+    atf_fs_path_t p;
+
+    ATF_REQUIRE(mkdir("test-dir", 0755) != -1);
+    ATF_REQUIRE(mkdir("test-dir/ro", 0755) != -1);
+    create_file("test-dir/ro/file", 0644);
+    ATF_REQUIRE(mkdir("test-dir/none", 0755) != -1);
+    ATF_REQUIRE(mkdir("test-dir/none/sub", 0755) != -1);
+    create_file("test-dir/none/sub/file", 0644);
+    ATF_REQUIRE(chmod("test-dir/none/sub", 0000) != -1);
+    ATF_REQUIRE(chmod("test-dir/none", 0000) != -1);
+    ATF_REQUIRE(chmod("test-dir/ro", 0555) != -1);
+    ATF_REQUIRE(chmod("test-dir", 0555) != -1);
+
+    RE(atf_fs_path_init_fmt(&p, "test-dir"));
+    RE(atf_fs_rmtree(&p));
+    ATF_REQUIRE(!exists(&p));
+    atf_fs_path_fini(&p);
+}
+
+ATF_TC(rmtree_unsearchable);
+ATF_TC_HEAD(rmtree_unsearchable, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that atf_fs_rmtree removes "
+                      "subdirectories of directories that can be read but "
+                      "not searched");
+    atf_tc_set_md_var(tc, "require.user", "unprivileged");
+}
+ATF_TC_BODY(rmtree_unsearchable, tc)
+{
+    atf_fs_path_t p;
+
+    ATF_REQUIRE(mkdir("test-dir", 0755) != -1);
+    ATF_REQUIRE(mkdir("test-dir/sub", 0755) != -1);
+    ATF_REQUIRE(mkdir("test-dir/sub/dir", 0755) != -1);
+    create_file("test-dir/sub/dir/file", 0644);
+    ATF_REQUIRE(chmod("test-dir/sub/dir", 0600) != -1);
+    ATF_REQUIRE(chmod("test-dir/sub", 0600) != -1);
+    ATF_REQUIRE(chmod("test-dir", 0600) != -1);
+
+    RE(atf_fs_path_init_fmt(&p, "test-dir"));
+    RE(atf_fs_rmtree(&p));
+    ATF_REQUIRE(!exists(&p));
+    atf_fs_path_fini(&p);
+}
+
+ATF_TC_WITH_CLEANUP(rmtree_immutable);
+ATF_TC_HEAD(rmtree_immutable, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that atf_fs_rmtree removes "
+                      "entries with immutable or append-only flags");
+    atf_tc_set_md_var(tc, "require.user", "root");
+}
+ATF_TC_BODY(rmtree_immutable, tc)
+{
+    atf_fs_path_t p;
+
+    ATF_REQUIRE(mkdir("test-dir", 0755) != -1);
+    ATF_REQUIRE(mkdir("test-dir/sub", 0755) != -1);
+    create_file("test-dir/file", 0644);
+    create_file("test-dir/sub/file", 0644);
+    if (system("chattr +i test-dir/file 2>/dev/null") != 0)
+        atf_tc_skip("Cannot set the immutable flag on this system");
+    ATF_REQUIRE(system("chattr +a test-dir/sub/file") == 0);
+    ATF_REQUIRE(system("chattr +i test-dir/sub") == 0);
+
+    RE(atf_fs_path_init_fmt(&p, "test-dir"));
+    RE(atf_fs_rmtree(&p));
+    ATF_REQUIRE(!exists(&p));
+    atf_fs_path_fini(&p);
+}
+ATF_TC_CLEANUP(rmtree_immutable, tc)
+{
+    /* Let the runtime engine remove the work directory on failure. */
+    if (system("chattr -R -ia test-dir 2>/dev/null") != 0)
+        return;
+}
+
+ATF_TC(rmtree_parallel);
+ATF_TC_HEAD(rmtree_parallel, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests the atf_fs_rmtree_parallel "
+                      "function");
+}
+ATF_TC_BODY(rmtree_parallel, tc)
+{
+    atf_fs_path_t p;
+    char buf[64];
+    int i, j;
+
+    ATF_REQUIRE(mkdir("test-dir", 0755) != -1);
+    for (i = 0; i < 10; i++) {
+        snprintf(buf, sizeof(buf), "test-dir/%d", i);
+        ATF_REQUIRE(mkdir(buf, 0755) != -1);
+        for (j = 0; j < 50; j++) {
+            snprintf(buf, sizeof(buf), "test-dir/%d/%d", i, j);
+            create_file(buf, 0644);
+        }
+    }
+    create_file("test-dir/file", 0644);
+    ATF_REQUIRE(chmod("test-dir/3", 0555) != -1);
+
+    RE(atf_fs_path_init_fmt(&p, "test-dir"));
+    RE(atf_fs_rmtree_parallel(&p, 4));
+    ATF_REQUIRE(!exists(&p));
+    atf_fs_path_fini(&p);
+}
+
 ATF_TC(mkdtemp_ok);
 ATF_TC_HEAD(mkdtemp_ok, tc)
 {
@@ -1058,8 +1320,11 @@ ATF_TP_ADD_TCS(tp)
     ATF_TP_ADD_TC(tp, path_is_absolute);
     ATF_TP_ADD_TC(tp, path_is_root);
     ATF_TP_ADD_TC(tp, path_branch_path);
+    ATF_TP_ADD_TC(tp, path_branch_view);
     ATF_TP_ADD_TC(tp, path_leaf_name);
+    ATF_TP_ADD_TC(tp, path_leaf_cstring);
     ATF_TP_ADD_TC(tp, path_append);
+    ATF_TP_ADD_TC(tp, path_append_path);
     ATF_TP_ADD_TC(tp, path_to_absolute);
     ATF_TP_ADD_TC(tp, path_equal);
 
@@ -1075,6 +1340,12 @@ ATF_TP_ADD_TCS(tp)
     ATF_TP_ADD_TC(tp, rmdir_empty);
     ATF_TP_ADD_TC(tp, rmdir_enotempty);
     ATF_TP_ADD_TC(tp, rmdir_eperm);
+    ATF_TP_ADD_TC(tp, rmtree_ok);
+    ATF_TP_ADD_TC(tp, rmtree_enoent);
+    ATF_TP_ADD_TC(tp, rmtree_protected);
+    ATF_TP_ADD_TC(tp, rmtree_unsearchable);
+    ATF_TP_ADD_TC(tp, rmtree_immutable);
+    ATF_TP_ADD_TC(tp, rmtree_parallel);
     ATF_TP_ADD_TC(tp, mkdtemp_ok);
     ATF_TP_ADD_TC(tp, mkdtemp_err);
     ATF_TP_ADD_TC(tp, mkdtemp_umask);
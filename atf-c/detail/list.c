@@ -25,6 +25,7 @@
 
 #include "atf-c/detail/list.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -36,77 +37,95 @@
  * Auxiliary functions.
  * --------------------------------------------------------------------- */
 
-struct list_entry {
-    struct list_entry *m_prev;
-    struct list_entry *m_next;
-    void *m_object;
-    bool m_managed;
-};
+/* Initial number of slots allocated on the first append. */
+static const size_t initial_capacity = 8;
+
+/* Storage of lists that have never been appended to, so that they can be
+ * iterated and exposed as an argv without allocating memory.  Never
+ * written to. */
+static void *empty_objects[1] = { NULL };
+
+static
+void **
+objects(const atf_list_t *l)
+{
+    return l->m_objects != NULL ? l->m_objects : empty_objects;
+}
 
 static
 atf_list_citer_t
-entry_to_citer(const atf_list_t *l, const struct list_entry *le)
+entry_to_citer(const atf_list_t *l, void *const *entry)
 {
     atf_list_citer_t iter;
     iter.m_list = l;
-    iter.m_entry = le;
+    iter.m_entry = entry;
     return iter;
 }
 
 static
 atf_list_iter_t
-entry_to_iter(atf_list_t *l, struct list_entry *le)
+entry_to_iter(atf_list_t *l, void **entry)
 {
     atf_list_iter_t iter;
     iter.m_list = l;
-    iter.m_entry = le;
+    iter.m_entry = entry;
     return iter;
 }
 
+/* Makes room for at least 'capacity' objects, doubling the current size of
+ * the arrays to keep appends amortized O(1).  The objects array always has
+ * one extra slot for the terminating NULL. */
 static
-struct list_entry *
-new_entry(void *object, bool managed)
-{
-    struct list_entry *le;
-
-    le = (struct list_entry *)malloc(sizeof(*le));
-    if (le != NULL) {
-        le->m_prev = le->m_next = NULL;
-        le->m_object = object;
-        le->m_managed = managed;
-    } else if (managed)
-        free(object);
-
-    return le;
-}
-
-static
-void
-delete_entry(struct list_entry *le)
+atf_error_t
+grow(atf_list_t *l, size_t capacity)
 {
-    if (le->m_managed)
-        free(le->m_object);
-
-    free(le);
-}
+    void **objects;
+    bool *managed;
+    size_t newcap;
+
+    if (capacity <= l->m_capacity)
+        return atf_no_error();
+
+    newcap = l->m_capacity == 0 ? initial_capacity : l->m_capacity;
+    while (newcap < capacity) {
+        if (newcap > SIZE_MAX / 2 / sizeof(void *))
+            return atf_no_memory_error();
+        newcap *= 2;
+    }
 
-static
-struct list_entry *
-new_entry_and_link(void *object, bool managed, struct list_entry *prev,
-                   struct list_entry *next)
-{
-    struct list_entry *le;
+    if (l->m_arena != NULL) {
+        /* The old arrays are only reclaimed with the arena; growing
+         * geometrically bounds the waste to the final size of the list. */
+        objects = (void **)atf_arena_alloc(l->m_arena,
+                                           (newcap + 1) * sizeof(void *));
+        managed = (bool *)atf_arena_alloc(l->m_arena, newcap * sizeof(bool));
+        if (objects == NULL || managed == NULL)
+            return atf_no_memory_error();
+        if (l->m_size > 0) {
+            memcpy(objects, l->m_objects, l->m_size * sizeof(void *));
+            memcpy(managed, l->m_managed, l->m_size * sizeof(bool));
+        }
+        objects[l->m_size] = NULL;
+        l->m_objects = objects;
+        l->m_managed = managed;
+        l->m_capacity = newcap;
+        return atf_no_error();
+    }
 
-    le = new_entry(object, managed);
-    if (le != NULL) {
-        le->m_prev = prev;
-        le->m_next = next;
+    objects = (void **)realloc(l->m_objects, (newcap + 1) * sizeof(void *));
+    if (objects == NULL)
+        return atf_no_memory_error();
+    l->m_objects = objects;
+    if (l->m_size == 0)
+        l->m_objects[0] = NULL;
 
-        prev->m_next = le;
-        next->m_prev = le;
-    }
+    managed = (bool *)realloc(l->m_managed, newcap * sizeof(bool));
+    if (managed == NULL)
+        return atf_no_memory_error();
+    l->m_managed = managed;
 
-    return le;
+    l->m_capacity = newcap;
+    return atf_no_error();
 }
 
 /* ---------------------------------------------------------------------
@@ -120,21 +139,21 @@ new_entry_and_link(void *object, bool managed, struct list_entry *prev,
 const void *
 atf_list_citer_data(const atf_list_citer_t citer)
 {
-    const struct list_entry *le = citer.m_entry;
-    PRE(le != NULL);
-    return le->m_object;
+    void *const *entry = citer.m_entry;
+    PRE(entry != NULL);
+    return *entry;
 }
 
 atf_list_citer_t
 atf_list_citer_next(const atf_list_citer_t citer)
 {
-    const struct list_entry *le = citer.m_entry;
+    void *const *entry = citer.m_entry;
     atf_list_citer_t newciter;
 
-    PRE(le != NULL);
+    PRE(entry != NULL);
 
     newciter = citer;
-    newciter.m_entry = le->m_next;
+    newciter.m_entry = entry + 1;
 
     return newciter;
 }
@@ -157,21 +176,21 @@ atf_equal_list_citer_list_citer(const atf_list_citer_t i1,
 void *
 atf_list_iter_data(const atf_list_iter_t iter)
 {
-    const struct list_entry *le = iter.m_entry;
-    PRE(le != NULL);
-    return le->m_object;
+    void **entry = iter.m_entry;
+    PRE(entry != NULL);
+    return *entry;
 }
 
 atf_list_iter_t
 atf_list_iter_next(const atf_list_iter_t iter)
 {
-    const struct list_entry *le = iter.m_entry;
+    void **entry = iter.m_entry;
     atf_list_iter_t newiter;
 
-    PRE(le != NULL);
+    PRE(entry != NULL);
 
     newiter = iter;
-    newiter.m_entry = le->m_next;
+    newiter.m_entry = entry + 1;
 
     return newiter;
 }
@@ -194,50 +213,41 @@ atf_equal_list_iter_list_iter(const atf_list_iter_t i1,
 atf_error_t
 atf_list_init(atf_list_t *l)
 {
-    struct list_entry *lebeg, *leend;
-
-    lebeg = new_entry(NULL, false);
-    if (lebeg == NULL) {
-        return atf_no_memory_error();
-    }
-
-    leend = new_entry(NULL, false);
-    if (leend == NULL) {
-        free(lebeg);
-        return atf_no_memory_error();
-    }
-
-    lebeg->m_next = leend;
-    lebeg->m_prev = NULL;
-
-    leend->m_next = NULL;
-    leend->m_prev = lebeg;
-
+    l->m_objects = NULL;
+    l->m_managed = NULL;
     l->m_size = 0;
-    l->m_begin = lebeg;
-    l->m_end = leend;
+    l->m_capacity = 0;
+    l->m_arena = NULL;
 
     return atf_no_error();
 }
 
-void
-atf_list_fini(atf_list_t *l)
+/* Initializes a list whose storage is taken from 'arena', which must
+ * outlive it. */
+atf_error_t
+atf_list_init_arena(atf_list_t *l, atf_arena_t *arena)
 {
-    struct list_entry *le;
-    size_t freed;
+    atf_error_t err;
 
-    le = (struct list_entry *)l->m_begin;
-    freed = 0;
-    while (le != NULL) {
-        struct list_entry *lenext;
+    err = atf_list_init(l);
+    if (!atf_is_error(err))
+        l->m_arena = arena;
+    return err;
+}
 
-        lenext = le->m_next;
-        delete_entry(le);
-        le = lenext;
+void
+atf_list_fini(atf_list_t *l)
+{
+    size_t i;
 
-        freed++;
+    for (i = 0; i < l->m_size; i++) {
+        if (l->m_managed[i])
+            free(l->m_objects[i]);
+    }
+    if (l->m_arena == NULL) {
+        free(l->m_objects);
+        free(l->m_managed);
     }
-    INV(freed == l->m_size + 2);
 }
 
 /*
@@ -247,66 +257,39 @@ atf_list_fini(atf_list_t *l)
 atf_list_iter_t
 atf_list_begin(atf_list_t *l)
 {
-    struct list_entry *le = l->m_begin;
-    return entry_to_iter(l, le->m_next);
+    return entry_to_iter(l, objects(l));
 }
 
 atf_list_citer_t
 atf_list_begin_c(const atf_list_t *l)
 {
-    const struct list_entry *le = l->m_begin;
-    return entry_to_citer(l, le->m_next);
+    return entry_to_citer(l, objects(l));
 }
 
 atf_list_iter_t
 atf_list_end(atf_list_t *l)
 {
-    return entry_to_iter(l, l->m_end);
+    return entry_to_iter(l, objects(l) + l->m_size);
 }
 
 atf_list_citer_t
 atf_list_end_c(const atf_list_t *l)
 {
-    return entry_to_citer(l, l->m_end);
+    return entry_to_citer(l, objects(l) + l->m_size);
 }
 
 void *
 atf_list_index(atf_list_t *list, const size_t idx)
 {
-    atf_list_iter_t iter;
-
     PRE(idx < atf_list_size(list));
-
-    iter = atf_list_begin(list);
-    {
-        size_t pos = 0;
-        while (pos < idx &&
-               !atf_equal_list_iter_list_iter((iter), atf_list_end(list))) {
-            iter = atf_list_iter_next(iter);
-            pos++;
-        }
-    }
-    return atf_list_iter_data(iter);
+    return list->m_objects[idx];
 }
 
 const void *
 atf_list_index_c(const atf_list_t *list, const size_t idx)
 {
-    atf_list_citer_t iter;
-
     PRE(idx < atf_list_size(list));
-
-    iter = atf_list_begin_c(list);
-    {
-        size_t pos = 0;
-        while (pos < idx &&
-               !atf_equal_list_citer_list_citer((iter),
-                                                atf_list_end_c(list))) {
-            iter = atf_list_citer_next(iter);
-            pos++;
-        }
-    }
-    return atf_list_citer_data(iter);
+    return list->m_objects[idx];
 }
 
 size_t
@@ -315,27 +298,33 @@ atf_list_size(const atf_list_t *l)
     return l->m_size;
 }
 
+/* Returns the contents of a list of non-NULL strings as a NULL-terminated
+ * array without copying them.  The array belongs to the list and is only valid
+ * until the list is modified or destroyed. */
+const char *const *
+atf_list_as_argv(const atf_list_t *l)
+{
+    INV(objects(l)[l->m_size] == NULL);
+    return (const char *const *)objects(l);
+}
+
 char **
 atf_list_to_charpp(const atf_list_t *l)
 {
     char **array;
-    atf_list_citer_t iter;
     size_t i;
 
     array = malloc(sizeof(char *) * (atf_list_size(l) + 1));
     if (array == NULL)
         goto out;
 
-    i = 0;
-    atf_list_for_each_c(iter, l) {
-        array[i] = strdup((const char *)atf_list_citer_data(iter));
+    for (i = 0; i < l->m_size; i++) {
+        array[i] = strdup((const char *)l->m_objects[i]);
         if (array[i] == NULL) {
             atf_utils_free_charpp(array);
             array = NULL;
             goto out;
         }
-
-        i++;
     }
     array[i] = NULL;
 
@@ -350,39 +339,96 @@ out:
 atf_error_t
 atf_list_append(atf_list_t *l, void *data, bool managed)
 {
-    struct list_entry *le, *next, *prev;
     atf_error_t err;
 
-    next = (struct list_entry *)l->m_end;
-    prev = next->m_prev;
-    le = new_entry_and_link(data, managed, prev, next);
-    if (le == NULL)
+    err = grow(l, l->m_size + 1);
+    if (atf_is_error(err)) {
+        if (managed)
+            free(data);
+        return err;
+    }
+
+    l->m_objects[l->m_size] = data;
+    l->m_managed[l->m_size] = managed;
+    l->m_size++;
+    l->m_objects[l->m_size] = NULL;
+
+    return atf_no_error();
+}
+
+/* Appends 'count' objects at once, growing the list only once.  As with
+ * atf_list_append, managed objects are released if this fails. */
+atf_error_t
+atf_list_append_array(atf_list_t *l, void *const *data, size_t count,
+                      bool managed)
+{
+    atf_error_t err;
+    size_t i;
+
+    if (count == 0)
+        return atf_no_error();
+
+    if (count > SIZE_MAX - l->m_size)
         err = atf_no_memory_error();
-    else {
-        l->m_size++;
-        err = atf_no_error();
+    else
+        err = grow(l, l->m_size + count);
+    if (atf_is_error(err)) {
+        if (managed) {
+            for (i = 0; i < count; i++)
+                free(data[i]);
+        }
+        return err;
     }
 
-    return err;
+    memcpy(l->m_objects + l->m_size, data, count * sizeof(void *));
+    for (i = 0; i < count; i++)
+        l->m_managed[l->m_size + i] = managed;
+    l->m_size += count;
+    l->m_objects[l->m_size] = NULL;
+
+    return atf_no_error();
 }
 
-void
+/* Moves all the objects of 'src' to the end of 'l'.  On success, 'src' is
+ * consumed and must not be finalized; on failure, both lists are left
+ * untouched. */
+atf_error_t
 atf_list_append_list(atf_list_t *l, atf_list_t *src)
 {
-    struct list_entry *e1, *e2, *ghost1, *ghost2;
+    atf_error_t err;
 
-    ghost1 = (struct list_entry *)l->m_end;
-    ghost2 = (struct list_entry *)src->m_begin;
+    if (l->m_size == 0) {
+        atf_list_fini(l);
+        *l = *src;
+        return atf_no_error();
+    }
 
-    e1 = ghost1->m_prev;
-    e2 = ghost2->m_next;
+    err = grow(l, l->m_size + src->m_size);
+    if (atf_is_error(err))
+        return err;
 
-    delete_entry(ghost1);
-    delete_entry(ghost2);
+    if (src->m_size > 0) {
+        memcpy(l->m_objects + l->m_size, src->m_objects,
+               src->m_size * sizeof(void *));
+        memcpy(l->m_managed + l->m_size, src->m_managed,
+               src->m_size * sizeof(bool));
+    }
+    l->m_size += src->m_size;
+    if (l->m_objects != NULL)
+        l->m_objects[l->m_size] = NULL;
 
-    e1->m_next = e2;
-    e2->m_prev = e1;
+    if (src->m_arena == NULL) {
+        free(src->m_objects);
+        free(src->m_managed);
+    }
 
-    l->m_end = src->m_end;
-    l->m_size += src->m_size;
+    return atf_no_error();
+}
+
+/* Makes room for 'count' objects so that appending up to that many does
+ * not need to allocate memory. */
+atf_error_t
+atf_list_reserve(atf_list_t *l, size_t count)
+{
+    return grow(l, count);
 }
@@ -30,6 +30,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include <atf-c/detail/arena.h>
 #include <atf-c/error_fwd.h>
 
 /* ---------------------------------------------------------------------
@@ -72,16 +73,24 @@ bool atf_equal_list_iter_list_iter(const atf_list_iter_t,
  * The "atf_list" type.
  * --------------------------------------------------------------------- */
 
+/* The objects are kept in a contiguous array that is always terminated
+ * by a NULL pointer so that lists of strings can be handed to exec(3)
+ * as is.  Appending may move the array, which invalidates iterators.
+ * If m_arena is not NULL, the arrays are allocated from it. */
 struct atf_list {
-    void *m_begin;
-    void *m_end;
+    void **m_objects;
+    bool *m_managed;
 
     size_t m_size;
+    size_t m_capacity;
+
+    atf_arena_t *m_arena;
 };
 typedef struct atf_list atf_list_t;
 
 /* Constructors and destructors */
 atf_error_t atf_list_init(atf_list_t *);
+atf_error_t atf_list_init_arena(atf_list_t *, atf_arena_t *);
 void atf_list_fini(atf_list_t *);
 
 /* Getters. */
@@ -92,11 +101,14 @@ atf_list_citer_t atf_list_end_c(const atf_list_t *);
 void *atf_list_index(atf_list_t *, const size_t);
 const void *atf_list_index_c(const atf_list_t *, const size_t);
 size_t atf_list_size(const atf_list_t *);
+const char *const *atf_list_as_argv(const atf_list_t *);
 char **atf_list_to_charpp(const atf_list_t *);
 
 /* Modifiers. */
 atf_error_t atf_list_append(atf_list_t *, void *, bool);
-void atf_list_append_list(atf_list_t *, atf_list_t *);
+atf_error_t atf_list_append_array(atf_list_t *, void *const *, size_t, bool);
+atf_error_t atf_list_append_list(atf_list_t *, atf_list_t *);
+atf_error_t atf_list_reserve(atf_list_t *, size_t);
 
 /* Macros. */
 #define atf_list_for_each(iter, list) \
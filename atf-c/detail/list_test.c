@@ -26,6 +26,7 @@
 #include "atf-c/detail/list.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <atf-c.h>
@@ -55,6 +56,32 @@ ATF_TC_BODY(list_init, tc)
     atf_list_fini(&list);
 }
 
+ATF_TC(list_init_arena);
+ATF_TC_HEAD(list_init_arena, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks the atf_list_init_arena "
+                      "function");
+}
+ATF_TC_BODY(list_init_arena, tc)
+{
+    atf_arena_t arena;
+    atf_list_t list;
+    char buf[] = "Test string";
+    size_t i;
+
+    atf_arena_init(&arena);
+    RE(atf_list_init_arena(&list, &arena));
+    for (i = 0; i < 100; i++)
+        RE(atf_list_append(&list, buf, false));
+    RE(atf_list_append(&list, strdup("managed"), true));
+    ATF_REQUIRE_EQ(atf_list_size(&list), 101);
+    ATF_CHECK_STREQ("managed", (const char *)atf_list_index_c(&list, 100));
+    ATF_CHECK_EQ(NULL, atf_list_as_argv(&list)[101]);
+    ATF_REQUIRE(atf_arena_get_usage(&arena).m_allocs > 0);
+    atf_list_fini(&list);
+    atf_arena_fini(&arena);
+}
+
 /*
  * Getters.
  */
@@ -145,6 +172,41 @@ ATF_TC_BODY(list_to_charpp_some, tc)
     atf_utils_free_charpp(array);
 }
 
+ATF_TC_WITHOUT_HEAD(list_as_argv_empty);
+ATF_TC_BODY(list_as_argv_empty, tc)
+{
+    atf_list_t list;
+    const char *const *argv;
+
+    RE(atf_list_init(&list));
+    ATF_REQUIRE((argv = atf_list_as_argv(&list)) != NULL);
+    ATF_CHECK_EQ(NULL, argv[0]);
+    atf_list_fini(&list);
+}
+
+ATF_TC_WITHOUT_HEAD(list_as_argv_some);
+ATF_TC_BODY(list_as_argv_some, tc)
+{
+    atf_list_t list;
+    const char *const *argv;
+
+    char s1[] = "one";
+    char s2[] = "two";
+    char s3[] = "three";
+
+    RE(atf_list_init(&list));
+    RE(atf_list_append(&list, s1, false));
+    RE(atf_list_append(&list, s2, false));
+    RE(atf_list_append(&list, s3, false));
+    ATF_REQUIRE((argv = atf_list_as_argv(&list)) != NULL);
+
+    ATF_CHECK(argv[0] == s1);
+    ATF_CHECK(argv[1] == s2);
+    ATF_CHECK(argv[2] == s3);
+    ATF_CHECK_EQ(NULL, argv[3]);
+    atf_list_fini(&list);
+}
+
 /*
  * Modifiers.
  */
@@ -182,7 +244,7 @@ ATF_TC_BODY(list_append_list, tc)
         RE(atf_list_init(&l1));
         RE(atf_list_init(&l2));
 
-        atf_list_append_list(&l1, &l2);
+        RE(atf_list_append_list(&l1, &l2));
         ATF_CHECK_EQ(atf_list_size(&l1), 0);
 
         atf_list_fini(&l1);
@@ -196,7 +258,7 @@ ATF_TC_BODY(list_append_list, tc)
         RE(atf_list_append(&l1, &item, false));
         RE(atf_list_init(&l2));
 
-        atf_list_append_list(&l1, &l2);
+        RE(atf_list_append_list(&l1, &l2));
         ATF_CHECK_EQ(atf_list_size(&l1), 1);
         ATF_CHECK_EQ(*(int *)atf_list_index(&l1, 0), item);
 
@@ -211,7 +273,7 @@ ATF_TC_BODY(list_append_list, tc)
         RE(atf_list_init(&l2));
         RE(atf_list_append(&l2, &item, false));
 
-        atf_list_append_list(&l1, &l2);
+        RE(atf_list_append_list(&l1, &l2));
         ATF_CHECK_EQ(atf_list_size(&l1), 1);
         ATF_CHECK_EQ(*(int *)atf_list_index(&l1, 0), item);
 
@@ -228,7 +290,7 @@ ATF_TC_BODY(list_append_list, tc)
         RE(atf_list_init(&l2));
         RE(atf_list_append(&l2, &item2, false));
 
-        atf_list_append_list(&l1, &l2);
+        RE(atf_list_append_list(&l1, &l2));
         ATF_CHECK_EQ(atf_list_size(&l1), 2);
         ATF_CHECK_EQ(*(int *)atf_list_index(&l1, 0), item1);
         ATF_CHECK_EQ(*(int *)atf_list_index(&l1, 1), item2);
@@ -238,23 +300,81 @@ ATF_TC_BODY(list_append_list, tc)
 
     {
         atf_list_t l1, l2;
-        atf_list_citer_t end1, end2;
+        int items[100];
+        size_t i;
 
         RE(atf_list_init(&l1));
         RE(atf_list_init(&l2));
+        for (i = 0; i < 100; i++) {
+            items[i] = i;
+            RE(atf_list_append(i < 30 ? &l1 : &l2, &items[i], false));
+        }
 
-        end1 = atf_list_end_c(&l1);
-        end2 = atf_list_end_c(&l2);
-        /* XXX Shouldn't query m_entry here. */
-        ATF_CHECK(end1.m_entry != end2.m_entry);
-
-        atf_list_append_list(&l1, &l2);
-        ATF_CHECK(atf_list_end_c(&l1).m_entry == end2.m_entry);
+        RE(atf_list_append_list(&l1, &l2));
+        ATF_REQUIRE_EQ(atf_list_size(&l1), 100);
+        for (i = 0; i < 100; i++)
+            ATF_CHECK_EQ(*(int *)atf_list_index(&l1, i), (int)i);
 
         atf_list_fini(&l1);
     }
 }
 
+ATF_TC(list_append_array);
+ATF_TC_HEAD(list_append_array, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks the atf_list_append_array "
+                      "function");
+}
+ATF_TC_BODY(list_append_array, tc)
+{
+    atf_list_t list;
+    char *managed[3];
+    char s1[] = "one";
+    char s2[] = "two";
+    char *unmanaged[2] = { s1, s2 };
+
+    RE(atf_list_init(&list));
+    RE(atf_list_append_array(&list, (void *const *)unmanaged, 0, false));
+    ATF_REQUIRE_EQ(atf_list_size(&list), 0);
+
+    RE(atf_list_append_array(&list, (void *const *)unmanaged, 2, false));
+    ATF_REQUIRE((managed[0] = strdup("three")) != NULL);
+    ATF_REQUIRE((managed[1] = strdup("four")) != NULL);
+    ATF_REQUIRE((managed[2] = strdup("five")) != NULL);
+    RE(atf_list_append_array(&list, (void *const *)managed, 3, true));
+
+    ATF_REQUIRE_EQ(atf_list_size(&list), 5);
+    ATF_CHECK_STREQ("one", (const char *)atf_list_index_c(&list, 0));
+    ATF_CHECK_STREQ("two", (const char *)atf_list_index_c(&list, 1));
+    ATF_CHECK_STREQ("three", (const char *)atf_list_index_c(&list, 2));
+    ATF_CHECK_STREQ("five", (const char *)atf_list_index_c(&list, 4));
+
+    atf_list_fini(&list);
+}
+
+ATF_TC(list_reserve);
+ATF_TC_HEAD(list_reserve, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that atf_list_reserve avoids "
+                      "moving the list while appending");
+}
+ATF_TC_BODY(list_reserve, tc)
+{
+    atf_list_t list;
+    const char *const *argv;
+    char buf[] = "Test string";
+    size_t i;
+
+    RE(atf_list_init(&list));
+    RE(atf_list_reserve(&list, 1000));
+    argv = atf_list_as_argv(&list);
+    for (i = 0; i < 1000; i++)
+        RE(atf_list_append(&list, buf, false));
+    ATF_REQUIRE(argv == atf_list_as_argv(&list));
+    ATF_REQUIRE_EQ(atf_list_size(&list), 1000);
+    atf_list_fini(&list);
+}
+
 /*
  * Macros.
  */
@@ -346,16 +466,21 @@ ATF_TP_ADD_TCS(tp)
 {
     /* Constructors and destructors. */
     ATF_TP_ADD_TC(tp, list_init);
+    ATF_TP_ADD_TC(tp, list_init_arena);
 
     /* Getters. */
     ATF_TP_ADD_TC(tp, list_index);
     ATF_TP_ADD_TC(tp, list_index_c);
     ATF_TP_ADD_TC(tp, list_to_charpp_empty);
     ATF_TP_ADD_TC(tp, list_to_charpp_some);
+    ATF_TP_ADD_TC(tp, list_as_argv_empty);
+    ATF_TP_ADD_TC(tp, list_as_argv_some);
 
     /* Modifiers. */
     ATF_TP_ADD_TC(tp, list_append);
     ATF_TP_ADD_TC(tp, list_append_list);
+    ATF_TP_ADD_TC(tp, list_append_array);
+    ATF_TP_ADD_TC(tp, list_reserve);
 
     /* Macros. */
     ATF_TP_ADD_TC(tp, list_for_each);
@@ -26,6 +26,7 @@
 #include "atf-c/detail/map.h"
 
 #include <errno.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -38,30 +39,160 @@
  * --------------------------------------------------------------------- */
 
 struct map_entry {
-    char *m_key;
+    const char *m_key;
     void *m_value;
+    size_t m_hash;
     bool m_managed;
 };
 
+/* Marker for unused slots in the hash table; used slots hold the index of
+ * their entry. */
+static const size_t empty_slot = SIZE_MAX;
+
 static
-struct map_entry *
-new_entry(const char *key, void *value, bool managed)
+atf_arena_t *
+arena(atf_map_t *m)
 {
-    struct map_entry *me;
+    return m->m_arena != NULL ? m->m_arena : &m->m_keys;
+}
 
-    me = (struct map_entry *)malloc(sizeof(*me));
-    if (me != NULL) {
-        me->m_key = strdup(key);
-        if (me->m_key == NULL) {
-            free(me);
-            me = NULL;
-        } else {
-            me->m_value = value;
-            me->m_managed = managed;
-        }
+/* Allocates an array of 'count' elements of 'size' bytes each; from the
+ * external arena if there is one, in which case the old array is simply
+ * abandoned. */
+static
+void *
+alloc_array(atf_map_t *m, void *old, const size_t count, const size_t size,
+            const size_t oldcount)
+{
+    void *array;
+
+    if (count > SIZE_MAX / size)
+        return NULL;
+
+    if (m->m_arena == NULL)
+        return realloc(old, count * size);
+
+    array = atf_arena_alloc(m->m_arena, count * size);
+    if (array != NULL && oldcount > 0)
+        memcpy(array, old, oldcount * size);
+    return array;
+}
+
+static
+void
+free_array(atf_map_t *m, void *array)
+{
+    if (m->m_arena == NULL)
+        free(array);
+}
+
+/* 64-bit FNV-1a. */
+static
+size_t
+hash_key(const char *key)
+{
+    uint64_t h = UINT64_C(14695981039346656037);
+
+    for (; *key != '\0'; key++) {
+        h ^= (unsigned char)*key;
+        h *= UINT64_C(1099511628211);
     }
+    return (size_t)h;
+}
+
+/* Returns the slot for 'key': either the one that refers to its entry or
+ * the empty one where it should be inserted.  The table is never full, so
+ * probing always terminates. */
+static
+size_t
+find_slot(const atf_map_t *m, const char *key, const size_t hash)
+{
+    const size_t mask = m->m_nslots - 1;
+    size_t pos;
+
+    PRE(m->m_nslots > 0);
+
+    for (pos = hash & mask; m->m_slots[pos] != empty_slot;
+         pos = (pos + 1) & mask) {
+        const struct map_entry *me = &m->m_entries[m->m_slots[pos]];
 
-    return me;
+        if (me->m_hash == hash && strcmp(me->m_key, key) == 0)
+            break;
+    }
+    return pos;
+}
+
+/* Rebuilds the hash table with 'nslots' slots, which must be a power of
+ * two. */
+static
+atf_error_t
+rehash(atf_map_t *m, const size_t nslots)
+{
+    size_t *slots;
+    size_t i;
+
+    slots = (size_t *)alloc_array(m, NULL, nslots, sizeof(size_t), 0);
+    if (slots == NULL)
+        return atf_no_memory_error();
+    for (i = 0; i < nslots; i++)
+        slots[i] = empty_slot;
+
+    free_array(m, m->m_slots);
+    m->m_slots = slots;
+    m->m_nslots = nslots;
+
+    for (i = 0; i < m->m_size; i++) {
+        const size_t pos = find_slot(m, m->m_entries[i].m_key,
+                                     m->m_entries[i].m_hash);
+        m->m_slots[pos] = i;
+    }
+
+    return atf_no_error();
+}
+
+/* Makes room for one more entry, keeping the load factor of the hash table
+ * under 3/4. */
+static
+atf_error_t
+grow(atf_map_t *m)
+{
+    atf_error_t err;
+
+    if (m->m_size == m->m_capacity) {
+        struct map_entry *entries;
+        size_t capacity;
+
+        capacity = m->m_capacity == 0 ? 8 : m->m_capacity * 2;
+        entries = (struct map_entry *)alloc_array(
+            m, m->m_entries, capacity, sizeof(struct map_entry), m->m_size);
+        if (entries == NULL)
+            return atf_no_memory_error();
+        m->m_entries = entries;
+        m->m_capacity = capacity;
+    }
+
+    if ((m->m_size + 1) * 4 > m->m_nslots * 3) {
+        err = rehash(m, m->m_nslots == 0 ? 16 : m->m_nslots * 2);
+        if (atf_is_error(err))
+            return err;
+    }
+
+    return atf_no_error();
+}
+
+static
+struct map_entry *
+find_entry(const atf_map_t *m, const char *key)
+{
+    size_t pos;
+
+    if (m->m_size == 0)
+        return NULL;
+
+    pos = find_slot(m, key, hash_key(key));
+    if (m->m_slots[pos] == empty_slot)
+        return NULL;
+    return &m->m_entries[m->m_slots[pos]];
 }
 
 /* ---------------------------------------------------------------------
@@ -91,12 +222,13 @@ atf_map_citer_data(const atf_map_citer_t citer)
 atf_map_citer_t
 atf_map_citer_next(const atf_map_citer_t citer)
 {
+    const struct map_entry *me = citer.m_entry;
     atf_map_citer_t newciter;
 
+    PRE(me != NULL);
+
     newciter = citer;
-    newciter.m_listiter = atf_list_citer_next(citer.m_listiter);
-    newciter.m_entry = ((const struct map_entry *)
-                        atf_list_citer_data(newciter.m_listiter));
+    newciter.m_entry = me + 1;
 
     return newciter;
 }
@@ -135,12 +267,13 @@ atf_map_iter_data(const atf_map_iter_t iter)
 atf_map_iter_t
 atf_map_iter_next(const atf_map_iter_t iter)
 {
+    struct map_entry *me = iter.m_entry;
     atf_map_iter_t newiter;
 
+    PRE(me != NULL);
+
     newiter = iter;
-    newiter.m_listiter = atf_list_iter_next(iter.m_listiter);
-    newiter.m_entry = ((struct map_entry *)
-                       atf_list_iter_data(newiter.m_listiter));
+    newiter.m_entry = me + 1;
 
     return newiter;
 }
@@ -163,35 +296,40 @@ atf_equal_map_iter_map_iter(const atf_map_iter_t i1,
 atf_error_t
 atf_map_init(atf_map_t *m)
 {
-    return atf_list_init(&m->m_list);
+    m->m_entries = NULL;
+    m->m_size = 0;
+    m->m_capacity = 0;
+    m->m_slots = NULL;
+    m->m_nslots = 0;
+    atf_arena_init(&m->m_keys);
+    m->m_arena = NULL;
+
+    return atf_no_error();
 }
 
+/* Initializes a map whose keys, copied values and internal arrays are
+ * taken from 'arena', which must outlive it. */
 atf_error_t
-atf_map_init_charpp(atf_map_t *m, const char *const *array)
+atf_map_init_arena(atf_map_t *m, atf_arena_t *a)
 {
     atf_error_t err;
-    const char *const *ptr = array;
 
     err = atf_map_init(m);
-    if (array != NULL) {
-        while (!atf_is_error(err) && *ptr != NULL) {
-            const char *key, *value;
-
-            key = *ptr;
-            INV(key != NULL);
-            ptr++;
+    if (!atf_is_error(err))
+        m->m_arena = a;
+    return err;
+}
 
-            if ((value = *ptr) == NULL) {
-                err = atf_libc_error(EINVAL, "List too short; no value for "
-                    "key '%s' provided", key);  /* XXX: Not really libc_error */
-                break;
-            }
-            ptr++;
+atf_error_t
+atf_map_init_charpp(atf_map_t *m, const char *const *array)
+{
+    atf_error_t err;
 
-            err = atf_map_insert(m, key, strdup(value), true);
-        }
-    }
+    err = atf_map_init(m);
+    if (atf_is_error(err))
+        return err;
 
+    err = atf_map_insert_charpp(m, array);
     if (atf_is_error(err))
         atf_map_fini(m);
 
@@ -201,17 +339,15 @@ atf_map_init_charpp(atf_map_t *m, const char *const *array)
 void
 atf_map_fini(atf_map_t *m)
 {
-    atf_list_iter_t iter;
-
-    atf_list_for_each(iter, &m->m_list) {
-        struct map_entry *me = atf_list_iter_data(iter);
+    size_t i;
 
-        if (me->m_managed)
-            free(me->m_value);
-        free(me->m_key);
-        free(me);
+    for (i = 0; i < m->m_size; i++) {
+        if (m->m_entries[i].m_managed)
+            free(m->m_entries[i].m_value);
     }
-    atf_list_fini(&m->m_list);
+    free_array(m, m->m_entries);
+    free_array(m, m->m_slots);
+    atf_arena_fini(&m->m_keys);
 }
 
 /*
@@ -223,8 +359,7 @@ atf_map_begin(atf_map_t *m)
 {
     atf_map_iter_t iter;
     iter.m_map = m;
-    iter.m_listiter = atf_list_begin(&m->m_list);
-    iter.m_entry = atf_list_iter_data(iter.m_listiter);
+    iter.m_entry = m->m_entries;
     return iter;
 }
 
@@ -233,8 +368,7 @@ atf_map_begin_c(const atf_map_t *m)
 {
     atf_map_citer_t citer;
     citer.m_map = m;
-    citer.m_listiter = atf_list_begin_c(&m->m_list);
-    citer.m_entry = atf_list_citer_data(citer.m_listiter);
+    citer.m_entry = m->m_entries;
     return citer;
 }
 
@@ -243,8 +377,7 @@ atf_map_end(atf_map_t *m)
 {
     atf_map_iter_t iter;
     iter.m_map = m;
-    iter.m_entry = NULL;
-    iter.m_listiter = atf_list_end(&m->m_list);
+    iter.m_entry = m->m_entries == NULL ? NULL : m->m_entries + m->m_size;
     return iter;
 }
 
@@ -253,26 +386,21 @@ atf_map_end_c(const atf_map_t *m)
 {
     atf_map_citer_t iter;
     iter.m_map = m;
-    iter.m_entry = NULL;
-    iter.m_listiter = atf_list_end_c(&m->m_list);
+    iter.m_entry = m->m_entries == NULL ? NULL : m->m_entries + m->m_size;
     return iter;
 }
 
 atf_map_iter_t
 atf_map_find(atf_map_t *m, const char *key)
 {
-    atf_list_iter_t iter;
-
-    atf_list_for_each(iter, &m->m_list) {
-        struct map_entry *me = atf_list_iter_data(iter);
+    struct map_entry *me;
 
-        if (strcmp(me->m_key, key) == 0) {
-            atf_map_iter_t i;
-            i.m_map = m;
-            i.m_entry = me;
-            i.m_listiter = iter;
-            return i;
-        }
+    me = find_entry(m, key);
+    if (me != NULL) {
+        atf_map_iter_t i;
+        i.m_map = m;
+        i.m_entry = me;
+        return i;
     }
 
     return atf_map_end(m);
@@ -281,18 +409,14 @@ atf_map_find(atf_map_t *m, const char *key)
 atf_map_citer_t
 atf_map_find_c(const atf_map_t *m, const char *key)
 {
-    atf_list_citer_t iter;
+    const struct map_entry *me;
 
-    atf_list_for_each_c(iter, &m->m_list) {
-        const struct map_entry *me = atf_list_citer_data(iter);
-
-        if (strcmp(me->m_key, key) == 0) {
-            atf_map_citer_t i;
-            i.m_map = m;
-            i.m_entry = me;
-            i.m_listiter = iter;
-            return i;
-        }
+    me = find_entry(m, key);
+    if (me != NULL) {
+        atf_map_citer_t i;
+        i.m_map = m;
+        i.m_entry = me;
+        return i;
     }
 
     return atf_map_end_c(m);
@@ -301,7 +425,7 @@ atf_map_find_c(const atf_map_t *m, const char *key)
 size_t
 atf_map_size(const atf_map_t *m)
 {
-    return atf_list_size(&m->m_list);
+    return m->m_size;
 }
 
 char **
@@ -348,32 +472,87 @@ atf_map_insert(atf_map_t *m, const char *key, void *value, bool managed)
 {
     struct map_entry *me;
     atf_error_t err;
-    atf_map_iter_t iter;
+    size_t hash, pos;
 
-    iter = atf_map_find(m, key);
-    if (atf_equal_map_iter_map_iter(iter, atf_map_end(m))) {
-        me = new_entry(key, value, managed);
-        if (me == NULL)
+    me = find_entry(m, key);
+    if (me == NULL) {
+        err = grow(m);
+        if (atf_is_error(err))
+            goto err;
+
+        me = &m->m_entries[m->m_size];
+        me->m_key = atf_arena_strdup(arena(m), key);
+        if (me->m_key == NULL) {
             err = atf_no_memory_error();
-        else {
-            err = atf_list_append(&m->m_list, me, false);
-            if (atf_is_error(err)) {
-                if (managed)
-                    free(value);
-                free(me);
-            }
+            goto err;
         }
+        hash = hash_key(key);
+        me->m_hash = hash;
+        me->m_value = value;
+        me->m_managed = managed;
+
+        pos = find_slot(m, key, hash);
+        INV(m->m_slots[pos] == empty_slot);
+        m->m_slots[pos] = m->m_size;
+        m->m_size++;
     } else {
-        me = iter.m_entry;
         if (me->m_managed)
             free(me->m_value);
 
         INV(strcmp(me->m_key, key) == 0);
         me->m_value = value;
         me->m_managed = managed;
+    }
+
+    return atf_no_error();
+
+err:
+    if (managed)
+        free(value);
+    return err;
+}
+
+/* Inserts the key/value pairs of a NULL-terminated array, copying the
+ * values into the arena of the map.  A NULL array is valid and empty. */
+atf_error_t
+atf_map_insert_charpp(atf_map_t *m, const char *const *array)
+{
+    atf_error_t err;
+    const char *const *ptr = array;
+
+    err = atf_no_error();
+    if (array != NULL) {
+        while (!atf_is_error(err) && *ptr != NULL) {
+            const char *key, *value;
 
-        err = atf_no_error();
+            key = *ptr;
+            INV(key != NULL);
+            ptr++;
+
+            if ((value = *ptr) == NULL) {
+                err = atf_libc_error(EINVAL, "List too short; no value for "
+                    "key '%s' provided", key);  /* XXX: Not really libc_error */
+                break;
+            }
+            ptr++;
+
+            err = atf_map_insert_copy(m, key, value);
+        }
     }
 
     return err;
 }
+
+/* Inserts a copy of the string 'value', allocated from the arena of the
+ * map.  Replacing the value later does not reclaim the copy until the map
+ * is destroyed. */
+atf_error_t
+atf_map_insert_copy(atf_map_t *m, const char *key, const char *value)
+{
+    char *copy;
+
+    copy = atf_arena_strdup(arena(m), value);
+    if (copy == NULL)
+        return atf_no_memory_error();
+    return atf_map_insert(m, key, copy, false);
+}
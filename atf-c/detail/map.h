@@ -28,8 +28,9 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 
-#include <atf-c/detail/list.h>
+#include <atf-c/detail/arena.h>
 #include <atf-c/error_fwd.h>
 
 /* ---------------------------------------------------------------------
@@ -39,7 +40,6 @@
 struct atf_map_citer {
     const struct atf_map *m_map;
     const void *m_entry;
-    atf_list_citer_t m_listiter;
 };
 typedef struct atf_map_citer atf_map_citer_t;
 
@@ -59,7 +59,6 @@ bool atf_equal_map_citer_map_citer(const atf_map_citer_t,
 struct atf_map_iter {
     struct atf_map *m_map;
     void *m_entry;
-    atf_list_iter_t m_listiter;
 };
 typedef struct atf_map_iter atf_map_iter_t;
 
@@ -76,15 +75,29 @@ bool atf_equal_map_iter_map_iter(const atf_map_iter_t,
  * The "atf_map" type.
  * --------------------------------------------------------------------- */
 
-/* A list-based map.  Typically very inefficient, but our maps are small
- * enough. */
+/* A hash map with open addressing.  The entries are kept in an array in
+ * insertion order, which is also the iteration order, and the hash table
+ * only holds indexes into that array.  Keys are copied into an arena owned
+ * by the map, or into m_arena if set, which then also holds the arrays.
+ * Inserting a new key invalidates iterators. */
+struct map_entry;
+
 struct atf_map {
-    atf_list_t m_list;
+    struct map_entry *m_entries;
+    size_t m_size;
+    size_t m_capacity;
+
+    size_t *m_slots;
+    size_t m_nslots;
+
+    atf_arena_t m_keys;
+    atf_arena_t *m_arena;
 };
 typedef struct atf_map atf_map_t;
 
 /* Constructors and destructors */
 atf_error_t atf_map_init(atf_map_t *);
+atf_error_t atf_map_init_arena(atf_map_t *, atf_arena_t *);
 atf_error_t atf_map_init_charpp(atf_map_t *, const char *const *);
 void atf_map_fini(atf_map_t *);
 
@@ -100,6 +113,8 @@ char **atf_map_to_charpp(const atf_map_t *);
 
 /* Modifiers. */
 atf_error_t atf_map_insert(atf_map_t *, const char *, void *, bool);
+atf_error_t atf_map_insert_charpp(atf_map_t *, const char *const *);
+atf_error_t atf_map_insert_copy(atf_map_t *, const char *, const char *);
 
 /* Macros. */
 #define atf_map_for_each(iter, map) \
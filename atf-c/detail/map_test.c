@@ -26,7 +26,9 @@
 #include "atf-c/detail/map.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <atf-c.h>
 
@@ -55,6 +57,34 @@ ATF_TC_BODY(map_init, tc)
     atf_map_fini(&map);
 }
 
+ATF_TC(map_init_arena);
+ATF_TC_HEAD(map_init_arena, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks the atf_map_init_arena "
+                      "function");
+}
+ATF_TC_BODY(map_init_arena, tc)
+{
+    atf_arena_t arena;
+    atf_map_t map;
+    char key[32];
+    size_t i;
+
+    atf_arena_init(&arena);
+    RE(atf_map_init_arena(&map, &arena));
+    for (i = 0; i < 100; i++) {
+        snprintf(key, sizeof(key), "key-%zd", i);
+        RE(atf_map_insert_copy(&map, key, key));
+    }
+    RE(atf_map_insert(&map, "managed", strdup("value"), true));
+    ATF_REQUIRE_EQ(atf_map_size(&map), 101);
+    ATF_REQUIRE_STREQ("key-42", (const char *)atf_map_citer_data(
+                      atf_map_find_c(&map, "key-42")));
+    ATF_REQUIRE(atf_arena_get_usage(&arena).m_allocs >= 200);
+    atf_map_fini(&map);
+    atf_arena_fini(&arena);
+}
+
 ATF_TC_WITHOUT_HEAD(map_init_charpp_null);
 ATF_TC_BODY(map_init_charpp_null, tc)
 {
@@ -388,6 +418,88 @@ ATF_TC_BODY(stable_keys, tc)
     atf_map_fini(&map);
 }
 
+ATF_TC(insertion_order);
+ATF_TC_HEAD(insertion_order, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that iteration follows the "
+                      "insertion order even after the map grows");
+}
+ATF_TC_BODY(insertion_order, tc)
+{
+    atf_map_t map;
+    atf_map_citer_t iter;
+    char key[32];
+    size_t i;
+
+    RE(atf_map_init(&map));
+    for (i = 0; i < 1000; i++) {
+        snprintf(key, sizeof(key), "key-%zd", 999 - i);
+        RE(atf_map_insert(&map, key, strdup(key), true));
+    }
+    RE(atf_map_insert(&map, "key-500", strdup("replaced"), true));
+    ATF_REQUIRE_EQ(atf_map_size(&map), 1000);
+
+    i = 0;
+    atf_map_for_each_c(iter, &map) {
+        snprintf(key, sizeof(key), "key-%zd", 999 - i);
+        ATF_REQUIRE_STREQ(key, atf_map_citer_key(iter));
+        if (i == 499)
+            ATF_REQUIRE_STREQ("replaced",
+                              (const char *)atf_map_citer_data(iter));
+        else
+            ATF_REQUIRE_STREQ(key, (const char *)atf_map_citer_data(iter));
+        i++;
+    }
+    ATF_REQUIRE_EQ(i, 1000);
+
+    atf_map_fini(&map);
+}
+
+static
+double
+elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1e9 +
+        (end->tv_nsec - start->tv_nsec);
+}
+
+ATF_TC(insert_find_many);
+ATF_TC_HEAD(insert_find_many, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Measures inserting and looking up a "
+                      "large number of keys");
+}
+ATF_TC_BODY(insert_find_many, tc)
+{
+    const size_t count = 100000;
+    struct timespec start, middle, end;
+    atf_map_t map;
+    char key[32];
+    size_t i;
+
+    RE(atf_map_init(&map));
+    ATF_REQUIRE(clock_gettime(CLOCK_MONOTONIC, &start) != -1);
+    for (i = 0; i < count; i++) {
+        snprintf(key, sizeof(key), "config.var-%zd", i);
+        RE(atf_map_insert(&map, key, NULL, false));
+    }
+    ATF_REQUIRE(clock_gettime(CLOCK_MONOTONIC, &middle) != -1);
+    for (i = 0; i < count; i++) {
+        snprintf(key, sizeof(key), "config.var-%zd", i);
+        ATF_REQUIRE(!atf_equal_map_citer_map_citer(atf_map_find_c(&map, key),
+                                                   atf_map_end_c(&map)));
+    }
+    ATF_REQUIRE(clock_gettime(CLOCK_MONOTONIC, &end) != -1);
+    ATF_REQUIRE(atf_equal_map_citer_map_citer(atf_map_find_c(&map, "x"),
+                                              atf_map_end_c(&map)));
+    ATF_REQUIRE_EQ(atf_map_size(&map), count);
+    atf_map_fini(&map);
+
+    printf("Inserted %zd keys in %.2f ns/key; looked them up in "
+           "%.2f ns/key\n", count, elapsed_ns(&start, &middle) / count,
+           elapsed_ns(&middle, &end) / count);
+}
+
 /* ---------------------------------------------------------------------
  * Main.
  * --------------------------------------------------------------------- */
@@ -396,6 +508,7 @@ ATF_TP_ADD_TCS(tp)
 {
     /* Constructors and destructors. */
     ATF_TP_ADD_TC(tp, map_init);
+    ATF_TP_ADD_TC(tp, map_init_arena);
     ATF_TP_ADD_TC(tp, map_init_charpp_null);
     ATF_TP_ADD_TC(tp, map_init_charpp_empty);
     ATF_TP_ADD_TC(tp, map_init_charpp_some);
@@ -416,6 +529,8 @@ ATF_TP_ADD_TCS(tp)
 
     /* Other. */
     ATF_TP_ADD_TC(tp, stable_keys);
+    ATF_TP_ADD_TC(tp, insertion_order);
+    ATF_TP_ADD_TC(tp, insert_find_many);
 
     return atf_no_error();
 }
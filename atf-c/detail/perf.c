@@ -0,0 +1,482 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/perf.h"
+
+#if defined(HAVE_CONFIG_H)
+#include "config.h"
+#endif
+
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+
+#if defined(HAVE_LINUX_PERF_EVENT_H)
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+#include <linux/perf_event.h>
+#endif
+
+#include <errno.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "atf-c/defs.h"
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/sanity.h"
+#include "atf-c/detail/text.h"
+#include "atf-c/error.h"
+
+/* ---------------------------------------------------------------------
+ * Events.
+ * --------------------------------------------------------------------- */
+
+/* Fields of getrusage(2) that can stand in for an event when it cannot be
+ * read through perf_event_open(2), either because the system does not
+ * provide it or because the user is not allowed to use it. */
+enum rusage_field {
+    RU_NONE,
+    RU_CPU_TIME,
+    RU_FAULTS,
+    RU_MINOR_FAULTS,
+    RU_MAJOR_FAULTS,
+    RU_SWITCHES,
+};
+
+struct atf_perf_event {
+    const char *m_name;
+    bool m_hardware;
+    /* Whether the event only happens in kernel context, in which case it
+     * cannot be counted with exclude_kernel set. */
+    bool m_kernel;
+    uint32_t m_type;
+    uint64_t m_config;
+    enum rusage_field m_rusage;
+};
+
+#if defined(HAVE_LINUX_PERF_EVENT_H)
+#   define EVENT(type, config) PERF_TYPE_ ## type, PERF_COUNT_ ## config
+#else
+#   define EVENT(type, config) 0, 0
+#endif
+
+static const struct atf_perf_event events[] = {
+    { "instructions", true, false, EVENT(HARDWARE, HW_INSTRUCTIONS),
+      RU_NONE },
+    { "cycles", true, false, EVENT(HARDWARE, HW_CPU_CYCLES), RU_NONE },
+    { "branches", true, false, EVENT(HARDWARE, HW_BRANCH_INSTRUCTIONS),
+      RU_NONE },
+    { "branch-misses", true, false, EVENT(HARDWARE, HW_BRANCH_MISSES),
+      RU_NONE },
+    { "cache-references", true, false, EVENT(HARDWARE, HW_CACHE_REFERENCES),
+      RU_NONE },
+    { "cache-misses", true, false, EVENT(HARDWARE, HW_CACHE_MISSES),
+      RU_NONE },
+    { "task-clock", false, false, EVENT(SOFTWARE, SW_TASK_CLOCK),
+      RU_CPU_TIME },
+    { "page-faults", false, false, EVENT(SOFTWARE, SW_PAGE_FAULTS),
+      RU_FAULTS },
+    { "minor-faults", false, false, EVENT(SOFTWARE, SW_PAGE_FAULTS_MIN),
+      RU_MINOR_FAULTS },
+    { "major-faults", false, false, EVENT(SOFTWARE, SW_PAGE_FAULTS_MAJ),
+      RU_MAJOR_FAULTS },
+    { "context-switches", false, true, EVENT(SOFTWARE, SW_CONTEXT_SWITCHES),
+      RU_SWITCHES },
+    { "cpu-migrations", false, true, EVENT(SOFTWARE, SW_CPU_MIGRATIONS),
+      RU_NONE },
+    { NULL, false, false, 0, 0, RU_NONE },
+};
+
+#undef EVENT
+
+/* The events collected when the specification says "default". */
+static const char *const default_events =
+    "instructions cycles branch-misses cache-misses task-clock page-faults "
+    "context-switches";
+
+/* The event that replaces the hardware ones if none of them can be read. */
+static const char *const fallback_event = "task-clock";
+
+static
+const struct atf_perf_event *
+find_event(const char *name)
+{
+    const struct atf_perf_event *iter;
+
+    for (iter = events; iter->m_name != NULL; iter++) {
+        if (strcmp(iter->m_name, name) == 0)
+            return iter;
+    }
+    return NULL;
+}
+
+#if defined(HAVE_LINUX_PERF_EVENT_H)
+static
+int
+open_event(const struct atf_perf_event *ev, const bool exclude_kernel)
+{
+    struct perf_event_attr attr;
+    unsigned long flags = 0;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = ev->m_type;
+    attr.config = ev->m_config;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+        PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = exclude_kernel ? 1 : 0;
+    attr.exclude_hv = 1;
+#if defined(PERF_FLAG_FD_CLOEXEC)
+    flags |= PERF_FLAG_FD_CLOEXEC;
+#endif
+
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, flags);
+}
+
+/* Reads the value of a stopped counter.  The time the counter was
+ * enabled and the time it was running differ if the kernel had to
+ * multiplex the hardware among several counters, in which case the
+ * value is extrapolated to the whole period. */
+static
+void
+read_event(struct atf_perf_counter *c)
+{
+    uint64_t buf[3];
+
+    if (read(c->m_fd, buf, sizeof(buf)) != (ssize_t)sizeof(buf) ||
+        buf[2] == 0)
+        return;
+    if (buf[2] < buf[1])
+        c->m_value = (uint64_t)((double)buf[0] * buf[1] / buf[2]);
+    else
+        c->m_value = buf[0];
+    c->m_valid = true;
+}
+#else
+static
+void
+read_event(struct atf_perf_counter *c ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+    UNREACHABLE;
+}
+#endif
+
+/* Sets up the way in which the value of a counter will be obtained.
+ *
+ * Hardware events only count user-space activity, which is what the
+ * default configuration of most systems allows unprivileged users to
+ * see.  Software events are counted in full if allowed, and only in
+ * user space otherwise unless they happen in kernel context. */
+static
+void
+counter_open(struct atf_perf_counter *c)
+{
+    const struct atf_perf_event *ev = c->m_event;
+
+    c->m_source = ATF_PERF_NONE;
+    c->m_fd = -1;
+    c->m_valid = false;
+    c->m_value = 0;
+
+#if defined(HAVE_LINUX_PERF_EVENT_H)
+    c->m_fd = open_event(ev, ev->m_hardware);
+    if (c->m_fd == -1 && !ev->m_hardware && !ev->m_kernel)
+        c->m_fd = open_event(ev, true);
+    if (c->m_fd != -1) {
+        c->m_source = ATF_PERF_EVENT;
+        return;
+    }
+#endif
+
+    if (ev->m_rusage != RU_NONE)
+        c->m_source = ATF_PERF_RUSAGE;
+}
+
+static
+atf_error_t
+add_counter(atf_perf_t *p, const struct atf_perf_event *ev)
+{
+    size_t i;
+
+    for (i = 0; i < p->m_ncounters; i++) {
+        if (p->m_counters[i].m_event == ev)
+            return atf_no_error();
+    }
+    if (p->m_ncounters == ATF_PERF_MAX_COUNTERS)
+        return atf_error_new_fmt("perf", "Too many perf events");
+
+    p->m_counters[p->m_ncounters].m_event = ev;
+    counter_open(&p->m_counters[p->m_ncounters]);
+    p->m_ncounters++;
+    return atf_no_error();
+}
+
+static
+atf_error_t
+add_event(const char *name, void *data)
+{
+    atf_perf_t *p = data;
+    const struct atf_perf_event *ev;
+
+    if (strcmp(name, "default") == 0)
+        return atf_text_for_each_word(default_events, " ", add_event, p);
+
+    ev = find_event(name);
+    if (ev == NULL)
+        return atf_error_new_fmt("perf", "Unknown perf event '%s'", name);
+    return add_counter(p, ev);
+}
+
+/* ---------------------------------------------------------------------
+ * Resource usage.
+ * --------------------------------------------------------------------- */
+
+static
+uint64_t
+tv_to_ns(const struct timeval *tv)
+{
+    return (uint64_t)tv->tv_sec * UINT64_C(1000000000) +
+        (uint64_t)tv->tv_usec * UINT64_C(1000);
+}
+
+static
+uint64_t
+rusage_value(const struct rusage *ru, const enum rusage_field field)
+{
+    switch (field) {
+    case RU_CPU_TIME:
+        return tv_to_ns(&ru->ru_utime) + tv_to_ns(&ru->ru_stime);
+    case RU_FAULTS:
+        return (uint64_t)ru->ru_minflt + (uint64_t)ru->ru_majflt;
+    case RU_MINOR_FAULTS:
+        return (uint64_t)ru->ru_minflt;
+    case RU_MAJOR_FAULTS:
+        return (uint64_t)ru->ru_majflt;
+    case RU_SWITCHES:
+        return (uint64_t)ru->ru_nvcsw + (uint64_t)ru->ru_nivcsw;
+    default:
+        UNREACHABLE;
+        return 0;
+    }
+}
+
+/* Computes the increase of a field since the counters were started,
+ * accounting for both the process and the children it waited for. */
+static
+uint64_t
+rusage_delta(const atf_perf_t *p, const struct rusage *self,
+             const struct rusage *children, const enum rusage_field field)
+{
+    return (rusage_value(self, field) + rusage_value(children, field)) -
+        (rusage_value(&p->m_start_self, field) +
+         rusage_value(&p->m_start_children, field));
+}
+
+/* ---------------------------------------------------------------------
+ * The "atf_perf" type.
+ * --------------------------------------------------------------------- */
+
+/*
+ * Constructors/destructors.
+ */
+
+/** Sets up the counters for the events in a specification.
+ *
+ * The specification is a list of event names separated by whitespace or
+ * commas, where "default" stands for the most useful ones.  Unknown
+ * names are an error, but events that cannot be read on this system are
+ * not: they are kept and reported as unavailable.  If none of the
+ * requested hardware events is available, task-clock is added in their
+ * place so that there is at least some measure of the work done. */
+atf_error_t
+atf_perf_init(atf_perf_t *p, const char *spec)
+{
+    atf_error_t err;
+    bool hardware, fallback;
+    size_t i;
+
+    p->m_ncounters = 0;
+    p->m_running = false;
+
+    err = atf_text_for_each_word(spec, " ,", add_event, p);
+    if (atf_is_error(err))
+        goto err;
+    if (p->m_ncounters == 0) {
+        err = atf_error_new_fmt("perf", "No perf events given");
+        goto err;
+    }
+
+    hardware = false;
+    fallback = true;
+    for (i = 0; i < p->m_ncounters; i++) {
+        const struct atf_perf_counter *c = &p->m_counters[i];
+
+        if (c->m_event->m_hardware) {
+            hardware = true;
+            if (c->m_source != ATF_PERF_NONE)
+                fallback = false;
+        }
+    }
+    if (hardware && fallback) {
+        err = add_counter(p, find_event(fallback_event));
+        if (atf_is_error(err))
+            goto err;
+    }
+
+    INV(!atf_is_error(err));
+    return err;
+
+err:
+    atf_perf_fini(p);
+    return err;
+}
+
+void
+atf_perf_fini(atf_perf_t *p)
+{
+    size_t i;
+
+    for (i = 0; i < p->m_ncounters; i++) {
+        if (p->m_counters[i].m_fd != -1)
+            close(p->m_counters[i].m_fd);
+    }
+    p->m_ncounters = 0;
+}
+
+/*
+ * Modifiers.
+ */
+
+void
+atf_perf_start(atf_perf_t *p)
+{
+    size_t i;
+
+    PRE(!p->m_running);
+
+    getrusage(RUSAGE_SELF, &p->m_start_self);
+    getrusage(RUSAGE_CHILDREN, &p->m_start_children);
+
+#if defined(HAVE_LINUX_PERF_EVENT_H)
+    for (i = 0; i < p->m_ncounters; i++) {
+        const struct atf_perf_counter *c = &p->m_counters[i];
+
+        if (c->m_source == ATF_PERF_EVENT) {
+            (void)ioctl(c->m_fd, PERF_EVENT_IOC_RESET, 0);
+            (void)ioctl(c->m_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    (void)i;
+#endif
+
+    p->m_running = true;
+}
+
+/** Stops the counters and records their values.
+ *
+ * Does nothing if the counters are not running, so that it can be called
+ * unconditionally on all the paths that terminate a test case. */
+void
+atf_perf_stop(atf_perf_t *p)
+{
+    struct rusage self, children;
+    size_t i;
+
+    if (!p->m_running)
+        return;
+
+#if defined(HAVE_LINUX_PERF_EVENT_H)
+    for (i = 0; i < p->m_ncounters; i++) {
+        const struct atf_perf_counter *c = &p->m_counters[i];
+
+        if (c->m_source == ATF_PERF_EVENT)
+            (void)ioctl(c->m_fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+#endif
+
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
+
+    for (i = 0; i < p->m_ncounters; i++) {
+        struct atf_perf_counter *c = &p->m_counters[i];
+
+        switch (c->m_source) {
+        case ATF_PERF_NONE:
+            break;
+
+        case ATF_PERF_EVENT:
+            read_event(c);
+            break;
+
+        case ATF_PERF_RUSAGE:
+            c->m_value = rusage_delta(p, &self, &children,
+                                      c->m_event->m_rusage);
+            c->m_valid = true;
+            break;
+        }
+    }
+
+    p->m_running = false;
+}
+
+/*
+ * Getters.
+ */
+
+/** Appends the values of the counters to a string as a JSON object.
+ *
+ * Counters that could not be read are given a null value. */
+atf_error_t
+atf_perf_format(const atf_perf_t *p, atf_dynstr_t *dest)
+{
+    atf_error_t err;
+    size_t i;
+
+    PRE(!p->m_running);
+
+    err = atf_dynstr_append_char(dest, '{');
+    for (i = 0; !atf_is_error(err) && i < p->m_ncounters; i++) {
+        const struct atf_perf_counter *c = &p->m_counters[i];
+
+        if (i > 0)
+            err = atf_dynstr_append_char(dest, ',');
+        if (!atf_is_error(err))
+            err = atf_text_append_json(dest, c->m_event->m_name);
+        if (atf_is_error(err))
+            break;
+        if (c->m_valid)
+            err = atf_dynstr_append_fmt(dest, ":%" PRIu64, c->m_value);
+        else
+            err = atf_dynstr_append_fmt(dest, ":null");
+    }
+    if (!atf_is_error(err))
+        err = atf_dynstr_append_char(dest, '}');
+    return err;
+}
@@ -0,0 +1,80 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#if !defined(ATF_C_DETAIL_PERF_H)
+#define ATF_C_DETAIL_PERF_H
+
+#include <sys/types.h>
+#include <sys/resource.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <atf-c/error_fwd.h>
+
+struct atf_dynstr;
+
+/* ---------------------------------------------------------------------
+ * The "atf_perf" type.
+ * --------------------------------------------------------------------- */
+
+#define ATF_PERF_MAX_COUNTERS 16
+
+/* How the value of a counter is obtained. */
+enum atf_perf_source {
+    ATF_PERF_NONE,
+    ATF_PERF_EVENT,
+    ATF_PERF_RUSAGE,
+};
+
+struct atf_perf_counter {
+    const struct atf_perf_event *m_event;
+    enum atf_perf_source m_source;
+    int m_fd;
+    bool m_valid;
+    uint64_t m_value;
+};
+
+struct atf_perf {
+    size_t m_ncounters;
+    struct atf_perf_counter m_counters[ATF_PERF_MAX_COUNTERS];
+    bool m_running;
+    struct rusage m_start_self;
+    struct rusage m_start_children;
+};
+typedef struct atf_perf atf_perf_t;
+
+/* Constructors/destructors. */
+atf_error_t atf_perf_init(atf_perf_t *, const char *);
+void atf_perf_fini(atf_perf_t *);
+
+/* Modifiers. */
+void atf_perf_start(atf_perf_t *);
+void atf_perf_stop(atf_perf_t *);
+
+/* Getters. */
+atf_error_t atf_perf_format(const atf_perf_t *, struct atf_dynstr *);
+
+#endif /* !defined(ATF_C_DETAIL_PERF_H) */
@@ -0,0 +1,289 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/perf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/env.h"
+#include "atf-c/detail/test_helpers.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+/* Does some work so that the counters have something to count. */
+static
+void
+busy_loop(void)
+{
+    volatile unsigned long sum = 0;
+    unsigned long i;
+    char *buf;
+
+    buf = malloc(1024 * 1024);
+    ATF_REQUIRE(buf != NULL);
+    memset(buf, 'x', 1024 * 1024);
+    for (i = 0; i < 10000000; i++)
+        sum += i ^ (unsigned long)buf[i % (1024 * 1024)];
+    free(buf);
+}
+
+/* Collects the given events around busy_loop and returns the formatted
+ * counters; the caller must free them. */
+static
+char *
+measure(const char *spec)
+{
+    atf_perf_t perf;
+    atf_dynstr_t out;
+
+    RE(atf_perf_init(&perf, spec));
+    atf_perf_start(&perf);
+    busy_loop();
+    atf_perf_stop(&perf);
+    RE(atf_dynstr_init(&out));
+    RE(atf_perf_format(&perf, &out));
+    atf_perf_fini(&perf);
+
+    printf("%s: %s\n", spec, atf_dynstr_cstring(&out));
+    return atf_dynstr_fini_disown(&out);
+}
+
+static
+void
+h_perf_head(atf_tc_t *tc)
+{
+    atf_tc_set_md_var(tc, "X-perf.events", "task-clock page-faults");
+}
+
+static
+void
+h_perf_body(const atf_tc_t *tc ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+    busy_loop();
+}
+
+static
+void
+h_bogus_head(atf_tc_t *tc)
+{
+    atf_tc_set_md_var(tc, "X-perf.events", "task-clock bogus");
+}
+
+static
+void
+h_skip_body(const atf_tc_t *tc ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+    atf_tc_skip("Not today");
+}
+
+/* ---------------------------------------------------------------------
+ * Test cases.
+ * --------------------------------------------------------------------- */
+
+ATF_TC_WITHOUT_HEAD(init__unknown_event);
+ATF_TC_BODY(init__unknown_event, tc)
+{
+    atf_perf_t perf;
+    atf_error_t err;
+    char buf[1024];
+
+    err = atf_perf_init(&perf, "task-clock foo");
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_REQUIRE(atf_error_is(err, "perf"));
+    atf_error_format(err, buf, sizeof(buf));
+    atf_error_free(err);
+    ATF_REQUIRE_STREQ("Unknown perf event 'foo'", buf);
+}
+
+ATF_TC_WITHOUT_HEAD(init__empty);
+ATF_TC_BODY(init__empty, tc)
+{
+    atf_perf_t perf;
+    atf_error_t err;
+
+    err = atf_perf_init(&perf, " , ");
+    ATF_REQUIRE(atf_error_is(err, "perf"));
+    atf_error_free(err);
+}
+
+ATF_TC_WITHOUT_HEAD(default_events);
+ATF_TC_BODY(default_events, tc)
+{
+    char *out = measure("default");
+
+    ATF_REQUIRE(atf_utils_grep_string("^\\{\"instructions\":[0-9n]", out));
+    ATF_REQUIRE(atf_utils_grep_string(",\"cycles\":", out));
+    ATF_REQUIRE(atf_utils_grep_string(",\"branch-misses\":", out));
+    ATF_REQUIRE(atf_utils_grep_string(",\"cache-misses\":", out));
+    ATF_REQUIRE(atf_utils_grep_string(",\"task-clock\":[0-9]+", out));
+    ATF_REQUIRE(atf_utils_grep_string(",\"page-faults\":[0-9]+", out));
+    ATF_REQUIRE(atf_utils_grep_string(",\"context-switches\":[0-9]+\\}$",
+                                      out));
+    free(out);
+}
+
+ATF_TC_WITHOUT_HEAD(software_events);
+ATF_TC_BODY(software_events, tc)
+{
+    char *out = measure("task-clock,page-faults,minor-faults,major-faults");
+
+    ATF_REQUIRE(atf_utils_grep_string("^\\{\"task-clock\":[0-9]+,"
+                                      "\"page-faults\":[1-9][0-9]*,"
+                                      "\"minor-faults\":[1-9][0-9]*,"
+                                      "\"major-faults\":[0-9]+\\}$", out));
+    free(out);
+}
+
+ATF_TC_WITHOUT_HEAD(duplicates);
+ATF_TC_BODY(duplicates, tc)
+{
+    char *out = measure("task-clock task-clock");
+
+    ATF_REQUIRE(atf_utils_grep_string("^\\{\"task-clock\":[0-9]+\\}$", out));
+    free(out);
+}
+
+ATF_TC_WITHOUT_HEAD(hardware_fallback);
+ATF_TC_BODY(hardware_fallback, tc)
+{
+    char *out = measure("instructions cycles");
+
+    if (atf_utils_grep_string("\"instructions\":null,\"cycles\":null", out))
+        ATF_REQUIRE(atf_utils_grep_string(",\"task-clock\":[0-9]+\\}$",
+                                          out));
+    else
+        ATF_REQUIRE(!atf_utils_grep_string("task-clock", out));
+    free(out);
+}
+
+ATF_TC_WITHOUT_HEAD(stop__idempotent);
+ATF_TC_BODY(stop__idempotent, tc)
+{
+    atf_perf_t perf;
+    atf_dynstr_t out1, out2;
+
+    RE(atf_perf_init(&perf, "task-clock"));
+    atf_perf_start(&perf);
+    busy_loop();
+    atf_perf_stop(&perf);
+    RE(atf_dynstr_init(&out1));
+    RE(atf_perf_format(&perf, &out1));
+    busy_loop();
+    atf_perf_stop(&perf);
+    RE(atf_dynstr_init(&out2));
+    RE(atf_perf_format(&perf, &out2));
+    atf_perf_fini(&perf);
+
+    ATF_REQUIRE(atf_equal_dynstr_dynstr(&out1, &out2));
+    atf_dynstr_fini(&out2);
+    atf_dynstr_fini(&out1);
+}
+
+ATF_TC_WITHOUT_HEAD(tc__record);
+ATF_TC_BODY(tc__record, tc)
+{
+    const char *const config[] = { NULL };
+    atf_tc_t h_tc;
+
+    RE(atf_env_set("ATF_RECORDS", "records.json"));
+    RE(atf_tc_init(&h_tc, "h_perf", h_perf_head, h_perf_body, NULL,
+                   config));
+    run_h_tc(&h_tc, "output", "error", "result");
+    atf_tc_fini(&h_tc);
+    RE(atf_tc_init(&h_tc, "h_skip", h_perf_head, h_skip_body, NULL,
+                   config));
+    run_h_tc(&h_tc, "output", "error", "result");
+    atf_tc_fini(&h_tc);
+
+    atf_utils_cat_file("records.json", "records: ");
+    ATF_REQUIRE(atf_utils_grep_file("^\\{\"tc\":\"h_perf\",\"result\":"
+                                    "\"passed\",\"perf\":\\{\"task-clock\":"
+                                    "[0-9]+,\"page-faults\":[0-9]+\\}\\}$",
+                                    "records.json"));
+    ATF_REQUIRE(atf_utils_grep_file("^\\{\"tc\":\"h_skip\",\"result\":"
+                                    "\"skipped\",\"perf\":\\{\"task-clock\":"
+                                    "[0-9]+,\"page-faults\":[0-9]+\\}\\}$",
+                                    "records.json"));
+    ATF_REQUIRE(atf_utils_compare_file("result", "skipped: Not today\n"));
+}
+
+ATF_TC_WITHOUT_HEAD(tc__no_record);
+ATF_TC_BODY(tc__no_record, tc)
+{
+    const char *const config[] = { NULL };
+    atf_tc_t h_tc;
+
+    RE(atf_env_set("ATF_RECORDS", "records.json"));
+    RE(atf_tc_init(&h_tc, "h_plain", NULL, h_perf_body, NULL, config));
+    run_h_tc(&h_tc, "output", "error", "result");
+    atf_tc_fini(&h_tc);
+
+    ATF_REQUIRE(!atf_utils_file_exists("records.json"));
+    ATF_REQUIRE(atf_utils_compare_file("result", "passed\n"));
+}
+
+ATF_TC_WITHOUT_HEAD(tc__invalid);
+ATF_TC_BODY(tc__invalid, tc)
+{
+    const char *const config[] = { NULL };
+    atf_tc_t h_tc;
+
+    RE(atf_env_set("ATF_RECORDS", "records.json"));
+    RE(atf_tc_init(&h_tc, "h_bogus", h_bogus_head, h_perf_body, NULL,
+                   config));
+    run_h_tc(&h_tc, "output", "error", "result");
+    atf_tc_fini(&h_tc);
+
+    ATF_REQUIRE(!atf_utils_file_exists("records.json"));
+    ATF_REQUIRE(atf_utils_compare_file("result", "failed: Invalid "
+        "X-perf.events: Unknown perf event 'bogus'\n"));
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    ATF_TP_ADD_TC(tp, init__unknown_event);
+    ATF_TP_ADD_TC(tp, init__empty);
+    ATF_TP_ADD_TC(tp, default_events);
+    ATF_TP_ADD_TC(tp, software_events);
+    ATF_TP_ADD_TC(tp, duplicates);
+    ATF_TP_ADD_TC(tp, hardware_fallback);
+    ATF_TP_ADD_TC(tp, stop__idempotent);
+    ATF_TP_ADD_TC(tp, tc__record);
+    ATF_TP_ADD_TC(tp, tc__no_record);
+    ATF_TP_ADD_TC(tp, tc__invalid);
+
+    return atf_no_error();
+}
@@ -37,6 +37,7 @@
 
 #include "atf-c/defs.h"
 #include "atf-c/detail/sanity.h"
+#include "atf-c/detail/trace.h"
 #include "atf-c/error.h"
 
 /* This prototype is not in the header file because this is a private
@@ -250,6 +251,7 @@ atf_process_child_init(atf_process_child_t *c)
     c->m_pid = 0;
     c->m_stdout = -1;
     c->m_stderr = -1;
+    c->m_trace_start = 0;
 
     return atf_no_error();
 }
@@ -274,6 +276,7 @@ atf_process_child_wait(atf_process_child_t *c, atf_process_status_t *s)
         err = atf_libc_error(errno, "Failed waiting for process %d",
                              c->m_pid);
     else {
+        ATF_TRACE_PROCESS(c->m_pid, c->m_trace_start, status);
         atf_process_child_fini(c);
         err = atf_process_status_init(s, status);
     }
@@ -458,6 +461,7 @@ fork_with_streams(atf_process_child_t *c,
     atf_error_t err;
     stream_prepare_t outsp;
     stream_prepare_t errsp;
+    uint64_t forked;
     pid_t pid;
 
     err = stream_prepare_init(&outsp, outsb);
@@ -468,6 +472,7 @@ fork_with_streams(atf_process_child_t *c,
     if (atf_is_error(err))
         goto err_outpipe;
 
+    forked = ATF_TRACE_NOW();
     pid = fork();
     if (pid == -1) {
         err = atf_libc_error(errno, "Failed to fork");
@@ -483,6 +488,7 @@ fork_with_streams(atf_process_child_t *c,
         err = do_parent(c, pid, &outsp, &errsp);
         if (atf_is_error(err))
             goto err_errpipe;
+        c->m_trace_start = forked;
     }
 
     goto out;
@@ -557,34 +563,6 @@ const_execvp(const char *file, const char *const *argv)
 #undef UNCONST
 }
 
-static
-atf_error_t
-list_to_array(const atf_list_t *l, const char ***ap)
-{
-    atf_error_t err;
-    const char **a;
-
-    a = (const char **)malloc((atf_list_size(l) + 1) * sizeof(const char *));
-    if (a == NULL)
-        err = atf_no_memory_error();
-    else {
-        const char **aiter;
-        atf_list_citer_t liter;
-
-        aiter = a;
-        atf_list_for_each_c(liter, l) {
-            *aiter = (const char *)atf_list_citer_data(liter);
-            aiter++;
-        }
-        *aiter = NULL;
-
-        err = atf_no_error();
-        *ap = a;
-    }
-
-    return err;
-}
-
 struct exec_args {
     const atf_fs_path_t *m_prog;
     const char *const *m_argv;
@@ -600,6 +578,7 @@ do_exec(void *v)
     if (ea->m_prehook != NULL)
         ea->m_prehook();
 
+    ATF_TRACE_EXEC(ea->m_argv);
     const int ret = const_execvp(atf_fs_path_cstring(ea->m_prog), ea->m_argv);
     const int errnocopy = errno;
     INV(ret == -1);
@@ -649,22 +628,11 @@ atf_process_exec_list(atf_process_status_t *s,
                       const atf_process_stream_t *errsb,
                       void (*prehook)(void))
 {
-    atf_error_t err;
-    const char **argv2;
-
     PRE(outsb == NULL ||
         atf_process_stream_type(outsb) != atf_process_stream_type_capture);
     PRE(errsb == NULL ||
         atf_process_stream_type(errsb) != atf_process_stream_type_capture);
 
-    argv2 = NULL; /* Silence GCC warning. */
-    err = list_to_array(argv, &argv2);
-    if (atf_is_error(err))
-        goto out;
-
-    err = atf_process_exec_array(s, prog, argv2, outsb, errsb, prehook);
-
-    free(argv2);
-out:
-    return err;
+    return atf_process_exec_array(s, prog, atf_list_as_argv(argv), outsb,
+                                  errsb, prehook);
 }
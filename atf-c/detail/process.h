@@ -29,6 +29,7 @@
 #include <sys/types.h>
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <atf-c/detail/fs.h>
 #include <atf-c/detail/list.h>
@@ -97,6 +98,9 @@ struct atf_process_child {
 
     int m_stdout;
     int m_stderr;
+
+    /* When the child was forked, if tracing. */
+    uint64_t m_trace_start;
 };
 typedef struct atf_process_child atf_process_child_t;
 
@@ -0,0 +1,109 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/record.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/env.h"
+#include "atf-c/detail/sanity.h"
+#include "atf-c/detail/text.h"
+#include "atf-c/error.h"
+
+/* ---------------------------------------------------------------------
+ * Free functions.
+ * --------------------------------------------------------------------- */
+
+static
+atf_error_t
+write_line(const int fd, const atf_dynstr_t *line)
+{
+    ssize_t ret;
+
+    while ((ret = write(fd, atf_dynstr_cstring(line),
+                        atf_dynstr_length(line))) == -1 && errno == EINTR)
+        continue; /* Retry. */
+    if (ret == -1)
+        return atf_libc_error(errno, "Failed to write record");
+    return atf_no_error();
+}
+
+/** Writes a record about a test case.
+ *
+ * A record is a JSON object in a line of its own that holds the name of
+ * the test case in its "tc" member, followed by the members given in the
+ * fields string, which must already be valid JSON without the enclosing
+ * braces.
+ *
+ * Records are appended to the file named by the ATF_RECORDS environment
+ * variable, or printed to stderr if it is not defined.  Every record is
+ * emitted with a single write(2) to a descriptor opened in append mode so
+ * that test programs running in parallel can share the same file. */
+atf_error_t
+atf_record_write(const char *ident, const char *fields)
+{
+    atf_error_t err;
+    atf_dynstr_t line;
+    int fd;
+
+    PRE(fields != NULL);
+
+    err = atf_dynstr_init_fmt(&line, "{\"tc\":");
+    if (atf_is_error(err))
+        goto out;
+    err = atf_text_append_json(&line, ident);
+    if (atf_is_error(err))
+        goto out_line;
+    if (*fields != '\0') {
+        err = atf_dynstr_append_fmt(&line, ",%s", fields);
+        if (atf_is_error(err))
+            goto out_line;
+    }
+    err = atf_dynstr_append_fmt(&line, "}\n");
+    if (atf_is_error(err))
+        goto out_line;
+
+    if (atf_env_has("ATF_RECORDS")) {
+        const char *path = atf_env_get("ATF_RECORDS");
+
+        fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd == -1) {
+            err = atf_libc_error(errno, "Cannot open records file %s", path);
+            goto out_line;
+        }
+        err = write_line(fd, &line);
+        close(fd);
+    } else {
+        err = write_line(STDERR_FILENO, &line);
+    }
+
+out_line:
+    atf_dynstr_fini(&line);
+out:
+    return err;
+}
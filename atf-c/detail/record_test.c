@@ -0,0 +1,88 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/record.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/env.h"
+#include "atf-c/detail/test_helpers.h"
+
+/* ---------------------------------------------------------------------
+ * Test cases.
+ * --------------------------------------------------------------------- */
+
+ATF_TC_WITHOUT_HEAD(write__file);
+ATF_TC_BODY(write__file, tc)
+{
+    RE(atf_env_set("ATF_RECORDS", "records.json"));
+    RE(atf_record_write("first", "\"a\":1"));
+    RE(atf_record_write("second \"tc\"", "\"b\":null,\"c\":\"x\""));
+    RE(atf_record_write("third", ""));
+
+    ATF_REQUIRE(atf_utils_compare_file("records.json",
+        "{\"tc\":\"first\",\"a\":1}\n"
+        "{\"tc\":\"second \\\"tc\\\"\",\"b\":null,\"c\":\"x\"}\n"
+        "{\"tc\":\"third\"}\n"));
+}
+
+ATF_TC_WITHOUT_HEAD(write__stderr);
+ATF_TC_BODY(write__stderr, tc)
+{
+    const pid_t pid = atf_utils_fork();
+    if (pid == 0) {
+        RE(atf_env_unset("ATF_RECORDS"));
+        RE(atf_record_write("the-tc", "\"a\":1"));
+        exit(EXIT_SUCCESS);
+    }
+    atf_utils_wait(pid, EXIT_SUCCESS, "", "{\"tc\":\"the-tc\",\"a\":1}\n");
+}
+
+ATF_TC_WITHOUT_HEAD(write__error);
+ATF_TC_BODY(write__error, tc)
+{
+    atf_error_t err;
+
+    RE(atf_env_set("ATF_RECORDS", "missing/records.json"));
+    err = atf_record_write("the-tc", "");
+    ATF_REQUIRE(atf_error_is(err, "libc"));
+    atf_error_free(err);
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    ATF_TP_ADD_TC(tp, write__file);
+    ATF_TP_ADD_TC(tp, write__stderr);
+    ATF_TP_ADD_TC(tp, write__error);
+
+    return atf_no_error();
+}
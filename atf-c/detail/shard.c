@@ -0,0 +1,399 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/shard.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/sanity.h"
+#include "atf-c/error.h"
+
+/* A line of the durations file.  The key points into the contents of the
+ * file, which are split in place. */
+struct duration {
+    const char *m_key;
+    double m_seconds;
+};
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static
+atf_error_t
+invalid_spec(const char *spec)
+{
+    return atf_error_new_fmt("shard", "Invalid shard specification `%s'; "
+                             "must be count or index/count with 1 <= index "
+                             "<= count", spec);
+}
+
+static
+bool
+parse_number(const char *str, const size_t length, size_t *value)
+{
+    const char *end;
+    char *endptr;
+    unsigned long ul;
+
+    if (length == 0 || !isdigit((unsigned char)str[0]))
+        return false;
+
+    end = str + length;
+    errno = 0;
+    ul = strtoul(str, &endptr, 10);
+    if (errno != 0 || endptr != end || ul == 0)
+        return false;
+
+    *value = ul;
+    return true;
+}
+
+/* Accepts the same numbers as the atf-sh library: digits with an optional
+ * fraction and exponent, followed by an optional "s". */
+static
+bool
+parse_seconds(const char *str, double *seconds)
+{
+    const char *ptr = str;
+    bool digits = false;
+
+    while (isdigit((unsigned char)*ptr)) {
+        digits = true;
+        ptr++;
+    }
+    if (*ptr == '.') {
+        ptr++;
+        while (isdigit((unsigned char)*ptr)) {
+            digits = true;
+            ptr++;
+        }
+    }
+    if (!digits)
+        return false;
+    if (*ptr == 'e' || *ptr == 'E') {
+        ptr++;
+        if (*ptr == '-' || *ptr == '+')
+            ptr++;
+        if (!isdigit((unsigned char)*ptr))
+            return false;
+        while (isdigit((unsigned char)*ptr))
+            ptr++;
+    }
+    if (strcmp(ptr, "") != 0 && strcmp(ptr, "s") != 0)
+        return false;
+
+    *seconds = strtod(str, NULL);
+    return isfinite(*seconds);
+}
+
+static
+atf_error_t
+parse_spec(const char *spec, size_t *index, size_t *count)
+{
+    const char *slash = strchr(spec, '/');
+
+    if (slash == NULL) {
+        *index = 0;
+        if (!parse_number(spec, strlen(spec), count))
+            return invalid_spec(spec);
+    } else {
+        if (!parse_number(spec, slash - spec, index) ||
+            !parse_number(slash + 1, strlen(slash + 1), count) ||
+            *index > *count)
+            return invalid_spec(spec);
+    }
+    return atf_no_error();
+}
+
+static
+atf_error_t
+read_file(const char *path, char **contents)
+{
+    atf_error_t err;
+    atf_dynstr_t buf;
+    char chunk[4096];
+    size_t n;
+    FILE *f;
+
+    f = fopen(path, "r");
+    if (f == NULL)
+        return atf_libc_error(errno, "Cannot open durations file %s", path);
+
+    err = atf_dynstr_init(&buf);
+    if (atf_is_error(err))
+        goto out_f;
+
+    while (!atf_is_error(err) && (n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        err = atf_dynstr_append_mem(&buf, chunk, n);
+    if (!atf_is_error(err) && ferror(f))
+        err = atf_libc_error(errno, "Cannot read durations file %s", path);
+
+    if (atf_is_error(err))
+        atf_dynstr_fini(&buf);
+    else {
+        *contents = atf_dynstr_fini_disown(&buf);
+        if (*contents == NULL)
+            err = atf_no_memory_error();
+    }
+out_f:
+    fclose(f);
+    return err;
+}
+
+/* Splits the contents of a durations file into its entries.  Every line
+ * holds a "program:ident" key and the duration of that test case in
+ * seconds, optionally followed by an "s"; blank lines and lines starting
+ * with "#" are ignored. */
+static
+atf_error_t
+parse_durations(const char *path, char *contents, struct duration **entries,
+                size_t *n)
+{
+    struct duration *array = NULL;
+    size_t count = 0, size = 0, lineno = 0;
+    char *line, *next;
+
+    for (line = contents; line != NULL; line = next) {
+        char *key, *value, *extra, *last;
+        double seconds;
+
+        next = strchr(line, '\n');
+        if (next != NULL)
+            *next++ = '\0';
+        lineno++;
+
+        key = strtok_r(line, " \t\r", &last);
+        if (key == NULL || key[0] == '#')
+            continue;
+        value = strtok_r(NULL, " \t\r", &last);
+        extra = strtok_r(NULL, " \t\r", &last);
+
+        if (value == NULL || extra != NULL || strchr(key, ':') == NULL ||
+            !parse_seconds(value, &seconds)) {
+            free(array);
+            return atf_error_new_fmt("shard", "Invalid line %zu in durations "
+                                     "file %s", lineno, path);
+        }
+
+        if (count == size) {
+            struct duration *grown;
+
+            size = size == 0 ? 64 : size * 2;
+            grown = realloc(array, size * sizeof(*array));
+            if (grown == NULL) {
+                free(array);
+                return atf_no_memory_error();
+            }
+            array = grown;
+        }
+        array[count].m_key = key;
+        array[count].m_seconds = seconds;
+        count++;
+    }
+
+    *entries = array;
+    *n = count;
+    return atf_no_error();
+}
+
+/* Longest test cases first, so that the greedy assignment below gets
+ * close to the best balance; ties are broken by name so that the order,
+ * and thus the result, does not depend on the order of the file. */
+static
+int
+compare_durations(const void *a, const void *b)
+{
+    const struct duration *d1 = a;
+    const struct duration *d2 = b;
+
+    if (d1->m_seconds != d2->m_seconds)
+        return d1->m_seconds > d2->m_seconds ? -1 : 1;
+    return strcmp(d1->m_key, d2->m_key);
+}
+
+/* Tells whether the program part of a key, which is usually relative to
+ * the root of the test suite, names the running program. */
+static
+bool
+program_matches(const char *key, const size_t length, const char *argv0)
+{
+    const size_t argv0len = strlen(argv0);
+
+    if (argv0len == length)
+        return strncmp(key, argv0, length) == 0;
+    return argv0len > length && argv0[argv0len - length - 1] == '/' &&
+        strncmp(key, argv0 + argv0len - length, length) == 0;
+}
+
+/* Spreads all the test cases in the durations file over the shards, each
+ * to the one with the least accumulated time, and records those of this
+ * program.  Every test program reads the same file and computes the same
+ * assignment, so the shards are balanced across the whole test suite. */
+static
+atf_error_t
+assign_durations(atf_shard_t *s, const char *path, const char *argv0)
+{
+    atf_error_t err;
+    struct duration *entries = NULL;
+    char *contents;
+    double *loads;
+    size_t i, n = 0;
+
+    err = read_file(path, &contents);
+    if (atf_is_error(err))
+        goto out;
+
+    err = parse_durations(path, contents, &entries, &n);
+    if (atf_is_error(err))
+        goto out_contents;
+    qsort(entries, n, sizeof(*entries), compare_durations);
+
+    loads = calloc(s->m_count, sizeof(*loads));
+    if (loads == NULL) {
+        err = atf_no_memory_error();
+        goto out_entries;
+    }
+
+    for (i = 0; i < n && !atf_is_error(err); i++) {
+        const char *key = entries[i].m_key;
+        const char *ident = strrchr(key, ':') + 1;
+        size_t j, best = 0;
+
+        for (j = 1; j < s->m_count; j++)
+            if (loads[j] < loads[best])
+                best = j;
+        loads[best] += entries[i].m_seconds;
+
+        if (program_matches(key, ident - key - 1, argv0) &&
+            atf_equal_map_citer_map_citer(
+                atf_map_find_c(&s->m_assigned, ident),
+                atf_map_end_c(&s->m_assigned)))
+            err = atf_map_insert(&s->m_assigned, ident,
+                                 (void *)(uintptr_t)(best + 1), false);
+    }
+
+    free(loads);
+out_entries:
+    free(entries);
+out_contents:
+    free(contents);
+out:
+    return err;
+}
+
+/* ---------------------------------------------------------------------
+ * Constructors/destructors.
+ * --------------------------------------------------------------------- */
+
+/** Initializes a shard selection.
+ *
+ * \param spec The shard to select, as "index/count", or "count" to keep
+ *     all test cases and report the shard of each.
+ * \param argv0 The path by which the test program was invoked, which is
+ *     matched against the keys of the durations file.
+ * \param progname The name of the test program, which is mixed into the
+ *     hash of its test cases.
+ * \param durations The durations file, or NULL. */
+atf_error_t
+atf_shard_init(atf_shard_t *s, const char *spec, const char *argv0,
+               const char *progname, const char *durations)
+{
+    atf_error_t err;
+
+    err = parse_spec(spec, &s->m_index, &s->m_count);
+    if (atf_is_error(err))
+        return err;
+    s->m_progname = progname;
+
+    err = atf_map_init(&s->m_assigned);
+    if (atf_is_error(err))
+        return err;
+
+    if (durations != NULL) {
+        err = assign_durations(s, durations, argv0);
+        if (atf_is_error(err))
+            atf_map_fini(&s->m_assigned);
+    }
+
+    return err;
+}
+
+void
+atf_shard_fini(atf_shard_t *s)
+{
+    atf_map_fini(&s->m_assigned);
+}
+
+/* ---------------------------------------------------------------------
+ * Free functions.
+ * --------------------------------------------------------------------- */
+
+/** Computes the 32-bit FNV-1a hash of "progname:ident".
+ *
+ * The atf-sh library computes the same hash so that the test cases of
+ * programs written in any language are spread in the same way. */
+uint32_t
+atf_shard_hash(const char *progname, const char *ident)
+{
+    const char *strs[] = { progname, ":", ident, NULL };
+    const char *const *str;
+    uint32_t hash = 2166136261u;
+
+    for (str = strs; *str != NULL; str++) {
+        const unsigned char *ch;
+
+        for (ch = (const unsigned char *)*str; *ch != '\0'; ch++) {
+            hash ^= *ch;
+            hash *= 16777619u;
+        }
+    }
+    return hash;
+}
+
+/** Gets the shard, numbered from 1, that a test case belongs to. */
+size_t
+atf_shard_of(const atf_shard_t *s, const char *ident)
+{
+    const atf_map_citer_t iter = atf_map_find_c(&s->m_assigned, ident);
+
+    if (!atf_equal_map_citer_map_citer(iter, atf_map_end_c(&s->m_assigned)))
+        return (size_t)(uintptr_t)atf_map_citer_data(iter);
+    return atf_shard_hash(s->m_progname, ident) % s->m_count + 1;
+}
+
+/** Tells whether a test case is part of the selected shard. */
+bool
+atf_shard_selects(const atf_shard_t *s, const char *ident)
+{
+    return s->m_index == 0 || atf_shard_of(s, ident) == s->m_index;
+}
@@ -0,0 +1,64 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#if !defined(ATF_C_DETAIL_SHARD_H)
+#define ATF_C_DETAIL_SHARD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atf-c/error_fwd.h>
+
+#include "atf-c/detail/map.h"
+
+/* ---------------------------------------------------------------------
+ * Sharding of the test cases of a test program.
+ * --------------------------------------------------------------------- */
+
+/* Selects the test cases of the shard m_index out of m_count, numbered
+ * from 1, or annotates every test case with its shard if m_index is 0.
+ * Test cases go to the shards by a hash of "program:ident" unless the
+ * durations file spreads them to balance the expected run time. */
+struct atf_shard {
+    size_t m_index;
+    size_t m_count;
+    const char *m_progname;
+
+    /* Test case identifiers to the shard, stored as the pointer value,
+     * that the durations file assigns them to. */
+    atf_map_t m_assigned;
+};
+typedef struct atf_shard atf_shard_t;
+
+atf_error_t atf_shard_init(atf_shard_t *, const char *, const char *,
+                           const char *, const char *);
+void atf_shard_fini(atf_shard_t *);
+
+uint32_t atf_shard_hash(const char *, const char *);
+size_t atf_shard_of(const atf_shard_t *, const char *);
+bool atf_shard_selects(const atf_shard_t *, const char *);
+
+#endif /* !defined(ATF_C_DETAIL_SHARD_H) */
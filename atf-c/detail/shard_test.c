@@ -0,0 +1,266 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/shard.h"
+
+#include <errno.h>
+#include <stdio.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/test_helpers.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static
+void
+check_invalid_spec(const char *spec)
+{
+    atf_error_t err;
+    atf_shard_t s;
+
+    err = atf_shard_init(&s, spec, "prog", "prog", NULL);
+    ATF_REQUIRE_MSG(atf_is_error(err), "Spec '%s' was accepted", spec);
+    ATF_REQUIRE(atf_error_is(err, "shard"));
+    atf_error_free(err);
+}
+
+static
+void
+check_invalid_durations(const char *contents)
+{
+    atf_error_t err;
+    atf_shard_t s;
+
+    atf_utils_create_file("durations", "%s", contents);
+    err = atf_shard_init(&s, "1/2", "prog", "prog", "durations");
+    ATF_REQUIRE_MSG(atf_is_error(err), "Durations '%s' were accepted",
+                    contents);
+    ATF_REQUIRE(atf_error_is(err, "shard"));
+    atf_error_free(err);
+}
+
+/* ---------------------------------------------------------------------
+ * Test cases.
+ * --------------------------------------------------------------------- */
+
+ATF_TC_WITHOUT_HEAD(init__specs);
+ATF_TC_BODY(init__specs, tc)
+{
+    atf_shard_t s;
+
+    RE(atf_shard_init(&s, "3/4", "prog", "prog", NULL));
+    ATF_REQUIRE_EQ(3, s.m_index);
+    ATF_REQUIRE_EQ(4, s.m_count);
+    atf_shard_fini(&s);
+
+    RE(atf_shard_init(&s, "1/1", "prog", "prog", NULL));
+    ATF_REQUIRE_EQ(1, s.m_index);
+    ATF_REQUIRE_EQ(1, s.m_count);
+    atf_shard_fini(&s);
+
+    RE(atf_shard_init(&s, "40", "prog", "prog", NULL));
+    ATF_REQUIRE_EQ(0, s.m_index);
+    ATF_REQUIRE_EQ(40, s.m_count);
+    atf_shard_fini(&s);
+}
+
+ATF_TC_WITHOUT_HEAD(init__invalid_specs);
+ATF_TC_BODY(init__invalid_specs, tc)
+{
+    check_invalid_spec("");
+    check_invalid_spec("a");
+    check_invalid_spec("0");
+    check_invalid_spec("0/4");
+    check_invalid_spec("5/4");
+    check_invalid_spec("1/0");
+    check_invalid_spec("1/");
+    check_invalid_spec("/4");
+    check_invalid_spec("1/4/4");
+    check_invalid_spec("-1/4");
+}
+
+ATF_TC_WITHOUT_HEAD(hash);
+ATF_TC_BODY(hash, tc)
+{
+    /* Known values of the FNV-1a hash, which atf-sh must reproduce. */
+    ATF_REQUIRE_EQ(1057798253u, atf_shard_hash("", ""));
+    ATF_REQUIRE_EQ(146638144u, atf_shard_hash("a", "b"));
+    ATF_REQUIRE_EQ(2983424912u, atf_shard_hash("prog", "tc"));
+}
+
+ATF_TC_WITHOUT_HEAD(selects__partition);
+ATF_TC_BODY(selects__partition, tc)
+{
+    atf_shard_t all, shards[4];
+    size_t counts[4] = { 0, 0, 0, 0 };
+    size_t i, j;
+
+    RE(atf_shard_init(&all, "4", "prog", "prog", NULL));
+    for (j = 0; j < 4; j++) {
+        char spec[16];
+
+        snprintf(spec, sizeof(spec), "%zu/4", j + 1);
+        RE(atf_shard_init(&shards[j], spec, "prog", "prog", NULL));
+    }
+
+    for (i = 0; i < 100; i++) {
+        char ident[16];
+        size_t selected = 0;
+
+        snprintf(ident, sizeof(ident), "tc_%zu", i);
+        ATF_REQUIRE(atf_shard_selects(&all, ident));
+        for (j = 0; j < 4; j++) {
+            ATF_REQUIRE_EQ(atf_shard_of(&all, ident),
+                           atf_shard_of(&shards[j], ident));
+            if (atf_shard_selects(&shards[j], ident)) {
+                ATF_REQUIRE_EQ(j + 1, atf_shard_of(&all, ident));
+                counts[j]++;
+                selected++;
+            }
+        }
+        ATF_REQUIRE_EQ_MSG(1, selected, "%s is in %zu shards", ident,
+                           selected);
+    }
+
+    for (j = 0; j < 4; j++) {
+        ATF_CHECK_MSG(counts[j] > 0, "Shard %zu is empty", j + 1);
+        atf_shard_fini(&shards[j]);
+    }
+    atf_shard_fini(&all);
+}
+
+ATF_TC_WITHOUT_HEAD(selects__progname);
+ATF_TC_BODY(selects__progname, tc)
+{
+    atf_shard_t s1, s2;
+    size_t i, differ = 0;
+
+    RE(atf_shard_init(&s1, "8", "a", "a", NULL));
+    RE(atf_shard_init(&s2, "8", "b", "b", NULL));
+    for (i = 0; i < 20; i++) {
+        char ident[16];
+
+        snprintf(ident, sizeof(ident), "tc_%zu", i);
+        if (atf_shard_of(&s1, ident) != atf_shard_of(&s2, ident))
+            differ++;
+    }
+    ATF_REQUIRE(differ > 0);
+    atf_shard_fini(&s2);
+    atf_shard_fini(&s1);
+}
+
+ATF_TC_WITHOUT_HEAD(durations__balance);
+ATF_TC_BODY(durations__balance, tc)
+{
+    atf_shard_t s;
+
+    /* In order of decreasing time, a goes to the first shard, b to the
+     * second one, c to the second one and d to the first one, leaving
+     * 14 and 11 seconds in each. */
+    atf_utils_create_file("durations",
+                          "# Durations of the test suite.\n"
+                          "\n"
+                          "dir/prog:d 4\n"
+                          "dir/prog:a 10.0\n"
+                          "other:c 5\n"
+                          "dir/prog:b 6s\n");
+
+    RE(atf_shard_init(&s, "2", "/usr/tests/dir/prog", "prog", "durations"));
+    ATF_REQUIRE_EQ(1, atf_shard_of(&s, "a"));
+    ATF_REQUIRE_EQ(2, atf_shard_of(&s, "b"));
+    ATF_REQUIRE_EQ(1, atf_shard_of(&s, "d"));
+    ATF_REQUIRE_EQ(atf_shard_hash("prog", "c") % 2 + 1,
+                   atf_shard_of(&s, "c"));
+    atf_shard_fini(&s);
+
+    RE(atf_shard_init(&s, "2/2", "dir/prog", "prog", "durations"));
+    ATF_REQUIRE(!atf_shard_selects(&s, "a"));
+    ATF_REQUIRE(atf_shard_selects(&s, "b"));
+    ATF_REQUIRE(!atf_shard_selects(&s, "d"));
+    atf_shard_fini(&s);
+}
+
+ATF_TC_WITHOUT_HEAD(durations__other_program);
+ATF_TC_BODY(durations__other_program, tc)
+{
+    atf_shard_t s;
+    const char *idents[] = { "a", "b", "d", NULL };
+    const char *const *ident;
+
+    atf_utils_create_file("durations", "dir/prog:a 10\ndir/prog:b 6\n"
+                          "dir/prog:d 4\n");
+
+    RE(atf_shard_init(&s, "3", "/usr/tests/xdir/prog", "prog", "durations"));
+    for (ident = idents; *ident != NULL; ident++)
+        ATF_REQUIRE_EQ(atf_shard_hash("prog", *ident) % 3 + 1,
+                       atf_shard_of(&s, *ident));
+    atf_shard_fini(&s);
+}
+
+ATF_TC_WITHOUT_HEAD(durations__invalid);
+ATF_TC_BODY(durations__invalid, tc)
+{
+    check_invalid_durations("prog:a\n");
+    check_invalid_durations("prog:a 1 2\n");
+    check_invalid_durations("prog:a foo\n");
+    check_invalid_durations("prog:a -1\n");
+    check_invalid_durations("a 1\n");
+    check_invalid_durations("prog:a 1\n  # comment\nprog:b 1ms\n");
+}
+
+ATF_TC_WITHOUT_HEAD(durations__missing);
+ATF_TC_BODY(durations__missing, tc)
+{
+    atf_error_t err;
+    atf_shard_t s;
+
+    err = atf_shard_init(&s, "1/2", "prog", "prog", "missing");
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_REQUIRE(atf_error_is(err, "libc"));
+    ATF_REQUIRE_EQ(ENOENT, atf_libc_error_code(err));
+    atf_error_free(err);
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    ATF_TP_ADD_TC(tp, init__specs);
+    ATF_TP_ADD_TC(tp, init__invalid_specs);
+    ATF_TP_ADD_TC(tp, hash);
+    ATF_TP_ADD_TC(tp, selects__partition);
+    ATF_TP_ADD_TC(tp, selects__progname);
+    ATF_TP_ADD_TC(tp, durations__balance);
+    ATF_TP_ADD_TC(tp, durations__other_program);
+    ATF_TP_ADD_TC(tp, durations__invalid);
+    ATF_TP_ADD_TC(tp, durations__missing);
+
+    return atf_no_error();
+}
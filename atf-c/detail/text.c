@@ -34,6 +34,36 @@
 #include "atf-c/detail/sanity.h"
 #include "atf-c/error.h"
 
+/** Appends a string to a dynamic string as a quoted JSON string. */
+atf_error_t
+atf_text_append_json(atf_dynstr_t *dest, const char *str)
+{
+    atf_error_t err;
+    const char *run;
+
+    err = atf_dynstr_append_char(dest, '"');
+    for (run = str; !atf_is_error(err) && *str != '\0'; str++) {
+        const unsigned char ch = (unsigned char)*str;
+
+        if (ch != '"' && ch != '\\' && ch >= 0x20)
+            continue;
+
+        err = atf_dynstr_append_mem(dest, run, str - run);
+        if (atf_is_error(err))
+            break;
+        if (ch == '"' || ch == '\\')
+            err = atf_dynstr_append_fmt(dest, "\\%c", ch);
+        else
+            err = atf_dynstr_append_fmt(dest, "\\u%04x", ch);
+        run = str + 1;
+    }
+    if (!atf_is_error(err))
+        err = atf_dynstr_append_mem(dest, run, str - run);
+    if (!atf_is_error(err))
+        err = atf_dynstr_append_char(dest, '"');
+    return err;
+}
+
 atf_error_t
 atf_text_for_each_word(const char *instr, const char *sep,
                        atf_error_t (*func)(const char *, void *),
@@ -83,8 +113,11 @@ atf_text_format_ap(char **dest, const char *fmt, va_list ap)
     va_copy(ap2, ap);
     err = atf_dynstr_init_ap(&tmp, fmt, ap2);
     va_end(ap2);
-    if (!atf_is_error(err))
+    if (!atf_is_error(err)) {
         *dest = atf_dynstr_fini_disown(&tmp);
+        if (*dest == NULL)
+            err = atf_no_memory_error();
+    }
 
     return err;
 }
@@ -114,14 +147,23 @@ atf_text_split(const char *str, const char *delim, atf_list_t *words)
         INV(ptr >= iter);
         if (ptr > iter) {
             atf_dynstr_t word;
+            char *wordstr;
 
             err = atf_dynstr_init_raw(&word, iter, ptr - iter);
             if (atf_is_error(err))
                 goto err_list;
 
-            err = atf_list_append(words, atf_dynstr_fini_disown(&word), true);
-            if (atf_is_error(err))
+            wordstr = atf_dynstr_fini_disown(&word);
+            if (wordstr == NULL) {
+                err = atf_no_memory_error();
+                goto err_list;
+            }
+
+            err = atf_list_append(words, wordstr, true);
+            if (atf_is_error(err)) {
+                free(wordstr);
                 goto err_list;
+            }
         }
 
         iter = ptr + strlen(delim);
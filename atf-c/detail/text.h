@@ -32,6 +32,9 @@
 #include <atf-c/detail/list.h>
 #include <atf-c/error_fwd.h>
 
+struct atf_dynstr;
+
+atf_error_t atf_text_append_json(struct atf_dynstr *, const char *);
 atf_error_t atf_text_for_each_word(const char *, const char *,
                                    atf_error_t (*)(const char *, void *),
                                    void *);
@@ -31,6 +31,7 @@
 
 #include <atf-c.h>
 
+#include "atf-c/detail/dynstr.h"
 #include "atf-c/detail/sanity.h"
 #include "atf-c/detail/test_helpers.h"
 
@@ -129,6 +130,33 @@ word_fail_at(const char *word ATF_DEFS_ATTRIBUTE_UNUSED, void *data)
  * Test cases for the free functions.
  * --------------------------------------------------------------------- */
 
+ATF_TC(append_json);
+ATF_TC_HEAD(append_json, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks the atf_text_append_json "
+                      "function");
+}
+ATF_TC_BODY(append_json, tc)
+{
+    atf_dynstr_t str;
+
+    RE(atf_dynstr_init_fmt(&str, "x="));
+    RE(atf_text_append_json(&str, ""));
+    ATF_REQUIRE_STREQ("x=\"\"", atf_dynstr_cstring(&str));
+    atf_dynstr_fini(&str);
+
+    RE(atf_dynstr_init(&str));
+    RE(atf_text_append_json(&str, "plain text"));
+    ATF_REQUIRE_STREQ("\"plain text\"", atf_dynstr_cstring(&str));
+    atf_dynstr_fini(&str);
+
+    RE(atf_dynstr_init(&str));
+    RE(atf_text_append_json(&str, "a\"b\\c\nd\001"));
+    ATF_REQUIRE_STREQ("\"a\\\"b\\\\c\\u000ad\\u0001\"",
+                      atf_dynstr_cstring(&str));
+    atf_dynstr_fini(&str);
+}
+
 ATF_TC(for_each_word);
 ATF_TC_HEAD(for_each_word, tc)
 {
@@ -409,6 +437,7 @@ ATF_TC_BODY(to_long, tc)
 
 ATF_TP_ADD_TCS(tp)
 {
+    ATF_TP_ADD_TC(tp, append_json);
     ATF_TP_ADD_TC(tp, for_each_word);
     ATF_TP_ADD_TC(tp, format);
     ATF_TP_ADD_TC(tp, format_ap);
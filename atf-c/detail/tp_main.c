@@ -28,17 +28,21 @@
 #endif
 
 #include <ctype.h>
+#include <errno.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+#include "atf-c/detail/arena.h"
 #include "atf-c/detail/dynstr.h"
 #include "atf-c/detail/env.h"
 #include "atf-c/detail/fs.h"
 #include "atf-c/detail/map.h"
 #include "atf-c/detail/sanity.h"
+#include "atf-c/detail/shard.h"
+#include "atf-c/detail/trace.h"
 #include "atf-c/error.h"
 #include "atf-c/tc.h"
 #include "atf-c/tp.h"
@@ -67,36 +71,17 @@ enum tc_part {
  * --------------------------------------------------------------------- */
 
 #define FREE_FORM_ERROR(name) \
-    struct name ## _error_data { \
-        char m_what[2048]; \
-    }; \
-    \
-    static \
-    void \
-    name ## _format(const atf_error_t err, char *buf, size_t buflen) \
-    { \
-        const struct name ## _error_data *data; \
-        \
-        PRE(atf_error_is(err, #name)); \
-        \
-        data = atf_error_data(err); \
-        snprintf(buf, buflen, "%s", data->m_what); \
-    } \
-    \
     static \
     atf_error_t \
     name ## _error(const char *fmt, ...) \
     { \
         atf_error_t err; \
-        struct name ## _error_data data; \
         va_list ap; \
         \
         va_start(ap, fmt); \
-        vsnprintf(data.m_what, sizeof(data.m_what), fmt, ap); \
+        err = atf_error_new_ap(#name, fmt, ap); \
         va_end(ap); \
         \
-        err = atf_error_new(#name, &data, sizeof(data), name ## _format); \
-        \
         return err; \
     }
 
@@ -136,6 +121,8 @@ print_warning(const char *message)
 
 struct params {
     bool m_do_list;
+    const char *m_shard;
+    const char *m_durations;
     atf_fs_path_t m_srcdir;
     char *m_tcname;
     enum tc_part m_tcpart;
@@ -168,6 +155,8 @@ params_init(struct params *p, const char *argv0)
     atf_error_t err;
 
     p->m_do_list = false;
+    p->m_shard = NULL;
+    p->m_durations = NULL;
     p->m_tcname = NULL;
     p->m_tcpart = BODY;
 
@@ -245,41 +234,95 @@ replace_path_param(atf_fs_path_t *param, const char *value)
  * --------------------------------------------------------------------- */
 
 static
-void
-list_tcs(const atf_tp_t *tp)
+atf_error_t
+append_md_var(const char *name, const char *value, void *arg)
+{
+    atf_dynstr_t *out = arg;
+
+    if (strcmp(name, "ident") == 0)
+        return atf_no_error();
+    else
+        return atf_dynstr_append_fmt(out, "%s: %s\n", name, value);
+}
+
+static
+atf_error_t
+write_all(const int fd, const char *data, size_t length)
 {
+    while (length > 0) {
+        const ssize_t written = write(fd, data, length);
+        if (written == -1) {
+            if (errno == EINTR)
+                continue;
+            return atf_libc_error(errno, "Failed to write the list of test "
+                                  "cases");
+        }
+        data += written;
+        length -= written;
+    }
+    return atf_no_error();
+}
+
+/* The whole list is built in memory first and then written in one go, as
+ * test programs with many test cases would otherwise issue a write for
+ * every line when the output is not buffered. */
+static
+atf_error_t
+list_tcs(const atf_tp_t *tp, const atf_shard_t *shard)
+{
+    atf_error_t err;
+    atf_dynstr_t out;
     const atf_tc_t *const *tcs;
     const atf_tc_t *const *tcsptr;
+    bool first = true;
 
-    printf("Content-Type: application/X-atf-tp; version=\"1\"\n\n");
+    err = atf_dynstr_init_fmt(&out, "Content-Type: application/X-atf-tp; "
+                              "version=\"1\"\n\n");
+    if (atf_is_error(err))
+        goto out;
 
     tcs = atf_tp_get_tcs(tp);
-    INV(tcs != NULL);  /* Should be checked. */
+    if (tcs == NULL) {
+        err = atf_no_memory_error();
+        goto out_out;
+    }
     for (tcsptr = tcs; *tcsptr != NULL; tcsptr++) {
         const atf_tc_t *tc = *tcsptr;
-        char **vars = atf_tc_get_md_vars(tc);
-        char **ptr;
+        const char *ident = atf_tc_get_ident(tc);
 
-        INV(vars != NULL);  /* Should be checked. */
+        if (shard != NULL && !atf_shard_selects(shard, ident))
+            continue;
 
-        if (tcsptr != tcs)  /* Not first. */
-            printf("\n");
+        err = atf_dynstr_append_fmt(&out, "%sident: %s\n",
+                                    first ? "" : "\n", ident);
+        if (atf_is_error(err))
+            goto out_tcs;
+        first = false;
 
-        for (ptr = vars; *ptr != NULL; ptr += 2) {
-            if (strcmp(*ptr, "ident") == 0) {
-                printf("ident: %s\n", *(ptr + 1));
-                break;
-            }
-        }
+        err = atf_tc_visit_md_vars(tc, append_md_var, &out);
+        if (atf_is_error(err))
+            goto out_tcs;
 
-        for (ptr = vars; *ptr != NULL; ptr += 2) {
-            if (strcmp(*ptr, "ident") != 0) {
-                printf("%s: %s\n", *ptr, *(ptr + 1));
-            }
+        if (shard != NULL && shard->m_index == 0) {
+            err = atf_dynstr_append_fmt(&out, "X-shard: %zu/%zu\n",
+                                        atf_shard_of(shard, ident),
+                                        shard->m_count);
+            if (atf_is_error(err))
+                goto out_tcs;
         }
-
-        atf_utils_free_charpp(vars);
     }
+
+    err = write_all(STDOUT_FILENO, atf_dynstr_cstring(&out),
+                    atf_dynstr_length(&out));
+
+out_tcs:
+#define UNCONST(a) ((void *)(unsigned long)(const void *)(a))
+    free(UNCONST(tcs));
+#undef UNCONST
+out_out:
+    atf_dynstr_fini(&out);
+out:
+    return err;
 }
 
 /* ---------------------------------------------------------------------
@@ -334,8 +377,12 @@ process_params(int argc, char **argv, struct params *p)
     old_opterr = opterr;
     opterr = 0;
     while (!atf_is_error(err) &&
-           (ch = getopt(argc, argv, GETOPT_POSIX ":lr:s:v:")) != -1) {
+           (ch = getopt(argc, argv, GETOPT_POSIX ":D:lr:S:s:v:")) != -1) {
         switch (ch) {
+        case 'D':
+            p->m_durations = optarg;
+            break;
+
         case 'l':
             p->m_do_list = true;
             break;
@@ -344,6 +391,10 @@ process_params(int argc, char **argv, struct params *p)
             err = replace_path_param(&p->m_resfile, optarg);
             break;
 
+        case 'S':
+            p->m_shard = optarg;
+            break;
+
         case 's':
             err = replace_path_param(&p->m_srcdir, optarg);
             break;
@@ -371,6 +422,13 @@ process_params(int argc, char **argv, struct params *p)
     optreset = 1;
 #endif
 
+    if (!atf_is_error(err)) {
+        if (p->m_durations != NULL && p->m_shard == NULL)
+            err = usage_error("-D requires -S");
+        else if (p->m_shard != NULL && !p->m_do_list)
+            err = usage_error("-S can only be used with -l");
+    }
+
     if (!atf_is_error(err)) {
         if (p->m_do_list) {
             if (argc > 0)
@@ -542,13 +600,23 @@ controlled_main(int argc, char **argv,
     atf_error_t err;
     struct params p;
     atf_tp_t tp;
+    atf_arena_t arena;
     char **raw_config;
 
+    ATF_TRACE_BEGIN("parse_args", NULL, NULL);
     err = process_params(argc, argv, &p);
+    ATF_TRACE_END();
     if (atf_is_error(err))
         goto out;
 
+    /* The test program and its test cases live until we exit, so there is
+     * no point in allocating and releasing their pieces one by one. */
+    atf_arena_init(&arena);
+    atf_arena_set_program(&arena);
+
+    ATF_TRACE_BEGIN("handle_srcdir", NULL, NULL);
     err = handle_srcdir(&p);
+    ATF_TRACE_END();
     if (atf_is_error(err))
         goto out_p;
 
@@ -562,21 +630,49 @@ controlled_main(int argc, char **argv,
     if (atf_is_error(err))
         goto out_p;
 
+    ATF_TRACE_BEGIN("add_tcs", NULL, NULL);
     err = add_tcs_hook(&tp);
+    ATF_TRACE_END();
+    /* Whatever is created from now on, like the objects of a test case
+     * body, is released by its owner and must not end up in the arena. */
+    atf_arena_set_program(NULL);
     if (atf_is_error(err))
         goto out_tp;
 
+    if (atf_env_has("ATF_ARENA_REPORT"))
+        atf_arena_print_usage(&arena, progname, stderr);
+
     if (p.m_do_list) {
-        list_tcs(&tp);
-        INV(!atf_is_error(err));
-        *exitcode = EXIT_SUCCESS;
+        atf_shard_t shard;
+
+        if (p.m_shard != NULL) {
+            err = atf_shard_init(&shard, p.m_shard, argv[0], progname,
+                                 p.m_durations);
+            if (atf_is_error(err))
+                goto out_tp;
+        }
+
+        ATF_TRACE_BEGIN("list_tcs", NULL, NULL);
+        err = list_tcs(&tp, p.m_shard != NULL ? &shard : NULL);
+        ATF_TRACE_END();
+        if (!atf_is_error(err))
+            *exitcode = EXIT_SUCCESS;
+
+        if (p.m_shard != NULL)
+            atf_shard_fini(&shard);
     } else {
+        /* Running the body of a test case never returns; the span is
+         * closed when the process exits. */
+        ATF_TRACE_BEGIN("run_tc", "tc", p.m_tcname);
         err = run_tc(&tp, &p, exitcode);
+        ATF_TRACE_END();
     }
 
 out_tp:
     atf_tp_fini(&tp);
 out_p:
+    atf_arena_set_program(NULL);
+    atf_arena_fini(&arena);
     params_fini(&p);
 out:
     return err;
@@ -601,7 +697,9 @@ atf_tp_main(int argc, char **argv, atf_error_t (*add_tcs_hook)(atf_tp_t *))
         progname += 3;
 
     exitcode = EXIT_FAILURE; /* Silence GCC warning. */
+    ATF_TRACE_BEGIN("atf_tp_main", "program", progname);
     err = controlled_main(argc, argv, add_tcs_hook, &exitcode);
+    ATF_TRACE_END();
     if (atf_is_error(err)) {
         print_error(err);
         atf_error_free(err);
@@ -0,0 +1,410 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/trace.h"
+
+#include <sys/types.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/env.h"
+#include "atf-c/detail/sanity.h"
+#include "atf-c/detail/text.h"
+#include "atf-c/error.h"
+
+/* ---------------------------------------------------------------------
+ * The trace file.
+ * --------------------------------------------------------------------- */
+
+/* The trace is written in the JSON array format of the Chrome trace event
+ * profiling tool, which chrome://tracing and Perfetto load directly.  The
+ * closing bracket of the array is optional in that format, which allows
+ * every process of a test run (the test program, the processes it forks
+ * and the test programs those execute) to append its events to the same
+ * file as they happen.  Each event is written with a single write to a
+ * descriptor opened in append mode so that the events of concurrent
+ * processes do not interleave. */
+
+int atf_trace_enabled = -1;
+
+static int Fd = -1;
+static bool Atexit_registered = false;
+
+/* The spans that are open, innermost last, so that they can be closed if
+ * the process exits from within them, as test cases do once they record
+ * their result.  They belong to the process that opened them; a forked
+ * child starts with none. */
+#define MAX_DEPTH 32
+static const char *Spans[MAX_DEPTH];
+static size_t Depth = 0;
+static pid_t Spans_pid = -1;
+
+/* Checks the environment the first time an event is raised. */
+static
+bool
+init_from_env(void)
+{
+    if (atf_trace_enabled == -1) {
+        atf_trace_enabled = 0;
+        if (atf_env_has("ATF_TRACE")) {
+            atf_error_t err = atf_trace_open(atf_env_get("ATF_TRACE"));
+            if (atf_is_error(err))
+                atf_error_free(err);  /* Tracing must not break tests. */
+        }
+    }
+    return atf_trace_enabled == 1;
+}
+
+static
+void
+write_all(const char *data, size_t remaining)
+{
+    while (remaining > 0) {
+        const ssize_t n = write(Fd, data, remaining);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        data += n;
+        remaining -= n;
+    }
+}
+
+/* Starts an event, leaving it open for the caller to add more fields. */
+static
+atf_error_t
+start_event(atf_dynstr_t *event, const char *name, const char phase,
+            const uint64_t ts)
+{
+    atf_error_t err;
+
+    err = atf_dynstr_init_fmt(event, "{\"name\":");
+    if (atf_is_error(err))
+        return err;
+
+    err = atf_text_append_json(event, name);
+    if (!atf_is_error(err))
+        err = atf_dynstr_append_fmt(event, ",\"cat\":\"atf\",\"ph\":\"%c\","
+            "\"ts\":%llu.%03u,\"pid\":%d,\"tid\":%d", phase,
+            (unsigned long long)(ts / 1000), (unsigned int)(ts % 1000),
+            (int)getpid(), (int)getpid());
+    if (atf_is_error(err))
+        atf_dynstr_fini(event);
+    return err;
+}
+
+/* Terminates and writes an event, releasing it in all cases. */
+static
+void
+finish_event(atf_dynstr_t *event, atf_error_t err)
+{
+    if (!atf_is_error(err))
+        err = atf_dynstr_append_cstring(event, "},\n");
+    if (!atf_is_error(err))
+        write_all(atf_dynstr_cstring(event), atf_dynstr_length(event));
+    else
+        atf_error_free(err);
+    atf_dynstr_fini(event);
+}
+
+static
+void
+simple_event(const char *name, const char phase, const char *arg,
+             const char *value)
+{
+    atf_error_t err;
+    atf_dynstr_t event;
+
+    err = start_event(&event, name, phase, atf_trace_now());
+    if (atf_is_error(err)) {
+        atf_error_free(err);
+        return;
+    }
+
+    if (phase == 'i')
+        err = atf_dynstr_append_cstring(&event, ",\"s\":\"p\"");
+    if (!atf_is_error(err) && arg != NULL) {
+        err = atf_dynstr_append_cstring(&event, ",\"args\":{");
+        if (!atf_is_error(err))
+            err = atf_text_append_json(&event, arg);
+        if (!atf_is_error(err))
+            err = atf_dynstr_append_char(&event, ':');
+        if (!atf_is_error(err))
+            err = atf_text_append_json(&event, value);
+        if (!atf_is_error(err))
+            err = atf_dynstr_append_char(&event, '}');
+    }
+    finish_event(&event, err);
+}
+
+/* Forgets the spans inherited from the parent of a forked process. */
+static
+void
+own_spans(void)
+{
+    const pid_t pid = getpid();
+
+    if (Spans_pid != pid) {
+        Spans_pid = pid;
+        Depth = 0;
+    }
+}
+
+static
+void
+close_spans(void)
+{
+    if (atf_trace_enabled != 1)
+        return;
+
+    own_spans();
+    while (Depth > 0)
+        atf_trace_end();
+}
+
+/* ---------------------------------------------------------------------
+ * Free functions.
+ * --------------------------------------------------------------------- */
+
+/* Writes the opening bracket of the array if the trace file is empty.
+ *
+ * Several processes may open a new trace file at the same time, so the
+ * file is locked while checking its size: otherwise two of them could
+ * both see it empty and write the bracket twice, or one could append an
+ * event before the other wrote the bracket. */
+static
+atf_error_t
+start_file(const char *path)
+{
+    atf_error_t err;
+    struct stat sb;
+
+    while (flock(Fd, LOCK_EX) == -1) {
+        if (errno != EINTR)
+            return atf_libc_error(errno, "Cannot lock trace file %s", path);
+    }
+
+    if (fstat(Fd, &sb) == -1)
+        err = atf_libc_error(errno, "Cannot stat trace file %s", path);
+    else {
+        if (sb.st_size == 0)
+            write_all("[\n", 2);
+        err = atf_no_error();
+    }
+
+    (void)flock(Fd, LOCK_UN);
+    return err;
+}
+
+/** Starts writing the trace to the given file, appending to it if it
+ * already exists. */
+atf_error_t
+atf_trace_open(const char *path)
+{
+    atf_error_t err;
+
+    atf_trace_close();
+
+    Fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (Fd == -1)
+        return atf_libc_error(errno, "Cannot open trace file %s", path);
+
+    err = start_file(path);
+    if (atf_is_error(err)) {
+        close(Fd);
+        Fd = -1;
+        return err;
+    }
+
+    if (!Atexit_registered) {
+        atexit(close_spans);
+        Atexit_registered = true;
+    }
+    Spans_pid = getpid();
+    Depth = 0;
+    atf_trace_enabled = 1;
+    return atf_no_error();
+}
+
+/** Stops writing the trace, closing any span left open. */
+void
+atf_trace_close(void)
+{
+    close_spans();
+    if (Fd != -1) {
+        close(Fd);
+        Fd = -1;
+    }
+    atf_trace_enabled = 0;
+}
+
+/** Returns the current time in nanoseconds from the monotonic clock,
+ * which is shared by all the processes of the system. */
+uint64_t
+atf_trace_now(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+        return 0;
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/** Opens a span, optionally with a single argument.
+ *
+ * The name must be a string literal: it is kept until the span is closed.
+ */
+void
+atf_trace_begin(const char *name, const char *arg, const char *value)
+{
+    if (!init_from_env())
+        return;
+
+    own_spans();
+    if (Depth < MAX_DEPTH)
+        Spans[Depth] = name;
+    Depth++;
+    simple_event(name, 'B', arg, value);
+}
+
+/** Closes the innermost open span. */
+void
+atf_trace_end(void)
+{
+    if (!init_from_env())
+        return;
+
+    own_spans();
+    if (Depth == 0)
+        return;
+    Depth--;
+    simple_event(Depth < MAX_DEPTH ? Spans[Depth] : "unknown", 'E', NULL,
+                 NULL);
+}
+
+/** Records an instantaneous event, optionally with a single argument. */
+void
+atf_trace_instant(const char *name, const char *arg, const char *value)
+{
+    if (!init_from_env())
+        return;
+
+    simple_event(name, 'i', arg, value);
+}
+
+/** Records the lifetime of a child process that has been waited for.
+ *
+ * The start time is the value of ATF_TRACE_NOW before the child was
+ * forked and the status is the one returned by waitpid. */
+void
+atf_trace_process(const pid_t pid, const uint64_t start, const int status)
+{
+    atf_error_t err;
+    atf_dynstr_t event;
+    uint64_t duration;
+
+    if (!init_from_env() || start == 0)
+        return;
+
+    duration = atf_trace_now() - start;
+    err = start_event(&event, "process", 'X', start);
+    if (atf_is_error(err)) {
+        atf_error_free(err);
+        return;
+    }
+
+    err = atf_dynstr_append_fmt(&event, ",\"dur\":%llu.%03u,\"args\":{"
+        "\"pid\":%d,", (unsigned long long)(duration / 1000),
+        (unsigned int)(duration % 1000), (int)pid);
+    if (!atf_is_error(err)) {
+        if (WIFEXITED(status))
+            err = atf_dynstr_append_fmt(&event, "\"exitstatus\":%d}",
+                                        WEXITSTATUS(status));
+        else if (WIFSIGNALED(status))
+            err = atf_dynstr_append_fmt(&event, "\"termsig\":%d}",
+                                        WTERMSIG(status));
+        else
+            err = atf_dynstr_append_fmt(&event, "\"status\":%d}", status);
+    }
+    finish_event(&event, err);
+}
+
+/** Records that the calling process is about to execute a program.
+ *
+ * This is meant to be called by a child process right before exec, so
+ * that the event carries its pid and arguments; the process is also
+ * named after the program in the trace. */
+void
+atf_trace_exec(const char *const *argv)
+{
+    atf_error_t err;
+    atf_dynstr_t event;
+    const char *const *arg;
+
+    if (!init_from_env())
+        return;
+
+    PRE(argv[0] != NULL);
+
+    err = start_event(&event, "process_name", 'M', atf_trace_now());
+    if (atf_is_error(err)) {
+        atf_error_free(err);
+        return;
+    }
+    err = atf_dynstr_append_cstring(&event, ",\"args\":{\"name\":");
+    if (!atf_is_error(err))
+        err = atf_text_append_json(&event, argv[0]);
+    if (!atf_is_error(err))
+        err = atf_dynstr_append_char(&event, '}');
+    finish_event(&event, err);
+
+    err = start_event(&event, "exec", 'i', atf_trace_now());
+    if (atf_is_error(err)) {
+        atf_error_free(err);
+        return;
+    }
+    err = atf_dynstr_append_cstring(&event, ",\"s\":\"p\",\"args\":{"
+                                    "\"argv\":[");
+    for (arg = argv; !atf_is_error(err) && *arg != NULL; arg++) {
+        if (arg != argv)
+            err = atf_dynstr_append_char(&event, ',');
+        if (!atf_is_error(err))
+            err = atf_text_append_json(&event, *arg);
+    }
+    if (!atf_is_error(err))
+        err = atf_dynstr_append_cstring(&event, "]}");
+    finish_event(&event, err);
+}
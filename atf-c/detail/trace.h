@@ -0,0 +1,88 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#if !defined(ATF_C_DETAIL_TRACE_H)
+#define ATF_C_DETAIL_TRACE_H
+
+#include <sys/types.h>
+
+#include <stdint.h>
+
+#include <atf-c/error_fwd.h>
+
+/* ---------------------------------------------------------------------
+ * Tracing of the phases of the test programs.
+ * --------------------------------------------------------------------- */
+
+/* Events are only recorded if the ATF_TRACE environment variable names a
+ * file when the first one is raised.  atf_trace_enabled is -1 until then,
+ * so that the check in the macros below, which is all a disabled event
+ * costs, also triggers that lazy initialization. */
+extern int atf_trace_enabled;
+
+#define ATF_TRACE_BEGIN(name, arg, value) \
+    do { \
+        if (atf_trace_enabled != 0) \
+            atf_trace_begin(name, arg, value); \
+    } while (0)
+
+#define ATF_TRACE_END() \
+    do { \
+        if (atf_trace_enabled != 0) \
+            atf_trace_end(); \
+    } while (0)
+
+#define ATF_TRACE_INSTANT(name, arg, value) \
+    do { \
+        if (atf_trace_enabled != 0) \
+            atf_trace_instant(name, arg, value); \
+    } while (0)
+
+#define ATF_TRACE_NOW() \
+    (atf_trace_enabled != 0 ? atf_trace_now() : 0)
+
+#define ATF_TRACE_PROCESS(pid, start, status) \
+    do { \
+        if (atf_trace_enabled != 0) \
+            atf_trace_process(pid, start, status); \
+    } while (0)
+
+#define ATF_TRACE_EXEC(argv) \
+    do { \
+        if (atf_trace_enabled != 0) \
+            atf_trace_exec(argv); \
+    } while (0)
+
+atf_error_t atf_trace_open(const char *);
+void atf_trace_close(void);
+
+uint64_t atf_trace_now(void);
+void atf_trace_begin(const char *, const char *, const char *);
+void atf_trace_end(void);
+void atf_trace_instant(const char *, const char *, const char *);
+void atf_trace_process(pid_t, uint64_t, int);
+void atf_trace_exec(const char *const *);
+
+#endif /* !defined(ATF_C_DETAIL_TRACE_H) */
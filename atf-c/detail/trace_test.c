@@ -0,0 +1,355 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/trace.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/env.h"
+#include "atf-c/detail/fs.h"
+#include "atf-c/detail/process.h"
+#include "atf-c/detail/test_helpers.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+/* Returns the contents of the trace file; the caller must free them. */
+static
+char *
+read_trace(void)
+{
+    struct stat sb;
+    char *contents;
+    int fd;
+
+    fd = open("trace.json", O_RDONLY);
+    ATF_REQUIRE(fd != -1);
+    ATF_REQUIRE(fstat(fd, &sb) != -1);
+    contents = malloc(sb.st_size + 1);
+    ATF_REQUIRE(contents != NULL);
+    ATF_REQUIRE_EQ(read(fd, contents, sb.st_size), sb.st_size);
+    contents[sb.st_size] = '\0';
+    close(fd);
+    return contents;
+}
+
+static
+size_t
+count_matches(const char *contents, const char *needle)
+{
+    size_t count = 0;
+
+    while ((contents = strstr(contents, needle)) != NULL) {
+        count++;
+        contents++;
+    }
+    return count;
+}
+
+static
+void
+open_span_and_exit(void *v ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+    if (atf_is_error(atf_trace_open("trace.json")))
+        exit(EXIT_FAILURE);
+    ATF_TRACE_BEGIN("child_span", NULL, NULL);
+    exit(EXIT_SUCCESS);
+}
+
+static
+void
+exit_from_span(void *v ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+    exit(EXIT_SUCCESS);
+}
+
+static
+void
+wait_child(void (*start)(void *))
+{
+    atf_process_child_t child;
+    atf_process_status_t status;
+
+    RE(atf_process_fork(&child, start, NULL, NULL, NULL));
+    RE(atf_process_child_wait(&child, &status));
+    ATF_REQUIRE(atf_process_status_exited(&status));
+    ATF_REQUIRE_EQ(EXIT_SUCCESS, atf_process_status_exitstatus(&status));
+    atf_process_status_fini(&status);
+}
+
+static
+void
+h_failing_body(const atf_tc_t *tc ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+    atf_tc_fail_check(__FILE__, __LINE__, "Something \"bad\" happened");
+}
+
+/* ---------------------------------------------------------------------
+ * Test cases.
+ * --------------------------------------------------------------------- */
+
+ATF_TC_WITHOUT_HEAD(disabled);
+ATF_TC_BODY(disabled, tc)
+{
+    if (atf_env_has("ATF_TRACE"))
+        atf_tc_skip("ATF_TRACE is set in the environment");
+
+    ATF_TRACE_BEGIN("span", NULL, NULL);
+    ATF_TRACE_INSTANT("event", NULL, NULL);
+    ATF_TRACE_END();
+    ATF_REQUIRE_EQ(0, atf_trace_enabled);
+    ATF_REQUIRE(!atf_utils_file_exists("trace.json"));
+}
+
+ATF_TC_WITHOUT_HEAD(spans);
+ATF_TC_BODY(spans, tc)
+{
+    char *contents;
+
+    RE(atf_trace_open("trace.json"));
+    ATF_TRACE_BEGIN("outer", "key", "value");
+    ATF_TRACE_BEGIN("inner", NULL, NULL);
+    ATF_TRACE_END();
+    ATF_TRACE_END();
+    atf_trace_close();
+
+    contents = read_trace();
+    printf("%s", contents);
+    ATF_REQUIRE(strncmp(contents, "[\n", 2) == 0);
+    ATF_REQUIRE_EQ(4, count_matches(contents, "},\n"));
+    ATF_REQUIRE(strstr(contents, "{\"name\":\"outer\",\"cat\":\"atf\","
+                       "\"ph\":\"B\",") != NULL);
+    ATF_REQUIRE(strstr(contents, ",\"args\":{\"key\":\"value\"}},\n") !=
+                NULL);
+    ATF_REQUIRE(strstr(contents, "{\"name\":\"inner\",\"cat\":\"atf\","
+                       "\"ph\":\"B\",") != NULL);
+    ATF_REQUIRE(strstr(contents, "{\"name\":\"inner\",\"cat\":\"atf\","
+                       "\"ph\":\"E\",") != NULL);
+    ATF_REQUIRE(strstr(contents, "{\"name\":\"outer\",\"cat\":\"atf\","
+                       "\"ph\":\"E\",") != NULL);
+    ATF_REQUIRE(strstr(contents, "{\"name\":\"inner\",\"cat\":\"atf\","
+                       "\"ph\":\"E\",") <
+                strstr(contents, "{\"name\":\"outer\",\"cat\":\"atf\","
+                       "\"ph\":\"E\","));
+    free(contents);
+}
+
+ATF_TC_WITHOUT_HEAD(append);
+ATF_TC_BODY(append, tc)
+{
+    char *contents;
+
+    RE(atf_trace_open("trace.json"));
+    ATF_TRACE_INSTANT("first", NULL, NULL);
+    atf_trace_close();
+    RE(atf_trace_open("trace.json"));
+    ATF_TRACE_INSTANT("second", NULL, NULL);
+    atf_trace_close();
+
+    contents = read_trace();
+    printf("%s", contents);
+    ATF_REQUIRE_EQ(1, count_matches(contents, "["));
+    ATF_REQUIRE(strstr(contents, "\"name\":\"first\"") != NULL);
+    ATF_REQUIRE(strstr(contents, "\"name\":\"second\"") != NULL);
+    free(contents);
+}
+
+ATF_TC_WITHOUT_HEAD(concurrent_open);
+ATF_TC_BODY(concurrent_open, tc)
+{
+    char *contents;
+    pid_t pids[8];
+    size_t i;
+
+    for (i = 0; i < sizeof(pids) / sizeof(pids[0]); i++) {
+        pids[i] = fork();
+        ATF_REQUIRE(pids[i] != -1);
+        if (pids[i] == 0) {
+            if (atf_is_error(atf_trace_open("trace.json")))
+                _exit(EXIT_FAILURE);
+            ATF_TRACE_INSTANT("child", NULL, NULL);
+            atf_trace_close();
+            _exit(EXIT_SUCCESS);
+        }
+    }
+    for (i = 0; i < sizeof(pids) / sizeof(pids[0]); i++) {
+        int status;
+
+        ATF_REQUIRE(waitpid(pids[i], &status, 0) != -1);
+        ATF_REQUIRE(WIFEXITED(status));
+        ATF_REQUIRE_EQ(EXIT_SUCCESS, WEXITSTATUS(status));
+    }
+
+    contents = read_trace();
+    printf("%s", contents);
+    ATF_REQUIRE(strncmp(contents, "[\n", 2) == 0);
+    ATF_REQUIRE_EQ(1, count_matches(contents, "["));
+    ATF_REQUIRE_EQ(8, count_matches(contents, "\"name\":\"child\""));
+    free(contents);
+}
+
+ATF_TC_WITHOUT_HEAD(escape);
+ATF_TC_BODY(escape, tc)
+{
+    char *contents;
+
+    RE(atf_trace_open("trace.json"));
+    ATF_TRACE_INSTANT("event", "reason", "a \"quoted\"\\path\nnext\t");
+    atf_trace_close();
+
+    contents = read_trace();
+    printf("%s", contents);
+    ATF_REQUIRE(strstr(contents, "\"ph\":\"i\",") != NULL);
+    ATF_REQUIRE(strstr(contents, "\"args\":{\"reason\":\"a \\\"quoted\\\"\\\\"
+                       "path\\u000anext\\u0009\"}") != NULL);
+    free(contents);
+}
+
+ATF_TC_WITHOUT_HEAD(close_at_exit);
+ATF_TC_BODY(close_at_exit, tc)
+{
+    char *contents;
+
+    wait_child(open_span_and_exit);
+
+    contents = read_trace();
+    printf("%s", contents);
+    ATF_REQUIRE(strstr(contents, "{\"name\":\"child_span\",\"cat\":\"atf\","
+                       "\"ph\":\"B\",") != NULL);
+    ATF_REQUIRE(strstr(contents, "{\"name\":\"child_span\",\"cat\":\"atf\","
+                       "\"ph\":\"E\",") != NULL);
+    free(contents);
+}
+
+ATF_TC_WITHOUT_HEAD(forked_child);
+ATF_TC_BODY(forked_child, tc)
+{
+    char *contents;
+
+    RE(atf_trace_open("trace.json"));
+    ATF_TRACE_BEGIN("parent_span", NULL, NULL);
+    wait_child(exit_from_span);
+    ATF_TRACE_END();
+    atf_trace_close();
+
+    contents = read_trace();
+    printf("%s", contents);
+    ATF_REQUIRE_EQ(1, count_matches(contents, "{\"name\":\"parent_span\","
+                                    "\"cat\":\"atf\",\"ph\":\"E\","));
+    ATF_REQUIRE_EQ(1, count_matches(contents, "{\"name\":\"process\","));
+    ATF_REQUIRE(strstr(contents, "\"exitstatus\":0}") != NULL);
+    free(contents);
+}
+
+ATF_TC_WITHOUT_HEAD(exec);
+ATF_TC_BODY(exec, tc)
+{
+    const char *const argv[] = { "echo", "hello \"world\"", NULL };
+    atf_fs_path_t prog;
+    atf_process_status_t status;
+    atf_process_stream_t outsb;
+    char *contents;
+
+    RE(atf_trace_open("trace.json"));
+    RE(atf_fs_path_init_fmt(&prog, "echo"));
+    RE(atf_process_stream_init_redirect_fd(&outsb, STDERR_FILENO));
+    RE(atf_process_exec_array(&status, &prog, argv, &outsb, NULL, NULL));
+    ATF_REQUIRE(atf_process_status_exited(&status));
+    atf_process_status_fini(&status);
+    atf_process_stream_fini(&outsb);
+    atf_fs_path_fini(&prog);
+    atf_trace_close();
+
+    contents = read_trace();
+    printf("%s", contents);
+    ATF_REQUIRE(strstr(contents, "{\"name\":\"process_name\",\"cat\":\"atf\","
+                       "\"ph\":\"M\",") != NULL);
+    ATF_REQUIRE(strstr(contents, "\"args\":{\"name\":\"echo\"}") != NULL);
+    ATF_REQUIRE(strstr(contents, "\"args\":{\"argv\":[\"echo\","
+                       "\"hello \\\"world\\\"\"]}") != NULL);
+    ATF_REQUIRE(strstr(contents, "{\"name\":\"process\",\"cat\":\"atf\","
+                       "\"ph\":\"X\",") != NULL);
+    ATF_REQUIRE(strstr(contents, "\"exitstatus\":0}") != NULL);
+    free(contents);
+}
+
+ATF_TC_WITHOUT_HEAD(failed_check);
+ATF_TC_BODY(failed_check, tc)
+{
+    const char *const config[] = { NULL };
+    atf_tc_t h_tc;
+    char *contents;
+
+    RE(atf_tc_init(&h_tc, "h_failing", NULL, h_failing_body, NULL, config));
+    RE(atf_trace_open("trace.json"));
+    run_h_tc(&h_tc, "output", "error", "result");
+    atf_trace_close();
+    atf_tc_fini(&h_tc);
+
+    contents = read_trace();
+    printf("%s", contents);
+    ATF_REQUIRE(strstr(contents, "{\"name\":\"body\",\"cat\":\"atf\","
+                       "\"ph\":\"B\",") != NULL);
+    ATF_REQUIRE(strstr(contents, "\"args\":{\"tc\":\"h_failing\"}") != NULL);
+    ATF_REQUIRE(strstr(contents, "{\"name\":\"check_failed\",\"cat\":\"atf\","
+                       "\"ph\":\"i\",") != NULL);
+    ATF_REQUIRE(strstr(contents, "Something \\\"bad\\\" happened") != NULL);
+    ATF_REQUIRE(strstr(contents, "{\"name\":\"requirement_failed\",") !=
+                NULL);
+    ATF_REQUIRE(strstr(contents, "{\"name\":\"write_resfile\",\"cat\":\"atf\","
+                       "\"ph\":\"B\",") != NULL);
+    ATF_REQUIRE(strstr(contents, "\"args\":{\"result\":\"failed\"}") != NULL);
+    free(contents);
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    ATF_TP_ADD_TC(tp, disabled);
+    ATF_TP_ADD_TC(tp, spans);
+    ATF_TP_ADD_TC(tp, append);
+    ATF_TP_ADD_TC(tp, concurrent_open);
+    ATF_TP_ADD_TC(tp, escape);
+    ATF_TP_ADD_TC(tp, close_at_exit);
+    ATF_TP_ADD_TC(tp, forked_child);
+    ATF_TP_ADD_TC(tp, exec);
+    ATF_TP_ADD_TC(tp, failed_check);
+
+    return atf_no_error();
+}
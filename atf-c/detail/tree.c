@@ -0,0 +1,1114 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/tree.h"
+
+#if defined(HAVE_CONFIG_H)
+#include "config.h"
+#endif
+
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#if defined(__linux__)
+#include <linux/fs.h>
+#endif
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/sanity.h"
+#include "atf-c/error.h"
+
+/* ---------------------------------------------------------------------
+ * Tree specifications.
+ * --------------------------------------------------------------------- */
+
+/* A specification describes one file per line, relative to the root of
+ * the tree:
+ *
+ *     path/to/dir/ [mode=0755]
+ *     path/to/file [mode=0644] [size=N] [pattern=TEXT] [content=TEXT...]
+ *     path/to/link -> target
+ *
+ * A trailing slash denotes a directory.  A file is empty unless it has a
+ * size, in which case it is filled with repetitions of its pattern (or
+ * with zeros if there is none), or a content, which extends up to the
+ * end of the line and understands the \n, \t and \\ escapes.  The last
+ * component of a path can contain a {first..last} range of numbers to
+ * describe many files at once.  Missing parent directories are created
+ * as needed, and empty lines and lines starting with # are ignored. */
+
+enum entry_kind {
+    dir_entry,
+    file_entry,
+    link_entry,
+};
+
+/* A line of the specification.  The strings point into the buffer that
+ * holds the specification, which is modified in place during parsing. */
+struct entry {
+    enum entry_kind m_kind;
+
+    char *m_parent;             /* NULL if the entry is in the root. */
+    const char *m_prefix;       /* The leaf or the text before the range. */
+    const char *m_suffix;       /* The text after the range, if any. */
+    unsigned long m_first;
+    unsigned long m_last;
+
+    bool m_has_mode;
+    mode_t m_mode;
+    bool m_has_size;
+    off_t m_size;
+    const char *m_data;         /* The pattern or the content, if any. */
+    size_t m_data_length;
+    const char *m_target;
+};
+
+static
+atf_error_t
+spec_error(const char *line, const char *reason)
+{
+    return atf_error_new_fmt("tree_spec", "Invalid tree specification "
+                             "line '%s': %s", line, reason);
+}
+
+/* Resolves the escape sequences of 'str' in place and returns its new
+ * length. */
+static
+size_t
+unescape(char *str)
+{
+    char *r, *w;
+
+    for (r = w = str; *r != '\0'; r++, w++) {
+        if (*r == '\\' && *(r + 1) != '\0') {
+            r++;
+            switch (*r) {
+            case 'n': *w = '\n'; break;
+            case 't': *w = '\t'; break;
+            default: *w = *r; break;
+            }
+        } else
+            *w = *r;
+    }
+    *w = '\0';
+    return w - str;
+}
+
+static
+char *
+next_token(char **str)
+{
+    char *token;
+
+    while (**str == ' ' || **str == '\t')
+        (*str)++;
+    if (**str == '\0')
+        return NULL;
+
+    token = *str;
+    while (**str != '\0' && **str != ' ' && **str != '\t')
+        (*str)++;
+    if (**str != '\0')
+        *(*str)++ = '\0';
+    return token;
+}
+
+static
+bool
+parse_number(const char *str, int base, unsigned long *value)
+{
+    char *end;
+
+    if (*str == '\0' || *str == '-')
+        return false;
+    errno = 0;
+    *value = strtoul(str, &end, base);
+    return errno == 0 && *end == '\0';
+}
+
+/* Splits the path of an entry into its parent and its leaf, the latter
+ * possibly containing a range. */
+static
+atf_error_t
+parse_path(char *path, const char *line, struct entry *e)
+{
+    char *leaf, *open, *close, *dots;
+
+    if (path[0] == '/')
+        return spec_error(line, "paths must be relative to the root");
+
+    leaf = strrchr(path, '/');
+    if (leaf == NULL) {
+        e->m_parent = NULL;
+        leaf = path;
+    } else {
+        *leaf++ = '\0';
+        e->m_parent = path;
+        if (strchr(path, '{') != NULL)
+            return spec_error(line, "ranges are only allowed in the last "
+                              "component");
+    }
+    if (*leaf == '\0' || strcmp(leaf, ".") == 0 || strcmp(leaf, "..") == 0)
+        return spec_error(line, "invalid file name");
+
+    e->m_prefix = leaf;
+    e->m_suffix = NULL;
+    e->m_first = e->m_last = 0;
+
+    open = strchr(leaf, '{');
+    if (open == NULL)
+        return atf_no_error();
+
+    close = strchr(open, '}');
+    dots = strstr(open, "..");
+    if (close == NULL || dots == NULL || dots > close)
+        return spec_error(line, "malformed range");
+    *open = *dots = *close = '\0';
+    if (!parse_number(open + 1, 10, &e->m_first) ||
+        !parse_number(dots + 2, 10, &e->m_last) || e->m_first > e->m_last)
+        return spec_error(line, "malformed range");
+    e->m_suffix = close + 1;
+
+    return atf_no_error();
+}
+
+static
+atf_error_t
+parse_line(char *line, struct entry *e)
+{
+    char *copy, *str, *path, *token;
+    atf_error_t err;
+    size_t length;
+
+    /* Keep the original line around for error messages; parsing breaks
+     * it into pieces. */
+    copy = strdup(line);
+    if (copy == NULL)
+        return atf_no_memory_error();
+
+    str = line;
+    path = next_token(&str);
+    INV(path != NULL);
+
+    e->m_has_mode = false;
+    e->m_has_size = false;
+    e->m_data = NULL;
+    e->m_data_length = 0;
+    e->m_target = NULL;
+
+    length = strlen(path);
+    if (length > 1 && path[length - 1] == '/') {
+        e->m_kind = dir_entry;
+        while (length > 1 && path[length - 1] == '/')
+            path[--length] = '\0';
+    } else
+        e->m_kind = file_entry;
+
+    err = parse_path(path, copy, e);
+    if (atf_is_error(err))
+        goto out;
+
+    while ((token = next_token(&str)) != NULL) {
+        unsigned long value;
+
+        if (strcmp(token, "->") == 0 && e->m_kind == file_entry &&
+            !e->m_has_mode && !e->m_has_size && e->m_data == NULL) {
+            e->m_kind = link_entry;
+            e->m_target = next_token(&str);
+            if (e->m_target == NULL || next_token(&str) != NULL)
+                err = spec_error(copy, "a link needs exactly one target");
+            break;
+        } else if (strncmp(token, "mode=", 5) == 0) {
+            if (!parse_number(token + 5, 8, &value) || value > 07777) {
+                err = spec_error(copy, "invalid mode");
+                break;
+            }
+            e->m_has_mode = true;
+            e->m_mode = (mode_t)value;
+        } else if (strncmp(token, "size=", 5) == 0 &&
+                   e->m_kind == file_entry) {
+            if (!parse_number(token + 5, 10, &value)) {
+                err = spec_error(copy, "invalid size");
+                break;
+            }
+            e->m_has_size = true;
+            e->m_size = (off_t)value;
+        } else if (strncmp(token, "pattern=", 8) == 0 &&
+                   e->m_kind == file_entry && e->m_data == NULL) {
+            e->m_data = token + 8;
+            e->m_data_length = strlen(e->m_data);
+        } else if (strncmp(token, "content=", 8) == 0 &&
+                   e->m_kind == file_entry && e->m_data == NULL) {
+            /* The content extends up to the end of the line. */
+            if (*str != '\0')
+                *(str - 1) = ' ';
+            e->m_data = token + 8;
+            e->m_data_length = unescape(token + 8);
+            break;
+        } else {
+            err = spec_error(copy, "unknown or misplaced attribute");
+            break;
+        }
+    }
+
+    if (!atf_is_error(err) && e->m_kind == file_entry &&
+        e->m_has_size && e->m_data != NULL && e->m_data_length == 0)
+        err = spec_error(copy, "empty pattern");
+
+out:
+    free(copy);
+    return err;
+}
+
+/* Parses the specification held in 'buf', which is modified in place. */
+static
+atf_error_t
+parse_spec(char *buf, struct entry **entriesp, size_t *nentriesp)
+{
+    struct entry *entries;
+    size_t nentries, maxentries;
+    char *line, *next;
+    atf_error_t err;
+
+    maxentries = 1;
+    for (line = buf; *line != '\0'; line++)
+        if (*line == '\n')
+            maxentries++;
+
+    entries = malloc(sizeof(*entries) * maxentries);
+    if (entries == NULL)
+        return atf_no_memory_error();
+
+    err = atf_no_error();
+    nentries = 0;
+    for (line = buf; line != NULL && !atf_is_error(err); line = next) {
+        next = strchr(line, '\n');
+        if (next != NULL)
+            *next++ = '\0';
+
+        while (*line == ' ' || *line == '\t')
+            line++;
+        if (*line == '\0' || *line == '#')
+            continue;
+
+        INV(nentries < maxentries);
+        err = parse_line(line, &entries[nentries]);
+        nentries++;
+    }
+
+    if (atf_is_error(err))
+        free(entries);
+    else {
+        *entriesp = entries;
+        *nentriesp = nentries;
+    }
+    return err;
+}
+
+/* ---------------------------------------------------------------------
+ * Tree creation.
+ * --------------------------------------------------------------------- */
+
+static
+size_t
+entry_count(const struct entry *e)
+{
+    return e->m_last - e->m_first + 1;
+}
+
+static
+atf_error_t
+entry_name(const struct entry *e, unsigned long i, char *buf, size_t buflen,
+           const char **name)
+{
+    int length;
+
+    if (e->m_suffix == NULL) {
+        *name = e->m_prefix;
+        return atf_no_error();
+    }
+
+    length = snprintf(buf, buflen, "%s%lu%s", e->m_prefix, i, e->m_suffix);
+    if (length < 0 || (size_t)length >= buflen)
+        return atf_libc_error(ENAMETOOLONG, "Cannot create %s%lu%s",
+                              e->m_prefix, i, e->m_suffix);
+    *name = buf;
+    return atf_no_error();
+}
+
+/* Creates the parent directories of an entry, like mkdir -p does. */
+static
+atf_error_t
+make_parents(int rootfd, char *parent)
+{
+    char *delim;
+
+    if (parent == NULL)
+        return atf_no_error();
+
+    delim = parent;
+    for (;;) {
+        delim = strchr(delim + 1, '/');
+        if (delim != NULL)
+            *delim = '\0';
+        if (mkdirat(rootfd, parent, 0755) == -1 && errno != EEXIST) {
+            const int olderrno = errno;
+            if (delim != NULL)
+                *delim = '/';
+            return atf_libc_error(olderrno, "Cannot create directory %s",
+                                  parent);
+        }
+        if (delim == NULL)
+            break;
+        *delim = '/';
+    }
+
+    return atf_no_error();
+}
+
+static
+atf_error_t
+open_parent(int rootfd, const struct entry *e, int *fd)
+{
+    if (e->m_parent == NULL) {
+        *fd = rootfd;
+        return atf_no_error();
+    }
+
+    *fd = openat(rootfd, e->m_parent, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (*fd == -1)
+        return atf_libc_error(errno, "Cannot open directory %s",
+                              e->m_parent);
+    return atf_no_error();
+}
+
+static
+atf_error_t
+write_all(int fd, const char *name, const void *data, size_t length)
+{
+    const char *ptr = data;
+
+    while (length > 0) {
+        const ssize_t n = write(fd, ptr, length);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            return atf_libc_error(errno, "Cannot write to %s", name);
+        }
+        ptr += n;
+        length -= n;
+    }
+    return atf_no_error();
+}
+
+/* A block of repetitions of the pattern of a file, so that large files
+ * are written with few calls. */
+struct chunk {
+    char *m_data;
+    size_t m_length;
+};
+
+static
+atf_error_t
+chunk_init(struct chunk *c, const struct entry *e)
+{
+    const size_t maxlength = 64 * 1024;
+    size_t length;
+
+    c->m_data = NULL;
+    c->m_length = 0;
+    if (!e->m_has_size || e->m_data == NULL || e->m_size == 0)
+        return atf_no_error();
+
+    length = (uintmax_t)e->m_size < maxlength ? (size_t)e->m_size : maxlength;
+    if (length > e->m_data_length)
+        length -= length % e->m_data_length;
+    else
+        length = e->m_data_length;
+
+    c->m_data = malloc(length);
+    if (c->m_data == NULL)
+        return atf_no_memory_error();
+    for (c->m_length = 0; c->m_length < length;
+         c->m_length += e->m_data_length)
+        memcpy(c->m_data + c->m_length, e->m_data, e->m_data_length);
+
+    return atf_no_error();
+}
+
+static
+void
+chunk_fini(struct chunk *c)
+{
+    free(c->m_data);
+}
+
+static
+atf_error_t
+create_file(int dirfd, const char *name, const struct entry *e,
+            const struct chunk *c)
+{
+    const mode_t mode = e->m_has_mode ? e->m_mode : 0644;
+    atf_error_t err;
+    int fd;
+
+    fd = openat(dirfd, name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, mode);
+    if (fd == -1)
+        return atf_libc_error(errno, "Cannot create file %s", name);
+
+    err = atf_no_error();
+    if (!e->m_has_size) {
+        if (e->m_data != NULL)
+            err = write_all(fd, name, e->m_data, e->m_data_length);
+    } else if (c->m_data == NULL) {
+        if (ftruncate(fd, e->m_size) == -1)
+            err = atf_libc_error(errno, "Cannot set the size of %s", name);
+    } else {
+        off_t left = e->m_size;
+        while (!atf_is_error(err) && left > 0) {
+            const size_t length = (uintmax_t)left < c->m_length ?
+                (size_t)left : c->m_length;
+            err = write_all(fd, name, c->m_data, length);
+            left -= length;
+        }
+    }
+
+    if (!atf_is_error(err) && e->m_has_mode && fchmod(fd, mode) == -1)
+        err = atf_libc_error(errno, "Cannot set the mode of %s", name);
+
+    close(fd);
+    return err;
+}
+
+/* Creates the files and links of the tree whose position, counting all
+ * the names described by the specification, modulo 'jobs' is 'worker'. */
+static
+atf_error_t
+create_items(int rootfd, const struct entry *entries, size_t nentries,
+             unsigned int worker, unsigned int jobs)
+{
+    atf_error_t err;
+    size_t i, index;
+
+    err = atf_no_error();
+    index = 0;
+    for (i = 0; i < nentries && !atf_is_error(err); i++) {
+        const struct entry *e = &entries[i];
+        struct chunk c;
+        char buf[1024];
+        unsigned long j;
+        int dirfd;
+
+        if (e->m_kind == dir_entry)
+            continue;
+        if (entry_count(e) <= (worker + jobs - index % jobs) % jobs) {
+            index += entry_count(e);
+            continue;
+        }
+
+        err = open_parent(rootfd, e, &dirfd);
+        if (atf_is_error(err))
+            break;
+        err = chunk_init(&c, e);
+        if (atf_is_error(err)) {
+            if (dirfd != rootfd)
+                close(dirfd);
+            break;
+        }
+
+        for (j = e->m_first; j <= e->m_last && !atf_is_error(err); j++) {
+            const char *name;
+
+            if (index++ % jobs != worker)
+                continue;
+
+            err = entry_name(e, j, buf, sizeof(buf), &name);
+            if (atf_is_error(err))
+                break;
+
+            if (e->m_kind == link_entry) {
+                if (symlinkat(e->m_target, dirfd, name) == -1)
+                    err = atf_libc_error(errno, "Cannot create link %s",
+                                         name);
+            } else
+                err = create_file(dirfd, name, e, &c);
+        }
+        chunk_fini(&c);
+        if (dirfd != rootfd)
+            close(dirfd);
+    }
+
+    return err;
+}
+
+/* Runs create_items in 'jobs' processes. */
+static
+atf_error_t
+create_items_parallel(int rootfd, const struct entry *entries,
+                      size_t nentries, unsigned int jobs)
+{
+    unsigned int i, failed;
+    pid_t *pids;
+
+    pids = malloc(sizeof(*pids) * jobs);
+    if (pids == NULL)
+        return atf_no_memory_error();
+
+    for (i = 0; i < jobs; i++) {
+        pids[i] = fork();
+        if (pids[i] == 0) {
+            atf_error_t err;
+
+            err = create_items(rootfd, entries, nentries, i, jobs);
+            if (atf_is_error(err)) {
+                char buf[4096];
+
+                atf_error_format(err, buf, sizeof(buf));
+                fprintf(stderr, "%s\n", buf);
+                atf_error_free(err);
+                _exit(EXIT_FAILURE);
+            }
+            _exit(EXIT_SUCCESS);
+        }
+    }
+
+    failed = 0;
+    for (i = 0; i < jobs; i++) {
+        int status;
+
+        if (pids[i] == -1) {
+            failed++;
+            continue;
+        }
+        while (waitpid(pids[i], &status, 0) == -1 && errno == EINTR)
+            continue;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+            failed++;
+    }
+    free(pids);
+
+    if (failed > 0)
+        return atf_error_new_fmt("tree", "%u of %u processes failed to "
+                                 "create their part of the tree", failed,
+                                 jobs);
+    return atf_no_error();
+}
+
+/* Creates the directories of the tree, which have to exist before their
+ * contents are created by any process. */
+static
+atf_error_t
+create_dirs(int rootfd, struct entry *entries, size_t nentries)
+{
+    atf_error_t err;
+    size_t i;
+
+    err = atf_no_error();
+    for (i = 0; i < nentries && !atf_is_error(err); i++) {
+        const struct entry *e = &entries[i];
+        char buf[1024];
+        unsigned long j;
+        int dirfd;
+
+        err = make_parents(rootfd, entries[i].m_parent);
+        if (atf_is_error(err) || e->m_kind != dir_entry)
+            continue;
+
+        err = open_parent(rootfd, e, &dirfd);
+        if (atf_is_error(err))
+            break;
+        for (j = e->m_first; j <= e->m_last && !atf_is_error(err); j++) {
+            const char *name;
+
+            err = entry_name(e, j, buf, sizeof(buf), &name);
+            if (!atf_is_error(err) && mkdirat(dirfd, name, 0755) == -1 &&
+                errno != EEXIST)
+                err = atf_libc_error(errno, "Cannot create directory %s",
+                                     name);
+        }
+        if (dirfd != rootfd)
+            close(dirfd);
+    }
+
+    return err;
+}
+
+/* Sets the mode of the directories once their contents exist, deepest
+ * first, so that read-only directories can be described. */
+static
+atf_error_t
+chmod_dirs(int rootfd, const struct entry *entries, size_t nentries)
+{
+    atf_error_t err;
+    size_t i;
+
+    err = atf_no_error();
+    for (i = nentries; i > 0 && !atf_is_error(err); i--) {
+        const struct entry *e = &entries[i - 1];
+        char buf[1024];
+        unsigned long j;
+        int dirfd;
+
+        if (e->m_kind != dir_entry || !e->m_has_mode)
+            continue;
+
+        err = open_parent(rootfd, e, &dirfd);
+        if (atf_is_error(err))
+            break;
+        for (j = e->m_first; j <= e->m_last && !atf_is_error(err); j++) {
+            const char *name;
+
+            err = entry_name(e, j, buf, sizeof(buf), &name);
+            if (!atf_is_error(err) &&
+                fchmodat(dirfd, name, e->m_mode, 0) == -1)
+                err = atf_libc_error(errno, "Cannot set the mode of %s",
+                                     name);
+        }
+        if (dirfd != rootfd)
+            close(dirfd);
+    }
+
+    return err;
+}
+
+/* Creates the tree described by 'spec' under 'root', which is created if
+ * it does not exist.  If 'jobs' is larger than one, the files are
+ * distributed among that many processes. */
+atf_error_t
+atf_tree_create(const char *root, const char *spec, unsigned int jobs)
+{
+    atf_dynstr_t buf;
+    struct entry *entries = NULL;
+    size_t nentries = 0;
+    atf_error_t err;
+    int rootfd;
+
+    PRE(jobs > 0);
+
+    err = atf_dynstr_init_fmt(&buf, "%s", spec);
+    if (atf_is_error(err))
+        return err;
+
+    err = parse_spec(atf_dynstr_data(&buf), &entries, &nentries);
+    if (atf_is_error(err))
+        goto out_buf;
+
+    if (mkdir(root, 0755) == -1 && errno != EEXIST) {
+        err = atf_libc_error(errno, "Cannot create directory %s", root);
+        goto out_entries;
+    }
+    rootfd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (rootfd == -1) {
+        err = atf_libc_error(errno, "Cannot open directory %s", root);
+        goto out_entries;
+    }
+
+    err = create_dirs(rootfd, entries, nentries);
+    if (atf_is_error(err))
+        goto out_rootfd;
+
+    if (jobs == 1)
+        err = create_items(rootfd, entries, nentries, 0, 1);
+    else
+        err = create_items_parallel(rootfd, entries, nentries, jobs);
+    if (atf_is_error(err))
+        goto out_rootfd;
+
+    err = chmod_dirs(rootfd, entries, nentries);
+
+out_rootfd:
+    close(rootfd);
+out_entries:
+    free(entries);
+out_buf:
+    atf_dynstr_fini(&buf);
+    return err;
+}
+
+/* ---------------------------------------------------------------------
+ * Tree cloning.
+ * --------------------------------------------------------------------- */
+
+struct clone_state {
+    bool m_hardlinks;
+    bool m_try_reflink;
+    atf_dynstr_t m_path;        /* The entry being cloned; for messages. */
+};
+
+static
+atf_error_t
+clone_error(int syserrno, const char *what, const struct clone_state *s)
+{
+    return atf_libc_error(syserrno, "Cannot %s %s", what,
+                          atf_dynstr_cstring(&s->m_path));
+}
+
+static
+atf_error_t
+copy_data(int in, int out, struct clone_state *s)
+{
+    char buf[16 * 1024];
+    ssize_t length;
+
+#if defined(FICLONE)
+    if (s->m_try_reflink) {
+        if (ioctl(out, FICLONE, in) != -1)
+            return atf_no_error();
+        /* Do not retry on file systems that do not support reflinks. */
+        if (errno == EOPNOTSUPP || errno == ENOTTY || errno == EXDEV ||
+            errno == EINVAL)
+            s->m_try_reflink = false;
+    }
+#endif
+
+    while ((length = read(in, buf, sizeof(buf))) > 0) {
+        atf_error_t err = write_all(out, atf_dynstr_cstring(&s->m_path),
+                                    buf, length);
+        if (atf_is_error(err))
+            return err;
+    }
+    if (length == -1)
+        return clone_error(errno, "read", s);
+    return atf_no_error();
+}
+
+static
+atf_error_t
+clone_file(int srcfd, int dstfd, const char *name, struct clone_state *s)
+{
+    atf_error_t err;
+    struct stat sb;
+    int in, out;
+
+    if (s->m_hardlinks && linkat(srcfd, name, dstfd, name, 0) != -1)
+        return atf_no_error();
+
+    in = openat(srcfd, name, O_RDONLY | O_CLOEXEC);
+    if (in == -1)
+        return clone_error(errno, "open", s);
+    if (fstat(in, &sb) == -1) {
+        err = clone_error(errno, "stat", s);
+        goto out_in;
+    }
+
+    out = openat(dstfd, name, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                 sb.st_mode & 07777);
+    if (out == -1) {
+        err = clone_error(errno, "create", s);
+        goto out_in;
+    }
+
+    err = copy_data(in, out, s);
+    if (!atf_is_error(err) && fchmod(out, sb.st_mode & 07777) == -1)
+        err = clone_error(errno, "set the mode of", s);
+
+    close(out);
+out_in:
+    close(in);
+    return err;
+}
+
+static
+atf_error_t
+clone_link(int srcfd, int dstfd, const char *name, struct clone_state *s)
+{
+    char target[PATH_MAX];
+    ssize_t length;
+
+    length = readlinkat(srcfd, name, target, sizeof(target) - 1);
+    if (length == -1)
+        return clone_error(errno, "read link", s);
+    target[length] = '\0';
+
+    if (symlinkat(target, dstfd, name) == -1)
+        return clone_error(errno, "create link", s);
+    return atf_no_error();
+}
+
+static atf_error_t clone_dir(int, int, struct clone_state *);
+
+static
+atf_error_t
+clone_subdir(int srcfd, int dstfd, const char *name, struct clone_state *s)
+{
+    atf_error_t err;
+    struct stat sb;
+    int subsrc, subdst;
+
+    subsrc = openat(srcfd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW |
+                    O_CLOEXEC);
+    if (subsrc == -1)
+        return clone_error(errno, "open directory", s);
+    if (fstat(subsrc, &sb) == -1) {
+        err = clone_error(errno, "stat", s);
+        close(subsrc);
+        return err;
+    }
+
+    if (mkdirat(dstfd, name, S_IRWXU) == -1) {
+        err = clone_error(errno, "create directory", s);
+        close(subsrc);
+        return err;
+    }
+    subdst = openat(dstfd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (subdst == -1) {
+        err = clone_error(errno, "open directory", s);
+        close(subsrc);
+        return err;
+    }
+
+    err = clone_dir(subsrc, subdst, s);
+    if (!atf_is_error(err) && fchmod(subdst, sb.st_mode & 07777) == -1)
+        err = clone_error(errno, "set the mode of", s);
+    close(subdst);
+    return err;
+}
+
+/* Clones the contents of the directory open at 'srcfd', which is closed
+ * on return, into the directory open at 'dstfd'. */
+static
+atf_error_t
+clone_dir(int srcfd, int dstfd, struct clone_state *s)
+{
+    const size_t length = atf_dynstr_length(&s->m_path);
+    atf_error_t err;
+    struct dirent *de;
+    DIR *dir;
+
+    dir = fdopendir(srcfd);
+    if (dir == NULL) {
+        err = clone_error(errno, "read directory", s);
+        close(srcfd);
+        return err;
+    }
+
+    err = atf_no_error();
+    while (!atf_is_error(err) && (de = readdir(dir)) != NULL) {
+        struct stat sb;
+        mode_t type;
+
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+            continue;
+
+        err = atf_dynstr_append_char(&s->m_path, '/');
+        if (!atf_is_error(err))
+            err = atf_dynstr_append_cstring(&s->m_path, de->d_name);
+        if (atf_is_error(err))
+            break;
+
+        /* Special files are not supported, so only these types matter;
+         * zero means that the type is not known yet. */
+        type = 0;
+#if defined(DT_DIR) && defined(DT_UNKNOWN)
+        switch (de->d_type) {
+        case DT_DIR: type = S_IFDIR; break;
+        case DT_LNK: type = S_IFLNK; break;
+        case DT_REG: type = S_IFREG; break;
+        case DT_UNKNOWN: break;
+        default: type = S_IFIFO; break;
+        }
+#endif
+        if (type == 0) {
+            if (fstatat(srcfd, de->d_name, &sb, AT_SYMLINK_NOFOLLOW) == -1) {
+                err = clone_error(errno, "stat", s);
+                break;
+            }
+            type = sb.st_mode & S_IFMT;
+        }
+
+        if (type == S_IFDIR)
+            err = clone_subdir(srcfd, dstfd, de->d_name, s);
+        else if (type == S_IFREG)
+            err = clone_file(srcfd, dstfd, de->d_name, s);
+        else if (type == S_IFLNK)
+            err = clone_link(srcfd, dstfd, de->d_name, s);
+        else
+            err = clone_error(ENOTSUP, "clone special file", s);
+
+        atf_dynstr_truncate(&s->m_path, length);
+    }
+    closedir(dir);
+
+    return err;
+}
+
+/* Clones the tree at 'source' into 'destination', which must not exist.
+ * Regular files are cloned with reflinks where the file system supports
+ * them and copied otherwise; if 'hardlinks' is true, they are hard-linked
+ * instead, so the contents of the files are shared with the source. */
+atf_error_t
+atf_tree_clone(const char *source, const char *destination, bool hardlinks)
+{
+    struct clone_state s;
+    atf_error_t err;
+    struct stat sb;
+    int srcfd, dstfd;
+
+    s.m_hardlinks = hardlinks;
+    s.m_try_reflink = true;
+    err = atf_dynstr_init_fmt(&s.m_path, "%s", source);
+    if (atf_is_error(err))
+        return err;
+
+    srcfd = open(source, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (srcfd == -1) {
+        err = clone_error(errno, "open directory", &s);
+        goto out;
+    }
+    if (fstat(srcfd, &sb) == -1) {
+        err = clone_error(errno, "stat", &s);
+        close(srcfd);
+        goto out;
+    }
+
+    if (mkdir(destination, S_IRWXU) == -1) {
+        err = atf_libc_error(errno, "Cannot create directory %s",
+                             destination);
+        close(srcfd);
+        goto out;
+    }
+    dstfd = open(destination, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dstfd == -1) {
+        err = atf_libc_error(errno, "Cannot open directory %s",
+                             destination);
+        close(srcfd);
+        goto out;
+    }
+
+    err = clone_dir(srcfd, dstfd, &s);
+    if (!atf_is_error(err) && fchmod(dstfd, sb.st_mode & 07777) == -1)
+        err = atf_libc_error(errno, "Cannot set the mode of %s",
+                             destination);
+    close(dstfd);
+
+out:
+    atf_dynstr_fini(&s.m_path);
+    return err;
+}
+
+/* ---------------------------------------------------------------------
+ * Tree modes.
+ * --------------------------------------------------------------------- */
+
+static atf_error_t chmod_contents(int, mode_t, mode_t, atf_dynstr_t *);
+
+/* Changes the mode of the entry 'name' of the directory open at 'dirfd'
+ * and, if it is a directory, of everything below it.  Symbolic links are
+ * not followed. */
+static
+atf_error_t
+chmod_entry(int dirfd, const char *name, mode_t set, mode_t clear,
+            atf_dynstr_t *path)
+{
+    atf_error_t err;
+    struct stat sb;
+
+    if (fstatat(dirfd, name, &sb, AT_SYMLINK_NOFOLLOW) == -1)
+        return atf_libc_error(errno, "Cannot stat %s",
+                              atf_dynstr_cstring(path));
+    if (S_ISLNK(sb.st_mode))
+        return atf_no_error();
+
+    if (S_ISDIR(sb.st_mode)) {
+        const int fd = openat(dirfd, name, O_RDONLY | O_DIRECTORY |
+                              O_NOFOLLOW | O_CLOEXEC);
+        if (fd == -1)
+            return atf_libc_error(errno, "Cannot open directory %s",
+                                  atf_dynstr_cstring(path));
+        err = chmod_contents(fd, set, clear, path);
+        if (atf_is_error(err))
+            return err;
+    }
+
+    if (fchmodat(dirfd, name, ((sb.st_mode & 07777) & ~clear) | set,
+                 0) == -1)
+        return atf_libc_error(errno, "Cannot set the mode of %s",
+                              atf_dynstr_cstring(path));
+    return atf_no_error();
+}
+
+/* Changes the mode of the contents of the directory open at 'fd', which
+ * is closed on return. */
+static
+atf_error_t
+chmod_contents(int fd, mode_t set, mode_t clear, atf_dynstr_t *path)
+{
+    const size_t length = atf_dynstr_length(path);
+    atf_error_t err;
+    struct dirent *de;
+    DIR *dir;
+
+    dir = fdopendir(fd);
+    if (dir == NULL) {
+        err = atf_libc_error(errno, "Cannot read directory %s",
+                             atf_dynstr_cstring(path));
+        close(fd);
+        return err;
+    }
+
+    err = atf_no_error();
+    while (!atf_is_error(err) && (de = readdir(dir)) != NULL) {
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+            continue;
+
+        err = atf_dynstr_append_char(path, '/');
+        if (!atf_is_error(err))
+            err = atf_dynstr_append_cstring(path, de->d_name);
+        if (!atf_is_error(err))
+            err = chmod_entry(dirfd(dir), de->d_name, set, clear, path);
+        atf_dynstr_truncate(path, length);
+    }
+    closedir(dir);
+
+    return err;
+}
+
+/* Sets the bits in 'set' and clears those in 'clear' from the mode of
+ * every directory and file of the tree at 'root', including 'root'. */
+atf_error_t
+atf_tree_chmod(const char *root, mode_t set, mode_t clear)
+{
+    atf_dynstr_t path;
+    atf_error_t err;
+
+    err = atf_dynstr_init_fmt(&path, "%s", root);
+    if (atf_is_error(err))
+        return err;
+    err = chmod_entry(AT_FDCWD, root, set, clear, &path);
+    atf_dynstr_fini(&path);
+    return err;
+}
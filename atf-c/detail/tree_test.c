@@ -0,0 +1,391 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/tree.h"
+
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/test_helpers.h"
+#include "atf-c/error.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static
+void
+check_spec_error(const char *spec)
+{
+    atf_error_t err;
+
+    printf("Checking that '%s' is rejected\n", spec);
+    err = atf_tree_create("root", spec, 1);
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_REQUIRE(atf_error_is(err, "tree_spec"));
+    atf_error_free(err);
+}
+
+static
+mode_t
+file_mode(const char *path)
+{
+    struct stat sb;
+
+    ATF_REQUIRE_MSG(lstat(path, &sb) != -1, "Cannot stat %s", path);
+    return sb.st_mode;
+}
+
+static
+off_t
+file_size(const char *path)
+{
+    struct stat sb;
+
+    ATF_REQUIRE_MSG(lstat(path, &sb) != -1, "Cannot stat %s", path);
+    return sb.st_size;
+}
+
+static
+double
+now(void)
+{
+    struct timespec ts;
+
+    ATF_REQUIRE(clock_gettime(CLOCK_MONOTONIC, &ts) != -1);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* ---------------------------------------------------------------------
+ * Test cases for atf_tree_create.
+ * --------------------------------------------------------------------- */
+
+ATF_TC(create_basic);
+ATF_TC_HEAD(create_basic, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests creating directories, files and "
+                      "links");
+}
+ATF_TC_BODY(create_basic, tc)
+{
+    char target[PATH_MAX];
+    ssize_t length;
+
+    RE(atf_tree_create("root",
+                       "# A comment\n"
+                       "\n"
+                       "dir/\n"
+                       "  dir/empty\n"
+                       "a/b/c/file content=Hello, world\\n\n"
+                       "link -> a/b/c/file\n",
+                       1));
+
+    ATF_REQUIRE(S_ISDIR(file_mode("root/dir")));
+    ATF_REQUIRE(S_ISREG(file_mode("root/dir/empty")));
+    ATF_REQUIRE_EQ(0, file_size("root/dir/empty"));
+    ATF_REQUIRE(S_ISDIR(file_mode("root/a/b")));
+    ATF_REQUIRE(atf_utils_compare_file("root/a/b/c/file",
+                                       "Hello, world\n"));
+
+    ATF_REQUIRE(S_ISLNK(file_mode("root/link")));
+    length = readlink("root/link", target, sizeof(target) - 1);
+    ATF_REQUIRE(length != -1);
+    target[length] = '\0';
+    ATF_REQUIRE_STREQ("a/b/c/file", target);
+}
+
+ATF_TC(create_sizes);
+ATF_TC_HEAD(create_sizes, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests creating files with a size and "
+                      "a pattern");
+}
+ATF_TC_BODY(create_sizes, tc)
+{
+    char buf[16];
+    int fd;
+
+    RE(atf_tree_create("root",
+                       "zeros size=100000\n"
+                       "abc size=200000 pattern=abc\n"
+                       "short size=2 pattern=abc\n"
+                       "empty size=0 pattern=abc\n",
+                       1));
+
+    ATF_REQUIRE_EQ(100000, file_size("root/zeros"));
+    ATF_REQUIRE_EQ(200000, file_size("root/abc"));
+    ATF_REQUIRE(atf_utils_compare_file("root/short", "ab"));
+    ATF_REQUIRE_EQ(0, file_size("root/empty"));
+
+    /* Check the pattern across the internal chunk boundaries. */
+    fd = open("root/abc", O_RDONLY);
+    ATF_REQUIRE(fd != -1);
+    ATF_REQUIRE_EQ(6, pread(fd, buf, 6, 65535));
+    buf[6] = '\0';
+    ATF_REQUIRE_STREQ("abcabc", buf);
+    ATF_REQUIRE_EQ(2, pread(fd, buf, 2, 199998));
+    buf[2] = '\0';
+    ATF_REQUIRE_STREQ("ab", buf);
+    close(fd);
+}
+
+ATF_TC(create_modes);
+ATF_TC_HEAD(create_modes, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests creating files and directories "
+                      "with explicit modes");
+}
+ATF_TC_BODY(create_modes, tc)
+{
+    mode_t old;
+
+    old = umask(0077);
+    RE(atf_tree_create("root",
+                       "ro/ mode=0555\n"
+                       "ro/file mode=0640 content=foo\n"
+                       "ro/sub/exec mode=0755\n",
+                       1));
+    umask(old);
+
+    ATF_REQUIRE_EQ(0555, file_mode("root/ro") & 07777);
+    ATF_REQUIRE_EQ(0640, file_mode("root/ro/file") & 07777);
+    ATF_REQUIRE_EQ(0755, file_mode("root/ro/sub/exec") & 07777);
+    ATF_REQUIRE(chmod("root/ro", 0755) != -1);
+}
+
+ATF_TC(create_ranges);
+ATF_TC_HEAD(create_ranges, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests creating many files with a "
+                      "single line");
+}
+ATF_TC_BODY(create_ranges, tc)
+{
+    RE(atf_tree_create("root",
+                       "d{1..3}/\n"
+                       "d2/f{0..99}.txt content=x\n"
+                       "l{5..6} -> d1\n",
+                       1));
+
+    ATF_REQUIRE(S_ISDIR(file_mode("root/d1")));
+    ATF_REQUIRE(S_ISDIR(file_mode("root/d3")));
+    ATF_REQUIRE(access("root/d4", F_OK) == -1);
+    ATF_REQUIRE(atf_utils_compare_file("root/d2/f0.txt", "x"));
+    ATF_REQUIRE(atf_utils_compare_file("root/d2/f99.txt", "x"));
+    ATF_REQUIRE(access("root/d2/f100.txt", F_OK) == -1);
+    ATF_REQUIRE(S_ISLNK(file_mode("root/l5")));
+    ATF_REQUIRE(S_ISLNK(file_mode("root/l6")));
+}
+
+ATF_TC(create_parallel);
+ATF_TC_HEAD(create_parallel, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests creating a tree with several "
+                      "processes");
+}
+ATF_TC_BODY(create_parallel, tc)
+{
+    char path[64];
+    int i;
+
+    RE(atf_tree_create("root",
+                       "a/f{1..500} content=a\n"
+                       "single content=s\n"
+                       "b/f{1..7} size=10 pattern=b\n",
+                       4));
+
+    for (i = 1; i <= 500; i++) {
+        snprintf(path, sizeof(path), "root/a/f%d", i);
+        ATF_REQUIRE_MSG(atf_utils_compare_file(path, "a"), "%s is wrong",
+                        path);
+    }
+    for (i = 1; i <= 7; i++) {
+        snprintf(path, sizeof(path), "root/b/f%d", i);
+        ATF_REQUIRE(atf_utils_compare_file(path, "bbbbbbbbbb"));
+    }
+    ATF_REQUIRE(atf_utils_compare_file("root/single", "s"));
+}
+
+ATF_TC(create_errors);
+ATF_TC_HEAD(create_errors, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that invalid specifications are "
+                      "rejected");
+}
+ATF_TC_BODY(create_errors, tc)
+{
+    atf_error_t err;
+
+    check_spec_error("/absolute");
+    check_spec_error("d{1..2}/file");
+    check_spec_error("f{1..}");
+    check_spec_error("f{3..1}");
+    check_spec_error("f{1..2");
+    check_spec_error("file mode=999");
+    check_spec_error("file size=-1");
+    check_spec_error("file size=10 pattern=");
+    check_spec_error("file unknown=1");
+    check_spec_error("dir/ size=10");
+    check_spec_error("link ->");
+    check_spec_error("link -> a b");
+    check_spec_error("..");
+    ATF_REQUIRE(access("root", F_OK) == -1);
+
+    RE(atf_tree_create("root", "file", 1));
+    err = atf_tree_create("root", "file/sub", 1);
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_REQUIRE(atf_error_is(err, "libc"));
+    atf_error_free(err);
+}
+
+/* ---------------------------------------------------------------------
+ * Test cases for atf_tree_clone.
+ * --------------------------------------------------------------------- */
+
+ATF_TC(clone_copy);
+ATF_TC_HEAD(clone_copy, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests cloning a tree without sharing "
+                      "the files");
+}
+ATF_TC_BODY(clone_copy, tc)
+{
+    RE(atf_tree_create("template",
+                       "a/b/file content=foo\n"
+                       "a/exec mode=0751 content=bar\n"
+                       "a/ro/ mode=0500\n"
+                       "link -> a/b/file\n",
+                       1));
+
+    RE(atf_tree_clone("template", "clone", false));
+    ATF_REQUIRE(atf_utils_compare_file("clone/a/b/file", "foo"));
+    ATF_REQUIRE(atf_utils_compare_file("clone/a/exec", "bar"));
+    ATF_REQUIRE_EQ(0751, file_mode("clone/a/exec") & 07777);
+    ATF_REQUIRE_EQ(0500, file_mode("clone/a/ro") & 07777);
+    ATF_REQUIRE(S_ISLNK(file_mode("clone/link")));
+
+    atf_utils_create_file("clone/a/b/file", "modified");
+    ATF_REQUIRE(atf_utils_compare_file("template/a/b/file", "foo"));
+
+    ATF_REQUIRE(chmod("clone/a/ro", 0755) != -1);
+    ATF_REQUIRE(chmod("template/a/ro", 0755) != -1);
+}
+
+ATF_TC(clone_hardlinks);
+ATF_TC_HEAD(clone_hardlinks, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests cloning a tree with hard links "
+                      "and measures it against creating the tree");
+}
+ATF_TC_BODY(clone_hardlinks, tc)
+{
+    struct stat sb1, sb2;
+    double start, created, cloned;
+    atf_error_t err;
+
+    start = now();
+    RE(atf_tree_create("template", "dir/f{1..10000} content=data\n", 1));
+    created = now();
+    RE(atf_tree_clone("template", "clone", true));
+    cloned = now();
+    printf("Created 10000 files in %.3f s; cloned them in %.3f s\n",
+           created - start, cloned - created);
+
+    ATF_REQUIRE(stat("template/dir/f42", &sb1) != -1);
+    ATF_REQUIRE(stat("clone/dir/f42", &sb2) != -1);
+    ATF_REQUIRE_EQ(sb1.st_ino, sb2.st_ino);
+
+    err = atf_tree_clone("template", "clone", true);
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_REQUIRE(atf_error_is(err, "libc"));
+    ATF_REQUIRE_EQ(EEXIST, atf_libc_error_code(err));
+    atf_error_free(err);
+}
+
+/* ---------------------------------------------------------------------
+ * Test cases for atf_tree_chmod.
+ * --------------------------------------------------------------------- */
+
+ATF_TC(chmod_tree);
+ATF_TC_HEAD(chmod_tree, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests changing the modes of a whole "
+                      "tree without following symbolic links");
+}
+ATF_TC_BODY(chmod_tree, tc)
+{
+    atf_utils_create_file("outside", "data");
+    ATF_REQUIRE(chmod("outside", 0666) != -1);
+    RE(atf_tree_create("root",
+                       "a/b/file mode=0664\n"
+                       "a/exec mode=0751\n"
+                       "a/ro/ mode=0555\n"
+                       "link -> ../outside\n",
+                       1));
+
+    RE(atf_tree_chmod("root", 0, S_IWUSR | S_IWGRP | S_IWOTH));
+    ATF_REQUIRE_EQ(0444, file_mode("root/a/b/file") & 07777);
+    ATF_REQUIRE_EQ(0551, file_mode("root/a/exec") & 07777);
+    ATF_REQUIRE_EQ(0555, file_mode("root/a/ro") & 07777);
+    ATF_REQUIRE_EQ(0, file_mode("root/a/b") & 0222);
+    ATF_REQUIRE_EQ(0, file_mode("root") & 0222);
+    ATF_REQUIRE_EQ(0666, file_mode("outside") & 07777);
+
+    RE(atf_tree_chmod("root", S_IWUSR, 0));
+    ATF_REQUIRE_EQ(0644, file_mode("root/a/b/file") & 07777);
+    ATF_REQUIRE_EQ(0751, file_mode("root/a/exec") & 07777);
+    ATF_REQUIRE_EQ(0755, file_mode("root/a/ro") & 07777);
+    ATF_REQUIRE_EQ(0200, file_mode("root") & 0222);
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    ATF_TP_ADD_TC(tp, create_basic);
+    ATF_TP_ADD_TC(tp, create_sizes);
+    ATF_TP_ADD_TC(tp, create_modes);
+    ATF_TP_ADD_TC(tp, create_ranges);
+    ATF_TP_ADD_TC(tp, create_parallel);
+    ATF_TP_ADD_TC(tp, create_errors);
+
+    ATF_TP_ADD_TC(tp, clone_copy);
+    ATF_TP_ADD_TC(tp, clone_hardlinks);
+
+    ATF_TP_ADD_TC(tp, chmod_tree);
+
+    return atf_no_error();
+}
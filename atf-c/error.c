@@ -42,6 +42,33 @@
  * currently do not have any threading support; therefore, this is fine. */
 static bool error_on_flight = false;
 
+/* The data of a libc error.  It is defined here because its size drives
+ * the size of the preallocated error below. */
+struct atf_libc_error_data {
+    int m_errno;
+    char m_what[4096];
+};
+typedef struct atf_libc_error_data atf_libc_error_data_t;
+
+/* Because of the above, errors are served from a single preallocated
+ * object whose payload is large enough for all the error types in the
+ * library.  Raising and handling an error, like the ENOENT errors
+ * discarded while probing for files, thus never touches the heap.
+ *
+ * The object is only handed out if it is not in use, so that code that
+ * breaks the rule above (which is only enforced in debug builds) gets
+ * heap-allocated errors instead of corrupting the one on flight. */
+static struct atf_error preallocated_error;
+static union {
+    atf_libc_error_data_t m_libc;
+    char m_bytes[4096 + 128];
+    long double m_align1;
+    void *m_align2;
+} preallocated_data;
+static bool preallocated_in_use = false;
+
+static struct atf_error no_memory_error;
+
 /* ---------------------------------------------------------------------
  * Auxiliary functions.
  * --------------------------------------------------------------------- */
@@ -55,31 +82,56 @@ error_format(const atf_error_t err, char *buf, size_t buflen)
 }
 
 static
-bool
-error_init(atf_error_t err, const char *type, void *data, size_t datalen,
+void
+error_init(atf_error_t err, const char *type, void *data,
            void (*format)(const atf_error_t, char *, size_t))
 {
-    bool ok;
-
-    PRE(data != NULL || datalen == 0);
-    PRE(datalen != 0 || data == NULL);
-
     err->m_free = false;
     err->m_type = type;
+    err->m_data = data;
     err->m_format = (format == NULL) ? error_format : format;
+}
 
-    ok = true;
-    if (data == NULL) {
-        err->m_data = NULL;
+/* Allocates an error with room for 'datalen' bytes of uninitialized data,
+ * or returns the no_memory error if that is not possible.  The caller is
+ * responsible for filling in the data of the former. */
+static
+atf_error_t
+error_alloc(const char *type, size_t datalen,
+            void (*format)(const atf_error_t, char *, size_t))
+{
+    atf_error_t err;
+
+    PRE(!error_on_flight);
+
+    if (!preallocated_in_use && datalen <= sizeof(preallocated_data)) {
+        err = &preallocated_error;
+        error_init(err, type, datalen == 0 ? NULL : &preallocated_data,
+                   format);
+        preallocated_in_use = true;
     } else {
-        err->m_data = malloc(datalen);
-        if (err->m_data == NULL) {
-            ok = false;
-        } else
-            memcpy(err->m_data, data, datalen);
+        void *data;
+
+        err = malloc(sizeof(*err));
+        if (err == NULL)
+            return atf_no_memory_error();
+
+        if (datalen == 0)
+            data = NULL;
+        else {
+            data = malloc(datalen);
+            if (data == NULL) {
+                free(err);
+                return atf_no_memory_error();
+            }
+        }
+
+        error_init(err, type, data, format);
+        err->m_free = true;
     }
 
-    return ok;
+    error_on_flight = true;
+    return err;
 }
 
 /* ---------------------------------------------------------------------
@@ -96,39 +148,72 @@ atf_error_new(const char *type, void *data, size_t datalen,
     PRE(data != NULL || datalen == 0);
     PRE(datalen != 0 || data == NULL);
 
-    err = malloc(sizeof(*err));
-    if (err == NULL)
-        err = atf_no_memory_error();
-    else {
-        if (!error_init(err, type, data, datalen, format)) {
-            free(err);
-            err = atf_no_memory_error();
-        } else {
-            err->m_free = true;
-            error_on_flight = true;
-        }
-    }
+    err = error_alloc(type, datalen, format);
+    if (err != &no_memory_error && datalen > 0)
+        memcpy(err->m_data, data, datalen);
 
     INV(err != NULL);
     POST(error_on_flight);
     return err;
 }
 
+/*
+ * Free-form errors.
+ */
+
+static
 void
-atf_error_free(atf_error_t err)
+message_format(const atf_error_t err, char *buf, size_t buflen)
+{
+    snprintf(buf, buflen, "%s", (const char *)atf_error_data(err));
+}
+
+/* Creates an error of the given type whose data is a message formatted
+ * straight into the error's storage; atf_error_format returns it as is. */
+atf_error_t
+atf_error_new_ap(const char *type, const char *fmt, va_list ap)
 {
-    bool freeit;
+    atf_error_t err;
+    va_list ap2;
+
+    err = error_alloc(type, sizeof(preallocated_data.m_libc.m_what),
+                      message_format);
+    if (err != &no_memory_error) {
+        va_copy(ap2, ap);
+        vsnprintf(err->m_data, sizeof(preallocated_data.m_libc.m_what),
+                  fmt, ap2);
+        va_end(ap2);
+    }
+
+    POST(error_on_flight);
+    return err;
+}
+
+atf_error_t
+atf_error_new_fmt(const char *type, const char *fmt, ...)
+{
+    atf_error_t err;
+    va_list ap;
+
+    va_start(ap, fmt);
+    err = atf_error_new_ap(type, fmt, ap);
+    va_end(ap);
+
+    return err;
+}
 
+void
+atf_error_free(atf_error_t err)
+{
     PRE(error_on_flight);
     PRE(err != NULL);
 
-    freeit = err->m_free;
-
-    if (err->m_data != NULL)
+    if (err == &preallocated_error)
+        preallocated_in_use = false;
+    else if (err->m_free) {
         free(err->m_data);
-
-    if (freeit)
         free(err);
+    }
 
     error_on_flight = false;
 }
@@ -176,12 +261,6 @@ atf_error_format(const atf_error_t err, char *buf, size_t buflen)
  * The "libc" error.
  */
 
-struct atf_libc_error_data {
-    int m_errno;
-    char m_what[4096];
-};
-typedef struct atf_libc_error_data atf_libc_error_data_t;
-
 static
 void
 libc_format(const atf_error_t err, char *buf, size_t buflen)
@@ -198,15 +277,17 @@ atf_error_t
 atf_libc_error(int syserrno, const char *fmt, ...)
 {
     atf_error_t err;
-    atf_libc_error_data_t data;
+    atf_libc_error_data_t *data;
     va_list ap;
 
-    data.m_errno = syserrno;
-    va_start(ap, fmt);
-    vsnprintf(data.m_what, sizeof(data.m_what), fmt, ap);
-    va_end(ap);
-
-    err = atf_error_new("libc", &data, sizeof(data), libc_format);
+    err = error_alloc("libc", sizeof(*data), libc_format);
+    if (err != &no_memory_error) {
+        data = err->m_data;
+        data->m_errno = syserrno;
+        va_start(ap, fmt);
+        vsnprintf(data->m_what, sizeof(data->m_what), fmt, ap);
+        va_end(ap);
+    }
 
     return err;
 }
@@ -239,8 +320,6 @@ atf_libc_error_msg(const atf_error_t err)
  * The "no_memory" error.
  */
 
-static struct atf_error no_memory_error;
-
 static
 void
 no_memory_format(const atf_error_t err, char *buf, size_t buflen)
@@ -255,8 +334,7 @@ atf_no_memory_error(void)
 {
     PRE(!error_on_flight);
 
-    error_init(&no_memory_error, "no_memory", NULL, 0,
-               no_memory_format);
+    error_init(&no_memory_error, "no_memory", NULL, no_memory_format);
 
     error_on_flight = true;
     return &no_memory_error;
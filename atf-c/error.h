@@ -28,6 +28,7 @@
 
 #include <atf-c/error_fwd.h>
 
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stddef.h>
 
@@ -45,6 +46,8 @@ struct atf_error {
 
 atf_error_t atf_error_new(const char *, void *, size_t,
                           void (*)(const atf_error_t, char *, size_t));
+atf_error_t atf_error_new_ap(const char *, const char *, va_list);
+atf_error_t atf_error_new_fmt(const char *, const char *, ...);
 void atf_error_free(atf_error_t);
 
 atf_error_t atf_no_error(void);
@@ -155,6 +155,56 @@ ATF_TC_BODY(format, tc)
     atf_error_free(err);
 }
 
+ATF_TC(new_fmt);
+ATF_TC_HEAD(new_fmt, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks the construction of free-form "
+                      "errors");
+}
+ATF_TC_BODY(new_fmt, tc)
+{
+    atf_error_t err;
+    char buf[1024];
+
+    err = atf_error_new_fmt("test_error", "%s message %d", "Test", 1);
+    ATF_REQUIRE(atf_error_is(err, "test_error"));
+    ATF_REQUIRE(strcmp(atf_error_data(err), "Test message 1") == 0);
+    atf_error_format(err, buf, sizeof(buf));
+    ATF_REQUIRE(strcmp(buf, "Test message 1") == 0);
+    atf_error_free(err);
+}
+
+ATF_TC(preallocated);
+ATF_TC_HEAD(preallocated, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that raising errors repeatedly "
+                      "reuses the same preallocated object");
+}
+ATF_TC_BODY(preallocated, tc)
+{
+    atf_error_t err, first;
+    int data, i;
+
+    first = atf_libc_error(ENOENT, "Cannot get information from file %s",
+                           "foo");
+    ATF_REQUIRE(!first->m_free);
+    atf_error_free(first);
+
+    for (i = 0; i < 1000; i++) {
+        err = atf_libc_error(ENOENT, "Cannot get information from file %s",
+                             "foo");
+        ATF_REQUIRE(err == first);
+        ATF_REQUIRE_EQ(atf_libc_error_code(err), ENOENT);
+        atf_error_free(err);
+
+        data = i;
+        err = atf_error_new("test_data_error", &data, sizeof(data), NULL);
+        ATF_REQUIRE(err == first);
+        ATF_REQUIRE_EQ(*((const int *)atf_error_data(err)), i);
+        atf_error_free(err);
+    }
+}
+
 /* ---------------------------------------------------------------------
  * Tests for the "libc" error.
  * --------------------------------------------------------------------- */
@@ -283,6 +333,8 @@ ATF_TP_ADD_TCS(tp)
     ATF_TP_ADD_TC(tp, no_error);
     ATF_TP_ADD_TC(tp, is_error);
     ATF_TP_ADD_TC(tp, format);
+    ATF_TP_ADD_TC(tp, new_fmt);
+    ATF_TP_ADD_TC(tp, preallocated);
 
     /* Add the tests for the "libc" error. */
     ATF_TP_ADD_TC(tp, libc_new);
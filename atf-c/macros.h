@@ -73,6 +73,30 @@
         .m_cleanup = atfu_ ## tc ## _cleanup, \
     }
 
+#define ATF_TC_BENCH(tc) \
+    static void atfu_ ## tc ## _head(atf_tc_t *); \
+    static void atfu_ ## tc ## _bench(const atf_tc_t *, const size_t); \
+    static \
+    void \
+    atfu_ ## tc ## _bench_head(atf_tc_t *atfu_tc) \
+    { \
+        atf_tc_bench_head(atfu_tc); \
+        atfu_ ## tc ## _head(atfu_tc); \
+    } \
+    static \
+    void \
+    atfu_ ## tc ## _body(const atf_tc_t *atfu_tc) \
+    { \
+        atf_tc_bench(atfu_tc, atfu_ ## tc ## _bench); \
+    } \
+    static atf_tc_t atfu_ ## tc ## _tc; \
+    static atf_tc_pack_t atfu_ ## tc ## _tc_pack = { \
+        .m_ident = #tc, \
+        .m_head = atfu_ ## tc ## _bench_head, \
+        .m_body = atfu_ ## tc ## _body, \
+        .m_cleanup = NULL, \
+    }
+
 #define ATF_TC_HEAD(tc, tcptr) \
     static \
     void \
@@ -89,6 +113,12 @@
 #define ATF_TC_BODY_NAME(tc) \
     (atfu_ ## tc ## _body)
 
+#define ATF_TC_BENCH_BODY(tc, tcptr, iters) \
+    static \
+    void \
+    atfu_ ## tc ## _bench(const atf_tc_t *tcptr ATF_DEFS_ATTRIBUTE_UNUSED, \
+                          const size_t iters ATF_DEFS_ATTRIBUTE_UNUSED)
+
 #define ATF_TC_CLEANUP(tc, tcptr) \
     static \
     void \
@@ -97,6 +127,21 @@
 #define ATF_TC_CLEANUP_NAME(tc) \
     (atfu_ ## tc ## _cleanup)
 
+#if defined(__GNUC__)
+#   define ATF_DO_NOT_OPTIMIZE(value) \
+    do { \
+        __typeof__(value) atfu_value = (value); \
+        __asm__ __volatile__("" : : "r,m"(atfu_value) : "memory"); \
+    } while (0)
+#   define ATF_COMPILER_BARRIER() \
+    __asm__ __volatile__("" : : : "memory")
+#else
+#   define ATF_DO_NOT_OPTIMIZE(value) \
+    atf_tc_bench_escape(&(value))
+#   define ATF_COMPILER_BARRIER() \
+    atf_tc_bench_escape(NULL)
+#endif
+
 #define ATF_TP_ADD_TCS(tps) \
     static atf_error_t atfu_tp_add_tcs(atf_tp_t *); \
     int atf_tp_main(int, char **, atf_error_t (*)(atf_tp_t *)); \
@@ -209,4 +254,27 @@
 #define ATF_REQUIRE_ERRNO(exp_errno, bool_expr) \
     atf_tc_require_errno(__FILE__, __LINE__, exp_errno, #bool_expr, bool_expr)
 
+#define ATF_ALLOCS_LE_IMPL(fail, max, statement) \
+    do { \
+        size_t atfu_allocs = atf_tc_alloc_count(); \
+        statement; \
+        atfu_allocs = atf_tc_alloc_count() - atfu_allocs; \
+        if (atfu_allocs > (size_t)(max)) \
+            fail(__FILE__, __LINE__, "%s made %zu heap allocations; " \
+                 "expected at most %zu", #statement, atfu_allocs, \
+                 (size_t)(max)); \
+    } while (0)
+
+#define ATF_REQUIRE_ALLOCS_LE(max, statement) \
+    ATF_ALLOCS_LE_IMPL(atf_tc_fail_requirement, max, statement)
+
+#define ATF_CHECK_ALLOCS_LE(max, statement) \
+    ATF_ALLOCS_LE_IMPL(atf_tc_fail_check, max, statement)
+
+#define ATF_REQUIRE_NO_ALLOC(statement) \
+    ATF_REQUIRE_ALLOCS_LE(0, statement)
+
+#define ATF_CHECK_NO_ALLOC(statement) \
+    ATF_CHECK_ALLOCS_LE(0, statement)
+
 #endif /* !defined(ATF_C_MACROS_H) */
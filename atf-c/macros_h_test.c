@@ -29,6 +29,8 @@ void atf_require_inside_if(void);
 void atf_require_equal_inside_if(void);
 void atf_check_errno_semicolons(void);
 void atf_require_errno_semicolons(void);
+void atf_allocs_inside_if(void);
+void atf_do_not_optimize(void);
 
 void
 atf_require_inside_if(void)
@@ -74,11 +76,50 @@ atf_require_errno_semicolons(void)
     ATF_REQUIRE_ERRNO(2, 2 == 2);
 }
 
+void
+atf_allocs_inside_if(void)
+{
+    /* Make sure that the allocation macros can be used inside an if
+     * statement that does not have braces and that they accept statements
+     * with commas in them. */
+    if (true)
+        ATF_CHECK_NO_ALLOC(((void)1, (void)2));
+    else
+        ATF_REQUIRE_NO_ALLOC((void)1);
+    if (true)
+        ATF_CHECK_ALLOCS_LE(1, (void)1);
+    else
+        ATF_REQUIRE_ALLOCS_LE(1, (void)2);
+}
+
+void
+atf_do_not_optimize(void)
+{
+    /* Make sure that ATF_DO_NOT_OPTIMIZE accepts both lvalues and rvalues
+     * of any type, and that it and ATF_COMPILER_BARRIER can be used inside
+     * an if statement that does not have braces. */
+    struct { char buf[64]; } aggregate = { { 0 } };
+    int value = 3;
+
+    if (true)
+        ATF_DO_NOT_OPTIMIZE(aggregate);
+    else
+        ATF_DO_NOT_OPTIMIZE(value);
+    if (true)
+        ATF_COMPILER_BARRIER();
+    else
+        ATF_COMPILER_BARRIER();
+#if defined(__GNUC__)
+    ATF_DO_NOT_OPTIMIZE(value * 2);
+#endif
+}
+
 /* Test case names should not be expanded during instatiation so that they
  * can have the exact same name as macros. */
 #define TEST_MACRO_1 invalid + name
 #define TEST_MACRO_2 invalid + name
 #define TEST_MACRO_3 invalid + name
+#define TEST_MACRO_4 invalid + name
 ATF_TC(TEST_MACRO_1);
 ATF_TC_HEAD(TEST_MACRO_1, tc) { if (tc != NULL) {} }
 ATF_TC_BODY(TEST_MACRO_1, tc) { if (tc != NULL) {} }
@@ -100,3 +141,9 @@ ATF_TC_BODY(TEST_MACRO_3, tc) { if (tc != NULL) {} }
 atf_tc_t *test_name_3 = &ATF_TC_NAME(TEST_MACRO_3);
 atf_tc_pack_t *test_pack_3 = &ATF_TC_PACK_NAME(TEST_MACRO_3);
 void (*body_3)(const atf_tc_t *) = ATF_TC_BODY_NAME(TEST_MACRO_3);
+ATF_TC_BENCH(TEST_MACRO_4);
+ATF_TC_HEAD(TEST_MACRO_4, tc) { if (tc != NULL) {} }
+ATF_TC_BENCH_BODY(TEST_MACRO_4, tc, iters) { if (tc != NULL && iters) {} }
+atf_tc_t *test_name_4 = &ATF_TC_NAME(TEST_MACRO_4);
+atf_tc_pack_t *test_pack_4 = &ATF_TC_PACK_NAME(TEST_MACRO_4);
+void (*head_4)(atf_tc_t *) = ATF_TC_HEAD_NAME(TEST_MACRO_4);
@@ -39,6 +39,7 @@
 
 #include <atf-c.h>
 
+#include "atf-c/detail/env.h"
 #include "atf-c/detail/fs.h"
 #include "atf-c/detail/process.h"
 #include "atf-c/detail/test_helpers.h"
@@ -205,6 +206,32 @@ init_and_run_h_tc(const char *name, void (*head)(atf_tc_t *),
 #define H_REQUIRE_ERRNO(id, exp_errno, bool_expr) \
     H_DEF(require_errno_ ## id, ATF_REQUIRE_ERRNO(exp_errno, bool_expr))
 
+#define H_CHECK_ALLOCS_LE_HEAD_NAME(id) \
+    ATF_TC_HEAD_NAME(h_check_allocs_le_ ## id)
+#define H_CHECK_ALLOCS_LE_BODY_NAME(id) \
+    ATF_TC_BODY_NAME(h_check_allocs_le_ ## id)
+#define H_CHECK_ALLOCS_LE(id, max, statement) \
+    H_DEF(check_allocs_le_ ## id, ATF_CHECK_ALLOCS_LE(max, statement))
+
+#define H_CHECK_NO_ALLOC_HEAD_NAME(id) ATF_TC_HEAD_NAME(h_check_no_alloc_ ## id)
+#define H_CHECK_NO_ALLOC_BODY_NAME(id) ATF_TC_BODY_NAME(h_check_no_alloc_ ## id)
+#define H_CHECK_NO_ALLOC(id, statement) \
+    H_DEF(check_no_alloc_ ## id, ATF_CHECK_NO_ALLOC(statement))
+
+#define H_REQUIRE_ALLOCS_LE_HEAD_NAME(id) \
+    ATF_TC_HEAD_NAME(h_require_allocs_le_ ## id)
+#define H_REQUIRE_ALLOCS_LE_BODY_NAME(id) \
+    ATF_TC_BODY_NAME(h_require_allocs_le_ ## id)
+#define H_REQUIRE_ALLOCS_LE(id, max, statement) \
+    H_DEF(require_allocs_le_ ## id, ATF_REQUIRE_ALLOCS_LE(max, statement))
+
+#define H_REQUIRE_NO_ALLOC_HEAD_NAME(id) \
+    ATF_TC_HEAD_NAME(h_require_no_alloc_ ## id)
+#define H_REQUIRE_NO_ALLOC_BODY_NAME(id) \
+    ATF_TC_BODY_NAME(h_require_no_alloc_ ## id)
+#define H_REQUIRE_NO_ALLOC(id, statement) \
+    H_DEF(require_no_alloc_ ## id, ATF_REQUIRE_NO_ALLOC(statement))
+
 /* ---------------------------------------------------------------------
  * Test cases for the ATF_{CHECK,REQUIRE}_ERRNO macros.
  * --------------------------------------------------------------------- */
@@ -764,6 +791,142 @@ ATF_TC_BODY(require_match, tc)
     do_require_eq_tests(tests);
 }
 
+/* ---------------------------------------------------------------------
+ * Test cases for the ATF_{CHECK,REQUIRE}_{ALLOCS_LE,NO_ALLOC} macros.
+ * --------------------------------------------------------------------- */
+
+static
+void
+alloc_stub(const int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++) {
+        void *volatile ptr = malloc(16);
+        free(ptr);
+    }
+}
+
+static
+void
+require_alloc_count(void)
+{
+    const size_t before = atf_tc_alloc_count();
+
+    alloc_stub(1);
+    if (atf_tc_alloc_count() == before)
+        atf_tc_skip("Heap allocations cannot be counted on this platform");
+}
+
+H_CHECK_ALLOCS_LE(ok, 2, alloc_stub(2));
+H_CHECK_ALLOCS_LE(fail, 2, alloc_stub(3));
+H_CHECK_NO_ALLOC(ok, alloc_stub(0));
+H_CHECK_NO_ALLOC(fail, alloc_stub(1));
+
+H_REQUIRE_ALLOCS_LE(ok, 2, alloc_stub(2));
+H_REQUIRE_ALLOCS_LE(fail, 2, alloc_stub(3));
+H_REQUIRE_NO_ALLOC(ok, alloc_stub(0));
+H_REQUIRE_NO_ALLOC(fail, alloc_stub(1));
+
+ATF_TC(check_allocs);
+ATF_TC_HEAD(check_allocs, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests the ATF_CHECK_ALLOCS_LE and "
+                      "ATF_CHECK_NO_ALLOC macros");
+}
+ATF_TC_BODY(check_allocs, tc)
+{
+    struct test {
+        void (*head)(atf_tc_t *);
+        void (*body)(const atf_tc_t *);
+        const char *msg;
+        bool ok;
+    } *t, tests[] = {
+        { H_CHECK_ALLOCS_LE_HEAD_NAME(ok), H_CHECK_ALLOCS_LE_BODY_NAME(ok),
+          NULL, true },
+        { H_CHECK_ALLOCS_LE_HEAD_NAME(fail), H_CHECK_ALLOCS_LE_BODY_NAME(fail),
+          "alloc_stub\\(3\\) made 3 heap allocations; expected at most 2",
+          false },
+        { H_CHECK_NO_ALLOC_HEAD_NAME(ok), H_CHECK_NO_ALLOC_BODY_NAME(ok),
+          NULL, true },
+        { H_CHECK_NO_ALLOC_HEAD_NAME(fail), H_CHECK_NO_ALLOC_BODY_NAME(fail),
+          "alloc_stub\\(1\\) made 1 heap allocations; expected at most 0",
+          false },
+        { NULL, NULL, NULL, false }
+    };
+
+    require_alloc_count();
+
+    for (t = &tests[0]; t->head != NULL; t++) {
+        init_and_run_h_tc("h_check_allocs", t->head, t->body);
+
+        ATF_REQUIRE(exists("before"));
+        ATF_REQUIRE(exists("after"));
+
+        if (t->ok) {
+            ATF_REQUIRE(atf_utils_grep_file("^passed", "result"));
+        } else {
+            ATF_REQUIRE(atf_utils_grep_file("^failed", "result"));
+            ATF_REQUIRE(atf_utils_grep_file("Check failed: .*"
+                "macros_test.c:[0-9]+: %s$", "error", t->msg));
+        }
+
+        ATF_REQUIRE(unlink("before") != -1);
+        ATF_REQUIRE(unlink("after") != -1);
+    }
+}
+
+ATF_TC(require_allocs);
+ATF_TC_HEAD(require_allocs, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests the ATF_REQUIRE_ALLOCS_LE and "
+                      "ATF_REQUIRE_NO_ALLOC macros");
+}
+ATF_TC_BODY(require_allocs, tc)
+{
+    struct test {
+        void (*head)(atf_tc_t *);
+        void (*body)(const atf_tc_t *);
+        const char *msg;
+        bool ok;
+    } *t, tests[] = {
+        { H_REQUIRE_ALLOCS_LE_HEAD_NAME(ok),
+          H_REQUIRE_ALLOCS_LE_BODY_NAME(ok),
+          NULL, true },
+        { H_REQUIRE_ALLOCS_LE_HEAD_NAME(fail),
+          H_REQUIRE_ALLOCS_LE_BODY_NAME(fail),
+          "alloc_stub\\(3\\) made 3 heap allocations; expected at most 2",
+          false },
+        { H_REQUIRE_NO_ALLOC_HEAD_NAME(ok), H_REQUIRE_NO_ALLOC_BODY_NAME(ok),
+          NULL, true },
+        { H_REQUIRE_NO_ALLOC_HEAD_NAME(fail),
+          H_REQUIRE_NO_ALLOC_BODY_NAME(fail),
+          "alloc_stub\\(1\\) made 1 heap allocations; expected at most 0",
+          false },
+        { NULL, NULL, NULL, false }
+    };
+
+    require_alloc_count();
+
+    for (t = &tests[0]; t->head != NULL; t++) {
+        init_and_run_h_tc("h_require_allocs", t->head, t->body);
+
+        ATF_REQUIRE(exists("before"));
+        if (t->ok) {
+            ATF_REQUIRE(atf_utils_grep_file("^passed", "result"));
+            ATF_REQUIRE(exists("after"));
+        } else {
+            ATF_REQUIRE(atf_utils_grep_file(
+                "^failed: .*macros_test.c:[0-9]+: %s$", "result", t->msg));
+            ATF_REQUIRE(!exists("after"));
+        }
+
+        ATF_REQUIRE(unlink("before") != -1);
+        if (t->ok)
+            ATF_REQUIRE(unlink("after") != -1);
+    }
+}
+
 /* ---------------------------------------------------------------------
  * Miscellaneous test cases covering several macros.
  * --------------------------------------------------------------------- */
@@ -831,6 +994,125 @@ ATF_TC_BODY(msg_embedded_fmt, tc)
     }
 }
 
+/* ---------------------------------------------------------------------
+ * Test cases for the ATF_TC_BENCH macros.
+ * --------------------------------------------------------------------- */
+
+ATF_TC_BENCH(h_bench);
+ATF_TC_HEAD(h_bench, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Helper test case");
+    atf_tc_set_md_var(tc, "X-bench.samples", "3");
+    atf_tc_set_md_var(tc, "X-bench.sample_time", "1");
+    atf_tc_set_md_var(tc, "X-bench.bytes", "16");
+}
+ATF_TC_BENCH_BODY(h_bench, tc, iters)
+{
+    struct { int values[4]; } block = { { 1, 2, 3, 4 } };
+    size_t i;
+
+    for (i = 0; i < iters; i++) {
+        block.values[i % 4] += (int)i;
+        ATF_DO_NOT_OPTIMIZE(block);
+        ATF_DO_NOT_OPTIMIZE(i * 2);
+    }
+    ATF_COMPILER_BARRIER();
+    create_ctl_file("ran");
+}
+
+ATF_TC_BENCH(h_bench_fail);
+ATF_TC_HEAD(h_bench_fail, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Helper test case");
+}
+ATF_TC_BENCH_BODY(h_bench_fail, tc, iters)
+{
+    ATF_REQUIRE_MSG(iters == 0, "Failed after %zu iterations", iters);
+}
+
+ATF_TC_BENCH(h_bench_invalid);
+ATF_TC_HEAD(h_bench_invalid, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Helper test case");
+    atf_tc_set_md_var(tc, "X-bench.samples", "0");
+}
+ATF_TC_BENCH_BODY(h_bench_invalid, tc, iters)
+{
+    create_ctl_file("ran");
+}
+
+ATF_TC(bench);
+ATF_TC_HEAD(bench, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests the ATF_TC_BENCH macro");
+}
+ATF_TC_BODY(bench, tc)
+{
+    const char *const config[] = { NULL };
+
+    RE(atf_tc_init_pack(&ATF_TC_NAME(h_bench), &ATF_TC_PACK_NAME(h_bench),
+                        config));
+    ATF_REQUIRE_STREQ("true", atf_tc_get_md_var(&ATF_TC_NAME(h_bench),
+                                                "X-bench"));
+    ATF_REQUIRE_STREQ("true", atf_tc_get_md_var(&ATF_TC_NAME(h_bench),
+                                                "is.exclusive"));
+
+    RE(atf_env_set("ATF_RECORDS", "records.json"));
+    run_h_tc(&ATF_TC_NAME(h_bench), "output", "error", "result");
+    atf_tc_fini(&ATF_TC_NAME(h_bench));
+
+    ATF_REQUIRE(exists("ran"));
+    ATF_REQUIRE(atf_utils_compare_file("result", "passed\n"));
+    atf_utils_cat_file("records.json", "");
+    ATF_REQUIRE(atf_utils_grep_file("^\\{\"tc\":\"h_bench\",\"bench\":\\{"
+        "\"iterations\":[0-9]+,\"samples\":3,\"ns_per_op\":[0-9.]+,"
+        "\"ci95_low_ns\":[0-9.]+,\"ci95_high_ns\":[0-9.]+,"
+        "\"mean_ns\":[0-9.]+,\"min_ns\":[0-9.]+,\"max_ns\":[0-9.]+,"
+        "\"ops_per_sec\":[0-9.]+,\"bytes_per_sec\":[0-9.]+,"
+        "\"cpu\":null\\}\\}$", "records.json"));
+}
+
+ATF_TC(bench_fail);
+ATF_TC_HEAD(bench_fail, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that failures in the body of "
+                      "an ATF_TC_BENCH test case are reported");
+}
+ATF_TC_BODY(bench_fail, tc)
+{
+    const char *const config[] = { NULL };
+
+    RE(atf_tc_init_pack(&ATF_TC_NAME(h_bench_fail),
+                        &ATF_TC_PACK_NAME(h_bench_fail), config));
+    RE(atf_env_set("ATF_RECORDS", "records.json"));
+    run_h_tc(&ATF_TC_NAME(h_bench_fail), "output", "error", "result");
+    atf_tc_fini(&ATF_TC_NAME(h_bench_fail));
+
+    ATF_REQUIRE(atf_utils_grep_file("^failed: .*macros_test.c:[0-9]+: "
+                                    "Failed after 1 iterations$", "result"));
+    ATF_REQUIRE(!exists("records.json"));
+}
+
+ATF_TC(bench_invalid);
+ATF_TC_HEAD(bench_invalid, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that invalid settings of an "
+                      "ATF_TC_BENCH test case are reported");
+}
+ATF_TC_BODY(bench_invalid, tc)
+{
+    const char *const config[] = { NULL };
+
+    RE(atf_tc_init_pack(&ATF_TC_NAME(h_bench_invalid),
+                        &ATF_TC_PACK_NAME(h_bench_invalid), config));
+    run_h_tc(&ATF_TC_NAME(h_bench_invalid), "output", "error", "result");
+    atf_tc_fini(&ATF_TC_NAME(h_bench_invalid));
+
+    ATF_REQUIRE(atf_utils_compare_file("result", "failed: Invalid value for "
+                                       "X-bench.samples: '0'\n"));
+    ATF_REQUIRE(!exists("ran"));
+}
+
 /* ---------------------------------------------------------------------
  * Tests cases for the header file.
  * --------------------------------------------------------------------- */
@@ -876,15 +1158,21 @@ ATF_TP_ADD_TCS(tp)
     ATF_TP_ADD_TC(tp, check_streq);
     ATF_TP_ADD_TC(tp, check_errno);
     ATF_TP_ADD_TC(tp, check_match);
+    ATF_TP_ADD_TC(tp, check_allocs);
 
     ATF_TP_ADD_TC(tp, require);
     ATF_TP_ADD_TC(tp, require_eq);
     ATF_TP_ADD_TC(tp, require_streq);
     ATF_TP_ADD_TC(tp, require_errno);
     ATF_TP_ADD_TC(tp, require_match);
+    ATF_TP_ADD_TC(tp, require_allocs);
 
     ATF_TP_ADD_TC(tp, msg_embedded_fmt);
 
+    ATF_TP_ADD_TC(tp, bench);
+    ATF_TP_ADD_TC(tp, bench_fail);
+    ATF_TP_ADD_TC(tp, bench_invalid);
+
     /* Add the test cases for the header file. */
     ATF_TP_ADD_TC(tp, use);
     ATF_TP_ADD_TC(tp, detect_unused_tests);
@@ -26,6 +26,7 @@
 #include "atf-c/tc.h"
 
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/uio.h>
 
@@ -39,11 +40,19 @@
 #include <unistd.h>
 
 #include "atf-c/defs.h"
+#include "atf-c/detail/alloc.h"
+#include "atf-c/detail/arena.h"
+#include "atf-c/detail/bench.h"
+#include "atf-c/detail/budget.h"
+#include "atf-c/detail/dynstr.h"
 #include "atf-c/detail/env.h"
 #include "atf-c/detail/fs.h"
 #include "atf-c/detail/map.h"
+#include "atf-c/detail/perf.h"
+#include "atf-c/detail/record.h"
 #include "atf-c/detail/sanity.h"
 #include "atf-c/detail/text.h"
+#include "atf-c/detail/trace.h"
 #include "atf-c/error.h"
 
 /* ---------------------------------------------------------------------
@@ -71,6 +80,15 @@ struct context {
     size_t expect_fail_count;
     int expect_exitcode;
     int expect_signo;
+
+    bool perf_enabled;
+    atf_perf_t perf;
+
+    bool budget_enabled;
+    atf_budget_t budget;
+
+    bool alloc_enabled;
+    struct atf_alloc_stats alloc;
 };
 
 static void context_init(struct context *, const atf_tc_t *, const char *);
@@ -81,6 +99,12 @@ static atf_error_t write_resfile(const int, const char *, const int,
                                  const atf_dynstr_t *);
 static void create_resfile(struct context *, const char *, const int,
                            atf_dynstr_t *);
+static void init_perf(struct context *);
+static void report_perf(struct context *, const char *);
+static void init_budget(struct context *);
+static void check_budget(struct context *);
+static void init_alloc(struct context *);
+static void report_alloc(struct context *, const char *);
 static void error_in_expect(struct context *, const char *, ...)
     ATF_DEFS_ATTRIBUTE_NORETURN;
 static void validate_expect(struct context *);
@@ -88,6 +112,9 @@ static void expected_failure(struct context *, atf_dynstr_t *)
     ATF_DEFS_ATTRIBUTE_NORETURN;
 static void fail_requirement(struct context *, atf_dynstr_t *)
     ATF_DEFS_ATTRIBUTE_NORETURN;
+static void fail_requirement_error(struct context *, atf_error_t,
+                                   const char *)
+    ATF_DEFS_ATTRIBUTE_NORETURN;
 static void fail_check(struct context *, atf_dynstr_t *);
 static void pass(struct context *)
     ATF_DEFS_ATTRIBUTE_NORETURN;
@@ -127,6 +154,10 @@ context_init(struct context *ctx, const atf_tc_t *tc, const char *resfile)
     ctx->expect_fail_count = 0;
     ctx->expect_exitcode = 0;
     ctx->expect_signo = 0;
+    ctx->perf_enabled = false;
+    ctx->budget_enabled = false;
+    ctx->alloc_enabled = false;
+    memset(&ctx->alloc, 0, sizeof(ctx->alloc));
 }
 
 static void
@@ -220,6 +251,12 @@ create_resfile(struct context *ctx, const char *result, const int arg,
 {
     atf_error_t err;
 
+    if (ctx->perf_enabled)
+        report_perf(ctx, result);
+    if (ctx->alloc_enabled)
+        report_alloc(ctx, result);
+
+    ATF_TRACE_BEGIN("write_resfile", "result", result);
     if (strcmp("/dev/stdout", ctx->resfile) == 0) {
         err = write_resfile(STDOUT_FILENO, result, arg, reason);
     } else if (strcmp("/dev/stderr", ctx->resfile) == 0) {
@@ -229,6 +266,7 @@ create_resfile(struct context *ctx, const char *result, const int arg,
         close(ctx->resfilefd);
         ctx->resfilefd = -1;
     }
+    ATF_TRACE_END();
 
     if (reason != NULL)
         atf_dynstr_fini(reason);
@@ -236,6 +274,149 @@ create_resfile(struct context *ctx, const char *result, const int arg,
     check_fatal_error(err);
 }
 
+/** Sets up the performance counters requested by the test case, if any.
+ *
+ * An invalid list of events is reported as a failure of the test case
+ * instead of an error because it is a problem in the test case itself. */
+static void
+init_perf(struct context *ctx)
+{
+    atf_error_t err;
+
+    if (!atf_tc_has_md_var(ctx->tc, "X-perf.events"))
+        return;
+
+    err = atf_perf_init(&ctx->perf,
+                        atf_tc_get_md_var(ctx->tc, "X-perf.events"));
+    if (atf_is_error(err))
+        fail_requirement_error(ctx, err, "X-perf.events");
+    ctx->perf_enabled = true;
+}
+
+/** Writes the record with the performance counters of the test case.
+ *
+ * The counters are stopped here in case the body did not return, which
+ * happens when it terminates the test case on its own. */
+static void
+report_perf(struct context *ctx, const char *result)
+{
+    atf_error_t err;
+    atf_dynstr_t fields;
+
+    atf_perf_stop(&ctx->perf);
+
+    err = atf_dynstr_init_fmt(&fields, "\"result\":");
+    if (!atf_is_error(err)) {
+        err = atf_text_append_json(&fields, result);
+        if (!atf_is_error(err))
+            err = atf_dynstr_append_fmt(&fields, ",\"perf\":");
+        if (!atf_is_error(err))
+            err = atf_perf_format(&ctx->perf, &fields);
+        if (!atf_is_error(err))
+            err = atf_record_write(atf_tc_get_ident(ctx->tc),
+                                   atf_dynstr_cstring(&fields));
+        atf_dynstr_fini(&fields);
+    }
+
+    atf_perf_fini(&ctx->perf);
+    ctx->perf_enabled = false;
+
+    check_fatal_error(err);
+}
+
+/** Sets up the resource budgets declared by the test case, if any. */
+static void
+init_budget(struct context *ctx)
+{
+    static const char *const names[] = { "cpu", "wall", "rss", "allocs",
+                                         NULL };
+    const char *const *name;
+
+    atf_budget_init(&ctx->budget);
+    for (name = names; *name != NULL; name++) {
+        char var[32];
+        atf_error_t err;
+
+        snprintf(var, sizeof(var), "X-budget.%s", *name);
+        if (!atf_tc_has_md_var(ctx->tc, var))
+            continue;
+
+        err = atf_budget_set(&ctx->budget, *name,
+                             atf_tc_get_md_var(ctx->tc, var));
+        if (atf_is_error(err))
+            fail_requirement_error(ctx, err, var);
+    }
+    ctx->budget_enabled = atf_budget_is_set(&ctx->budget);
+}
+
+/** Fails the test case if it used more resources than its budgets allow.
+ *
+ * The measurements are stopped here in case the body did not return,
+ * which happens when it makes the test case pass on its own. */
+static void
+check_budget(struct context *ctx)
+{
+    atf_dynstr_t reason;
+
+    atf_budget_stop(&ctx->budget);
+    ctx->budget_enabled = false;
+
+    check_fatal_error(atf_dynstr_init(&reason));
+    check_fatal_error(atf_budget_check(&ctx->budget, &reason));
+    if (atf_dynstr_length(&reason) > 0)
+        fail_requirement(ctx, &reason);
+    atf_dynstr_fini(&reason);
+}
+
+/** Determines whether the test case asked for the statistics of its heap.
+ *
+ * The request is silently ignored where allocations cannot be tracked so
+ * that test cases do not have to care about the platform they run on. */
+static void
+init_alloc(struct context *ctx)
+{
+    atf_error_t err;
+    bool enabled;
+
+    if (!atf_tc_has_md_var(ctx->tc, "X-alloc.stats"))
+        return;
+
+    err = atf_text_to_bool(atf_tc_get_md_var(ctx->tc, "X-alloc.stats"),
+                           &enabled);
+    if (atf_is_error(err))
+        fail_requirement_error(ctx, err, "X-alloc.stats");
+    ctx->alloc_enabled = enabled;
+}
+
+/** Writes the record with the statistics of the heap of the test case.
+ *
+ * As with the performance counters, the statistics are stopped here in
+ * case the body did not return. */
+static void
+report_alloc(struct context *ctx, const char *result)
+{
+    atf_error_t err;
+    atf_dynstr_t fields;
+
+    atf_alloc_stats_stop(&ctx->alloc);
+    ctx->alloc_enabled = false;
+
+    err = atf_dynstr_init_fmt(&fields, "\"result\":");
+    if (!atf_is_error(err)) {
+        err = atf_text_append_json(&fields, result);
+        if (!atf_is_error(err))
+            err = atf_dynstr_append_fmt(&fields, ",\"alloc\":");
+        if (!atf_is_error(err))
+            err = atf_alloc_format(&ctx->alloc, &fields);
+        if (!atf_is_error(err))
+            err = atf_record_write(atf_tc_get_ident(ctx->tc),
+                                   atf_dynstr_cstring(&fields));
+        atf_dynstr_fini(&fields);
+    }
+
+    check_fatal_error(err);
+}
+
 /** Fails a test case if validate_expect fails. */
 static void
 error_in_expect(struct context *ctx, const char *fmt, ...)
@@ -294,6 +475,8 @@ expected_failure(struct context *ctx, atf_dynstr_t *reason)
 static void
 fail_requirement(struct context *ctx, atf_dynstr_t *reason)
 {
+    ATF_TRACE_INSTANT("requirement_failed", "reason",
+                      atf_dynstr_cstring(reason));
     if (ctx->expect == EXPECT_FAIL) {
         expected_failure(ctx, reason);
     } else if (ctx->expect == EXPECT_PASS) {
@@ -306,9 +489,31 @@ fail_requirement(struct context *ctx, atf_dynstr_t *reason)
     UNREACHABLE;
 }
 
+/** Fails the test case with the message of the given error, which is
+ * released.
+ *
+ * If a property name is given, the message says that its value is invalid.
+ */
+static void
+fail_requirement_error(struct context *ctx, atf_error_t err,
+                       const char *property)
+{
+    char buf[4096];
+    atf_dynstr_t reason;
+
+    atf_error_format(err, buf, sizeof(buf));
+    atf_error_free(err);
+    if (property != NULL)
+        format_reason_fmt(&reason, NULL, 0, "Invalid %s: %s", property, buf);
+    else
+        format_reason_fmt(&reason, NULL, 0, "%s", buf);
+    fail_requirement(ctx, &reason);
+}
+
 static void
 fail_check(struct context *ctx, atf_dynstr_t *reason)
 {
+    ATF_TRACE_INSTANT("check_failed", "reason", atf_dynstr_cstring(reason));
     if (ctx->expect == EXPECT_FAIL) {
         fprintf(stderr, "*** Expected check failure: %s: %s\n",
             atf_dynstr_cstring(&ctx->expect_reason),
@@ -332,6 +537,8 @@ pass(struct context *ctx)
         error_in_expect(ctx, "Test case was expecting a failure but got "
             "a pass instead");
     } else if (ctx->expect == EXPECT_PASS) {
+        if (ctx->budget_enabled)
+            check_budget(ctx);
         create_resfile(ctx, "passed", -1, NULL);
         exit(EXIT_SUCCESS);
     } else {
@@ -529,6 +736,130 @@ out:
     return err;
 }
 
+/* ---------------------------------------------------------------------
+ * The "atf_tc_data" type.
+ * --------------------------------------------------------------------- */
+
+/* Tables of data files embedded into the test program, registered by the
+ * constructors that atf-embed-data(1) generates. */
+static struct atf_tc_data_table *Data_tables = NULL;
+
+/* Data files that were not embedded and that have been mapped from the
+ * source directory instead.  They stay mapped until the test program
+ * exits so that callers can hold onto them. */
+struct mapped_data {
+    struct atf_tc_data m_data;
+    struct mapped_data *m_next;
+};
+static struct mapped_data *Mapped_data = NULL;
+
+void
+atf_tc_register_data(struct atf_tc_data_table *table)
+{
+    PRE(table->m_next == NULL);
+
+    table->m_next = Data_tables;
+    Data_tables = table;
+}
+
+static const struct atf_tc_data *
+find_embedded_data(const char *name)
+{
+    const struct atf_tc_data_table *table;
+    const struct mapped_data *md;
+    size_t i;
+
+    for (table = Data_tables; table != NULL; table = table->m_next) {
+        for (i = 0; i < table->m_nentries; i++) {
+            if (strcmp(table->m_entries[i].m_name, name) == 0)
+                return &table->m_entries[i];
+        }
+    }
+
+    for (md = Mapped_data; md != NULL; md = md->m_next) {
+        if (strcmp(md->m_data.m_name, name) == 0)
+            return &md->m_data;
+    }
+
+    return NULL;
+}
+
+static atf_error_t
+map_data(const char *srcdir, const char *name, const struct atf_tc_data **out)
+{
+    atf_error_t err;
+    atf_fs_path_t p;
+    struct mapped_data *md;
+    struct stat sb;
+    int fd;
+
+    err = atf_fs_path_init_fmt(&p, "%s/%s", srcdir, name);
+    if (atf_is_error(err))
+        goto out;
+
+    fd = open(atf_fs_path_cstring(&p), O_RDONLY);
+    if (fd == -1) {
+        err = atf_libc_error(errno, "Data file %s is not embedded into the "
+                             "test program and cannot be opened",
+                             atf_fs_path_cstring(&p));
+        goto out_p;
+    }
+
+    if (fstat(fd, &sb) == -1) {
+        err = atf_libc_error(errno, "Cannot stat %s", atf_fs_path_cstring(&p));
+        goto out_fd;
+    }
+
+    md = malloc(sizeof(*md) + strlen(name) + 1);
+    if (md == NULL) {
+        err = atf_no_memory_error();
+        goto out_fd;
+    }
+    strcpy((char *)(md + 1), name);
+    md->m_data.m_name = (const char *)(md + 1);
+    md->m_data.m_length = sb.st_size;
+
+    if (sb.st_size == 0)
+        md->m_data.m_data = "";
+    else {
+        void *addr = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            err = atf_libc_error(errno, "Cannot map %s",
+                                 atf_fs_path_cstring(&p));
+            free(md);
+            goto out_fd;
+        }
+        md->m_data.m_data = addr;
+    }
+
+    md->m_next = Mapped_data;
+    Mapped_data = md;
+    *out = &md->m_data;
+
+out_fd:
+    close(fd);
+out_p:
+    atf_fs_path_fini(&p);
+out:
+    return err;
+}
+
+static atf_error_t
+get_data(struct context *ctx, const char *name,
+         const struct atf_tc_data **out)
+{
+    *out = find_embedded_data(name);
+    if (*out != NULL)
+        return atf_no_error();
+
+    if (!atf_tc_has_config_var(ctx->tc, "srcdir"))
+        return atf_error_new_fmt("data", "Data file %s is not embedded into "
+                                 "the test program and srcdir is not set",
+                                 name);
+
+    return map_data(atf_tc_get_config_var(ctx->tc, "srcdir"), name, out);
+}
+
 /* ---------------------------------------------------------------------
  * The "atf_tc" type.
  * --------------------------------------------------------------------- */
@@ -536,6 +867,9 @@ out:
 struct atf_tc_impl {
     const char *m_ident;
 
+    /* Where this structure and its maps live; NULL if on the heap. */
+    atf_arena_t *m_arena;
+
     atf_map_t m_vars;
     atf_map_t m_config;
 
@@ -554,23 +888,39 @@ atf_tc_init(atf_tc_t *tc, const char *ident, atf_tc_head_t head,
             const char *const *config)
 {
     atf_error_t err;
+    atf_arena_t *arena;
 
-    tc->pimpl = malloc(sizeof(struct atf_tc_impl));
+    arena = atf_arena_get_program();
+    if (arena != NULL)
+        tc->pimpl = atf_arena_alloc(arena, sizeof(struct atf_tc_impl));
+    else
+        tc->pimpl = malloc(sizeof(struct atf_tc_impl));
     if (tc->pimpl == NULL) {
         err = atf_no_memory_error();
         goto err;
     }
 
     tc->pimpl->m_ident = ident;
+    tc->pimpl->m_arena = arena;
     tc->pimpl->m_head = head;
     tc->pimpl->m_body = body;
     tc->pimpl->m_cleanup = cleanup;
 
-    err = atf_map_init_charpp(&tc->pimpl->m_config, config);
+    if (arena != NULL)
+        err = atf_map_init_arena(&tc->pimpl->m_config, arena);
+    else
+        err = atf_map_init(&tc->pimpl->m_config);
     if (atf_is_error(err))
-        goto err;
+        goto err_impl;
 
-    err = atf_map_init(&tc->pimpl->m_vars);
+    err = atf_map_insert_charpp(&tc->pimpl->m_config, config);
+    if (atf_is_error(err))
+        goto err_vars;
+
+    if (arena != NULL)
+        err = atf_map_init_arena(&tc->pimpl->m_vars, arena);
+    else
+        err = atf_map_init(&tc->pimpl->m_vars);
     if (atf_is_error(err))
         goto err_vars;
 
@@ -585,8 +935,11 @@ atf_tc_init(atf_tc_t *tc, const char *ident, atf_tc_head_t head,
     }
 
     /* XXX Should the head be able to return error codes? */
-    if (tc->pimpl->m_head != NULL)
+    if (tc->pimpl->m_head != NULL) {
+        ATF_TRACE_BEGIN("head", "tc", ident);
         tc->pimpl->m_head(tc);
+        ATF_TRACE_END();
+    }
 
     if (strcmp(atf_tc_get_md_var(tc, "ident"), ident) != 0) {
         report_fatal_error("Test case head modified the read-only 'ident' "
@@ -601,6 +954,9 @@ err_map:
     atf_map_fini(&tc->pimpl->m_vars);
 err_vars:
     atf_map_fini(&tc->pimpl->m_config);
+err_impl:
+    if (arena == NULL)
+        free(tc->pimpl);
 err:
     return err;
 }
@@ -617,7 +973,9 @@ void
 atf_tc_fini(atf_tc_t *tc)
 {
     atf_map_fini(&tc->pimpl->m_vars);
-    free(tc->pimpl);
+    atf_map_fini(&tc->pimpl->m_config);
+    if (tc->pimpl->m_arena == NULL)
+        free(tc->pimpl);
 }
 
 /*
@@ -742,6 +1100,28 @@ atf_tc_get_md_vars(const atf_tc_t *tc)
     return atf_map_to_charpp(&tc->pimpl->m_vars);
 }
 
+/*
+ * Calls the visitor on every meta-data variable of the test case, in the
+ * order in which they were defined, without copying them.  Stops at the
+ * first error returned by the visitor and returns it.
+ */
+atf_error_t
+atf_tc_visit_md_vars(const atf_tc_t *tc, atf_tc_md_var_visitor_t visitor,
+                     void *arg)
+{
+    atf_error_t err;
+    atf_map_citer_t iter;
+
+    err = atf_no_error();
+    atf_map_for_each_c(iter, &tc->pimpl->m_vars) {
+        err = visitor(atf_map_citer_key(iter), atf_map_citer_data(iter), arg);
+        if (atf_is_error(err))
+            break;
+    }
+
+    return err;
+}
+
 bool
 atf_tc_has_config_var(const atf_tc_t *tc, const char *name)
 {
@@ -770,17 +1150,18 @@ atf_error_t
 atf_tc_set_md_var(atf_tc_t *tc, const char *name, const char *fmt, ...)
 {
     atf_error_t err;
-    char *value;
+    atf_dynstr_t value;
     va_list ap;
 
     va_start(ap, fmt);
-    err = atf_text_format_ap(&value, fmt, ap);
+    err = atf_dynstr_init_ap(&value, fmt, ap);
     va_end(ap);
+    if (atf_is_error(err))
+        return err;
 
-    if (!atf_is_error(err))
-        err = atf_map_insert(&tc->pimpl->m_vars, name, value, true);
-    else
-        free(value);
+    err = atf_map_insert_copy(&tc->pimpl->m_vars, name,
+                              atf_dynstr_cstring(&value));
+    atf_dynstr_fini(&value);
 
     return err;
 }
@@ -812,6 +1193,28 @@ static void _atf_tc_expect_signal(struct context *, const int, const char *,
     va_list);
 static void _atf_tc_expect_death(struct context *, const char *,
     va_list);
+static const void *_atf_tc_get_data(struct context *, const char *,
+    size_t *);
+static long bench_long(struct context *, const char *, const char *,
+    const long);
+static long bench_md_long(struct context *, const char *, const long,
+    const long);
+static void _atf_tc_bench(struct context *, atf_tc_bench_t);
+
+static const void *
+_atf_tc_get_data(struct context *ctx, const char *name, size_t *length)
+{
+    const struct atf_tc_data *data;
+    atf_error_t err;
+
+    err = get_data(ctx, name, &data);
+    if (atf_is_error(err))
+        fail_requirement_error(ctx, err, NULL);
+
+    if (length != NULL)
+        *length = data->m_length;
+    return data->m_data;
+}
 
 static void
 _atf_tc_fail(struct context *ctx, const char *fmt, va_list ap)
@@ -912,6 +1315,71 @@ _atf_tc_require_errno(struct context *ctx, const char *file, const size_t line,
         fail_requirement);
 }
 
+/** Parses an integral setting of a benchmark, failing the test case if
+ * it is invalid. */
+static long
+bench_long(struct context *ctx, const char *name, const char *str,
+           const long min)
+{
+    atf_error_t err;
+    long value;
+
+    err = atf_text_to_long(str, &value);
+    if (atf_is_error(err) || value < min) {
+        atf_dynstr_t reason;
+
+        if (atf_is_error(err))
+            atf_error_free(err);
+        format_reason_fmt(&reason, NULL, 0, "Invalid value for %s: '%s'",
+                          name, str);
+        fail_requirement(ctx, &reason);
+    }
+    return value;
+}
+
+static long
+bench_md_long(struct context *ctx, const char *name, const long defval,
+              const long min)
+{
+    if (!atf_tc_has_md_var(ctx->tc, name))
+        return defval;
+    return bench_long(ctx, name, atf_tc_get_md_var(ctx->tc, name), min);
+}
+
+static void
+_atf_tc_bench(struct context *ctx, atf_tc_bench_t func)
+{
+    struct atf_bench_config config;
+    struct atf_bench_result result;
+    atf_dynstr_t fields;
+    atf_error_t err;
+
+    atf_bench_config_init(&config);
+    config.m_samples = bench_md_long(ctx, "X-bench.samples",
+                                     config.m_samples, 1);
+    config.m_warmup = bench_md_long(ctx, "X-bench.warmup", config.m_warmup,
+                                    0);
+    config.m_sample_ns = bench_md_long(ctx, "X-bench.sample_time",
+                                       config.m_sample_ns / 1000000, 1) *
+        1000000;
+    config.m_bytes = bench_md_long(ctx, "X-bench.bytes", 0, 0);
+    if (atf_tc_has_config_var(ctx->tc, "bench.cpu"))
+        config.m_cpu = bench_long(ctx, "bench.cpu",
+            atf_tc_get_config_var(ctx->tc, "bench.cpu"), 0);
+
+    err = atf_bench_run(ctx->tc, func, &config, &result);
+    if (atf_is_error(err))
+        fail_requirement_error(ctx, err, NULL);
+
+    check_fatal_error(atf_dynstr_init_fmt(&fields, "\"bench\":"));
+    err = atf_bench_format(&result, &fields);
+    if (!atf_is_error(err))
+        err = atf_record_write(atf_tc_get_ident(ctx->tc),
+                               atf_dynstr_cstring(&fields));
+    atf_dynstr_fini(&fields);
+    check_fatal_error(err);
+}
+
 static void
 _atf_tc_expect_pass(struct context *ctx)
 {
@@ -1011,8 +1479,25 @@ atf_error_t
 atf_tc_run(const atf_tc_t *tc, const char *resfile)
 {
     context_init(&Current, tc, resfile);
-
+    init_perf(&Current);
+    init_budget(&Current);
+    init_alloc(&Current);
+
+    ATF_TRACE_BEGIN("body", "tc", tc->pimpl->m_ident);
+    if (Current.budget_enabled)
+        atf_budget_start(&Current.budget);
+    if (Current.perf_enabled)
+        atf_perf_start(&Current.perf);
+    if (Current.alloc_enabled)
+        Current.alloc_enabled = atf_alloc_stats_start();
     tc->pimpl->m_body(tc);
+    if (Current.alloc_enabled)
+        atf_alloc_stats_stop(&Current.alloc);
+    if (Current.perf_enabled)
+        atf_perf_stop(&Current.perf);
+    if (Current.budget_enabled)
+        atf_budget_stop(&Current.budget);
+    ATF_TRACE_END();
 
     validate_expect(&Current);
 
@@ -1038,11 +1523,51 @@ atf_tc_run(const atf_tc_t *tc, const char *resfile)
 atf_error_t
 atf_tc_cleanup(const atf_tc_t *tc)
 {
-    if (tc->pimpl->m_cleanup != NULL)
+    if (tc->pimpl->m_cleanup != NULL) {
+        ATF_TRACE_BEGIN("cleanup", "tc", tc->pimpl->m_ident);
         tc->pimpl->m_cleanup(tc);
+        ATF_TRACE_END();
+    }
     return atf_no_error(); /* XXX */
 }
 
+/** Marks a test case as a benchmark.
+ *
+ * Benchmarks are flagged with X-bench so that runners can tell them apart
+ * and with is.exclusive so that kyua does not run them in parallel with
+ * other test cases, which would distort their timings.  This is called
+ * before the head of the test case so that it can override these. */
+void
+atf_tc_bench_head(atf_tc_t *tc)
+{
+    check_fatal_error(atf_tc_set_md_var(tc, "X-bench", "true"));
+    check_fatal_error(atf_tc_set_md_var(tc, "is.exclusive", "true"));
+}
+
+/** Keeps the compiler from optimizing away the computation of a value
+ * when the benchmark macros cannot rely on inline assembly. */
+static const volatile void *volatile Bench_sink;
+
+void
+atf_tc_bench_escape(const volatile void *ptr)
+{
+    Bench_sink = ptr;
+}
+
+/** Gets the number of heap allocations made so far by the test program.
+ *
+ * Used by the allocation assertions in macros.h, which only look at the
+ * difference between two calls; hence, this returns zero where the
+ * allocations cannot be counted so that the assertions always hold. */
+size_t
+atf_tc_alloc_count(void)
+{
+    size_t count;
+
+    (void)atf_alloc_count(&count);
+    return count;
+}
+
 /* ---------------------------------------------------------------------
  * Free functions that depend on Current.
  * --------------------------------------------------------------------- */
@@ -1058,6 +1583,22 @@ atf_tc_cleanup(const atf_tc_t *tc)
  * is hard.  TODO: Revisit in the future.
  */
 
+const atf_tc_t *
+atf_tc_get_current(void)
+{
+    PRE(Current.tc != NULL);
+
+    return Current.tc;
+}
+
+const void *
+atf_tc_get_data(const char *name, size_t *length)
+{
+    PRE(Current.tc != NULL);
+
+    return _atf_tc_get_data(&Current, name, length);
+}
+
 void
 atf_tc_fail(const char *fmt, ...)
 {
@@ -1155,6 +1696,15 @@ atf_tc_require_errno(const char *file, const size_t line, const int exp_errno,
                           expr_result);
 }
 
+void
+atf_tc_bench(const atf_tc_t *tc ATF_DEFS_ATTRIBUTE_UNUSED,
+             atf_tc_bench_t func)
+{
+    PRE(Current.tc == tc);
+
+    _atf_tc_bench(&Current, func);
+}
+
 void
 atf_tc_expect_pass(void)
 {
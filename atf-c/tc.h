@@ -37,6 +37,9 @@ struct atf_tc;
 typedef void (*atf_tc_head_t)(struct atf_tc *);
 typedef void (*atf_tc_body_t)(const struct atf_tc *);
 typedef void (*atf_tc_cleanup_t)(const struct atf_tc *);
+typedef void (*atf_tc_bench_t)(const struct atf_tc *, const size_t);
+typedef atf_error_t (*atf_tc_md_var_visitor_t)(const char *, const char *,
+                                               void *);
 
 /* ---------------------------------------------------------------------
  * The "atf_tc_pack" type.
@@ -54,6 +57,27 @@ struct atf_tc_pack {
 };
 typedef const struct atf_tc_pack atf_tc_pack_t;
 
+/* ---------------------------------------------------------------------
+ * The "atf_tc_data" type.
+ * --------------------------------------------------------------------- */
+
+/* For static initialization only, by the sources that atf-embed-data(1)
+ * generates to embed data files into test programs. */
+struct atf_tc_data {
+    const char *m_name;
+    const void *m_data;
+    size_t m_length;
+};
+
+struct atf_tc_data_table {
+    const struct atf_tc_data *m_entries;
+    size_t m_nentries;
+
+    struct atf_tc_data_table *m_next;
+};
+
+void atf_tc_register_data(struct atf_tc_data_table *);
+
 /* ---------------------------------------------------------------------
  * The "atf_tc" type.
  * --------------------------------------------------------------------- */
@@ -87,6 +111,8 @@ const char *atf_tc_get_md_var(const atf_tc_t *, const char *);
 char **atf_tc_get_md_vars(const atf_tc_t *);
 bool atf_tc_has_config_var(const atf_tc_t *, const char *);
 bool atf_tc_has_md_var(const atf_tc_t *, const char *);
+atf_error_t atf_tc_visit_md_vars(const atf_tc_t *, atf_tc_md_var_visitor_t,
+                                 void *);
 
 /* Modifiers. */
 atf_error_t atf_tc_set_md_var(atf_tc_t *, const char *, const char *, ...);
@@ -99,6 +125,7 @@ atf_error_t atf_tc_run(const atf_tc_t *, const char *);
 atf_error_t atf_tc_cleanup(const atf_tc_t *);
 
 /* To be run from test case bodies only. */
+const void *atf_tc_get_data(const char *, size_t *);
 void atf_tc_fail(const char *, ...)
     ATF_DEFS_ATTRIBUTE_FORMAT_PRINTF(1, 2)
     ATF_DEFS_ATTRIBUTE_NORETURN;
@@ -132,5 +159,14 @@ void atf_tc_check_errno(const char *, const size_t, const int,
                         const char *, const bool);
 void atf_tc_require_errno(const char *, const size_t, const int,
                           const char *, const bool);
+size_t atf_tc_alloc_count(void);
+
+/* Internal to utils.c. */
+const atf_tc_t *atf_tc_get_current(void);
+
+/* Internal to the benchmark macros in macros.h and to atf-c++. */
+void atf_tc_bench_head(atf_tc_t *);
+void atf_tc_bench(const atf_tc_t *, atf_tc_bench_t);
+void atf_tc_bench_escape(const volatile void *);
 
 #endif /* !defined(ATF_C_TC_H) */
@@ -126,6 +126,56 @@ ATF_TC_BODY(vars, tcin)
     atf_tc_fini(&tc);
 }
 
+static atf_error_t
+count_md_var(const char *name, const char *value, void *arg)
+{
+    size_t *count = arg;
+
+    if (strcmp(name, "test-var") == 0)
+        ATF_REQUIRE(strcmp(value, "Test text") == 0);
+    (*count)++;
+    return atf_no_error();
+}
+
+static atf_error_t
+stop_md_var(const char *name, const char *value, void *arg)
+{
+    size_t *count = arg;
+
+    if (name != NULL && value != NULL) {}
+    (*count)++;
+    return atf_no_memory_error();
+}
+
+ATF_TC(visit_md_vars);
+ATF_TC_HEAD(visit_md_vars, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests the atf_tc_visit_md_vars "
+                      "function");
+}
+ATF_TC_BODY(visit_md_vars, tcin)
+{
+    atf_tc_t tc;
+    atf_error_t err;
+    size_t count;
+
+    RE(atf_tc_init(&tc, "test1", ATF_TC_HEAD_NAME(test_var),
+                   ATF_TC_BODY_NAME(empty), NULL, NULL));
+
+    count = 0;
+    RE(atf_tc_visit_md_vars(&tc, count_md_var, &count));
+    ATF_REQUIRE_EQ(2, count);
+
+    count = 0;
+    err = atf_tc_visit_md_vars(&tc, stop_md_var, &count);
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_REQUIRE(atf_error_is(err, "no_memory"));
+    atf_error_free(err);
+    ATF_REQUIRE_EQ(1, count);
+
+    atf_tc_fini(&tc);
+}
+
 ATF_TC(config);
 ATF_TC_HEAD(config, tc)
 {
@@ -164,6 +214,54 @@ ATF_TC_BODY(config, tcin)
  * but good tests here could allow us to avoid much of the indirect
  * testing done later on. */
 
+ATF_TC(get_data__embedded);
+ATF_TC_HEAD(get_data__embedded, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that atf_tc_get_data returns "
+                      "the files embedded into the test program");
+}
+ATF_TC_BODY(get_data__embedded, tc)
+{
+    const char *expected = "This file is embedded into tc_test.\n";
+    const void *data;
+    size_t length;
+
+    data = atf_tc_get_data("tc_test_embedded.txt", &length);
+    ATF_REQUIRE_EQ(strlen(expected), length);
+    ATF_REQUIRE(memcmp(expected, data, length) == 0);
+    ATF_REQUIRE(data == atf_tc_get_data("tc_test_embedded.txt", NULL));
+}
+
+ATF_TC(get_data__srcdir);
+ATF_TC_HEAD(get_data__srcdir, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that atf_tc_get_data falls back "
+                      "to the files in the source directory");
+}
+ATF_TC_BODY(get_data__srcdir, tc)
+{
+    const char *expected = "This file is read from the source directory.\n";
+    const void *data;
+    size_t length;
+
+    data = atf_tc_get_data("tc_test_srcdir.txt", &length);
+    ATF_REQUIRE_EQ(strlen(expected), length);
+    ATF_REQUIRE(memcmp(expected, data, length) == 0);
+    ATF_REQUIRE(data == atf_tc_get_data("tc_test_srcdir.txt", NULL));
+}
+
+ATF_TC(get_data__missing);
+ATF_TC_HEAD(get_data__missing, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that atf_tc_get_data fails the "
+                      "test case if the file does not exist");
+}
+ATF_TC_BODY(get_data__missing, tc)
+{
+    atf_tc_expect_fail("The data file does not exist");
+    atf_tc_get_data("tc_test_missing.txt", NULL);
+}
+
 /* ---------------------------------------------------------------------
  * Main.
  * --------------------------------------------------------------------- */
@@ -174,9 +272,13 @@ ATF_TP_ADD_TCS(tp)
     ATF_TP_ADD_TC(tp, init);
     ATF_TP_ADD_TC(tp, init_pack);
     ATF_TP_ADD_TC(tp, vars);
+    ATF_TP_ADD_TC(tp, visit_md_vars);
     ATF_TP_ADD_TC(tp, config);
 
     /* Add the test cases for the free functions. */
+    ATF_TP_ADD_TC(tp, get_data__embedded);
+    ATF_TP_ADD_TC(tp, get_data__srcdir);
+    ATF_TP_ADD_TC(tp, get_data__missing);
     /* TODO */
 
     return atf_no_error();
@@ -30,7 +30,9 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "atf-c/detail/arena.h"
 #include "atf-c/detail/fs.h"
+#include "atf-c/detail/list.h"
 #include "atf-c/detail/map.h"
 #include "atf-c/detail/sanity.h"
 #include "atf-c/error.h"
@@ -39,6 +41,10 @@
 struct atf_tp_impl {
     atf_list_t m_tcs;
     atf_map_t m_config;
+
+    /* Where this structure and its containers live; NULL if on the
+     * heap. */
+    atf_arena_t *m_arena;
 };
 
 /* ---------------------------------------------------------------------
@@ -76,25 +82,47 @@ atf_error_t
 atf_tp_init(atf_tp_t *tp, const char *const *config)
 {
     atf_error_t err;
+    atf_arena_t *arena;
 
     PRE(config != NULL);
 
-    tp->pimpl = malloc(sizeof(struct atf_tp_impl));
+    arena = atf_arena_get_program();
+    if (arena != NULL)
+        tp->pimpl = atf_arena_alloc(arena, sizeof(struct atf_tp_impl));
+    else
+        tp->pimpl = malloc(sizeof(struct atf_tp_impl));
     if (tp->pimpl == NULL)
         return atf_no_memory_error();
+    tp->pimpl->m_arena = arena;
 
-    err = atf_list_init(&tp->pimpl->m_tcs);
+    if (arena != NULL)
+        err = atf_list_init_arena(&tp->pimpl->m_tcs, arena);
+    else
+        err = atf_list_init(&tp->pimpl->m_tcs);
     if (atf_is_error(err))
-        goto out;
+        goto err_impl;
 
-    err = atf_map_init_charpp(&tp->pimpl->m_config, config);
-    if (atf_is_error(err)) {
-        atf_list_fini(&tp->pimpl->m_tcs);
-        goto out;
-    }
+    if (arena != NULL)
+        err = atf_map_init_arena(&tp->pimpl->m_config, arena);
+    else
+        err = atf_map_init(&tp->pimpl->m_config);
+    if (atf_is_error(err))
+        goto err_tcs;
+
+    err = atf_map_insert_charpp(&tp->pimpl->m_config, config);
+    if (atf_is_error(err))
+        goto err_config;
 
     INV(!atf_is_error(err));
-out:
+    return err;
+
+err_config:
+    atf_map_fini(&tp->pimpl->m_config);
+err_tcs:
+    atf_list_fini(&tp->pimpl->m_tcs);
+err_impl:
+    if (arena == NULL)
+        free(tp->pimpl);
     return err;
 }
 
@@ -111,7 +139,8 @@ atf_tp_fini(atf_tp_t *tp)
     }
     atf_list_fini(&tp->pimpl->m_tcs);
 
-    free(tp->pimpl);
+    if (tp->pimpl->m_arena == NULL)
+        free(tp->pimpl);
 }
 
 /*
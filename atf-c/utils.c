@@ -39,7 +39,13 @@
 
 #include <atf-c.h>
 
+#include "atf-c/detail/baseline.h"
+#include "atf-c/detail/bench.h"
+#include "atf-c/detail/cache.h"
 #include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/fs.h"
+#include "atf-c/detail/record.h"
+#include "atf-c/detail/tree.h"
 
 /** Allocate a filename to be used by atf_utils_{fork,wait}.
  *
@@ -69,6 +75,107 @@ init_out_filename(atf_dynstr_t *name, const pid_t pid, const char *suffix,
     }
 }
 
+/** Fails the calling test case with the description of an error, if any.
+ *
+ * \param error The error to check, which is released. */
+static void
+check_error(atf_error_t error)
+{
+    if (atf_is_error(error)) {
+        char buf[4096];
+
+        atf_error_format(error, buf, sizeof(buf));
+        atf_error_free(error);
+        atf_tc_fail("%s", buf);
+    }
+}
+
+/** Adapts the generators of the public API to the cache module.
+ *
+ * \param dir Directory in which to generate the fixture.
+ * \param inputs Inputs to pass to the generator.
+ * \param data Pointer to the atf_utils_fixture_generator_t to call.
+ *
+ * \return Always success, as the generator fails the test case itself. */
+static
+atf_error_t
+run_fixture_generator(const char *dir, const char *inputs, void *data)
+{
+    const atf_utils_fixture_generator_t *generator = data;
+
+    (*generator)(dir, inputs);
+    return atf_no_error();
+}
+
+/** Locates a fixture in the cache, generating it if necessary.
+ *
+ * \param key Version of the fixture; see atf_utils_cached_fixture.
+ * \param inputs Inputs to pass to the generator.
+ * \param generator Function that generates the fixture.
+ * \param path Output path to the fixture in the cache. */
+static void
+cached_fixture(const char *key, const char *inputs,
+               atf_utils_fixture_generator_t generator, atf_fs_path_t *path)
+{
+    atf_fs_path_t dir;
+
+    check_error(atf_cache_default_dir(&dir));
+    const atf_error_t error = atf_cache_fixture(atf_fs_path_cstring(&dir),
+                                                key, inputs,
+                                                run_fixture_generator,
+                                                &generator, path);
+    atf_fs_path_fini(&dir);
+    check_error(error);
+}
+
+/** Adapts the timed blocks of the public API to the bench module. */
+struct timed_block {
+    atf_utils_timed_block_t m_block;
+    void *m_data;
+};
+
+static
+void
+run_timed_block(void *data, const size_t n)
+{
+    const struct timed_block *tb = data;
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        tb->m_block(tb->m_data);
+}
+
+/** Gets a non-negative integer configuration variable of the current test
+ * case, failing it if the value is out of range. */
+static
+long
+baseline_config_var(const atf_tc_t *tc, const char *name, const long defval,
+                    const long min)
+{
+    const long value = atf_tc_get_config_var_as_long_wd(tc, name, defval);
+
+    if (value < min)
+        atf_tc_fail("Invalid value for %s: '%ld'", name, value);
+    return value;
+}
+
+/** Emits a record with the result of a comparison against a baseline. */
+static
+void
+record_baseline(const atf_tc_t *tc, const char *name,
+                const struct atf_baseline_result *result)
+{
+    atf_dynstr_t fields;
+
+    check_error(atf_dynstr_init_fmt(&fields, "\"baseline\":"));
+    atf_error_t error = atf_baseline_format(name, result, &fields);
+    if (!atf_is_error(error))
+        error = atf_record_write(atf_tc_get_ident(tc),
+                                 atf_dynstr_cstring(&fields));
+    atf_dynstr_fini(&fields);
+    check_error(error);
+}
+
 /** Searches for a regexp in a string.
  *
  * \param regex The regexp to look for.
@@ -93,6 +200,55 @@ grep_string(const char *regex, const char *str)
     return res == 0;
 }
 
+/** Returns a fixture from the cache shared by all test programs.
+ *
+ * The fixture is generated by calling the generator with the path of an
+ * empty directory to fill and with the inputs, but only if the cache does
+ * not hold a fixture for the same key and inputs yet.  Concurrent callers
+ * wait for each other so that the generator runs only once.
+ *
+ * \param key Version of the fixture, which must change whenever the
+ *     generator changes in a way that affects its output.
+ * \param inputs Inputs to pass to the generator.
+ * \param generator Function that generates the fixture.
+ *
+ * \return The path to the fixture, which is read-only.
+ * The caller must release it with free(3). */
+char *
+atf_utils_cached_fixture(const char *key, const char *inputs,
+                         atf_utils_fixture_generator_t generator)
+{
+    atf_fs_path_t path;
+
+    cached_fixture(key, inputs, generator, &path);
+    char *copy = strdup(atf_fs_path_cstring(&path));
+    atf_fs_path_fini(&path);
+    ATF_REQUIRE(copy != NULL);
+    return copy;
+}
+
+/** Creates a private copy of a fixture from the cache.
+ *
+ * The files of the copy are cloned when the file system supports it, so
+ * this is cheap even for large fixtures.
+ *
+ * \param key Version of the fixture; see atf_utils_cached_fixture.
+ * \param inputs Inputs to pass to the generator.
+ * \param generator Function that generates the fixture.
+ * \param destination Path to the directory to create with the copy. */
+void
+atf_utils_cached_fixture_clone(const char *key, const char *inputs,
+                               atf_utils_fixture_generator_t generator,
+                               const char *destination)
+{
+    atf_fs_path_t path;
+
+    cached_fixture(key, inputs, generator, &path);
+    const atf_error_t error = atf_cache_clone(&path, destination);
+    atf_fs_path_fini(&path);
+    check_error(error);
+}
+
 /** Prints the contents of a file to stdout.
  *
  * \param name The name of the file to be printed.
@@ -133,6 +289,103 @@ atf_utils_cat_file(const char *name, const char *prefix)
     ATF_REQUIRE(count == 0);
 }
 
+/** Checks that a block of code has not become slower than its baseline.
+ *
+ * Takes repeated timing samples of the block, running it as many times per
+ * sample as needed to get stable measurements, and compares them against
+ * the samples stored in the NAME.baseline file of the source directory.
+ * The test case fails if the block is slower than the baseline by more
+ * than the percentage in the baseline.threshold configuration variable,
+ * 5 by default, with 95% confidence.  The number of samples comes from
+ * the baseline.samples configuration variable, 30 by default.
+ *
+ * If the baseline.update configuration variable is true, the baseline
+ * file is rewritten with the new samples instead.
+ *
+ * \param name Name of the baseline, which must be unique within the
+ *     source directory.
+ * \param block Function containing the code to time.
+ * \param data Opaque pointer to pass to the block. */
+void
+atf_utils_check_baseline(const char *name, atf_utils_timed_block_t block,
+                         void *data)
+{
+    const atf_tc_t *tc = atf_tc_get_current();
+    struct atf_bench_config config;
+    struct atf_baseline_result result;
+    struct timed_block tb;
+    atf_dynstr_t path;
+    double *samples, *base;
+    size_t iterations, nbase;
+    long threshold;
+
+    atf_bench_config_init(&config);
+    config.m_samples = baseline_config_var(tc, "baseline.samples", 30, 2);
+    threshold = baseline_config_var(tc, "baseline.threshold", 5, 0);
+
+    if (!atf_tc_has_config_var(tc, "srcdir"))
+        atf_tc_fail("Cannot locate baseline %s: srcdir is not set", name);
+    check_error(atf_dynstr_init_fmt(&path, "%s/%s.baseline",
+                                    atf_tc_get_config_var(tc, "srcdir"),
+                                    name));
+
+    samples = malloc(config.m_samples * sizeof(*samples));
+    ATF_REQUIRE(samples != NULL);
+    tb.m_block = block;
+    tb.m_data = data;
+    check_error(atf_bench_sample(run_timed_block, &tb, &config, samples,
+                                 &iterations));
+
+    if (atf_tc_get_config_var_as_bool_wd(tc, "baseline.update", false)) {
+        const atf_error_t error = atf_baseline_write(
+            atf_dynstr_cstring(&path), samples, config.m_samples);
+        free(samples);
+        atf_dynstr_fini(&path);
+        check_error(error);
+        return;
+    }
+
+    atf_error_t error = atf_baseline_read(atf_dynstr_cstring(&path), &base,
+                                          &nbase);
+    if (atf_is_error(error) && atf_error_is(error, "libc") &&
+        atf_libc_error_code(error) == ENOENT) {
+        atf_error_free(error);
+        atf_tc_fail("Baseline %s does not exist; run with -v "
+                    "baseline.update=true to create it",
+                    atf_dynstr_cstring(&path));
+    }
+    atf_dynstr_fini(&path);
+    check_error(error);
+
+    atf_baseline_compare(base, nbase, samples, config.m_samples,
+                         threshold / 100.0, &result);
+    free(base);
+    free(samples);
+
+    record_baseline(tc, name, &result);
+    if (result.m_regressed)
+        atf_tc_fail("%s regressed: median of %.1f ns per call against "
+                    "%.1f ns in the baseline, slower by more than %ld%% with "
+                    "95%% confidence", name, result.m_median,
+                    result.m_base_median, threshold);
+}
+
+/** Clones a directory tree.
+ *
+ * Regular files are cloned with reflinks if the file system supports them
+ * and copied otherwise, unless hard links are requested.
+ *
+ * \param source Path to the tree to clone.
+ * \param destination Path to the clone, which must not exist.
+ * \param hardlinks Whether to hard-link the files of the source, which
+ *     means that their contents are shared. */
+void
+atf_utils_clone_tree(const char *source, const char *destination,
+                     const bool hardlinks)
+{
+    check_error(atf_tree_clone(source, destination, hardlinks));
+}
+
 /** Compares a file against the given golden contents.
  *
  * \param name Name of the file to be compared.
@@ -222,6 +475,53 @@ atf_utils_create_file(const char *name, const char *contents, ...)
     atf_dynstr_fini(&formatted);
 }
 
+/** Creates a directory tree from a specification.
+ *
+ * \param root Path to the directory that holds the tree.
+ * \param spec Formatting string for the specification of the tree, with
+ *     one file per line.  See atf-c(3) for its syntax. */
+void
+atf_utils_create_tree(const char *root, const char *spec, ...)
+{
+    va_list ap;
+    atf_dynstr_t formatted;
+    atf_error_t error;
+
+    va_start(ap, spec);
+    error = atf_dynstr_init_ap(&formatted, spec, ap);
+    va_end(ap);
+    check_error(error);
+
+    error = atf_tree_create(root, atf_dynstr_cstring(&formatted), 1);
+    atf_dynstr_fini(&formatted);
+    check_error(error);
+}
+
+/** Creates a directory tree from a specification using many processes.
+ *
+ * \param root Path to the directory that holds the tree.
+ * \param jobs Number of processes among which to distribute the files.
+ * \param spec Formatting string for the specification of the tree. */
+void
+atf_utils_create_tree_parallel(const char *root, const unsigned int jobs,
+                               const char *spec, ...)
+{
+    va_list ap;
+    atf_dynstr_t formatted;
+    atf_error_t error;
+
+    ATF_REQUIRE_MSG(jobs > 0, "The number of jobs must be positive");
+
+    va_start(ap, spec);
+    error = atf_dynstr_init_ap(&formatted, spec, ap);
+    va_end(ap);
+    check_error(error);
+
+    error = atf_tree_create(root, atf_dynstr_cstring(&formatted), jobs);
+    atf_dynstr_fini(&formatted);
+    check_error(error);
+}
+
 /** Checks if a file exists.
  *
  * \param path Location of the file to check for.
@@ -358,6 +658,7 @@ atf_utils_readline(const int fd)
 {
     char ch;
     ssize_t cnt;
+    char *line;
     atf_dynstr_t temp;
     atf_error_t error;
 
@@ -366,7 +667,7 @@ atf_utils_readline(const int fd)
 
     while ((cnt = read(fd, &ch, sizeof(ch))) == sizeof(ch) &&
            ch != '\n') {
-        error = atf_dynstr_append_fmt(&temp, "%c", ch);
+        error = atf_dynstr_append_char(&temp, ch);
         ATF_REQUIRE(!atf_is_error(error));
     }
     ATF_REQUIRE(cnt != -1);
@@ -374,8 +675,11 @@ atf_utils_readline(const int fd)
     if (cnt == 0 && atf_dynstr_length(&temp) == 0) {
         atf_dynstr_fini(&temp);
         return NULL;
-    } else
-        return atf_dynstr_fini_disown(&temp);
+    }
+
+    line = atf_dynstr_fini_disown(&temp);
+    ATF_REQUIRE(line != NULL);
+    return line;
 }
 
 /** Redirects a file descriptor to a file.
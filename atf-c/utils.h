@@ -31,11 +31,26 @@
 
 #include <atf-c/defs.h>
 
+typedef void (*atf_utils_fixture_generator_t)(const char *, const char *);
+typedef void (*atf_utils_timed_block_t)(void *);
+
+char *atf_utils_cached_fixture(const char *, const char *,
+                               atf_utils_fixture_generator_t);
+void atf_utils_cached_fixture_clone(const char *, const char *,
+                                    atf_utils_fixture_generator_t,
+                                    const char *);
 void atf_utils_cat_file(const char *, const char *);
+void atf_utils_check_baseline(const char *, atf_utils_timed_block_t, void *);
+void atf_utils_clone_tree(const char *, const char *, const bool);
 bool atf_utils_compare_file(const char *, const char *);
 void atf_utils_copy_file(const char *, const char *);
 void atf_utils_create_file(const char *, const char *, ...)
     ATF_DEFS_ATTRIBUTE_FORMAT_PRINTF(2, 3);
+void atf_utils_create_tree(const char *, const char *, ...)
+    ATF_DEFS_ATTRIBUTE_FORMAT_PRINTF(2, 3);
+void atf_utils_create_tree_parallel(const char *, const unsigned int,
+                                    const char *, ...)
+    ATF_DEFS_ATTRIBUTE_FORMAT_PRINTF(3, 4);
 bool atf_utils_file_exists(const char *);
 pid_t atf_utils_fork(void);
 void atf_utils_free_charpp(char **);
@@ -38,6 +38,7 @@
 #include <atf-c.h>
 
 #include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/env.h"
 #include "atf-c/detail/test_helpers.h"
 
 /** Reads the contents of a file into a buffer.
@@ -64,6 +65,62 @@ read_file(const char *path, void *const buffer, const size_t buflen)
     return length;
 }
 
+/** Generator for fixtures that counts its calls in the work directory. */
+static void
+generate_fixture(const char *dir, const char *inputs)
+{
+    const int fd = open("generations", O_WRONLY | O_CREAT | O_APPEND, 0644);
+    ATF_REQUIRE(fd != -1);
+    ATF_REQUIRE(write(fd, "x", 1) == 1);
+    close(fd);
+
+    atf_utils_create_tree(dir, "sub/file content=%s\n", inputs);
+}
+
+ATF_TC_WITHOUT_HEAD(cached_fixture);
+ATF_TC_BODY(cached_fixture, tc)
+{
+    ATF_REQUIRE(setenv("ATF_CACHE_DIR", "cache", 1) == 0);
+
+    char *path1 = atf_utils_cached_fixture("v1", "foo", generate_fixture);
+    char *path2 = atf_utils_cached_fixture("v1", "foo", generate_fixture);
+    char *path3 = atf_utils_cached_fixture("v1", "bar", generate_fixture);
+    ATF_REQUIRE(atf_utils_compare_file("generations", "xx"));
+
+    ATF_REQUIRE_STREQ(path1, path2);
+    ATF_REQUIRE(strcmp(path1, path3) != 0);
+    ATF_REQUIRE(atf_utils_grep_string("^cache/", path1));
+
+    atf_dynstr_t file;
+    RE(atf_dynstr_init_fmt(&file, "%s/sub/file", path3));
+    ATF_REQUIRE(atf_utils_compare_file(atf_dynstr_cstring(&file), "bar"));
+    atf_dynstr_fini(&file);
+
+    free(path3);
+    free(path2);
+    free(path1);
+}
+
+ATF_TC_WITHOUT_HEAD(cached_fixture_clone);
+ATF_TC_BODY(cached_fixture_clone, tc)
+{
+    ATF_REQUIRE(setenv("ATF_CACHE_DIR", "cache", 1) == 0);
+
+    atf_utils_cached_fixture_clone("v1", "foo", generate_fixture, "copy1");
+    atf_utils_cached_fixture_clone("v1", "foo", generate_fixture, "copy2");
+    ATF_REQUIRE(atf_utils_compare_file("generations", "x"));
+
+    atf_utils_create_file("copy1/sub/file", "modified");
+    ATF_REQUIRE(atf_utils_compare_file("copy2/sub/file", "foo"));
+
+    char *path = atf_utils_cached_fixture("v1", "foo", generate_fixture);
+    atf_dynstr_t file;
+    RE(atf_dynstr_init_fmt(&file, "%s/sub/file", path));
+    ATF_REQUIRE(atf_utils_compare_file(atf_dynstr_cstring(&file), "foo"));
+    atf_dynstr_fini(&file);
+    free(path);
+}
+
 ATF_TC_WITHOUT_HEAD(cat_file__empty);
 ATF_TC_BODY(cat_file__empty, tc)
 {
@@ -120,6 +177,98 @@ ATF_TC_BODY(cat_file__no_newline_eof, tc)
     ATF_REQUIRE_STREQ("PREFIXFoo\nPREFIX bar baz", buffer);
 }
 
+/** Block of code for atf_utils_check_baseline with some work to time. */
+static void
+timed_loop(void *data)
+{
+    unsigned long *sum = data;
+    unsigned long i;
+
+    for (i = 0; i < 100; i++) {
+        *sum += i;
+        ATF_COMPILER_BARRIER();
+    }
+}
+
+ATF_TC_WITHOUT_HEAD(h_check_baseline);
+ATF_TC_BODY(h_check_baseline, tc)
+{
+    unsigned long sum = 0;
+
+    atf_utils_check_baseline("loop", timed_loop, &sum);
+    ATF_DO_NOT_OPTIMIZE(sum);
+}
+
+/** Runs h_check_baseline with a few samples and up to two extra
+ * configuration variables, the first NULL name ending the list. */
+static void
+run_h_check_baseline(const char *name1, const char *value1,
+                     const char *name2, const char *value2)
+{
+    const char *const config[] = { "baseline.samples", "5",
+                                   name1, value1, name2, value2, NULL };
+
+    RE(atf_tc_init_pack(&ATF_TC_NAME(h_check_baseline),
+                        &ATF_TC_PACK_NAME(h_check_baseline), config));
+    run_h_tc(&ATF_TC_NAME(h_check_baseline), "output", "error", "result");
+    atf_tc_fini(&ATF_TC_NAME(h_check_baseline));
+}
+
+ATF_TC_WITHOUT_HEAD(check_baseline__update);
+ATF_TC_BODY(check_baseline__update, tc)
+{
+    run_h_check_baseline("srcdir", ".", "baseline.update", "true");
+    ATF_REQUIRE(atf_utils_compare_file("result", "passed\n"));
+    ATF_REQUIRE(atf_utils_grep_file("^atf-baseline 1$", "loop.baseline"));
+
+    RE(atf_env_set("ATF_RECORDS", "records.json"));
+    run_h_check_baseline("srcdir", ".", "baseline.threshold", "1000");
+    ATF_REQUIRE(atf_utils_compare_file("result", "passed\n"));
+    atf_utils_cat_file("records.json", "");
+    ATF_REQUIRE(atf_utils_grep_file("^\\{\"tc\":\"h_check_baseline\","
+        "\"baseline\":\\{\"name\":\"loop\",\"samples\":5,"
+        "\"baseline_samples\":5,.*\"regressed\":false\\}\\}$",
+        "records.json"));
+}
+
+ATF_TC_WITHOUT_HEAD(check_baseline__regression);
+ATF_TC_BODY(check_baseline__regression, tc)
+{
+    atf_utils_create_file("loop.baseline", "atf-baseline 1\n"
+                          "0.001 0.001 0.001 0.001 0.001\n");
+    run_h_check_baseline("srcdir", ".", NULL, NULL);
+    atf_utils_cat_file("result", "result: ");
+    ATF_REQUIRE(atf_utils_grep_file("^failed: loop regressed: median of "
+        "[0-9.]+ ns per call against 0.0 ns in the baseline, slower by more "
+        "than 5%% with 95%% confidence$", "result"));
+
+    atf_utils_create_file("loop.baseline", "atf-baseline 1\n"
+                          "1e9 1e9 1e9 1e9 1e9\n");
+    run_h_check_baseline("srcdir", ".", NULL, NULL);
+    ATF_REQUIRE(atf_utils_compare_file("result", "passed\n"));
+}
+
+ATF_TC_WITHOUT_HEAD(check_baseline__missing);
+ATF_TC_BODY(check_baseline__missing, tc)
+{
+    run_h_check_baseline("srcdir", ".", NULL, NULL);
+    ATF_REQUIRE(atf_utils_compare_file("result", "failed: Baseline "
+        "./loop.baseline does not exist; run with -v baseline.update=true "
+        "to create it\n"));
+
+    run_h_check_baseline(NULL, NULL, NULL, NULL);
+    ATF_REQUIRE(atf_utils_compare_file("result", "failed: Cannot locate "
+        "baseline loop: srcdir is not set\n"));
+}
+
+ATF_TC_WITHOUT_HEAD(clone_tree);
+ATF_TC_BODY(clone_tree, tc)
+{
+    atf_utils_create_tree("src", "dir/file content=foo\\n");
+    atf_utils_clone_tree("src", "dest", false);
+    ATF_REQUIRE(atf_utils_compare_file("dest/dir/file", "foo\n"));
+}
+
 ATF_TC_WITHOUT_HEAD(compare_file__empty__match);
 ATF_TC_BODY(compare_file__empty__match, tc)
 {
@@ -215,6 +364,27 @@ ATF_TC_BODY(create_file, tc)
     ATF_REQUIRE_STREQ("This is a test with 12345", buffer);
 }
 
+ATF_TC_WITHOUT_HEAD(create_tree);
+ATF_TC_BODY(create_tree, tc)
+{
+    atf_utils_create_tree("root", "dir/\nfile%d content=%s\nlink -> dir\n",
+                          1, "foo");
+
+    struct stat sb;
+    ATF_REQUIRE(lstat("root/dir", &sb) != -1 && S_ISDIR(sb.st_mode));
+    ATF_REQUIRE(lstat("root/link", &sb) != -1 && S_ISLNK(sb.st_mode));
+    ATF_REQUIRE(atf_utils_compare_file("root/file1", "foo"));
+}
+
+ATF_TC_WITHOUT_HEAD(create_tree_parallel);
+ATF_TC_BODY(create_tree_parallel, tc)
+{
+    atf_utils_create_tree_parallel("root", 3, "f{1..10} size=3 pattern=x");
+
+    ATF_REQUIRE(atf_utils_compare_file("root/f1", "xxx"));
+    ATF_REQUIRE(atf_utils_compare_file("root/f10", "xxx"));
+}
+
 ATF_TC_WITHOUT_HEAD(file_exists);
 ATF_TC_BODY(file_exists, tc)
 {
@@ -524,11 +694,20 @@ ATF_TC_BODY(wait__save_stderr, tc)
 
 ATF_TP_ADD_TCS(tp)
 {
+    ATF_TP_ADD_TC(tp, cached_fixture);
+    ATF_TP_ADD_TC(tp, cached_fixture_clone);
+
     ATF_TP_ADD_TC(tp, cat_file__empty);
     ATF_TP_ADD_TC(tp, cat_file__one_line);
     ATF_TP_ADD_TC(tp, cat_file__several_lines);
     ATF_TP_ADD_TC(tp, cat_file__no_newline_eof);
 
+    ATF_TP_ADD_TC(tp, check_baseline__update);
+    ATF_TP_ADD_TC(tp, check_baseline__regression);
+    ATF_TP_ADD_TC(tp, check_baseline__missing);
+
+    ATF_TP_ADD_TC(tp, clone_tree);
+
     ATF_TP_ADD_TC(tp, compare_file__empty__match);
     ATF_TP_ADD_TC(tp, compare_file__empty__not_match);
     ATF_TP_ADD_TC(tp, compare_file__short__match);
@@ -540,6 +719,8 @@ ATF_TP_ADD_TCS(tp)
     ATF_TP_ADD_TC(tp, copy_file__some_contents);
 
     ATF_TP_ADD_TC(tp, create_file);
+    ATF_TP_ADD_TC(tp, create_tree);
+    ATF_TP_ADD_TC(tp, create_tree_parallel);
 
     ATF_TP_ADD_TC(tp, file_exists);
 
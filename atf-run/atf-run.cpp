@@ -0,0 +1,938 @@
+// Copyright (c) 2026 The NetBSD Foundation, Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+// CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+// IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+}
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+extern "C" {
+#include "atf-c/defs.h"
+}
+
+#include "atf-c++/detail/application.hpp"
+#include "atf-c++/detail/env.hpp"
+#include "atf-c++/detail/exceptions.hpp"
+#include "atf-c++/detail/fs.hpp"
+#include "atf-c++/detail/sanity.hpp"
+#include "atf-c++/detail/text.hpp"
+
+#include "atf-run/kyuafile.hpp"
+#include "atf-run/test_program.hpp"
+
+using atf::atf_run::test_case;
+using atf::atf_run::test_result;
+using atf::atf_run::vars_map;
+
+// ------------------------------------------------------------------------
+// Auxiliary functions.
+// ------------------------------------------------------------------------
+
+namespace {
+
+//! Time limit for a test program to print its list of test cases.
+static const unsigned int list_timeout = 300;
+
+//! Number of trailing lines of output kept in the report for each stream
+//! of a failed test case.
+static const std::size_t report_lines = 20;
+
+//! Pipe written to by the signal handlers to wake up the main loop.
+static int wakeup_pipe[2] = { -1, -1 };
+
+//! Set to the signal that asked the runner to terminate, if any.
+static volatile sig_atomic_t interrupted = 0;
+
+static
+void
+wakeup(void)
+{
+    const int old_errno = errno;
+    if (::write(wakeup_pipe[1], "", 1) == -1) {
+        // Either the pipe is full, and thus a wakeup is already pending,
+        // or there is nothing sensible to do from a signal handler.
+    }
+    errno = old_errno;
+}
+
+static
+void
+sigchld_handler(const int signo ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+    wakeup();
+}
+
+static
+void
+interrupt_handler(const int signo)
+{
+    interrupted = signo;
+    wakeup();
+}
+
+static
+double
+now(void)
+{
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static
+std::vector< std::string >
+tail_lines(const atf::fs::path& file, const std::size_t count)
+{
+    std::deque< std::string > lines;
+    std::ifstream is(file.c_str());
+    std::string line;
+    while (std::getline(is, line)) {
+        lines.push_back(line);
+        if (lines.size() > count)
+            lines.pop_front();
+    }
+    return std::vector< std::string >(lines.begin(), lines.end());
+}
+
+// ------------------------------------------------------------------------
+// The "job" class.
+// ------------------------------------------------------------------------
+
+//!
+//! \brief A process run by the scheduler on behalf of a test program.
+//!
+//! Listing the test cases of a program is a job on its own; running a
+//! test case is a job that goes through its body and, if any, its
+//! cleanup, both in the same work directory.
+//!
+struct job {
+    enum phase_type { LIST, BODY, CLEANUP };
+
+    phase_type phase;
+    std::string name;
+    atf::fs::path program;
+    test_case tc;
+    atf::fs::path dir;
+
+    pid_t pid;
+    double start;
+    double deadline;
+    bool timed_out;
+    test_result result;
+
+    job(const phase_type p_phase, const std::string& p_name,
+        const atf::fs::path& p_program, const test_case& p_tc,
+        const atf::fs::path& p_dir) :
+        phase(p_phase),
+        name(p_name),
+        program(p_program),
+        tc(p_tc),
+        dir(p_dir),
+        pid(-1),
+        start(0.0),
+        deadline(0.0),
+        timed_out(false),
+        result(test_result::BROKEN, "Not run")
+    {
+    }
+
+    std::string
+    full_name(void)
+        const
+    {
+        return name + ":" + tc.ident;
+    }
+
+    atf::fs::path
+    work_dir(void)
+        const
+    {
+        return dir / "work";
+    }
+};
+
+// ------------------------------------------------------------------------
+// The "record" class.
+// ------------------------------------------------------------------------
+
+struct record {
+    std::string name;
+    test_result result;
+    double duration;
+    std::vector< std::string > output;
+
+    record(const std::string& p_name, const test_result& p_result,
+           const double p_duration) :
+        name(p_name),
+        result(p_result),
+        duration(p_duration)
+    {
+    }
+
+    bool
+    operator<(const record& r)
+        const
+    {
+        return name < r.name;
+    }
+};
+
+// ------------------------------------------------------------------------
+// The "scheduler" class.
+// ------------------------------------------------------------------------
+
+//!
+//! \brief Runs the test cases of several test programs in parallel.
+//!
+//! Every test case runs in a private work directory, which is also its
+//! home and temporary directory, in a process group of its own so that
+//! the processes that it leaves behind or that are still alive when it
+//! times out can be killed together.  Test cases marked as exclusive run
+//! after all the others, one at a time.
+//!
+class scheduler {
+    const atf::fs::path m_root;
+    const unsigned int m_jobs;
+    const vars_map& m_config;
+    const std::vector< std::string >& m_list_args;
+    const std::map< std::string, std::vector< std::string > >& m_filters;
+    atf::fs::path m_workdir;
+    unsigned long m_last_id;
+
+    std::deque< job* > m_pending;
+    std::deque< job* > m_exclusive;
+    std::map< pid_t, job* > m_running;
+    bool m_exclusive_running;
+
+    std::vector< record > m_records;
+
+    atf::fs::path
+    new_job_dir(void)
+    {
+        const atf::fs::path dir = m_workdir /
+            atf::text::to_string(++m_last_id);
+        if (::mkdir(dir.c_str(), 0755) == -1)
+            throw atf::system_error("atf-run", "Cannot create " + dir.str(),
+                                    errno);
+        return dir;
+    }
+
+    std::vector< std::string >
+    program_args(const job& j, const std::string& target)
+        const
+    {
+        std::vector< std::string > args;
+        args.push_back(j.program.str());
+        if (j.phase == job::BODY)
+            args.push_back("-r" + (j.dir / "result").str());
+        args.push_back("-s" + j.program.branch_path().str());
+        for (vars_map::const_iterator iter = m_config.begin();
+             iter != m_config.end(); iter++)
+            args.push_back("-v" + (*iter).first + "=" + (*iter).second);
+        args.push_back(target);
+        return args;
+    }
+
+    static
+    void
+    exec_child(const atf::fs::path& cwd, const atf::fs::path& dir,
+               const std::vector< std::string >& args)
+    {
+        struct sigaction sa;
+        std::memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = SIG_DFL;
+        ::sigaction(SIGCHLD, &sa, NULL);
+        ::sigaction(SIGHUP, &sa, NULL);
+        ::sigaction(SIGINT, &sa, NULL);
+        ::sigaction(SIGTERM, &sa, NULL);
+
+        if (::setpgid(0, 0) == -1 || ::chdir(cwd.c_str()) == -1)
+            std::_Exit(EXIT_FAILURE);
+
+        const int in = ::open("/dev/null", O_RDONLY);
+        const int out = ::open((dir / "stdout").c_str(),
+                               O_WRONLY | O_CREAT | O_APPEND, 0644);
+        const int err = ::open((dir / "stderr").c_str(),
+                               O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (in == -1 || out == -1 || err == -1 ||
+            ::dup2(in, STDIN_FILENO) == -1 ||
+            ::dup2(out, STDOUT_FILENO) == -1 ||
+            ::dup2(err, STDERR_FILENO) == -1)
+            std::_Exit(EXIT_FAILURE);
+
+        ::setenv("HOME", cwd.c_str(), 1);
+        ::setenv("TMPDIR", cwd.c_str(), 1);
+        ::setenv("TZ", "UTC", 1);
+        ::setenv("__RUNNING_INSIDE_ATF_RUN", "internal-yes-value", 1);
+        static const char* const locale_vars[] = { "LANG", "LC_ALL",
+            "LC_COLLATE", "LC_CTYPE", "LC_MESSAGES", "LC_MONETARY",
+            "LC_NUMERIC", "LC_TIME", NULL };
+        for (const char* const* var = locale_vars; *var != NULL; var++)
+            ::unsetenv(*var);
+
+        std::vector< char* > argv;
+        for (std::vector< std::string >::const_iterator iter = args.begin();
+             iter != args.end(); iter++)
+            argv.push_back(const_cast< char* >((*iter).c_str()));
+        argv.push_back(NULL);
+        ::execv(argv[0], &argv[0]);
+
+        std::cerr << "Failed to execute " << args[0] << ": "
+                  << std::strerror(errno) << "\n";
+        std::_Exit(EXIT_FAILURE);
+    }
+
+    void
+    spawn(job& j, const atf::fs::path& cwd,
+          const std::vector< std::string >& args, const unsigned int timeout)
+    {
+        std::cout.flush();
+        std::cerr.flush();
+
+        const pid_t pid = ::fork();
+        if (pid == -1)
+            throw atf::system_error("atf-run", "Cannot fork", errno);
+        else if (pid == 0)
+            exec_child(cwd, j.dir, args);
+
+        (void)::setpgid(pid, pid);
+        j.pid = pid;
+        j.timed_out = false;
+        const double start = now();
+        if (j.phase != job::CLEANUP)
+            j.start = start;
+        j.deadline = timeout == 0 ? 0.0 : start + timeout;
+        m_running[pid] = &j;
+    }
+
+    void
+    start(job& j)
+    {
+        switch (j.phase) {
+        case job::LIST: {
+            std::vector< std::string > args;
+            args.push_back(j.program.str());
+            args.push_back("-l");
+            args.insert(args.end(), m_list_args.begin(), m_list_args.end());
+            spawn(j, j.dir, args, list_timeout);
+            break;
+        }
+
+        case job::BODY:
+            if (::mkdir(j.work_dir().c_str(), 0755) == -1)
+                throw atf::system_error("atf-run", "Cannot create " +
+                                        j.work_dir().str(), errno);
+            spawn(j, j.work_dir(), program_args(j, j.tc.ident),
+                  j.tc.timeout());
+            break;
+
+        default:
+            UNREACHABLE;
+        }
+    }
+
+    void
+    start_jobs(void)
+    {
+        while (m_running.size() < m_jobs && !m_exclusive_running &&
+               interrupted == 0) {
+            if (!m_pending.empty()) {
+                job* j = m_pending.front();
+                m_pending.pop_front();
+                start(*j);
+            } else if (!m_exclusive.empty() && m_running.empty()) {
+                job* j = m_exclusive.front();
+                m_exclusive.pop_front();
+                m_exclusive_running = true;
+                start(*j);
+            } else
+                break;
+        }
+    }
+
+    void
+    add_record(const job& j, const std::string& name,
+               const test_result& result)
+    {
+        record r(name, result, now() - j.start);
+        if (!result.good()) {
+            static const char* const streams[] = { "stdout", "stderr",
+                                                   NULL };
+            for (const char* const* stream = streams; *stream != NULL;
+                 stream++) {
+                const std::vector< std::string > lines =
+                    tail_lines(j.dir / *stream, report_lines);
+                for (std::vector< std::string >::const_iterator iter =
+                     lines.begin(); iter != lines.end(); iter++)
+                    r.output.push_back(std::string(*stream) + ": " + *iter);
+            }
+        }
+        m_records.push_back(r);
+
+        std::cout << name << "  ->  " << result.state_name();
+        if (!result.reason.empty())
+            std::cout << ": " << result.reason;
+        std::cout << "  [" << std::fixed << std::setprecision(3)
+                  << r.duration << "s]\n";
+        std::cout.flush();
+    }
+
+    void
+    finish(job* j)
+    {
+        if (j->phase != job::LIST)
+            add_record(*j, j->full_name(), j->result);
+        if (j->tc.is_exclusive())
+            m_exclusive_running = false;
+
+        atf::fs::rmtree(j->dir);
+        delete j;
+    }
+
+    bool
+    selected(const std::string& name, const std::string& ident)
+        const
+    {
+        if (m_filters.empty())
+            return true;
+        const std::map< std::string, std::vector< std::string > >::
+            const_iterator iter = m_filters.find(name);
+        if (iter == m_filters.end())
+            return false;
+        const std::vector< std::string >& idents = (*iter).second;
+        if (idents.empty())
+            return true;
+        for (std::vector< std::string >::const_iterator iter2 =
+             idents.begin(); iter2 != idents.end(); iter2++)
+            if (*iter2 == ident)
+                return true;
+        return false;
+    }
+
+    void
+    listed(job* j, const int status)
+    {
+        std::vector< test_case > tcs;
+        std::string error;
+
+        if (j->timed_out)
+            error = "Test program timed out while listing its test cases";
+        else if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+            error = "Test program did not exit cleanly while listing its "
+                "test cases";
+        else {
+            std::ifstream is((j->dir / "stdout").c_str());
+            try {
+                tcs = atf::atf_run::parse_test_case_list(is);
+            } catch (const std::runtime_error& e) {
+                error = std::string("Invalid test case list: ") + e.what();
+            }
+            // The shard of a test program may legitimately be empty.
+            if (error.empty() && tcs.empty() && m_list_args.empty())
+                error = "Test program has no test cases";
+        }
+
+        if (!error.empty()) {
+            add_record(*j, j->name + ":__test_cases_list__",
+                       test_result(test_result::BROKEN, error));
+            finish(j);
+            return;
+        }
+
+        for (std::vector< test_case >::const_iterator iter = tcs.begin();
+             iter != tcs.end(); iter++) {
+            if (!selected(j->name, (*iter).ident))
+                continue;
+
+            job* tcj = new job(job::BODY, j->name, j->program, *iter,
+                               new_job_dir());
+            const std::string reason =
+                atf::atf_run::check_requirements((*iter).md, m_config);
+            if (!reason.empty()) {
+                tcj->start = now();
+                tcj->result = test_result(test_result::SKIPPED, reason);
+                finish(tcj);
+            } else if ((*iter).is_exclusive())
+                m_exclusive.push_back(tcj);
+            else
+                m_pending.push_back(tcj);
+        }
+        finish(j);
+    }
+
+    void
+    body_done(job* j, const int status)
+    {
+        // Get rid of any processes that the body left behind.
+        (void)::kill(-j->pid, SIGKILL);
+
+        const atf::fs::path resfile = j->dir / "result";
+        std::ifstream is(resfile.c_str());
+        j->result = atf::atf_run::calculate_result(is ? &is : NULL, status,
+                                                   j->timed_out);
+        if (!j->tc.has_cleanup()) {
+            finish(j);
+            return;
+        }
+
+        j->phase = job::CLEANUP;
+        spawn(*j, j->work_dir(), program_args(*j, j->tc.ident + ":cleanup"),
+              j->tc.timeout());
+    }
+
+    void
+    cleanup_done(job* j, const int status)
+    {
+        (void)::kill(-j->pid, SIGKILL);
+        j->result = atf::atf_run::calculate_cleanup_result(j->result, status,
+                                                           j->timed_out);
+        finish(j);
+    }
+
+    void
+    reap(void)
+    {
+        int status;
+        pid_t pid;
+        while ((pid = ::waitpid(-1, &status, WNOHANG)) > 0) {
+            const std::map< pid_t, job* >::iterator iter =
+                m_running.find(pid);
+            if (iter == m_running.end())
+                continue;
+            job* j = (*iter).second;
+            m_running.erase(iter);
+
+            switch (j->phase) {
+            case job::LIST: listed(j, status); break;
+            case job::BODY: body_done(j, status); break;
+            case job::CLEANUP: cleanup_done(j, status); break;
+            }
+        }
+    }
+
+    int
+    poll_timeout(void)
+    {
+        const double current = now();
+        double timeout = -1.0;
+
+        for (std::map< pid_t, job* >::iterator iter = m_running.begin();
+             iter != m_running.end(); iter++) {
+            job* j = (*iter).second;
+            if (j->deadline == 0.0 || j->timed_out)
+                continue;
+            if (j->deadline <= current) {
+                j->timed_out = true;
+                (void)::kill(-j->pid, SIGKILL);
+            } else if (timeout < 0.0 || j->deadline - current < timeout)
+                timeout = j->deadline - current;
+        }
+
+        return timeout < 0.0 ? -1 : static_cast< int >(timeout * 1000) + 1;
+    }
+
+    void
+    abort_all(void)
+    {
+        for (std::map< pid_t, job* >::iterator iter = m_running.begin();
+             iter != m_running.end(); iter++) {
+            (void)::kill(-(*iter).first, SIGKILL);
+            int status;
+            (void)::waitpid((*iter).first, &status, 0);
+            delete (*iter).second;
+        }
+        m_running.clear();
+
+        std::deque< job* >* queues[] = { &m_pending, &m_exclusive, NULL };
+        for (std::deque< job* >** queue = queues; *queue != NULL; queue++) {
+            for (std::deque< job* >::iterator iter = (*queue)->begin();
+                 iter != (*queue)->end(); iter++)
+                delete *iter;
+            (*queue)->clear();
+        }
+    }
+
+public:
+    scheduler(const atf::fs::path& root, const unsigned int jobs,
+              const vars_map& config,
+              const std::vector< std::string >& list_args,
+              const std::map< std::string, std::vector< std::string > >&
+                  filters,
+              const atf::fs::path& workdir_parent) :
+        m_root(root),
+        m_jobs(jobs),
+        m_config(config),
+        m_list_args(list_args),
+        m_filters(filters),
+        m_workdir("."),
+        m_last_id(0),
+        m_exclusive_running(false)
+    {
+        std::string templ = (workdir_parent / "atf-run.XXXXXX").str();
+        std::vector< char > buf(templ.begin(), templ.end());
+        buf.push_back('\0');
+        if (::mkdtemp(&buf[0]) == NULL)
+            throw atf::system_error("atf-run", "Cannot create a work "
+                                    "directory in " + workdir_parent.str(),
+                                    errno);
+        m_workdir = atf::fs::path(&buf[0]);
+    }
+
+    ~scheduler(void)
+    {
+        abort_all();
+        try {
+            atf::fs::rmtree(m_workdir);
+        } catch (const std::exception&) {
+        }
+    }
+
+    void
+    add_program(const std::string& name)
+    {
+        atf::fs::path program = m_root / name;
+        if (!program.is_absolute())
+            program = program.to_absolute();
+        m_pending.push_back(new job(job::LIST, name, program, test_case(""),
+                                    new_job_dir()));
+    }
+
+    void
+    run(void)
+    {
+        start_jobs();
+        while (!m_running.empty()) {
+            struct pollfd pfd;
+            pfd.fd = wakeup_pipe[0];
+            pfd.events = POLLIN;
+            if (::poll(&pfd, 1, poll_timeout()) == -1 && errno != EINTR)
+                throw atf::system_error("atf-run", "poll failed", errno);
+
+            char buf[64];
+            while (::read(wakeup_pipe[0], buf, sizeof(buf)) > 0)
+                continue;
+
+            if (interrupted != 0) {
+                abort_all();
+                throw std::runtime_error("Interrupted by signal " +
+                                         atf::text::to_string(interrupted));
+            }
+
+            reap();
+            start_jobs();
+        }
+        INV(m_pending.empty() && m_exclusive.empty());
+    }
+
+    const std::vector< record >&
+    records(void)
+        const
+    {
+        return m_records;
+    }
+};
+
+static
+void
+install_handlers(void)
+{
+    if (::pipe(wakeup_pipe) == -1)
+        throw atf::system_error("atf-run", "Cannot create pipe", errno);
+    for (int i = 0; i < 2; i++) {
+        ::fcntl(wakeup_pipe[i], F_SETFD, FD_CLOEXEC);
+        ::fcntl(wakeup_pipe[i], F_SETFL,
+                ::fcntl(wakeup_pipe[i], F_GETFL) | O_NONBLOCK);
+    }
+
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sa.sa_handler = sigchld_handler;
+    ::sigaction(SIGCHLD, &sa, NULL);
+
+    sa.sa_flags = SA_RESTART;
+    sa.sa_handler = interrupt_handler;
+    ::sigaction(SIGHUP, &sa, NULL);
+    ::sigaction(SIGINT, &sa, NULL);
+    ::sigaction(SIGTERM, &sa, NULL);
+}
+
+} // anonymous namespace
+
+// ------------------------------------------------------------------------
+// The "atf_run" class.
+// ------------------------------------------------------------------------
+
+class atf_run : public atf::application::app {
+    static const char* m_description;
+
+    unsigned int m_jobs;
+    atf::fs::path m_kyuafile;
+    std::string m_report;
+    atf::fs::path m_workdir;
+    vars_map m_config;
+    std::vector< std::string > m_list_args;
+    std::string m_shard;
+    std::string m_durations;
+
+    std::string specific_args(void) const;
+    options_set specific_options(void) const;
+    void process_option(int, const char*);
+
+    void write_report(const std::vector< record >&, const std::string&) const;
+
+public:
+    atf_run(void);
+
+    int main(void);
+};
+
+const char* atf_run::m_description =
+    "atf-run runs the test programs listed in a Kyuafile and in those that "
+    "it includes, spreading their test cases over several processes.";
+
+atf_run::atf_run(void) :
+    app(m_description, "atf-run(1)"),
+    m_jobs(1),
+    m_kyuafile("Kyuafile"),
+    m_workdir(atf::env::get("TMPDIR", "/tmp"))
+{
+    const long cpus = ::sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 1)
+        m_jobs = static_cast< unsigned int >(cpus);
+}
+
+std::string
+atf_run::specific_args(void)
+    const
+{
+    return "[test_program[:test_case] ...]";
+}
+
+atf_run::options_set
+atf_run::specific_options(void)
+    const
+{
+    using atf::application::option;
+    options_set opts;
+    opts.insert(option('D', "durations", "File with the durations of the "
+                       "test cases to balance the shards"));
+    opts.insert(option('j', "jobs", "Number of test cases to run in "
+                       "parallel; default: number of CPUs"));
+    opts.insert(option('k', "kyuafile", "Kyuafile to load; default: "
+                       "Kyuafile"));
+    opts.insert(option('r', "report", "File to write the summary report "
+                       "to"));
+    opts.insert(option('S', "index/count", "Runs only the given shard of "
+                       "the test cases"));
+    opts.insert(option('v', "var=value", "Sets the configuration variable "
+                       "`var' to `value'"));
+    opts.insert(option('w', "directory", "Directory in which to create the "
+                       "work directories; default: TMPDIR or /tmp"));
+    return opts;
+}
+
+void
+atf_run::process_option(int ch, const char* arg)
+{
+    switch (ch) {
+    case 'D':
+        m_durations = arg;
+        break;
+
+    case 'j':
+        try {
+            m_jobs = atf::text::to_type< unsigned int >(arg);
+        } catch (const std::runtime_error&) {
+            m_jobs = 0;
+        }
+        if (m_jobs == 0)
+            throw atf::application::usage_error("Invalid number of jobs "
+                                                "'%s'", arg);
+        break;
+
+    case 'k':
+        m_kyuafile = atf::fs::path(arg);
+        break;
+
+    case 'r':
+        m_report = arg;
+        break;
+
+    case 'S': {
+        const std::string str(arg);
+        const std::string::size_type pos = str.find('/');
+        if (pos == std::string::npos || pos == 0 ||
+            pos == str.length() - 1 ||
+            str.find_first_not_of("0123456789/") != std::string::npos ||
+            str.find('/', pos + 1) != std::string::npos)
+            throw atf::application::usage_error("Invalid shard "
+                                                "specification '%s'", arg);
+        m_shard = str;
+        break;
+    }
+
+    case 'v': {
+        const std::string str(arg);
+        const std::string::size_type pos = str.find('=');
+        if (pos == std::string::npos || pos == 0)
+            throw atf::application::usage_error("Invalid variable "
+                                                "definition '%s'", arg);
+        m_config[str.substr(0, pos)] = str.substr(pos + 1);
+        break;
+    }
+
+    case 'w':
+        m_workdir = atf::fs::path(arg);
+        break;
+
+    default:
+        UNREACHABLE;
+    }
+}
+
+void
+atf_run::write_report(const std::vector< record >& records,
+                      const std::string& summary)
+    const
+{
+    std::ofstream os(m_report.c_str());
+    if (!os)
+        throw std::runtime_error("Cannot create report " + m_report);
+
+    std::vector< record > sorted(records);
+    std::sort(sorted.begin(), sorted.end());
+    for (std::vector< record >::const_iterator iter = sorted.begin();
+         iter != sorted.end(); iter++) {
+        const record& r = *iter;
+        os << r.result.state_name() << " " << r.name << " " << std::fixed
+           << std::setprecision(3) << r.duration << "s";
+        if (!r.result.reason.empty())
+            os << ": " << r.result.reason;
+        os << "\n";
+        for (std::vector< std::string >::const_iterator iter2 =
+             r.output.begin(); iter2 != r.output.end(); iter2++)
+            os << "    " << *iter2 << "\n";
+    }
+    os << summary << "\n";
+    if (!os)
+        throw std::runtime_error("Failed to write report " + m_report);
+}
+
+int
+atf_run::main(void)
+{
+    if (!m_durations.empty() && m_shard.empty())
+        throw atf::application::usage_error("-D requires -S");
+    if (!m_shard.empty()) {
+        m_list_args.push_back("-S" + m_shard);
+        if (!m_durations.empty()) {
+            atf::fs::path durations(m_durations);
+            if (!durations.is_absolute())
+                durations = durations.to_absolute();
+            m_list_args.push_back("-D" + durations.str());
+        }
+    }
+
+    const std::vector< std::string > programs =
+        atf::atf_run::load_kyuafile(m_kyuafile);
+
+    std::map< std::string, std::vector< std::string > > filters;
+    for (int i = 0; i < m_argc; i++) {
+        const std::string arg(m_argv[i]);
+        const std::string::size_type pos = arg.find(':');
+        const std::string name = arg.substr(0, pos);
+        if (std::find(programs.begin(), programs.end(), name) ==
+            programs.end())
+            throw atf::application::usage_error("Unknown test program "
+                                                "'%s'", name.c_str());
+        std::vector< std::string >& idents = filters[name];
+        if (pos != std::string::npos)
+            idents.push_back(arg.substr(pos + 1));
+        else
+            idents.clear();
+    }
+
+    install_handlers();
+
+    const double start = now();
+    scheduler sched(m_kyuafile.branch_path(), m_jobs, m_config, m_list_args,
+                    filters, m_workdir);
+    for (std::vector< std::string >::const_iterator iter = programs.begin();
+         iter != programs.end(); iter++)
+        if (filters.empty() || filters.find(*iter) != filters.end())
+            sched.add_program(*iter);
+    sched.run();
+
+    std::map< test_result::state_type, std::size_t > counts;
+    const std::vector< record >& records = sched.records();
+    for (std::vector< record >::const_iterator iter = records.begin();
+         iter != records.end(); iter++)
+        counts[(*iter).result.state]++;
+
+    std::ostringstream summary;
+    summary << records.size() << " test cases: "
+            << counts[test_result::PASSED] << " passed, "
+            << counts[test_result::FAILED] << " failed, "
+            << counts[test_result::BROKEN] << " broken, "
+            << counts[test_result::SKIPPED] << " skipped, "
+            << counts[test_result::EXPECTED_FAILURE]
+            << " expected failures in " << std::fixed
+            << std::setprecision(3) << now() - start << "s";
+    std::cout << "\n" << summary.str() << "\n";
+
+    if (!m_report.empty())
+        write_report(records, summary.str());
+
+    return counts[test_result::FAILED] + counts[test_result::BROKEN] == 0 ?
+        EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int
+main(int argc, char* const* argv)
+{
+    return atf_run().run(argc, argv);
+}
@@ -0,0 +1,487 @@
+# Copyright (c) 2026 The NetBSD Foundation, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+# CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+# INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+# IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+# DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+# GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+# IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+# IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+: ${ATF_RUN:="__ATF_RUN__"}
+: ${ATF_SH:="__ATF_SH__"}
+
+# Creates an atf-sh test program from the test cases given in stdin.
+create_test_program() {
+    local output="${1}"; shift
+    echo "#! ${ATF_SH}" >"${output}"
+    cat >>"${output}"
+    chmod +x "${output}"
+}
+
+# Creates a test program with one test case for each basic result.
+create_results_program() {
+    create_test_program "${1}" <<EOF
+atf_test_case pass
+pass_body() { echo "some output"; }
+atf_test_case fail
+fail_body() { echo "failing output"; atf_fail "On purpose"; }
+atf_test_case skip
+skip_body() { atf_skip "Not today"; }
+atf_test_case xfail
+xfail_body() { atf_expect_fail "Known bug"; atf_fail "Bug"; }
+atf_init_test_cases() {
+    atf_add_test_case pass
+    atf_add_test_case fail
+    atf_add_test_case skip
+    atf_add_test_case xfail
+}
+EOF
+}
+
+atf_test_case results
+results_head()
+{
+    atf_set "descr" "Verifies that the results of the test cases are" \
+        "reported and summarized"
+}
+results_body()
+{
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+atf_test_program{name="tp"}
+EOF
+    create_results_program tp
+
+    atf_check -s eq:1 -o save:stdout -e empty "${ATF_RUN}" -j 2
+    atf_check -o match:"^tp:pass  ->  passed  \[" cat stdout
+    atf_check -o match:"^tp:fail  ->  failed: On purpose  \[" cat stdout
+    atf_check -o match:"^tp:skip  ->  skipped: Not today  \[" cat stdout
+    atf_check -o match:"^tp:xfail  ->  expected_failure: Known bug" cat stdout
+    atf_check -o match:"^4 test cases: 1 passed, 1 failed, 0 broken, 1 \
+skipped, 1 expected failures in" cat stdout
+}
+
+atf_test_case report
+report_head()
+{
+    atf_set "descr" "Verifies the contents of the report file"
+}
+report_body()
+{
+    cat >Kyuafile <<EOF
+syntax(2)
+atf_test_program{name="tp"}
+EOF
+    create_results_program tp
+
+    atf_check -s eq:1 -o ignore -e empty "${ATF_RUN}" -r report
+    atf_check -o save:states sed -n -e 's,^\([a-z_][a-z_]*\) \([^ ]*\) .*,\1 \2,p' \
+        report
+    cat >expout <<EOF
+failed tp:fail
+passed tp:pass
+skipped tp:skip
+expected_failure tp:xfail
+EOF
+    atf_check -o file:expout cat states
+    atf_check -o match:"^    stdout: failing output$" cat report
+    atf_check -o not-match:"some output" cat report
+    atf_check -o match:"^4 test cases:" tail -n 1 report
+}
+
+atf_test_case all_passed
+all_passed_head()
+{
+    atf_set "descr" "Verifies that the exit status is 0 when no test case" \
+        "fails"
+}
+all_passed_body()
+{
+    cat >Kyuafile <<EOF
+syntax(2)
+atf_test_program{name="tp"}
+EOF
+    create_test_program tp <<EOF
+atf_test_case a
+a_body() { :; }
+atf_test_case b
+b_body() { atf_skip "Skipped"; }
+atf_init_test_cases() { atf_add_test_case a; atf_add_test_case b; }
+EOF
+
+    atf_check -s eq:0 -o match:"2 test cases: 1 passed" -e empty "${ATF_RUN}"
+}
+
+atf_test_case include_and_filters
+include_and_filters_head()
+{
+    atf_set "descr" "Verifies that included Kyuafiles are loaded and that" \
+        "the test programs and test cases to run can be selected"
+}
+include_and_filters_body()
+{
+    mkdir root root/sub
+    cat >root/Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+include("sub/Kyuafile")
+EOF
+    cat >root/sub/Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+atf_test_program{name="tp1"}
+atf_test_program{name="tp2"}
+EOF
+    create_results_program root/sub/tp1
+    create_results_program root/sub/tp2
+
+    atf_check -s eq:1 -o match:"^8 test cases:" -e empty \
+        "${ATF_RUN}" -k root/Kyuafile
+    atf_check -s eq:1 -o match:"^8 test cases:" -e empty \
+        "${ATF_RUN}" -k "$(pwd)/root/Kyuafile"
+
+    atf_check -s eq:0 -o save:stdout -e empty \
+        "${ATF_RUN}" -k root/Kyuafile sub/tp1:pass sub/tp2:skip
+    atf_check -o match:"^sub/tp1:pass  ->  passed" cat stdout
+    atf_check -o match:"^sub/tp2:skip  ->  skipped" cat stdout
+    atf_check -o match:"^2 test cases:" cat stdout
+
+    atf_check -s eq:1 -o match:"^4 test cases:" -e empty \
+        "${ATF_RUN}" -k root/Kyuafile sub/tp2
+
+    atf_check -s eq:1 -o empty \
+        -e match:"atf-run: ERROR: Unknown test program 'sub/tp3'" \
+        "${ATF_RUN}" -k root/Kyuafile sub/tp3
+}
+
+atf_test_case kyuafile_errors
+kyuafile_errors_head()
+{
+    atf_set "descr" "Verifies that invalid Kyuafiles are reported"
+}
+kyuafile_errors_body()
+{
+    atf_check -s eq:1 -o empty -e match:"atf-run: ERROR: Cannot open" \
+        "${ATF_RUN}"
+
+    cat >Kyuafile <<EOF
+syntax(2)
+plain_test_program{name="tp"}
+EOF
+    atf_check -s eq:1 -o empty \
+        -e match:"atf-run: ERROR: .*Kyuafile:2: Unsupported test program" \
+        "${ATF_RUN}"
+}
+
+atf_test_case broken_program
+broken_program_head()
+{
+    atf_set "descr" "Verifies that test programs that cannot list their" \
+        "test cases are reported as broken"
+}
+broken_program_body()
+{
+    cat >Kyuafile <<EOF
+syntax(2)
+atf_test_program{name="tp"}
+EOF
+    printf '#! /bin/sh\necho garbage\n' >tp
+    chmod +x tp
+
+    atf_check -s eq:1 -o match:"^tp:__test_cases_list__  ->  broken: \
+Invalid test case list" -e empty "${ATF_RUN}"
+}
+
+atf_test_case isolation
+isolation_head()
+{
+    atf_set "descr" "Verifies that each test case runs in a private work" \
+        "directory that is also its home and temporary directory"
+}
+isolation_body()
+{
+    cat >Kyuafile <<EOF
+syntax(2)
+atf_test_program{name="tp"}
+EOF
+    create_test_program tp <<EOF
+atf_test_case check
+check_body() {
+    test "\${HOME}" = "\$(pwd)" || atf_fail "HOME is \${HOME}"
+    test "\${TMPDIR}" = "\$(pwd)" || atf_fail "TMPDIR is \${TMPDIR}"
+    test -z "\$(ls)" || atf_fail "Work directory not empty"
+    touch leftover
+    pwd >>"\$(atf_config_get dirs)"
+}
+atf_init_test_cases() {
+    for i in 1 2 3 4; do
+        eval "atf_test_case check\${i}; check\${i}_body() { check_body; }"
+        atf_add_test_case check\${i}
+    done
+}
+EOF
+
+    mkdir work
+    atf_check -s eq:0 -o match:"^4 test cases: 4 passed" -e empty \
+        "${ATF_RUN}" -j 2 -w "$(pwd)/work" -v dirs="$(pwd)/dirs"
+    atf_check -o inline:"4\n" -x "sort -u dirs | wc -l | tr -d ' '"
+    atf_check -o empty ls work
+}
+
+atf_test_case parallel
+parallel_head()
+{
+    atf_set "descr" "Verifies that test cases run concurrently"
+}
+parallel_body()
+{
+    cat >Kyuafile <<EOF
+syntax(2)
+atf_test_program{name="tp"}
+EOF
+    create_test_program tp <<EOF
+wait_for() {
+    local dir="\$(atf_config_get dir)"
+    touch "\${dir}/\${1}"
+    while [ ! -f "\${dir}/\${2}" ]; do sleep 0.1; done
+}
+atf_test_case a
+a_head() { atf_set "timeout" "10"; }
+a_body() { wait_for a b; }
+atf_test_case b
+b_head() { atf_set "timeout" "10"; }
+b_body() { wait_for b a; }
+atf_init_test_cases() { atf_add_test_case a; atf_add_test_case b; }
+EOF
+
+    atf_check -s eq:0 -o match:"^2 test cases: 2 passed" -e empty \
+        "${ATF_RUN}" -j 2 -v dir="$(pwd)"
+}
+
+atf_test_case exclusive
+exclusive_head()
+{
+    atf_set "descr" "Verifies that exclusive test cases run alone"
+}
+exclusive_body()
+{
+    cat >Kyuafile <<EOF
+syntax(2)
+atf_test_program{name="tp"}
+EOF
+    create_test_program tp <<EOF
+run() {
+    local dir="\$(atf_config_get dir)"
+    mkdir "\${dir}/lock" || atf_fail "Not running alone"
+    sleep 0.5
+    rmdir "\${dir}/lock"
+}
+atf_init_test_cases() {
+    for i in 1 2 3; do
+        eval "atf_test_case x\${i}; x\${i}_head() { atf_set is.exclusive true; }"
+        eval "x\${i}_body() { run; }"
+        atf_add_test_case x\${i}
+    done
+}
+EOF
+
+    atf_check -s eq:0 -o match:"^3 test cases: 3 passed" -e empty \
+        "${ATF_RUN}" -j 3 -v dir="$(pwd)"
+}
+
+atf_test_case timeout
+timeout_head()
+{
+    atf_set "descr" "Verifies that test cases that exceed their timeout" \
+        "are killed along with their subprocesses"
+}
+timeout_body()
+{
+    cat >Kyuafile <<EOF
+syntax(2)
+atf_test_program{name="tp"}
+EOF
+    create_test_program tp <<EOF
+atf_test_case hang
+hang_head() { atf_set "timeout" "1"; }
+hang_body() {
+    ( sleep 60; touch "\$(atf_config_get dir)/survived" ) &
+    sleep 60
+}
+atf_test_case expected
+expected_head() { atf_set "timeout" "1"; }
+expected_body() { atf_expect_timeout "Hangs"; sleep 60; }
+atf_init_test_cases() {
+    atf_add_test_case hang
+    atf_add_test_case expected
+}
+EOF
+
+    atf_check -s eq:1 -o save:stdout -e empty "${ATF_RUN}" -v dir="$(pwd)"
+    atf_check -o match:"^tp:hang  ->  broken: Test case body timed out" \
+        cat stdout
+    atf_check -o match:"^tp:expected  ->  expected_failure: Hangs" cat stdout
+    test ! -f survived || atf_fail "Subprocess of timed out test case survived"
+}
+
+atf_test_case cleanup
+cleanup_head()
+{
+    atf_set "descr" "Verifies that cleanup routines run in the work" \
+        "directory of the body and that their failures are reported"
+}
+cleanup_body()
+{
+    cat >Kyuafile <<EOF
+syntax(2)
+atf_test_program{name="tp"}
+EOF
+    create_test_program tp <<EOF
+atf_test_case good cleanup
+good_body() { touch cookie; }
+good_cleanup() {
+    test -f cookie || exit 1
+    touch "\$(atf_config_get dir)/cleaned"
+}
+atf_test_case bad cleanup
+bad_body() { :; }
+bad_cleanup() { exit 1; }
+atf_init_test_cases() {
+    atf_add_test_case good
+    atf_add_test_case bad
+}
+EOF
+
+    atf_check -s eq:1 -o save:stdout -e empty "${ATF_RUN}" -v dir="$(pwd)"
+    atf_check -o match:"^tp:good  ->  passed" cat stdout
+    atf_check -o match:"^tp:bad  ->  broken: Test case cleanup did not \
+terminate successfully" cat stdout
+    test -f cleaned || atf_fail "Cleanup routine did not run"
+}
+
+atf_test_case requirements
+requirements_head()
+{
+    atf_set "descr" "Verifies that test cases whose requirements are not" \
+        "met are skipped without running them"
+}
+requirements_body()
+{
+    cat >Kyuafile <<EOF
+syntax(2)
+atf_test_program{name="tp"}
+EOF
+    create_test_program tp <<EOF
+atf_test_case config
+config_head() { atf_set "require.config" "needed"; }
+config_body() { :; }
+atf_test_case progs
+progs_head() { atf_set "require.progs" "non-existent-program"; }
+progs_body() { atf_fail "Should not run"; }
+atf_init_test_cases() {
+    atf_add_test_case config
+    atf_add_test_case progs
+}
+EOF
+
+    atf_check -s eq:0 -o save:stdout -e empty "${ATF_RUN}"
+    atf_check -o match:"^tp:config  ->  skipped: Required configuration \
+property 'needed' not defined" cat stdout
+    atf_check -o match:"^tp:progs  ->  skipped: Required program \
+'non-existent-program' not found in the PATH" cat stdout
+
+    atf_check -s eq:0 -o match:"^tp:config  ->  passed" -e empty \
+        "${ATF_RUN}" -v needed=yes
+}
+
+atf_test_case shards
+shards_head()
+{
+    atf_set "descr" "Verifies that the shards split the test cases of" \
+        "the test suite and honor the durations file"
+}
+shards_body()
+{
+    cat >Kyuafile <<EOF
+syntax(2)
+atf_test_program{name="tp"}
+EOF
+    create_results_program tp
+
+    for i in 1 2 3; do
+        "${ATF_RUN}" -S ${i}/3 >stdout
+        sed -n -e 's,^\(tp:[a-z]*\)  ->.*,\1,p' stdout >>union
+    done
+    cat >expout <<EOF
+tp:fail
+tp:pass
+tp:skip
+tp:xfail
+EOF
+    atf_check -o file:expout sort union
+
+    cat >durations <<EOF
+tp:pass 4
+tp:fail 3
+tp:skip 2
+tp:xfail 1
+EOF
+    atf_check -s eq:0 -o save:stdout -e empty "${ATF_RUN}" -S 1/2 -D durations
+    atf_check -o match:"^tp:pass  ->  passed" cat stdout
+    atf_check -o match:"^tp:xfail  ->  expected_failure" cat stdout
+    atf_check -o match:"^2 test cases:" cat stdout
+}
+
+atf_test_case usage_errors
+usage_errors_head()
+{
+    atf_set "descr" "Verifies that invalid options are reported"
+}
+usage_errors_body()
+{
+    atf_check -s eq:1 -o empty -e match:"Invalid number of jobs '0'" \
+        "${ATF_RUN}" -j 0
+    atf_check -s eq:1 -o empty -e match:"Invalid variable definition 'foo'" \
+        "${ATF_RUN}" -v foo
+    atf_check -s eq:1 -o empty -e match:"Invalid shard specification '3'" \
+        "${ATF_RUN}" -S 3
+    atf_check -s eq:1 -o empty -e match:"-D requires -S" \
+        "${ATF_RUN}" -D durations
+}
+
+atf_init_test_cases()
+{
+    atf_add_test_case results
+    atf_add_test_case report
+    atf_add_test_case all_passed
+    atf_add_test_case include_and_filters
+    atf_add_test_case kyuafile_errors
+    atf_add_test_case broken_program
+    atf_add_test_case isolation
+    atf_add_test_case parallel
+    atf_add_test_case exclusive
+    atf_add_test_case timeout
+    atf_add_test_case cleanup
+    atf_add_test_case requirements
+    atf_add_test_case shards
+    atf_add_test_case usage_errors
+}
+
+# vim: syntax=sh:expandtab:shiftwidth=4:softtabstop=4
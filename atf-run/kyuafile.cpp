@@ -0,0 +1,442 @@
+// Copyright (c) 2026 The NetBSD Foundation, Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+// CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+// IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "atf-run/kyuafile.hpp"
+
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+#include "atf-c++/detail/text.hpp"
+
+namespace impl = atf::atf_run;
+#define IMPL_NAME "atf::atf_run"
+
+// ------------------------------------------------------------------------
+// Auxiliary functions.
+// ------------------------------------------------------------------------
+
+namespace {
+
+struct token {
+    enum type { END, IDENT, STRING, NUMBER, PUNCT };
+
+    type m_type;
+    std::string m_text;
+    std::size_t m_line;
+
+    token(const type t, const std::string& text, const std::size_t line) :
+        m_type(t), m_text(text), m_line(line)
+    {
+    }
+
+    bool
+    is(const type t, const std::string& text)
+        const
+    {
+        return m_type == t && m_text == text;
+    }
+};
+
+//!
+//! \brief Splits the contents of a Kyuafile into tokens.
+//!
+//! Comments, which start with two dashes as in Lua, are discarded.
+//!
+class lexer {
+    const std::string& m_name;
+    const std::string m_text;
+    std::string::size_type m_pos;
+    std::size_t m_line;
+
+    char
+    peek(const std::string::size_type offset = 0)
+        const
+    {
+        return m_pos + offset < m_text.length() ? m_text[m_pos + offset] : '\0';
+    }
+
+    void
+    skip_blanks(void)
+    {
+        while (m_pos < m_text.length()) {
+            if (peek() == '\n') {
+                m_line++;
+                m_pos++;
+            } else if (std::isspace(static_cast< unsigned char >(peek()))) {
+                m_pos++;
+            } else if (peek() == '-' && peek(1) == '-') {
+                while (m_pos < m_text.length() && peek() != '\n')
+                    m_pos++;
+            } else
+                break;
+        }
+    }
+
+    token
+    read_string(void)
+    {
+        const char quote = m_text[m_pos++];
+        std::string value;
+        while (peek() != quote) {
+            if (peek() == '\0' || peek() == '\n')
+                throw impl::parse_error(m_name, m_line,
+                                        "Unterminated string");
+            if (peek() == '\\') {
+                m_pos++;
+                switch (peek()) {
+                case 'n': value += '\n'; break;
+                case 't': value += '\t'; break;
+                case '\\': case '"': case '\'': value += peek(); break;
+                default:
+                    throw impl::parse_error(m_name, m_line,
+                                            "Invalid escape sequence in "
+                                            "string");
+                }
+            } else
+                value += peek();
+            m_pos++;
+        }
+        m_pos++;
+        return token(token::STRING, value, m_line);
+    }
+
+public:
+    lexer(const std::string& name, const std::string& text) :
+        m_name(name), m_text(text), m_pos(0), m_line(1)
+    {
+    }
+
+    token
+    next(void)
+    {
+        skip_blanks();
+
+        const char ch = peek();
+        if (ch == '\0')
+            return token(token::END, "", m_line);
+        else if (ch == '"' || ch == '\'')
+            return read_string();
+        else if (std::isalpha(static_cast< unsigned char >(ch)) || ch == '_') {
+            const std::string::size_type start = m_pos;
+            while (std::isalnum(static_cast< unsigned char >(peek())) ||
+                   peek() == '_')
+                m_pos++;
+            return token(token::IDENT, m_text.substr(start, m_pos - start),
+                         m_line);
+        } else if (std::isdigit(static_cast< unsigned char >(ch))) {
+            const std::string::size_type start = m_pos;
+            while (std::isdigit(static_cast< unsigned char >(peek())))
+                m_pos++;
+            return token(token::NUMBER, m_text.substr(start, m_pos - start),
+                         m_line);
+        } else if (std::strchr("(){},=;", ch) != NULL) {
+            m_pos++;
+            return token(token::PUNCT, std::string(1, ch), m_line);
+        } else
+            throw impl::parse_error(m_name, m_line, std::string("Unexpected "
+                                    "character '") + ch + "'");
+    }
+};
+
+//!
+//! \brief Parses the statements of a Kyuafile.
+//!
+class parser {
+    const std::string& m_name;
+    lexer m_lexer;
+    token m_token;
+
+    void
+    advance(void)
+    {
+        m_token = m_lexer.next();
+    }
+
+    void
+    expect(const std::string& punct)
+    {
+        if (!m_token.is(token::PUNCT, punct))
+            throw impl::parse_error(m_name, m_token.m_line, "Expected '" +
+                                    punct + "'");
+        advance();
+    }
+
+    std::string
+    value(void)
+    {
+        if (m_token.m_type != token::STRING &&
+            m_token.m_type != token::NUMBER)
+            throw impl::parse_error(m_name, m_token.m_line,
+                                    "Expected a string or a number");
+        const std::string text = m_token.m_text;
+        advance();
+        return text;
+    }
+
+    std::vector< std::string >
+    arguments(void)
+    {
+        std::vector< std::string > args;
+
+        expect("(");
+        if (!m_token.is(token::PUNCT, ")")) {
+            args.push_back(value());
+            while (m_token.is(token::PUNCT, ",")) {
+                advance();
+                args.push_back(value());
+            }
+        }
+        expect(")");
+        return args;
+    }
+
+    std::vector< std::pair< std::string, std::string > >
+    fields(void)
+    {
+        std::vector< std::pair< std::string, std::string > > pairs;
+
+        expect("{");
+        while (!m_token.is(token::PUNCT, "}")) {
+            if (m_token.m_type != token::IDENT)
+                throw impl::parse_error(m_name, m_token.m_line,
+                                        "Expected a property name");
+            const std::string key = m_token.m_text;
+            advance();
+            expect("=");
+            pairs.push_back(std::make_pair(key, value()));
+            if (!m_token.is(token::PUNCT, ","))
+                break;
+            advance();
+        }
+        expect("}");
+        return pairs;
+    }
+
+    void
+    call(const std::string& function, const std::size_t line,
+         impl::kyuafile& kf)
+    {
+        const std::vector< std::string > args = arguments();
+
+        if (function == "syntax") {
+            const std::string version = args.empty() ? "" : args.back();
+            if (args.size() < 1 || args.size() > 2 ||
+                (args.size() == 2 && args[0] != "kyuafile") ||
+                (version != "1" && version != "2"))
+                throw impl::parse_error(m_name, line, "Unsupported syntax "
+                                        "declaration");
+        } else if (function == "test_suite") {
+            if (args.size() != 1)
+                throw impl::parse_error(m_name, line, "test_suite takes one "
+                                        "argument");
+            kf.test_suite = args[0];
+        } else if (function == "include") {
+            if (args.size() != 1)
+                throw impl::parse_error(m_name, line, "include takes one "
+                                        "argument");
+            kf.includes.push_back(args[0]);
+        } else
+            throw impl::parse_error(m_name, line, "Unknown function '" +
+                                    function + "'");
+    }
+
+    void
+    definition(const std::string& type, const std::size_t line,
+               impl::kyuafile& kf)
+    {
+        const std::vector< std::pair< std::string, std::string > > props =
+            fields();
+
+        if (type != "atf_test_program")
+            throw impl::parse_error(m_name, line, "Unsupported test program "
+                                    "type '" + type + "'; only "
+                                    "atf_test_program is supported");
+
+        std::string name;
+        std::vector< std::pair< std::string, std::string > >::const_iterator
+            iter;
+        for (iter = props.begin(); iter != props.end(); iter++) {
+            if ((*iter).first == "name")
+                name = (*iter).second;
+            else if ((*iter).first != "test_suite")
+                throw impl::parse_error(m_name, line, "Unsupported property "
+                                        "'" + (*iter).first + "'");
+        }
+        if (name.empty())
+            throw impl::parse_error(m_name, line, "Test program without a "
+                                    "name");
+        kf.test_programs.push_back(name);
+    }
+
+public:
+    parser(const std::string& name, const std::string& text) :
+        m_name(name), m_lexer(name, text), m_token(m_lexer.next())
+    {
+    }
+
+    impl::kyuafile
+    parse(void)
+    {
+        impl::kyuafile kf;
+        bool first = true;
+
+        while (m_token.m_type != token::END) {
+            if (m_token.m_type != token::IDENT)
+                throw impl::parse_error(m_name, m_token.m_line,
+                                        "Expected a statement");
+            const std::string name = m_token.m_text;
+            const std::size_t line = m_token.m_line;
+            advance();
+
+            if (first && name != "syntax")
+                throw impl::parse_error(m_name, line, "The syntax "
+                                        "declaration must come first");
+            first = false;
+
+            if (m_token.is(token::PUNCT, "("))
+                call(name, line, kf);
+            else if (m_token.is(token::PUNCT, "{"))
+                definition(name, line, kf);
+            else
+                throw impl::parse_error(m_name, m_token.m_line,
+                                        "Expected '(' or '{'");
+
+            if (m_token.is(token::PUNCT, ";"))
+                advance();
+        }
+        if (first)
+            throw impl::parse_error(m_name, m_token.m_line, "Missing syntax "
+                                    "declaration");
+
+        return kf;
+    }
+};
+
+//!
+//! \brief Joins a directory and a relative name, folding leading "..".
+//!
+//! This keeps the names of test programs short and lets the detection of
+//! recursive inclusions see through files that include their parents.
+//!
+static
+std::string
+join(std::string dir, std::string name)
+{
+    while (!dir.empty() && name.compare(0, 3, "../") == 0) {
+        const std::string::size_type slash = dir.rfind('/');
+        const std::string last = slash == std::string::npos ? dir :
+            dir.substr(slash + 1);
+        if (last == "..")
+            break;
+        dir = slash == std::string::npos ? "" : dir.substr(0, slash);
+        name.erase(0, 3);
+    }
+    return dir.empty() ? name : dir + "/" + name;
+}
+
+static
+void
+load_recursively(const atf::fs::path& root, const std::string& file,
+                 std::set< std::string >& visited,
+                 std::vector< std::string >& programs)
+{
+    atf::fs::path path = root / file;
+    if (!path.is_absolute())
+        path = path.to_absolute();
+    if (!visited.insert(path.str()).second)
+        throw std::runtime_error("Recursive inclusion of " + file);
+
+    std::ifstream is(path.c_str());
+    if (!is)
+        throw std::runtime_error("Cannot open " + (root / file).str());
+    const impl::kyuafile kf = impl::parse_kyuafile(is, (root / file).str());
+
+    const std::string::size_type slash = file.rfind('/');
+    const std::string dir = slash == std::string::npos ? "" :
+        file.substr(0, slash);
+    std::vector< std::string >::const_iterator iter;
+    for (iter = kf.test_programs.begin(); iter != kf.test_programs.end();
+         iter++)
+        programs.push_back(join(dir, *iter));
+    for (iter = kf.includes.begin(); iter != kf.includes.end(); iter++)
+        load_recursively(root, join(dir, *iter), visited, programs);
+
+    visited.erase(path.str());
+}
+
+} // anonymous namespace
+
+// ------------------------------------------------------------------------
+// The "parse_error" class.
+// ------------------------------------------------------------------------
+
+impl::parse_error::parse_error(const std::string& name, const std::size_t line,
+                               const std::string& message) :
+    std::runtime_error(name + ":" + atf::text::to_string(line) + ": " +
+                       message)
+{
+}
+
+// ------------------------------------------------------------------------
+// The "kyuafile" class.
+// ------------------------------------------------------------------------
+
+//!
+//! \brief Parses a Kyuafile.
+//!
+//! The name of the file is only used in the error messages.
+//!
+impl::kyuafile
+impl::parse_kyuafile(std::istream& is, const std::string& name)
+{
+    std::ostringstream text;
+    text << is.rdbuf();
+    return parser(name, text.str()).parse();
+}
+
+// ------------------------------------------------------------------------
+// Free functions.
+// ------------------------------------------------------------------------
+
+//!
+//! \brief Collects the test programs of a Kyuafile and of those that it
+//! includes.
+//!
+//! The test programs come in the order in which they are defined, those
+//! of each Kyuafile before the ones of the files that it includes, and are
+//! named relative to the directory of the given Kyuafile.
+//!
+std::vector< std::string >
+impl::load_kyuafile(const atf::fs::path& file)
+{
+    std::set< std::string > visited;
+    std::vector< std::string > programs;
+    load_recursively(file.branch_path(), file.leaf_name(), visited,
+                     programs);
+    return programs;
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2026 The NetBSD Foundation, Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+// CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+// IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#if !defined(ATF_RUN_KYUAFILE_HPP)
+#define ATF_RUN_KYUAFILE_HPP
+
+#include <cstddef>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "atf-c++/detail/fs.hpp"
+
+namespace atf {
+namespace atf_run {
+
+// ------------------------------------------------------------------------
+// The "parse_error" class.
+// ------------------------------------------------------------------------
+
+class parse_error : public std::runtime_error {
+public:
+    parse_error(const std::string&, const std::size_t, const std::string&);
+};
+
+// ------------------------------------------------------------------------
+// The "kyuafile" class.
+// ------------------------------------------------------------------------
+
+//!
+//! \brief The contents of a single Kyuafile.
+//!
+//! Only the subset of the syntax used by the Kyuafiles of ATF-based test
+//! suites is understood: the syntax and test_suite declarations, the
+//! atf_test_program definitions and the include statements.  The names
+//! of the test programs and of the included files are kept as written,
+//! relative to the directory of the Kyuafile.
+//!
+struct kyuafile {
+    std::string test_suite;
+    std::vector< std::string > includes;
+    std::vector< std::string > test_programs;
+};
+
+kyuafile parse_kyuafile(std::istream&, const std::string&);
+
+// ------------------------------------------------------------------------
+// Free functions.
+// ------------------------------------------------------------------------
+
+std::vector< std::string > load_kyuafile(const atf::fs::path&);
+
+} // namespace atf_run
+} // namespace atf
+
+#endif // !defined(ATF_RUN_KYUAFILE_HPP)
@@ -0,0 +1,196 @@
+// Copyright (c) 2026 The NetBSD Foundation, Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+// CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+// IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "atf-run/kyuafile.hpp"
+
+extern "C" {
+#include <sys/stat.h>
+}
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <atf-c++.hpp>
+
+namespace {
+
+static
+atf::atf_run::kyuafile
+parse(const std::string& text)
+{
+    std::istringstream is(text);
+    return atf::atf_run::parse_kyuafile(is, "Kyuafile");
+}
+
+static
+void
+write_file(const char* name, const std::string& contents)
+{
+    std::ofstream os(name);
+    ATF_REQUIRE(os);
+    os << contents;
+}
+
+} // anonymous namespace
+
+// ------------------------------------------------------------------------
+// Test cases for the "parse_kyuafile" function.
+// ------------------------------------------------------------------------
+
+ATF_TEST_CASE_WITHOUT_HEAD(parse__empty);
+ATF_TEST_CASE_BODY(parse__empty)
+{
+    const atf::atf_run::kyuafile kf = parse("syntax(2)\n");
+    ATF_REQUIRE(kf.test_suite.empty());
+    ATF_REQUIRE(kf.includes.empty());
+    ATF_REQUIRE(kf.test_programs.empty());
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(parse__all);
+ATF_TEST_CASE_BODY(parse__all)
+{
+    const atf::atf_run::kyuafile kf = parse(
+        "-- A comment.\n"
+        "syntax(\"kyuafile\", 1)\n"
+        "\n"
+        "test_suite(\"atf\")\n"
+        "\n"
+        "include(\"sub/Kyuafile\")\n"
+        "atf_test_program{name=\"a_test\"}\n"
+        "atf_test_program{name='b_test', test_suite=\"other\"};\n"
+        "include('sub2/Kyuafile')  -- Trailing comment.\n");
+
+    ATF_REQUIRE_EQ("atf", kf.test_suite);
+    ATF_REQUIRE_EQ(2, kf.includes.size());
+    ATF_REQUIRE_EQ("sub/Kyuafile", kf.includes[0]);
+    ATF_REQUIRE_EQ("sub2/Kyuafile", kf.includes[1]);
+    ATF_REQUIRE_EQ(2, kf.test_programs.size());
+    ATF_REQUIRE_EQ("a_test", kf.test_programs[0]);
+    ATF_REQUIRE_EQ("b_test", kf.test_programs[1]);
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(parse__errors);
+ATF_TEST_CASE_BODY(parse__errors)
+{
+    using atf::atf_run::parse_error;
+
+    ATF_REQUIRE_THROW_RE(parse_error, "Kyuafile:1: .*syntax", parse(
+        "test_suite(\"atf\")\n"));
+    ATF_REQUIRE_THROW_RE(parse_error, "Kyuafile:1: Unsupported syntax", parse(
+        "syntax(3)\n"));
+    ATF_REQUIRE_THROW_RE(parse_error, "Kyuafile:2: Unsupported test "
+                         "program type 'plain_test_program'", parse(
+        "syntax(2)\n"
+        "plain_test_program{name=\"a\"}\n"));
+    ATF_REQUIRE_THROW_RE(parse_error, "Kyuafile:2: Unsupported property "
+                         "'timeout'", parse(
+        "syntax(2)\n"
+        "atf_test_program{name=\"a\", timeout=3}\n"));
+    ATF_REQUIRE_THROW_RE(parse_error, "Kyuafile:3: ", parse(
+        "syntax(2)\n"
+        "\n"
+        "include(\"foo\" \"bar\")\n"));
+    ATF_REQUIRE_THROW_RE(parse_error, "Kyuafile:2: ", parse(
+        "syntax(2)\n"
+        "test_suite(\"unterminated)\n"));
+}
+
+// ------------------------------------------------------------------------
+// Test cases for the "load_kyuafile" function.
+// ------------------------------------------------------------------------
+
+ATF_TEST_CASE_WITHOUT_HEAD(load__includes);
+ATF_TEST_CASE_BODY(load__includes)
+{
+    ATF_REQUIRE(::mkdir("root", 0755) != -1);
+    ATF_REQUIRE(::mkdir("root/sub", 0755) != -1);
+    ATF_REQUIRE(::mkdir("root/sub/deeper", 0755) != -1);
+    write_file("root/Kyuafile",
+               "syntax(2)\n"
+               "atf_test_program{name=\"top_test\"}\n"
+               "include(\"sub/Kyuafile\")\n");
+    write_file("root/sub/Kyuafile",
+               "syntax(2)\n"
+               "include(\"deeper/Kyuafile\")\n"
+               "atf_test_program{name=\"sub_test\"}\n");
+    write_file("root/sub/deeper/Kyuafile",
+               "syntax(2)\n"
+               "atf_test_program{name=\"deep_test\"}\n");
+
+    const std::vector< std::string > programs =
+        atf::atf_run::load_kyuafile(atf::fs::path("root/Kyuafile"));
+    ATF_REQUIRE_EQ(3, programs.size());
+    ATF_REQUIRE_EQ("top_test", programs[0]);
+    ATF_REQUIRE_EQ("sub/sub_test", programs[1]);
+    ATF_REQUIRE_EQ("sub/deeper/deep_test", programs[2]);
+
+    ATF_REQUIRE(programs == atf::atf_run::load_kyuafile(
+        atf::fs::path("root/Kyuafile").to_absolute()));
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(load__missing);
+ATF_TEST_CASE_BODY(load__missing)
+{
+    write_file("Kyuafile",
+               "syntax(2)\n"
+               "include(\"sub/Kyuafile\")\n");
+    ATF_REQUIRE_THROW_RE(std::runtime_error, "Cannot open .*sub/Kyuafile",
+                         atf::atf_run::load_kyuafile(
+                             atf::fs::path("Kyuafile")));
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(load__recursive);
+ATF_TEST_CASE_BODY(load__recursive)
+{
+    ATF_REQUIRE(::mkdir("sub", 0755) != -1);
+    write_file("Kyuafile",
+               "syntax(2)\n"
+               "include(\"sub/Kyuafile\")\n");
+    write_file("sub/Kyuafile",
+               "syntax(2)\n"
+               "include(\"../Kyuafile\")\n");
+    ATF_REQUIRE_THROW_RE(std::runtime_error, "Recursive inclusion",
+                         atf::atf_run::load_kyuafile(
+                             atf::fs::path("Kyuafile")));
+}
+
+// ------------------------------------------------------------------------
+// Main.
+// ------------------------------------------------------------------------
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    // Add the test cases for the "parse_kyuafile" function.
+    ATF_ADD_TEST_CASE(tcs, parse__empty);
+    ATF_ADD_TEST_CASE(tcs, parse__all);
+    ATF_ADD_TEST_CASE(tcs, parse__errors);
+
+    // Add the test cases for the "load_kyuafile" function.
+    ATF_ADD_TEST_CASE(tcs, load__includes);
+    ATF_ADD_TEST_CASE(tcs, load__missing);
+    ATF_ADD_TEST_CASE(tcs, load__recursive);
+}
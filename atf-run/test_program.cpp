@@ -0,0 +1,502 @@
+// Copyright (c) 2026 The NetBSD Foundation, Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+// CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+// IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "atf-run/test_program.hpp"
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/utsname.h>
+#include <sys/wait.h>
+
+#include <unistd.h>
+}
+
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+#include "atf-c++/detail/fs.hpp"
+#include "atf-c++/detail/sanity.hpp"
+#include "atf-c++/detail/text.hpp"
+
+namespace impl = atf::atf_run;
+#define IMPL_NAME "atf::atf_run"
+
+// ------------------------------------------------------------------------
+// Auxiliary functions.
+// ------------------------------------------------------------------------
+
+namespace {
+
+static
+bool
+md_bool(const impl::vars_map& md, const std::string& name)
+{
+    const impl::vars_map::const_iterator iter = md.find(name);
+    if (iter == md.end())
+        return false;
+    try {
+        return atf::text::to_bool((*iter).second);
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+}
+
+static
+std::vector< std::string >
+md_words(const impl::vars_map& md, const std::string& name)
+{
+    const impl::vars_map::const_iterator iter = md.find(name);
+    if (iter == md.end())
+        return std::vector< std::string >();
+    return atf::text::split((*iter).second, " ");
+}
+
+static
+std::string
+check_arch_or_machine(const impl::vars_map& md, const std::string& name,
+                      const std::string& what)
+{
+    const std::vector< std::string > allowed = md_words(md, name);
+    if (allowed.empty())
+        return "";
+
+    struct utsname un;
+    if (::uname(&un) == -1)
+        return "Cannot determine the current " + what;
+    for (std::vector< std::string >::const_iterator iter = allowed.begin();
+         iter != allowed.end(); iter++)
+        if (*iter == un.machine)
+            return "";
+    return "Current " + what + " '" + un.machine + "' not supported";
+}
+
+static
+std::string
+check_memory(const impl::vars_map& md)
+{
+    const impl::vars_map::const_iterator iter = md.find("require.memory");
+    if (iter == md.end())
+        return "";
+
+    int64_t needed;
+    try {
+        needed = atf::text::to_bytes((*iter).second);
+    } catch (const std::runtime_error& e) {
+        return "Invalid value in require.memory: " + std::string(e.what());
+    }
+
+#if defined(_SC_PHYS_PAGES)
+    const long pages = ::sysconf(_SC_PHYS_PAGES);
+    const long page_size = ::sysconf(_SC_PAGESIZE);
+    if (pages > 0 && page_size > 0) {
+        const int64_t available = int64_t(pages) * page_size;
+        if (available < needed)
+            return "Requires " + atf::text::to_string(needed) + " bytes of "
+                "physical memory but only " +
+                atf::text::to_string(available) + " available";
+    }
+#endif
+    return "";
+}
+
+static
+std::string
+check_progs(const impl::vars_map& md)
+{
+    const std::vector< std::string > progs = md_words(md, "require.progs");
+    for (std::vector< std::string >::const_iterator iter = progs.begin();
+         iter != progs.end(); iter++) {
+        const std::string& prog = *iter;
+        if (prog.find('/') == std::string::npos) {
+            if (!atf::fs::have_prog_in_path(prog))
+                return "Required program '" + prog + "' not found in the "
+                    "PATH";
+        } else {
+            const atf::fs::path p(prog);
+            if (!p.is_absolute())
+                return "Relative path '" + prog + "' not allowed in "
+                    "require.progs";
+            if (!atf::fs::is_executable(p))
+                return "Required program '" + prog + "' not found";
+        }
+    }
+    return "";
+}
+
+//!
+//! \brief The contents of a results file.
+//!
+struct raw_result {
+    std::string status;
+    int arg;
+    std::string reason;
+};
+
+static
+raw_result
+parse_raw_result(std::istream& is)
+{
+    std::ostringstream text;
+    text << is.rdbuf();
+    std::string line = text.str();
+    if (!line.empty() && line[line.length() - 1] == '\n')
+        line.erase(line.length() - 1);
+    if (line.empty())
+        throw std::runtime_error("Empty results file");
+
+    raw_result raw;
+    raw.arg = -1;
+
+    const std::string::size_type delim = line.find_first_of("(:");
+    raw.status = line.substr(0, delim);
+    std::string::size_type pos = delim;
+    if (pos != std::string::npos && line[pos] == '(') {
+        const std::string::size_type end = line.find(')', pos);
+        if (end == std::string::npos)
+            throw std::runtime_error("Unterminated argument in '" + line +
+                                     "'");
+        try {
+            raw.arg = atf::text::to_type< int >(line.substr(pos + 1,
+                                                            end - pos - 1));
+        } catch (const std::runtime_error&) {
+            throw std::runtime_error("Invalid argument in '" + line + "'");
+        }
+        pos = end + 1;
+    }
+
+    if (raw.status == "passed") {
+        if (pos != std::string::npos)
+            throw std::runtime_error("Unexpected reason in '" + line + "'");
+    } else {
+        if (pos == std::string::npos || line.compare(pos, 2, ": ") != 0 ||
+            pos + 2 == line.length())
+            throw std::runtime_error("Missing reason in '" + line + "'");
+        raw.reason = line.substr(pos + 2);
+    }
+
+    return raw;
+}
+
+static
+std::string
+format_status(const int status)
+{
+    if (WIFEXITED(status))
+        return "exited with code " + atf::text::to_string(WEXITSTATUS(status));
+    else if (WIFSIGNALED(status))
+        return "received signal " + atf::text::to_string(WTERMSIG(status));
+    else
+        return "terminated in an unknown manner";
+}
+
+static
+impl::test_result
+require_success(const raw_result& raw, const int status,
+                const impl::test_result::state_type state,
+                const std::string& name)
+{
+    if (WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS)
+        return impl::test_result(state, raw.reason);
+    return impl::test_result(impl::test_result::BROKEN, name + " test case "
+                             "should have reported success but " +
+                             format_status(status));
+}
+
+} // anonymous namespace
+
+// ------------------------------------------------------------------------
+// The "test_case" class.
+// ------------------------------------------------------------------------
+
+impl::test_case::test_case(const std::string& p_ident) :
+    ident(p_ident)
+{
+}
+
+bool
+impl::test_case::has_cleanup(void)
+    const
+{
+    return md_bool(md, "has.cleanup");
+}
+
+bool
+impl::test_case::is_exclusive(void)
+    const
+{
+    return md_bool(md, "is.exclusive");
+}
+
+//!
+//! \brief Gets the timeout of the test case, in seconds.
+//!
+//! Zero means that the test case has no time limit.
+//!
+unsigned int
+impl::test_case::timeout(void)
+    const
+{
+    const vars_map::const_iterator iter = md.find("timeout");
+    if (iter == md.end())
+        return 300;
+    try {
+        return atf::text::to_type< unsigned int >((*iter).second);
+    } catch (const std::runtime_error&) {
+        return 300;
+    }
+}
+
+//!
+//! \brief Parses the list of test cases printed by a test program.
+//!
+//! The list may be empty, as it is for the shards of a test program that
+//! get none of its test cases.
+//!
+std::vector< impl::test_case >
+impl::parse_test_case_list(std::istream& is)
+{
+    std::string line;
+    if (!std::getline(is, line) ||
+        line != "Content-Type: application/X-atf-tp; version=\"1\"")
+        throw std::runtime_error("Invalid header in test case list");
+    if (!std::getline(is, line) || !line.empty())
+        throw std::runtime_error("Missing blank line after the header in "
+                                 "test case list");
+
+    std::vector< test_case > tcs;
+    bool in_block = false;
+    while (std::getline(is, line)) {
+        if (line.empty()) {
+            in_block = false;
+            continue;
+        }
+
+        const std::string::size_type delim = line.find(": ");
+        if (delim == std::string::npos)
+            throw std::runtime_error("Invalid property '" + line + "' in "
+                                     "test case list");
+        const std::string name = line.substr(0, delim);
+        const std::string value = line.substr(delim + 2);
+
+        if (!in_block) {
+            if (name != "ident")
+                throw std::runtime_error("Test case definition does not "
+                                         "start with ident");
+            tcs.push_back(test_case(value));
+            in_block = true;
+        }
+        tcs.back().md[name] = value;
+    }
+
+    return tcs;
+}
+
+//!
+//! \brief Checks whether the requirements of a test case are met.
+//!
+//! \return The reason to skip the test case, or an empty string if it can
+//! run.
+//!
+std::string
+impl::check_requirements(const vars_map& md, const vars_map& config)
+{
+    std::string reason;
+
+    reason = check_arch_or_machine(md, "require.arch", "architecture");
+    if (!reason.empty())
+        return reason;
+    reason = check_arch_or_machine(md, "require.machine", "machine type");
+    if (!reason.empty())
+        return reason;
+
+    const std::vector< std::string > vars = md_words(md, "require.config");
+    for (std::vector< std::string >::const_iterator iter = vars.begin();
+         iter != vars.end(); iter++)
+        if (config.find(*iter) == config.end())
+            return "Required configuration property '" + *iter + "' not "
+                "defined";
+
+    const std::vector< std::string > files = md_words(md, "require.files");
+    for (std::vector< std::string >::const_iterator iter = files.begin();
+         iter != files.end(); iter++) {
+        const atf::fs::path p(*iter);
+        if (!p.is_absolute())
+            return "Relative path '" + *iter + "' not allowed in "
+                "require.files";
+        if (!atf::fs::exists(p))
+            return "Required file '" + *iter + "' not found";
+    }
+
+    reason = check_memory(md);
+    if (!reason.empty())
+        return reason;
+
+    reason = check_progs(md);
+    if (!reason.empty())
+        return reason;
+
+    const vars_map::const_iterator user = md.find("require.user");
+    if (user != md.end()) {
+        if ((*user).second == "root" && ::geteuid() != 0)
+            return "Requires root privileges";
+        else if ((*user).second == "unprivileged" && ::geteuid() == 0)
+            return "Requires an unprivileged user";
+        else if ((*user).second != "root" &&
+                 (*user).second != "unprivileged")
+            return "Invalid value in require.user: " + (*user).second;
+    }
+
+    return "";
+}
+
+// ------------------------------------------------------------------------
+// The "test_result" class.
+// ------------------------------------------------------------------------
+
+impl::test_result::test_result(const state_type p_state,
+                               const std::string& p_reason) :
+    state(p_state),
+    reason(p_reason)
+{
+}
+
+//!
+//! \brief Checks whether the result does not denote a problem.
+//!
+bool
+impl::test_result::good(void)
+    const
+{
+    return state != FAILED && state != BROKEN;
+}
+
+const char*
+impl::test_result::state_name(void)
+    const
+{
+    switch (state) {
+    case PASSED: return "passed";
+    case FAILED: return "failed";
+    case SKIPPED: return "skipped";
+    case EXPECTED_FAILURE: return "expected_failure";
+    case BROKEN: return "broken";
+    }
+    UNREACHABLE;
+    return NULL;
+}
+
+//!
+//! \brief Determines the result of the body of a test case.
+//!
+//! Reconciles the contents of the results file, if any, with the way in
+//! which the body terminated, given as a status as returned by waitpid(2),
+//! and with whether it had to be killed because it timed out.
+//!
+impl::test_result
+impl::calculate_result(std::istream* resfile, const int status,
+                       const bool timed_out)
+{
+    if (resfile == NULL) {
+        if (timed_out)
+            return test_result(test_result::BROKEN, "Test case body timed "
+                               "out");
+        return test_result(test_result::BROKEN, "Premature exit; test case " +
+                           format_status(status));
+    }
+
+    raw_result raw;
+    try {
+        raw = parse_raw_result(*resfile);
+    } catch (const std::runtime_error& e) {
+        return test_result(test_result::BROKEN, "Invalid results file: " +
+                           std::string(e.what()));
+    }
+
+    if (timed_out) {
+        if (raw.status == "expected_timeout")
+            return test_result(test_result::EXPECTED_FAILURE, raw.reason);
+        return test_result(test_result::BROKEN, "Test case body timed out");
+    }
+
+    if (raw.status == "passed") {
+        return require_success(raw, status, test_result::PASSED, "Passed");
+    } else if (raw.status == "skipped") {
+        return require_success(raw, status, test_result::SKIPPED, "Skipped");
+    } else if (raw.status == "expected_failure") {
+        return require_success(raw, status, test_result::EXPECTED_FAILURE,
+                               "Expected failure");
+    } else if (raw.status == "failed") {
+        if (WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE)
+            return test_result(test_result::FAILED, raw.reason);
+        return test_result(test_result::BROKEN, "Failed test case should "
+                           "have reported failure but " +
+                           format_status(status));
+    } else if (raw.status == "broken") {
+        return test_result(test_result::BROKEN, raw.reason);
+    } else if (raw.status == "expected_exit") {
+        if (WIFEXITED(status) &&
+            (raw.arg == -1 || WEXITSTATUS(status) == raw.arg))
+            return test_result(test_result::EXPECTED_FAILURE, raw.reason);
+        return test_result(test_result::FAILED, "Expected clean exit but " +
+                           format_status(status));
+    } else if (raw.status == "expected_signal") {
+        if (WIFSIGNALED(status) &&
+            (raw.arg == -1 || WTERMSIG(status) == raw.arg))
+            return test_result(test_result::EXPECTED_FAILURE, raw.reason);
+        return test_result(test_result::FAILED, "Expected signal but " +
+                           format_status(status));
+    } else if (raw.status == "expected_death") {
+        if (WIFEXITED(status) || WIFSIGNALED(status))
+            return test_result(test_result::EXPECTED_FAILURE, raw.reason);
+        return test_result(test_result::FAILED, "Expected death but " +
+                           format_status(status));
+    } else if (raw.status == "expected_timeout") {
+        return test_result(test_result::FAILED, "Test case was expected to "
+                           "hang but it continued execution");
+    } else {
+        return test_result(test_result::BROKEN, "Invalid results file: "
+                           "Unknown result '" + raw.status + "'");
+    }
+}
+
+//!
+//! \brief Adjusts the result of a test case for the outcome of its cleanup.
+//!
+impl::test_result
+impl::calculate_cleanup_result(const test_result& body, const int status,
+                               const bool timed_out)
+{
+    if (!body.good())
+        return body;
+    if (timed_out)
+        return test_result(test_result::BROKEN, "Test case cleanup timed "
+                           "out");
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+        return test_result(test_result::BROKEN, "Test case cleanup did not "
+                           "terminate successfully; it " +
+                           format_status(status));
+    return body;
+}
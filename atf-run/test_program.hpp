@@ -0,0 +1,87 @@
+// Copyright (c) 2026 The NetBSD Foundation, Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+// CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+// IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#if !defined(ATF_RUN_TEST_PROGRAM_HPP)
+#define ATF_RUN_TEST_PROGRAM_HPP
+
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace atf {
+namespace atf_run {
+
+typedef std::map< std::string, std::string > vars_map;
+
+// ------------------------------------------------------------------------
+// The "test_case" class.
+// ------------------------------------------------------------------------
+
+struct test_case {
+    std::string ident;
+    vars_map md;
+
+    explicit test_case(const std::string&);
+
+    bool has_cleanup(void) const;
+    bool is_exclusive(void) const;
+    unsigned int timeout(void) const;
+};
+
+std::vector< test_case > parse_test_case_list(std::istream&);
+
+std::string check_requirements(const vars_map&, const vars_map&);
+
+// ------------------------------------------------------------------------
+// The "test_result" class.
+// ------------------------------------------------------------------------
+
+struct test_result {
+    enum state_type {
+        PASSED,
+        FAILED,
+        SKIPPED,
+        EXPECTED_FAILURE,
+        BROKEN
+    };
+
+    state_type state;
+    std::string reason;
+
+    test_result(const state_type, const std::string&);
+
+    bool good(void) const;
+    const char* state_name(void) const;
+};
+
+test_result calculate_result(std::istream*, const int, const bool);
+test_result calculate_cleanup_result(const test_result&, const int,
+                                     const bool);
+
+} // namespace atf_run
+} // namespace atf
+
+#endif // !defined(ATF_RUN_TEST_PROGRAM_HPP)
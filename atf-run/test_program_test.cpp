@@ -0,0 +1,362 @@
+// Copyright (c) 2026 The NetBSD Foundation, Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+// CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+// IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "atf-run/test_program.hpp"
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <signal.h>
+#include <unistd.h>
+}
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <atf-c++.hpp>
+
+using atf::atf_run::test_result;
+
+namespace {
+
+//!
+//! \brief Gets a wait status as returned by waitpid(2).
+//!
+//! \param exitstatus The exit code of the process, if signo is 0.
+//! \param signo The signal that kills the process, or 0.
+//!
+static
+int
+make_status(const int exitstatus, const int signo)
+{
+    const pid_t pid = ::fork();
+    ATF_REQUIRE(pid != -1);
+    if (pid == 0) {
+        if (signo != 0) {
+            ::signal(signo, SIG_DFL);
+            ::kill(::getpid(), signo);
+        }
+        std::exit(exitstatus);
+    }
+
+    int status;
+    ATF_REQUIRE_EQ(pid, ::waitpid(pid, &status, 0));
+    return status;
+}
+
+static
+test_result
+result_of(const std::string& contents, const int status,
+          const bool timed_out = false)
+{
+    std::istringstream is(contents);
+    return atf::atf_run::calculate_result(&is, status, timed_out);
+}
+
+static
+void
+check_result(const test_result::state_type state, const std::string& reason,
+             const test_result& result)
+{
+    ATF_REQUIRE_EQ(std::string(test_result(state, "").state_name()),
+                   result.state_name());
+    if (!atf::utils::grep_string(reason, result.reason))
+        ATF_FAIL("Reason '" + result.reason + "' does not match '" +
+                 reason + "'");
+}
+
+} // anonymous namespace
+
+// ------------------------------------------------------------------------
+// Test cases for the "test_case" class.
+// ------------------------------------------------------------------------
+
+ATF_TEST_CASE_WITHOUT_HEAD(test_case__md);
+ATF_TEST_CASE_BODY(test_case__md)
+{
+    atf::atf_run::test_case t("foo");
+    ATF_REQUIRE(!t.has_cleanup());
+    ATF_REQUIRE(!t.is_exclusive());
+    ATF_REQUIRE_EQ(300, t.timeout());
+
+    t.md["has.cleanup"] = "true";
+    t.md["is.exclusive"] = "yes";
+    t.md["timeout"] = "0";
+    ATF_REQUIRE(t.has_cleanup());
+    ATF_REQUIRE(t.is_exclusive());
+    ATF_REQUIRE_EQ(0, t.timeout());
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(parse_test_case_list__ok);
+ATF_TEST_CASE_BODY(parse_test_case_list__ok)
+{
+    std::istringstream is(
+        "Content-Type: application/X-atf-tp; version=\"1\"\n"
+        "\n"
+        "ident: first\n"
+        "descr: The first test case\n"
+        "\n"
+        "ident: second\n"
+        "has.cleanup: true\n"
+        "timeout: 10\n");
+
+    const std::vector< atf::atf_run::test_case > tcs =
+        atf::atf_run::parse_test_case_list(is);
+    ATF_REQUIRE_EQ(2, tcs.size());
+    ATF_REQUIRE_EQ("first", tcs[0].ident);
+    ATF_REQUIRE_EQ("The first test case", (*tcs[0].md.find("descr")).second);
+    ATF_REQUIRE(!tcs[0].has_cleanup());
+    ATF_REQUIRE_EQ("second", tcs[1].ident);
+    ATF_REQUIRE(tcs[1].has_cleanup());
+    ATF_REQUIRE_EQ(10, tcs[1].timeout());
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(parse_test_case_list__empty);
+ATF_TEST_CASE_BODY(parse_test_case_list__empty)
+{
+    std::istringstream is(
+        "Content-Type: application/X-atf-tp; version=\"1\"\n"
+        "\n");
+    ATF_REQUIRE(atf::atf_run::parse_test_case_list(is).empty());
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(parse_test_case_list__errors);
+ATF_TEST_CASE_BODY(parse_test_case_list__errors)
+{
+    const char* inputs[] = {
+        "",
+        "Content-Type: application/X-atf-tp; version=\"2\"\n\nident: a\n",
+        "Content-Type: application/X-atf-tp; version=\"1\"\nident: a\n",
+        "Content-Type: application/X-atf-tp; version=\"1\"\n\ndescr: a\n",
+        "Content-Type: application/X-atf-tp; version=\"1\"\n\nident a\n",
+        NULL
+    };
+    for (const char** input = inputs; *input != NULL; input++) {
+        std::istringstream is(*input);
+        ATF_REQUIRE_THROW(std::runtime_error,
+                          atf::atf_run::parse_test_case_list(is));
+    }
+}
+
+// ------------------------------------------------------------------------
+// Test cases for the "check_requirements" function.
+// ------------------------------------------------------------------------
+
+ATF_TEST_CASE_WITHOUT_HEAD(check_requirements__none);
+ATF_TEST_CASE_BODY(check_requirements__none)
+{
+    atf::atf_run::vars_map md, config;
+    md["descr"] = "Nothing to check";
+    ATF_REQUIRE_EQ("", atf::atf_run::check_requirements(md, config));
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(check_requirements__config);
+ATF_TEST_CASE_BODY(check_requirements__config)
+{
+    atf::atf_run::vars_map md, config;
+    md["require.config"] = "var1 var2";
+    config["var1"] = "value";
+    ATF_REQUIRE_EQ("Required configuration property 'var2' not defined",
+                   atf::atf_run::check_requirements(md, config));
+    config["var2"] = "";
+    ATF_REQUIRE_EQ("", atf::atf_run::check_requirements(md, config));
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(check_requirements__files);
+ATF_TEST_CASE_BODY(check_requirements__files)
+{
+    atf::atf_run::vars_map md, config;
+    md["require.files"] = "/";
+    ATF_REQUIRE_EQ("", atf::atf_run::check_requirements(md, config));
+    md["require.files"] = "/ /non-existent/file";
+    ATF_REQUIRE_EQ("Required file '/non-existent/file' not found",
+                   atf::atf_run::check_requirements(md, config));
+    md["require.files"] = "relative";
+    ATF_REQUIRE_MATCH("Relative path 'relative'",
+                      atf::atf_run::check_requirements(md, config));
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(check_requirements__progs);
+ATF_TEST_CASE_BODY(check_requirements__progs)
+{
+    atf::atf_run::vars_map md, config;
+    md["require.progs"] = "sh";
+    ATF_REQUIRE_EQ("", atf::atf_run::check_requirements(md, config));
+    md["require.progs"] = "sh non-existent-program";
+    ATF_REQUIRE_EQ("Required program 'non-existent-program' not found in "
+                   "the PATH",
+                   atf::atf_run::check_requirements(md, config));
+    md["require.progs"] = "/non-existent/program";
+    ATF_REQUIRE_EQ("Required program '/non-existent/program' not found",
+                   atf::atf_run::check_requirements(md, config));
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(check_requirements__user);
+ATF_TEST_CASE_BODY(check_requirements__user)
+{
+    atf::atf_run::vars_map md, config;
+    md["require.user"] = ::geteuid() == 0 ? "root" : "unprivileged";
+    ATF_REQUIRE_EQ("", atf::atf_run::check_requirements(md, config));
+    md["require.user"] = ::geteuid() == 0 ? "unprivileged" : "root";
+    ATF_REQUIRE_MATCH("^Requires ",
+                      atf::atf_run::check_requirements(md, config));
+}
+
+// ------------------------------------------------------------------------
+// Test cases for the "calculate_result" function.
+// ------------------------------------------------------------------------
+
+ATF_TEST_CASE_WITHOUT_HEAD(calculate_result__no_file);
+ATF_TEST_CASE_BODY(calculate_result__no_file)
+{
+    check_result(test_result::BROKEN, "Premature exit.*code 3",
+                 atf::atf_run::calculate_result(NULL, make_status(3, 0),
+                                                false));
+    check_result(test_result::BROKEN, "Premature exit.*signal",
+                 atf::atf_run::calculate_result(NULL,
+                                                make_status(0, SIGKILL),
+                                                false));
+    check_result(test_result::BROKEN, "body timed out",
+                 atf::atf_run::calculate_result(NULL,
+                                                make_status(0, SIGKILL),
+                                                true));
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(calculate_result__plain);
+ATF_TEST_CASE_BODY(calculate_result__plain)
+{
+    const int ok = make_status(EXIT_SUCCESS, 0);
+    const int fail = make_status(EXIT_FAILURE, 0);
+
+    check_result(test_result::PASSED, "^$", result_of("passed\n", ok));
+    check_result(test_result::BROKEN, "should have reported success",
+                 result_of("passed\n", fail));
+    check_result(test_result::FAILED, "^Oops$",
+                 result_of("failed: Oops\n", fail));
+    check_result(test_result::BROKEN, "should have reported failure",
+                 result_of("failed: Oops\n", ok));
+    check_result(test_result::SKIPPED, "^Not now$",
+                 result_of("skipped: Not now\n", ok));
+    check_result(test_result::BROKEN, "^Bad$", result_of("broken: Bad", ok));
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(calculate_result__expected);
+ATF_TEST_CASE_BODY(calculate_result__expected)
+{
+    const int ok = make_status(EXIT_SUCCESS, 0);
+    const int exit3 = make_status(3, 0);
+    const int killed = make_status(0, SIGKILL);
+
+    check_result(test_result::EXPECTED_FAILURE, "^Known$",
+                 result_of("expected_failure: Known\n", ok));
+    check_result(test_result::EXPECTED_FAILURE, "^Known$",
+                 result_of("expected_exit(3): Known\n", exit3));
+    check_result(test_result::FAILED, "Expected clean exit",
+                 result_of("expected_exit(3): Known\n", ok));
+    check_result(test_result::EXPECTED_FAILURE, "^Known$",
+                 result_of("expected_exit: Known\n", ok));
+    check_result(test_result::EXPECTED_FAILURE, "^Known$",
+                 result_of("expected_signal(9): Known\n", killed));
+    check_result(test_result::FAILED, "Expected signal",
+                 result_of("expected_signal: Known\n", exit3));
+    check_result(test_result::EXPECTED_FAILURE, "^Known$",
+                 result_of("expected_death: Known\n", killed));
+    check_result(test_result::EXPECTED_FAILURE, "^Hangs$",
+                 result_of("expected_timeout: Hangs\n", killed, true));
+    check_result(test_result::FAILED, "expected to hang",
+                 result_of("expected_timeout: Hangs\n", ok));
+    check_result(test_result::BROKEN, "body timed out",
+                 result_of("passed\n", killed, true));
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(calculate_result__invalid);
+ATF_TEST_CASE_BODY(calculate_result__invalid)
+{
+    const int ok = make_status(EXIT_SUCCESS, 0);
+
+    const char* inputs[] = {
+        "",
+        "passed: with reason\n",
+        "failed\n",
+        "failed: \n",
+        "expected_exit(3: Bad\n",
+        "expected_exit(a): Bad\n",
+        "unknown: Bad\n",
+        NULL
+    };
+    for (const char** input = inputs; *input != NULL; input++)
+        check_result(test_result::BROKEN, "^Invalid results file",
+                     result_of(*input, ok));
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(calculate_cleanup_result);
+ATF_TEST_CASE_BODY(calculate_cleanup_result)
+{
+    const int ok = make_status(EXIT_SUCCESS, 0);
+    const int fail = make_status(EXIT_FAILURE, 0);
+    const test_result passed(test_result::PASSED, "");
+    const test_result failed(test_result::FAILED, "Body failed");
+
+    check_result(test_result::PASSED, "^$",
+                 atf::atf_run::calculate_cleanup_result(passed, ok, false));
+    check_result(test_result::BROKEN, "cleanup did not terminate.*code 1",
+                 atf::atf_run::calculate_cleanup_result(passed, fail,
+                                                        false));
+    check_result(test_result::BROKEN, "cleanup timed out",
+                 atf::atf_run::calculate_cleanup_result(passed, ok, true));
+    check_result(test_result::FAILED, "^Body failed$",
+                 atf::atf_run::calculate_cleanup_result(failed, fail,
+                                                        false));
+}
+
+// ------------------------------------------------------------------------
+// Main.
+// ------------------------------------------------------------------------
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    // Add the test cases for the "test_case" class.
+    ATF_ADD_TEST_CASE(tcs, test_case__md);
+    ATF_ADD_TEST_CASE(tcs, parse_test_case_list__ok);
+    ATF_ADD_TEST_CASE(tcs, parse_test_case_list__empty);
+    ATF_ADD_TEST_CASE(tcs, parse_test_case_list__errors);
+
+    // Add the test cases for the "check_requirements" function.
+    ATF_ADD_TEST_CASE(tcs, check_requirements__none);
+    ATF_ADD_TEST_CASE(tcs, check_requirements__config);
+    ATF_ADD_TEST_CASE(tcs, check_requirements__files);
+    ATF_ADD_TEST_CASE(tcs, check_requirements__progs);
+    ATF_ADD_TEST_CASE(tcs, check_requirements__user);
+
+    // Add the test cases for the "calculate_result" function.
+    ATF_ADD_TEST_CASE(tcs, calculate_result__no_file);
+    ATF_ADD_TEST_CASE(tcs, calculate_result__plain);
+    ATF_ADD_TEST_CASE(tcs, calculate_result__expected);
+    ATF_ADD_TEST_CASE(tcs, calculate_result__invalid);
+    ATF_ADD_TEST_CASE(tcs, calculate_cleanup_result);
+}
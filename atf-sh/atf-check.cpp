@@ -25,14 +25,18 @@
 
 extern "C" {
 #include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/time.h>
 #include <sys/wait.h>
 
 #include <limits.h>
 #include <signal.h>
+#include <time.h>
 #include <unistd.h>
 }
 
 #include <cerrno>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
@@ -355,6 +359,104 @@ execute_with_shell(char* const* argv)
     return execute(sh_argv);
 }
 
+static
+std::string
+format_timespec(const struct timespec& ts)
+{
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%lld.%09ld",
+                  static_cast< long long >(ts.tv_sec), ts.tv_nsec);
+    return buf;
+}
+
+static
+std::string
+format_timeval(const struct timeval& tv)
+{
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%lld.%06ld",
+                  static_cast< long long >(tv.tv_sec),
+                  static_cast< long >(tv.tv_usec));
+    return buf;
+}
+
+static
+struct timeval
+timeval_sub(const struct timeval& t1, const struct timeval& t2)
+{
+    struct timeval diff;
+    diff.tv_sec = t1.tv_sec - t2.tv_sec;
+    diff.tv_usec = t1.tv_usec - t2.tv_usec;
+    if (diff.tv_usec < 0) {
+        diff.tv_sec--;
+        diff.tv_usec += 1000000;
+    }
+    return diff;
+}
+
+static
+struct timeval
+timespec_sub(const struct timespec& t1, const struct timespec& t2)
+{
+    struct timeval diff;
+    diff.tv_sec = t1.tv_sec - t2.tv_sec;
+    diff.tv_usec = (t1.tv_nsec - t2.tv_nsec) / 1000;
+    if (diff.tv_usec < 0) {
+        diff.tv_sec--;
+        diff.tv_usec += 1000000;
+    }
+    return diff;
+}
+
+//
+// Writes a single profiling record describing the execution of a command.
+//
+// The record is a single line of tab-separated fields: the monotonic start
+// and end times, the elapsed wall time, the user and system times consumed
+// by the command, the largest maximum resident set size of the children
+// waited for so far (RUSAGE_CHILDREN does not report it per child), its
+// termination status and the command line itself.  The file is truncated
+// first so that the caller can easily pick up the record.
+//
+static
+void
+write_profile_record(const std::string& file, const struct timespec& start,
+                     const struct timespec& end, const struct rusage& before,
+                     const struct rusage& after,
+                     const atf::check::check_result& r,
+                     const std::string& cmdline)
+{
+    std::ofstream os(file.c_str(), std::ios::trunc);
+    if (!os)
+        throw std::runtime_error("Failed to open profile file " + file);
+
+    std::string status;
+    if (r.exited())
+        status = "exit:" + atf::text::to_string(r.exitcode());
+    else if (r.signaled())
+        status = "signal:" + atf::text::to_string(r.termsig());
+    else
+        status = "unknown";
+
+    std::string flat_cmdline = cmdline;
+    for (std::string::iterator iter = flat_cmdline.begin();
+         iter != flat_cmdline.end(); iter++) {
+        if (*iter == '\t' || *iter == '\n')
+            *iter = ' ';
+    }
+
+    os << format_timespec(start) << '\t'
+       << format_timespec(end) << '\t'
+       << format_timeval(timespec_sub(end, start)) << '\t'
+       << format_timeval(timeval_sub(after.ru_utime, before.ru_utime)) << '\t'
+       << format_timeval(timeval_sub(after.ru_stime, before.ru_stime)) << '\t'
+       << after.ru_maxrss << '\t'
+       << status << '\t'
+       << flat_cmdline << '\n';
+    if (!os)
+        throw std::runtime_error("Failed to write profile file " + file);
+}
+
 static
 void
 cat_file(const atf::fs::path& path)
@@ -694,6 +796,7 @@ namespace {
 
 class atf_check : public atf::application::app {
     bool m_xflag;
+    std::string m_profile_file;
 
     std::vector< status_check > m_status_checks;
     std::vector< output_check > m_stdout_checks;
@@ -764,6 +867,8 @@ atf_check::specific_options(void)
     opts.insert(option('e', "action:arg", "Handle stderr. Action must be "
                 "one of: empty ignore file:<path> inline:<val> match:regexp "
                 "save:<path>"));
+    opts.insert(option('p', "file", "Write timing and resource usage "
+                "information about the command to file"));
     opts.insert(option('x', "", "Execute command as a shell command"));
 
     return opts;
@@ -785,6 +890,10 @@ atf_check::process_option(int ch, const char* arg)
         m_stderr_checks.push_back(parse_output_check_arg(arg));
         break;
 
+    case 'p':
+        m_profile_file = arg;
+        break;
+
     case 'x':
         m_xflag = true;
         break;
@@ -802,9 +911,23 @@ atf_check::main(void)
 
     int status = EXIT_FAILURE;
 
+    struct timespec start, end;
+    struct rusage before, after;
+    if (!m_profile_file.empty()) {
+        ::getrusage(RUSAGE_CHILDREN, &before);
+        ::clock_gettime(CLOCK_MONOTONIC, &start);
+    }
+
     std::auto_ptr< atf::check::check_result > r =
         m_xflag ? execute_with_shell(m_argv) : execute(m_argv);
 
+    if (!m_profile_file.empty()) {
+        ::clock_gettime(CLOCK_MONOTONIC, &end);
+        ::getrusage(RUSAGE_CHILDREN, &after);
+        write_profile_record(m_profile_file, start, end, before, after, *r,
+                             flatten_argv(m_argv));
+    }
+
     if (m_status_checks.empty())
         m_status_checks.push_back(status_check(sc_exit, false, EXIT_SUCCESS));
     else if (m_status_checks.size() > 1) {
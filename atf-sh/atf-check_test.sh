@@ -389,6 +389,30 @@ stdin_body()
         atf_fail "atf-check does not seem to respect stdin"
 }
 
+atf_test_case pflag
+pflag_head()
+{
+    atf_set "descr" "Tests for the -p option"
+}
+pflag_body()
+{
+    ${Atf_Check} -p record -o ignore -s exit:3 -x 'exit 3' || \
+        atf_fail "atf-check failed"
+    cat record
+    test $(wc -l <record) -eq 1 || atf_fail "More than one record written"
+    cut -f 1-5 record | tr '\t' ' ' | \
+        grep '^[0-9]*\.[0-9]* [0-9]*\.[0-9]* [0-9.]* [0-9.]* [0-9.]*$' \
+        >/dev/null || atf_fail "Times not written"
+    test "$(cut -f 7 record)" = "exit:3" || atf_fail "Status not written"
+    test "$(cut -f 8 record)" = "exit 3" || atf_fail "Command not written"
+
+    ${Atf_Check} -p record -s signal:kill -x 'kill -9 $$' || \
+        atf_fail "atf-check failed"
+    cat record
+    test $(wc -l <record) -eq 1 || atf_fail "Record not truncated"
+    test "$(cut -f 7 record)" = "signal:9" || atf_fail "Signal not recorded"
+}
+
 atf_test_case invalid_umask
 invalid_umask_head()
 {
@@ -435,6 +459,8 @@ atf_init_test_cases()
 
     atf_add_test_case stdin
 
+    atf_add_test_case pflag
+
     atf_add_test_case invalid_umask
 }
 
@@ -183,6 +183,148 @@ flush_stdout_on_death_body()
         || atf_fail 'Second command not in output'
 }
 
+atf_test_case profile
+profile_head()
+{
+    atf_set "descr" "Verifies that atf_check records the timing of each" \
+                    "call when ATF_SH_PROFILE is set"
+}
+profile_body()
+{
+    h="$(atf_get_srcdir)/misc_helpers -s $(atf_get_srcdir)"
+
+    atf_check -s eq:1 -o ignore -e ignore -x \
+              "ATF_SH_PROFILE=prof ${h} atf_check_profile"
+    test -f prof/misc_helpers.atf_check_profile.trace || \
+        atf_fail "The trace file was not created"
+    test -f prof/misc_helpers.atf_check_profile.report || \
+        atf_fail "The report file was not created"
+
+    atf_check -s eq:0 -o inline:'4\n' -e empty \
+        -x 'wc -l <prof/misc_helpers.atf_check_profile.trace | tr -d " "'
+    atf_check -s eq:0 -o inline:'1 2 3 4\n' -e empty \
+        -x 'cut -f 1 prof/misc_helpers.atf_check_profile.trace | xargs'
+    atf_check -s eq:0 -o match:'exit:1' -e empty \
+        grep 'false$' prof/misc_helpers.atf_check_profile.trace
+
+    sed -n 2p prof/misc_helpers.atf_check_profile.report >slowest
+    atf_check -s eq:0 -o match:'^ *2 .*exit:0 .*sleep 1$' -e empty cat slowest
+}
+
+atf_test_case profile_trap
+profile_trap_head()
+{
+    atf_set "descr" "Verifies that profiling does not interfere with an" \
+                    "EXIT trap installed by the body"
+}
+profile_trap_body()
+{
+    h="$(atf_get_srcdir)/misc_helpers -s $(atf_get_srcdir)"
+
+    atf_check -s eq:0 -o match:'^user trap ran$' -e ignore -x \
+              "ATF_SH_PROFILE=prof ${h} atf_check_profile_trap"
+    atf_check -s eq:0 -o match:'^ *1 .*exit:0 .*true$' -e empty \
+        sed -n 2p prof/misc_helpers.atf_check_profile_trap.report
+}
+
+atf_test_case no_profile
+no_profile_head()
+{
+    atf_set "descr" "Verifies that atf_check does not record anything" \
+                    "when ATF_SH_PROFILE is not set"
+}
+no_profile_body()
+{
+    h="$(atf_get_srcdir)/misc_helpers -s $(atf_get_srcdir)"
+
+    atf_check -s eq:0 -o ignore -e ignore -x \
+              "unset ATF_SH_PROFILE; ${h} atf_check_info_ok"
+    # Not run through atf_check: its temporary files may live in the work
+    # directory when TMPDIR points there.
+    test -z "$(ls)" || atf_fail "Unexpected files created: $(ls)"
+}
+
+atf_test_case parallel_ok
+parallel_ok_head()
+{
+    atf_set "descr" "Verifies that atf_check calls within a parallel block" \
+                    "report their output in submission order"
+}
+parallel_ok_body()
+{
+    h="$(atf_get_srcdir)/misc_helpers -s $(atf_get_srcdir)"
+
+    atf_check -s eq:0 -o save:stdout -e save:stderr -x \
+              "TMPDIR=$(pwd) ${h} -r resfile atf_parallel_ok"
+    grep 'Executing command.*echo line' stdout | sed -e 's,.*echo line \([0-9]\).*,\1,' \
+        | tr '\n' ' ' >order
+    atf_check -s eq:0 -o inline:'1 2 3 4 5 6 ' -e empty cat order
+    atf_check -s eq:0 -o match:'Executing command.*false' -e empty \
+        tail -n 1 stdout
+    atf_check -s eq:1 -o empty -e empty -x 'ls | grep atf-parallel'
+}
+
+atf_test_case parallel_fail
+parallel_fail_head()
+{
+    atf_set "descr" "Verifies that all failures within a parallel block" \
+                    "are reported at once"
+}
+parallel_fail_body()
+{
+    h="$(atf_get_srcdir)/misc_helpers -s $(atf_get_srcdir)"
+
+    atf_check -s eq:1 -o save:stdout -e save:stderr -x \
+              "TMPDIR=$(pwd) ${h} -r resfile atf_parallel_fail"
+    atf_check -s eq:0 -o ignore -e empty \
+        grep '^failed: 2 of 5 parallel atf-check calls failed (#2 #4)' resfile
+    atf_check -s eq:0 -o ignore -e empty grep 'first failure' stderr
+    atf_check -s eq:0 -o ignore -e empty \
+        grep 'stdout does not match expected value' stderr
+    atf_check -s eq:0 -o ignore -e empty \
+        grep '^Parallel atf_check #2 failed' stderr
+    atf_check -s eq:0 -o ignore -e empty \
+        grep '^Parallel atf_check #4 failed: -o inline:foo' stderr
+    atf_check -s eq:1 -o empty -e empty grep 'Not reached' stdout
+    atf_check -s eq:1 -o empty -e empty -x 'ls | grep atf-parallel'
+}
+
+atf_test_case parallel_skip
+parallel_skip_head()
+{
+    atf_set "descr" "Verifies that the files of a parallel block are" \
+                    "removed if the test case terminates within it"
+}
+parallel_skip_body()
+{
+    h="$(atf_get_srcdir)/misc_helpers -s $(atf_get_srcdir)"
+
+    atf_check -s eq:0 -o ignore -e ignore -x \
+              "TMPDIR=$(pwd) ${h} -r resfile atf_parallel_skip"
+    atf_check -s eq:0 -o ignore -e empty \
+        grep '^skipped: Leaving within the block' resfile
+    atf_check -s eq:1 -o empty -e empty -x 'ls | grep atf-parallel'
+}
+
+atf_test_case parallel_concurrency
+parallel_concurrency_head()
+{
+    atf_set "descr" "Verifies that atf_check calls within a parallel block" \
+                    "run concurrently and that the number of jobs is bounded"
+}
+parallel_concurrency_body()
+{
+    h="$(atf_get_srcdir)/misc_helpers -s $(atf_get_srcdir)"
+
+    mkdir two one
+    atf_check -s eq:0 -o ignore -e ignore -x \
+        "cd two && ${h} -v jobs=2 atf_parallel_barrier"
+    atf_check -s eq:1 -o ignore -e ignore -x \
+        "cd one && ${h} -v jobs=1 -r ../resfile atf_parallel_barrier"
+    atf_check -s eq:0 -o ignore -e empty \
+        grep '^failed: 1 of 2 parallel' resfile
+}
+
 atf_init_test_cases()
 {
     atf_add_test_case info_ok
@@ -192,6 +334,13 @@ atf_init_test_cases()
     atf_add_test_case null_stderr
     atf_add_test_case equal
     atf_add_test_case flush_stdout_on_death
+    atf_add_test_case profile
+    atf_add_test_case profile_trap
+    atf_add_test_case no_profile
+    atf_add_test_case parallel_ok
+    atf_add_test_case parallel_fail
+    atf_add_test_case parallel_skip
+    atf_add_test_case parallel_concurrency
 }
 
 # vim: syntax=sh:expandtab:shiftwidth=4:softtabstop=4
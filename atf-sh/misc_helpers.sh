@@ -155,6 +155,94 @@ atf_check_flush_stdout_body()
     done
 }
 
+atf_test_case atf_check_profile
+atf_check_profile_head()
+{
+    atf_set "descr" "Helper test case for the t_atf_check test program"
+}
+atf_check_profile_body()
+{
+    atf_check true
+    atf_check -x 'sleep 1'
+    atf_check -s exit:1 false
+    atf_check -s exit:0 false
+}
+
+atf_test_case atf_check_profile_trap
+atf_check_profile_trap_head()
+{
+    atf_set "descr" "Helper test case for the t_atf_check test program"
+}
+atf_check_profile_trap_body()
+{
+    trap 'echo "user trap ran"' EXIT
+    atf_check true
+    atf_skip "Done"
+}
+
+atf_test_case atf_parallel_ok
+atf_parallel_ok_head()
+{
+    atf_set "descr" "Helper test case for the t_atf_check test program"
+}
+atf_parallel_ok_body()
+{
+    atf_parallel_begin 3
+    for i in 1 2 3 4 5 6; do
+        atf_check -o inline:"line ${i}\n" echo line ${i}
+    done
+    atf_parallel_end
+    atf_check -s exit:1 false
+}
+
+atf_test_case atf_parallel_fail
+atf_parallel_fail_head()
+{
+    atf_set "descr" "Helper test case for the t_atf_check test program"
+}
+atf_parallel_fail_body()
+{
+    atf_parallel_begin
+    atf_check true
+    atf_check -x 'echo first failure; exit 1'
+    atf_check true
+    atf_check -o inline:"foo\n" echo bar
+    atf_check true
+    atf_parallel_end
+    echo "Not reached"
+}
+
+atf_test_case atf_parallel_skip
+atf_parallel_skip_head()
+{
+    atf_set "descr" "Helper test case for the t_atf_check test program"
+}
+atf_parallel_skip_body()
+{
+    atf_parallel_begin
+    atf_check -x 'sleep 1'
+    atf_check true
+    atf_skip "Leaving within the block"
+}
+
+atf_test_case atf_parallel_barrier
+atf_parallel_barrier_head()
+{
+    atf_set "descr" "Helper test case for the t_atf_check test program"
+}
+atf_parallel_barrier_body()
+{
+    # Each command waits for the other one to start, so they can only
+    # succeed if they run concurrently.
+    atf_parallel_begin $(atf_config_get jobs)
+    for i in a b; do
+        atf_check -x "touch ${i}; for i in 1 2 3 4 5; do" \
+            "[ \$(ls | grep -c '^[ab]\$') -eq 2 ] && exit 0; sleep 1;" \
+            "done; exit 1"
+    done
+    atf_parallel_end
+}
+
 # -------------------------------------------------------------------------
 # Helper tests for "t_config".
 # -------------------------------------------------------------------------
@@ -286,6 +374,12 @@ atf_init_test_cases()
     atf_add_test_case atf_check_equal_eval_ok
     atf_add_test_case atf_check_equal_eval_fail
     atf_add_test_case atf_check_flush_stdout
+    atf_add_test_case atf_check_profile
+    atf_add_test_case atf_check_profile_trap
+    atf_add_test_case atf_parallel_ok
+    atf_add_test_case atf_parallel_fail
+    atf_add_test_case atf_parallel_skip
+    atf_add_test_case atf_parallel_barrier
 
     # Add helper tests for t_config.
     atf_add_test_case config_get
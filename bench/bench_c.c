@@ -0,0 +1,296 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atf-c.h>
+
+#include "atf-c/check.h"
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/fs.h"
+#include "atf-c/detail/list.h"
+#include "atf-c/detail/map.h"
+#include "atf-c/detail/process.h"
+#include "bench/harness.h"
+
+/* ---------------------------------------------------------------------
+ * Benchmarks for the "atf_dynstr" type.
+ * --------------------------------------------------------------------- */
+
+static
+void
+dynstr_init_fmt(size_t iterations)
+{
+    for (; iterations > 0; iterations--) {
+        atf_dynstr_t str;
+
+        bench_check(atf_dynstr_init_fmt(&str, "%s-%d", "value", 1234));
+        atf_dynstr_fini(&str);
+    }
+}
+
+static
+void
+dynstr_append_fmt(size_t iterations)
+{
+    for (; iterations > 0; iterations--) {
+        atf_dynstr_t str;
+        int i;
+
+        bench_check(atf_dynstr_init(&str));
+        for (i = 0; i < 64; i++)
+            bench_check(atf_dynstr_append_fmt(&str, "line %d\n", i));
+        atf_dynstr_fini(&str);
+    }
+}
+
+/* ---------------------------------------------------------------------
+ * Benchmarks for the "atf_list" type.
+ * --------------------------------------------------------------------- */
+
+static
+void
+list_append_iterate(size_t iterations)
+{
+    static char item[] = "item";
+
+    for (; iterations > 0; iterations--) {
+        atf_list_citer_t iter;
+        atf_list_t list;
+        size_t count = 0;
+        int i;
+
+        bench_check(atf_list_init(&list));
+        for (i = 0; i < 64; i++)
+            bench_check(atf_list_append(&list, item, false));
+        atf_list_for_each_c(iter, &list)
+            count++;
+        if (count != 64)
+            abort();
+        atf_list_fini(&list);
+    }
+}
+
+/* ---------------------------------------------------------------------
+ * Benchmarks for the "atf_map" type.
+ * --------------------------------------------------------------------- */
+
+static const char *const Map_keys[] = {
+    "descr", "has.cleanup", "require.arch", "require.config",
+    "require.files", "require.machine", "require.memory", "require.progs",
+    "require.user", "timeout", "X-custom-1", "X-custom-2",
+};
+#define NMAP_KEYS (sizeof(Map_keys) / sizeof(Map_keys[0]))
+
+static
+void
+map_insert_find(size_t iterations)
+{
+    static char value[] = "value";
+
+    for (; iterations > 0; iterations--) {
+        atf_map_t map;
+        size_t i;
+
+        bench_check(atf_map_init(&map));
+        for (i = 0; i < NMAP_KEYS; i++)
+            bench_check(atf_map_insert(&map, Map_keys[i], value, false));
+        for (i = 0; i < NMAP_KEYS; i++) {
+            if (atf_equal_map_citer_map_citer(atf_map_find_c(&map,
+                Map_keys[i]), atf_map_end_c(&map)))
+                abort();
+        }
+        atf_map_fini(&map);
+    }
+}
+
+/* ---------------------------------------------------------------------
+ * Benchmarks for the "atf_fs_path" type.
+ * --------------------------------------------------------------------- */
+
+static
+void
+fs_path_init_fmt(size_t iterations)
+{
+    for (; iterations > 0; iterations--) {
+        atf_fs_path_t path;
+
+        bench_check(atf_fs_path_init_fmt(&path, "/usr//local/./tests/%s/",
+                                         "atf-c"));
+        atf_fs_path_fini(&path);
+    }
+}
+
+static
+void
+fs_path_branch_leaf(size_t iterations)
+{
+    atf_fs_path_t path;
+
+    bench_check(atf_fs_path_init_fmt(&path, "/usr/local/tests/atf/tc_test"));
+    for (; iterations > 0; iterations--) {
+        atf_fs_path_t branch;
+        atf_dynstr_t leaf;
+
+        bench_check(atf_fs_path_branch_path(&path, &branch));
+        bench_check(atf_fs_path_leaf_name(&path, &leaf));
+        atf_dynstr_fini(&leaf);
+        atf_fs_path_fini(&branch);
+    }
+    atf_fs_path_fini(&path);
+}
+
+static
+void
+fs_path_append(size_t iterations)
+{
+    for (; iterations > 0; iterations--) {
+        atf_fs_path_t path;
+
+        bench_check(atf_fs_path_init_fmt(&path, "/tmp/work"));
+        bench_check(atf_fs_path_append_fmt(&path, "dir%d/file", 5));
+        atf_fs_path_fini(&path);
+    }
+}
+
+/* ---------------------------------------------------------------------
+ * Benchmarks for the "atf_error" type.
+ * --------------------------------------------------------------------- */
+
+static
+void
+error_new_fmt(size_t iterations)
+{
+    for (; iterations > 0; iterations--)
+        atf_error_free(atf_error_new_fmt("bench", "Error %d in %s", 5, "x"));
+}
+
+static
+void
+error_libc(size_t iterations)
+{
+    for (; iterations > 0; iterations--)
+        atf_error_free(atf_libc_error(2, "Cannot open %s", "file"));
+}
+
+/* ---------------------------------------------------------------------
+ * Benchmarks for processes.
+ * --------------------------------------------------------------------- */
+
+static
+void
+exit_child(void *v ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+    _exit(EXIT_SUCCESS);
+}
+
+static
+void
+process_fork(size_t iterations)
+{
+    for (; iterations > 0; iterations--) {
+        atf_process_child_t child;
+        atf_process_status_t status;
+
+        bench_check(atf_process_fork(&child, exit_child, NULL, NULL, NULL));
+        bench_check(atf_process_child_wait(&child, &status));
+        atf_process_status_fini(&status);
+    }
+}
+
+static
+void
+process_exec_array(size_t iterations)
+{
+    const char *const argv[] = { "true", NULL };
+    atf_fs_path_t prog;
+
+    bench_check(atf_fs_path_init_fmt(&prog, "/bin/true"));
+    for (; iterations > 0; iterations--) {
+        atf_process_status_t status;
+
+        bench_check(atf_process_exec_array(&status, &prog, argv, NULL, NULL,
+                                           NULL));
+        atf_process_status_fini(&status);
+    }
+    atf_fs_path_fini(&prog);
+}
+
+static
+void
+check_exec_array(size_t iterations)
+{
+    const char *const argv[] = { "/bin/echo", "hello", NULL };
+
+    for (; iterations > 0; iterations--) {
+        atf_check_result_t result;
+
+        bench_check(atf_check_exec_array(argv, &result));
+        atf_check_result_fini(&result);
+    }
+}
+
+/* ---------------------------------------------------------------------
+ * Benchmarks for the utility functions.
+ * --------------------------------------------------------------------- */
+
+static
+void
+utils_grep_string(size_t iterations)
+{
+    for (; iterations > 0; iterations--) {
+        if (!atf_utils_grep_string("^[a-z]+: .*%s$", "result: passed", "ed"))
+            abort();
+    }
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+int
+main(int argc, char **argv)
+{
+    const int first = bench_init(argc, argv, "c");
+    bench_select(argc - first, argv + first);
+
+    bench_run("dynstr/init_fmt", dynstr_init_fmt);
+    bench_run("dynstr/append_fmt_64", dynstr_append_fmt);
+    bench_run("list/append_iterate_64", list_append_iterate);
+    bench_run("map/insert_find_12", map_insert_find);
+    bench_run("fs_path/init_fmt", fs_path_init_fmt);
+    bench_run("fs_path/branch_leaf", fs_path_branch_leaf);
+    bench_run("fs_path/append_fmt", fs_path_append);
+    bench_run("error/new_fmt", error_new_fmt);
+    bench_run("error/libc", error_libc);
+    bench_run("process/fork", process_fork);
+    bench_run("process/exec_array", process_exec_array);
+    bench_run("check/exec_array", check_exec_array);
+    bench_run("utils/grep_string", utils_grep_string);
+
+    return EXIT_SUCCESS;
+}
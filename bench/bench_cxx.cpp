@@ -0,0 +1,150 @@
+// Copyright (c) 2026 The NetBSD Foundation, Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+// CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+// IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "atf-c++/check.hpp"
+#include "atf-c++/detail/fs.hpp"
+#include "atf-c++/detail/process.hpp"
+#include "atf-c++/detail/text.hpp"
+#include "atf-c++/utils.hpp"
+
+#include "bench/harness.h"
+
+// ------------------------------------------------------------------------
+// Benchmarks for the "fs::path" class.
+// ------------------------------------------------------------------------
+
+static void
+fs_path_construct(size_t iterations)
+{
+    for (; iterations > 0; iterations--) {
+        const atf::fs::path path("/usr//local/./tests/atf-c++/");
+        if (path.str().empty())
+            std::abort();
+    }
+}
+
+static void
+fs_path_branch_leaf(size_t iterations)
+{
+    const atf::fs::path path("/usr/local/tests/atf/tests_test");
+    for (; iterations > 0; iterations--) {
+        if (path.branch_path().str().empty() || path.leaf_name().empty())
+            std::abort();
+    }
+}
+
+static void
+fs_path_join(size_t iterations)
+{
+    const atf::fs::path base("/tmp/work");
+    for (; iterations > 0; iterations--) {
+        const atf::fs::path path = base / "dir5" / "file";
+        if (path.str().empty())
+            std::abort();
+    }
+}
+
+// ------------------------------------------------------------------------
+// Benchmarks for the text utilities.
+// ------------------------------------------------------------------------
+
+static void
+text_split(size_t iterations)
+{
+    for (; iterations > 0; iterations--) {
+        const std::vector< std::string > words =
+            atf::text::split("require.progs=/bin/ls /bin/cp /bin/mv", " ");
+        if (words.size() != 3)
+            std::abort();
+    }
+}
+
+static void
+text_to_type(size_t iterations)
+{
+    for (; iterations > 0; iterations--) {
+        if (atf::text::to_type< int >("12345") != 12345)
+            std::abort();
+    }
+}
+
+// ------------------------------------------------------------------------
+// Benchmarks for processes.
+// ------------------------------------------------------------------------
+
+static void
+check_exec(size_t iterations)
+{
+    const atf::process::argv_array argv("/bin/echo", "hello", NULL);
+    for (; iterations > 0; iterations--) {
+        std::auto_ptr< atf::check::check_result > result =
+            atf::check::exec(argv);
+        if (!result->exited())
+            std::abort();
+    }
+}
+
+// ------------------------------------------------------------------------
+// Benchmarks for the utility functions.
+// ------------------------------------------------------------------------
+
+static void
+utils_grep_string(size_t iterations)
+{
+    for (; iterations > 0; iterations--) {
+        if (!atf::utils::grep_string("^[a-z]+: .*ed$", "result: passed"))
+            std::abort();
+    }
+}
+
+// ------------------------------------------------------------------------
+// Main.
+// ------------------------------------------------------------------------
+
+int
+main(int argc, char** argv)
+{
+    const int first = bench_init(argc, argv, "c++");
+    bench_select(argc - first, argv + first);
+
+    bench_run("fs::path/construct", fs_path_construct);
+    bench_run("fs::path/branch_leaf", fs_path_branch_leaf);
+    bench_run("fs::path/join", fs_path_join);
+    bench_run("text/split", text_split);
+    bench_run("text/to_type", text_to_type);
+    bench_run("check/exec", check_exec);
+    bench_run("utils/grep_string", utils_grep_string);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+#! /bin/sh
+# Copyright (c) 2026 The NetBSD Foundation, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+# CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+# INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+# IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+# DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+# GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+# IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+# IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Compares two sets of results of `make bench` and flags the benchmarks
+# that got slower or that allocate more memory.
+
+Prog_Name=${0##*/}
+
+# Prints an error message about the command line and exits.
+usage_error() {
+    echo "${Prog_Name}: ${*}" 1>&2
+    echo "Usage: ${Prog_Name} [-t threshold] old.json new.json" 1>&2
+    exit 1
+}
+
+main() {
+    threshold=10
+    while getopts ':t:' arg; do
+        case "${arg}" in
+            t)
+                threshold="${OPTARG}"
+                ;;
+            :)
+                usage_error "Option -${OPTARG} requires an argument"
+                ;;
+            \?)
+                usage_error "Unknown option -${OPTARG}"
+                ;;
+        esac
+    done
+    shift $((${OPTIND} - 1))
+
+    [ ${#} -eq 2 ] || usage_error "Two result files are required"
+    [ -f "${1}" ] || usage_error "Cannot find ${1}"
+    [ -f "${2}" ] || usage_error "Cannot find ${2}"
+
+    awk -v threshold="${threshold}" '
+function field(line, name,    re, value) {
+    re = "\"" name "\": [^,}]*"
+    if (!match(line, re))
+        return ""
+    value = substr(line, RSTART + length(name) + 4,
+                   RLENGTH - length(name) - 4)
+    gsub(/"/, "", value)
+    return value
+}
+
+function key(line) {
+    return field(line, "language") ":" field(line, "name")
+}
+
+BEGIN {
+    printf("%-32s %12s %12s %8s %9s %9s\n", "benchmark", "old ns/op",
+           "new ns/op", "delta", "old allocs", "new allocs")
+    regressions = 0
+}
+
+NR == FNR {
+    k = key($0)
+    old_median[k] = field($0, "median_ns")
+    old_allocs[k] = field($0, "allocs_per_op")
+    next
+}
+
+{
+    k = key($0)
+    median = field($0, "median_ns")
+    allocs = field($0, "allocs_per_op")
+    if (!(k in old_median)) {
+        printf("%-32s %12s %12.1f %8s %9s %9s  new\n", k, "-", median, "-",
+               "-", allocs)
+        next
+    }
+
+    delta = (median - old_median[k]) * 100 / old_median[k]
+    status = ""
+    if (delta > threshold) {
+        status = "  REGRESSION"
+        regressions++
+    } else if (delta < -threshold) {
+        status = "  improvement"
+    }
+    if (allocs != "null" && old_allocs[k] != "null" &&
+        allocs - old_allocs[k] > 0.005) {
+        status = status "  MORE-ALLOCS"
+        regressions++
+    }
+    printf("%-32s %12.1f %12.1f %+7.1f%% %9s %9s%s\n", k, old_median[k],
+           median, delta, old_allocs[k], allocs, status)
+}
+
+END {
+    if (regressions > 0) {
+        printf("%d regression(s) found with a threshold of %s%%\n",
+               regressions, threshold)
+        exit 1
+    }
+}' "${1}" "${2}"
+}
+
+main "${@}"
+
+# vim: syntax=sh:expandtab:shiftwidth=4:softtabstop=4
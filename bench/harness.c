@@ -0,0 +1,274 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "bench/harness.h"
+
+#include <err.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "atf-c/detail/alloc.h"
+#include "atf-c/error.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static const char *Language = NULL;
+static FILE *Results = NULL;
+static char **Filters = NULL;
+static int Nfilters = 0;
+static size_t Samples = 15;
+static uint64_t Min_sample_ns = 20000000;
+
+/* Keeps the original standard output for the results and sends anything
+ * else printed there to /dev/null; some of the measured functions (e.g.
+ * atf_utils_grep_string) print diagnostics that would otherwise be mixed
+ * with the JSON lines. */
+static
+void
+setup_results(void)
+{
+    int fd, null;
+
+    fd = dup(STDOUT_FILENO);
+    if (fd == -1)
+        err(EXIT_FAILURE, "Cannot duplicate stdout");
+    Results = fdopen(fd, "w");
+    if (Results == NULL)
+        err(EXIT_FAILURE, "Cannot open results stream");
+
+    fflush(stdout);
+    null = open("/dev/null", O_WRONLY);
+    if (null == -1)
+        err(EXIT_FAILURE, "Cannot open /dev/null");
+    if (dup2(null, STDOUT_FILENO) == -1)
+        err(EXIT_FAILURE, "Cannot redirect stdout");
+    close(null);
+}
+
+static
+uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+        err(EXIT_FAILURE, "clock_gettime failed");
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static
+uint64_t
+time_iterations(bench_func_t func, const size_t iterations)
+{
+    const uint64_t start = now_ns();
+    func(iterations);
+    return now_ns() - start;
+}
+
+static
+int
+compare_doubles(const void *a, const void *b)
+{
+    const double da = *(const double *)a;
+    const double db = *(const double *)b;
+
+    return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+static
+bool
+selected(const char *name)
+{
+    int i;
+
+    if (Nfilters == 0)
+        return true;
+    for (i = 0; i < Nfilters; i++) {
+        if (strstr(name, Filters[i]) != NULL)
+            return true;
+    }
+    return false;
+}
+
+/* Finds the number of iterations that makes a sample last at least the
+ * minimum sample time.  This also warms up the caches, the allocator and
+ * the dynamic linker before any measurement is recorded. */
+static
+size_t
+calibrate(bench_func_t func)
+{
+    size_t iterations = 1;
+
+    for (;;) {
+        const uint64_t elapsed = time_iterations(func, iterations);
+        if (elapsed >= Min_sample_ns)
+            break;
+        if (elapsed < Min_sample_ns / 100)
+            iterations *= 10;
+        else
+            iterations = (size_t)((double)iterations * Min_sample_ns /
+                                  elapsed * 1.2) + 1;
+    }
+    return iterations;
+}
+
+/* ---------------------------------------------------------------------
+ * Free functions.
+ * --------------------------------------------------------------------- */
+
+/** Parses the options of a benchmark program.
+ *
+ * Accepts -r to set the number of samples and -t to set the minimum time
+ * of each sample in milliseconds.  Returns the index of the first
+ * argument that is not an option. */
+int
+bench_init(int argc, char **argv, const char *language)
+{
+    int ch;
+
+    Language = language;
+    while ((ch = getopt(argc, argv, ":r:t:")) != -1) {
+        switch (ch) {
+        case 'r':
+            Samples = strtoul(optarg, NULL, 10);
+            if (Samples == 0)
+                errx(EXIT_FAILURE, "Invalid number of samples %s", optarg);
+            break;
+
+        case 't':
+            Min_sample_ns = strtoull(optarg, NULL, 10) * 1000000;
+            if (Min_sample_ns == 0)
+                errx(EXIT_FAILURE, "Invalid sample time %s", optarg);
+            break;
+
+        case ':':
+            errx(EXIT_FAILURE, "Option -%c requires an argument", optopt);
+
+        default:
+            errx(EXIT_FAILURE, "Unknown option -%c", optopt);
+        }
+    }
+
+    setup_results();
+    return optind;
+}
+
+/** Restricts the benchmarks to run to those whose name contains any of
+ * the given strings.  All benchmarks run if there are none. */
+void
+bench_select(int nfilters, char **filters)
+{
+    Nfilters = nfilters;
+    Filters = filters;
+}
+
+/** Sets the language reported along the results of the benchmarks that
+ * run next, for programs that measure code written in several. */
+void
+bench_set_language(const char *language)
+{
+    Language = language;
+}
+
+/** Runs a benchmark and prints its results as a JSON object on a line of
+ * its own.
+ *
+ * Times are reported per operation: the median and the 90th percentile
+ * across all samples.  The allocations per operation are averaged across
+ * all samples, or reported as null if they cannot be counted.
+ *
+ * Returns the median time per operation, or a negative value if the
+ * benchmark was not selected. */
+double
+bench_run(const char *name, bench_func_t func)
+{
+    double *per_op, median;
+    size_t iterations, i, allocs_before, allocs_after;
+    bool have_allocs;
+
+    if (!selected(name))
+        return -1.0;
+
+    iterations = calibrate(func);
+
+    per_op = malloc(Samples * sizeof(*per_op));
+    if (per_op == NULL)
+        err(EXIT_FAILURE, "Cannot allocate samples");
+
+    have_allocs = atf_alloc_count(&allocs_before);
+    for (i = 0; i < Samples; i++)
+        per_op[i] = (double)time_iterations(func, iterations) / iterations;
+    have_allocs = atf_alloc_count(&allocs_after) && have_allocs;
+
+    qsort(per_op, Samples, sizeof(*per_op), compare_doubles);
+    median = per_op[Samples / 2];
+
+    fprintf(Results, "{\"name\": \"%s\", \"language\": \"%s\", \"iterations\": %zu, "
+           "\"samples\": %zu, \"median_ns\": %.1f, \"p90_ns\": %.1f, ",
+           name, Language, iterations, Samples, median,
+           per_op[(Samples * 9 + 9) / 10 - 1]);
+    if (have_allocs)
+        fprintf(Results, "\"allocs_per_op\": %.2f}\n",
+               (double)(allocs_after - allocs_before) /
+               ((double)iterations * Samples));
+    else
+        fprintf(Results, "\"allocs_per_op\": null}\n");
+    fflush(Results);
+
+    free(per_op);
+    return median;
+}
+
+/** Prints a value computed from the results of other benchmarks, such as
+ * the cost of a unit of work obtained from the difference between two of
+ * them, in the same format as those. */
+void
+bench_derived(const char *name, double value_ns)
+{
+    fprintf(Results, "{\"name\": \"%s\", \"language\": \"%s\", "
+            "\"derived\": true, \"median_ns\": %.1f, "
+            "\"allocs_per_op\": null}\n", name, Language, value_ns);
+    fflush(Results);
+}
+
+/** Aborts the benchmark program if the given error is set. */
+void
+bench_check(atf_error_t error)
+{
+    if (atf_is_error(error)) {
+        char buf[1024];
+
+        atf_error_format(error, buf, sizeof(buf));
+        atf_error_free(error);
+        errx(EXIT_FAILURE, "%s", buf);
+    }
+}
@@ -0,0 +1,250 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+/* Measures the fixed cost that the libraries impose on every test case:
+ * starting the test program, registering and listing its test cases,
+ * running a trivial body, writing its results file and invoking its
+ * cleanup routine.  The test programs are generated by overhead.sh with
+ * different numbers of test cases so that the per-test-case cost can be
+ * derived from how the times grow. */
+
+#include "bench/harness.h"
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/fs.h"
+#include "atf-c/detail/process.h"
+
+struct program {
+    char *language;
+    unsigned long count;
+    atf_fs_path_t path;
+    atf_fs_path_t srcdir;
+    atf_fs_path_t resfile;
+
+    double list_ns;
+    double run_ns;
+    double body_cleanup_ns;
+};
+
+static struct program *Current = NULL;
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static
+void
+parse_program(const char *spec, struct program *p)
+{
+    char *language, *count, *path, *end;
+
+    language = strdup(spec);
+    if (language == NULL)
+        err(EXIT_FAILURE, "Cannot allocate program");
+    count = strchr(language, ':');
+    path = count == NULL ? NULL : strchr(count + 1, ':');
+    if (path == NULL)
+        errx(EXIT_FAILURE, "Invalid program %s; expected "
+             "language:count:path", spec);
+    *count++ = '\0';
+    *path++ = '\0';
+
+    p->language = language;
+    p->count = strtoul(count, &end, 10);
+    if (*end != '\0' || p->count == 0)
+        errx(EXIT_FAILURE, "Invalid number of test cases in %s", spec);
+    bench_check(atf_fs_path_init_fmt(&p->path, "%s", path));
+    bench_check(atf_fs_path_branch_path(&p->path, &p->srcdir));
+    bench_check(atf_fs_path_init_fmt(&p->resfile, "%s.res", path));
+    p->list_ns = p->run_ns = p->body_cleanup_ns = -1.0;
+}
+
+static
+void
+free_program(struct program *p)
+{
+    atf_fs_path_fini(&p->resfile);
+    atf_fs_path_fini(&p->srcdir);
+    atf_fs_path_fini(&p->path);
+    free(p->language);
+}
+
+static
+void
+exec_program(const char *const *argv)
+{
+    atf_process_status_t status;
+
+    bench_check(atf_process_exec_array(&status, &Current->path, argv, NULL,
+                                       NULL, NULL));
+    if (!atf_process_status_exited(&status) ||
+        atf_process_status_exitstatus(&status) != EXIT_SUCCESS)
+        errx(EXIT_FAILURE, "Test program %s failed",
+             atf_fs_path_cstring(&Current->path));
+    atf_process_status_fini(&status);
+}
+
+static
+void
+list(size_t iterations)
+{
+    const char *const argv[] = { atf_fs_path_cstring(&Current->path),
+        "-s", atf_fs_path_cstring(&Current->srcdir), "-l", NULL };
+
+    for (; iterations > 0; iterations--)
+        exec_program(argv);
+}
+
+static
+void
+run(size_t iterations)
+{
+    const char *const argv[] = { atf_fs_path_cstring(&Current->path),
+        "-s", atf_fs_path_cstring(&Current->srcdir),
+        "-r", atf_fs_path_cstring(&Current->resfile), "tc_1", NULL };
+
+    for (; iterations > 0; iterations--)
+        exec_program(argv);
+}
+
+static
+void
+body_cleanup(size_t iterations)
+{
+    const char *const cleanup_argv[] = { atf_fs_path_cstring(&Current->path),
+        "-s", atf_fs_path_cstring(&Current->srcdir), "tc_1:cleanup", NULL };
+
+    for (; iterations > 0; iterations--) {
+        run(1);
+        exec_program(cleanup_argv);
+    }
+}
+
+static
+double
+measure(const char *what, bench_func_t func)
+{
+    char name[128];
+
+    snprintf(name, sizeof(name), "%s/%lu/%s", Current->language,
+             Current->count, what);
+    return bench_run(name, func);
+}
+
+/* Prints the cost of each additional test case, computed from the times
+ * of the program with the fewest test cases in the same language. */
+static
+void
+derive(const struct program *p, const struct program *base)
+{
+    const double n = (double)(p->count - base->count);
+    char name[128];
+
+    bench_set_language(p->language);
+#define DERIVE(what, field) \
+    do { \
+        snprintf(name, sizeof(name), "%s/%lu/%s_per_tc", p->language, \
+                 p->count, what); \
+        bench_derived(name, (p->field - base->field) / n); \
+    } while (0)
+    DERIVE("list", list_ns);
+    DERIVE("run", run_ns);
+    DERIVE("body_cleanup", body_cleanup_ns);
+#undef DERIVE
+}
+
+static
+void
+usage_error(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-r samples] [-t sample-ms] "
+            "language:count:path ...\n", prog);
+    exit(EXIT_FAILURE);
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+int
+main(int argc, char **argv)
+{
+    struct program *programs;
+    int first, nprograms, i, j;
+
+    first = bench_init(argc, argv, "c");
+    /* Run the programs as kyua does, which also silences the warnings
+     * about running them standalone. */
+    if (setenv("__RUNNING_INSIDE_ATF_RUN", "internal-yes-value", 1) == -1)
+        err(EXIT_FAILURE, "Cannot set the environment");
+    nprograms = argc - first;
+    if (nprograms == 0)
+        usage_error(argv[0]);
+
+    programs = calloc(nprograms, sizeof(*programs));
+    if (programs == NULL)
+        err(EXIT_FAILURE, "Cannot allocate programs");
+    for (i = 0; i < nprograms; i++)
+        parse_program(argv[first + i], &programs[i]);
+
+    for (i = 0; i < nprograms; i++) {
+        Current = &programs[i];
+        bench_set_language(Current->language);
+        Current->list_ns = measure("list", list);
+        Current->run_ns = measure("run", run);
+        Current->body_cleanup_ns = measure("body_cleanup", body_cleanup);
+    }
+
+    for (i = 0; i < nprograms; i++) {
+        const struct program *base = NULL;
+
+        for (j = 0; j < nprograms; j++) {
+            if (strcmp(programs[j].language, programs[i].language) == 0 &&
+                (base == NULL || programs[j].count < base->count))
+                base = &programs[j];
+        }
+        if (base->count < programs[i].count)
+            derive(&programs[i], base);
+    }
+
+    for (i = 0; i < nprograms; i++) {
+        atf_fs_path_t *resfile = &programs[i].resfile;
+        atf_error_t error;
+
+        error = atf_fs_unlink(resfile);
+        if (atf_is_error(error))
+            atf_error_free(error);
+        free_program(&programs[i]);
+    }
+    free(programs);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,212 @@
+#! /bin/sh
+# Copyright (c) 2026 The NetBSD Foundation, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+# CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+# INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+# IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+# DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+# GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+# IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+# IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Generates test programs with different numbers of trivial test cases in
+# C, C++ and sh, builds them and runs the overhead driver on them.
+#
+# The toolchain is taken from the environment, as set up by `make
+# bench-overhead': COMPILE_C and COMPILE_CXX compile a source file into
+# an object, LINK_C and LINK_CXX link an object against LIBS_C and
+# LIBS_CXX respectively, ATF_SH is the interpreter of the shell programs
+# and OVERHEAD is the driver.
+
+Prog_Name=${0##*/}
+
+# Prints an error message and exits.
+err() {
+    echo "${Prog_Name}: ${*}" 1>&2
+    exit 1
+}
+
+# Prints an error message about the command line and exits.
+usage_error() {
+    echo "${Prog_Name}: ${*}" 1>&2
+    echo "Usage: ${Prog_Name} [-n counts] [-r samples] [-s sh-counts]" \
+        "[-t sample-ms] -w workdir" 1>&2
+    exit 1
+}
+
+# Generates a C test program with the given number of test cases.
+gen_c() {
+    awk -v n="${1}" 'BEGIN {
+        print "#include <atf-c.h>"
+        for (i = 1; i <= n; i++) {
+            print ""
+            printf("ATF_TC_WITH_CLEANUP(tc_%d);\n", i)
+            printf("ATF_TC_HEAD(tc_%d, tc)\n{\n", i)
+            printf("    atf_tc_set_md_var(tc, \"descr\", " \
+                   "\"Trivial test case %d\");\n}\n", i)
+            printf("ATF_TC_BODY(tc_%d, tc)\n{\n}\n", i)
+            printf("ATF_TC_CLEANUP(tc_%d, tc)\n{\n}\n", i)
+        }
+        print ""
+        print "ATF_TP_ADD_TCS(tp)\n{"
+        for (i = 1; i <= n; i++)
+            printf("    ATF_TP_ADD_TC(tp, tc_%d);\n", i)
+        print "\n    return atf_no_error();\n}"
+    }'
+}
+
+# Generates a C++ test program with the given number of test cases.
+gen_cxx() {
+    awk -v n="${1}" 'BEGIN {
+        print "#include <atf-c++.hpp>"
+        for (i = 1; i <= n; i++) {
+            print ""
+            printf("ATF_TEST_CASE_WITH_CLEANUP(tc_%d);\n", i)
+            printf("ATF_TEST_CASE_HEAD(tc_%d)\n{\n", i)
+            printf("    set_md_var(\"descr\", \"Trivial test case %d\");\n}\n",
+                   i)
+            printf("ATF_TEST_CASE_BODY(tc_%d)\n{\n}\n", i)
+            printf("ATF_TEST_CASE_CLEANUP(tc_%d)\n{\n}\n", i)
+        }
+        print ""
+        print "ATF_INIT_TEST_CASES(tcs)\n{"
+        for (i = 1; i <= n; i++)
+            printf("    ATF_ADD_TEST_CASE(tcs, tc_%d);\n", i)
+        print "}"
+    }'
+}
+
+# Generates a shell test program with the given number of test cases.
+gen_sh() {
+    awk -v n="${1}" -v atf_sh="${ATF_SH}" 'BEGIN {
+        print "#! " atf_sh
+        for (i = 1; i <= n; i++) {
+            print ""
+            printf("atf_test_case tc_%d cleanup\n", i)
+            printf("tc_%d_head() {\n", i)
+            printf("    atf_set \"descr\" \"Trivial test case %d\"\n}\n", i)
+            printf("tc_%d_body() {\n    :\n}\n", i)
+            printf("tc_%d_cleanup() {\n    :\n}\n", i)
+        }
+        print ""
+        print "atf_init_test_cases() {"
+        for (i = 1; i <= n; i++)
+            printf("    atf_add_test_case tc_%d\n", i)
+        print "}"
+    }'
+}
+
+# Writes the output of a generator into a file, leaving the file alone if
+# its contents did not change so that it is not rebuilt needlessly.
+generate() {
+    gen_"${1}" "${2}" >"${3}.tmp" || err "Failed to generate ${3}"
+    if cmp -s "${3}.tmp" "${3}"; then
+        rm -f "${3}.tmp"
+    else
+        mv "${3}.tmp" "${3}"
+    fi
+}
+
+# Builds the test program for the given language and number of test cases
+# in the work directory and prints its spec for the driver.
+build() {
+    language="${1}"; count="${2}"; workdir="${3}"
+
+    case "${language}" in
+        c)
+            base="${workdir}/c_${count}"
+            generate c "${count}" "${base}.c"
+            if [ ! -f "${base}.o" -o "${base}.c" -nt "${base}.o" ]; then
+                ${COMPILE_C} -c -o "${base}.o" "${base}.c" 1>&2 || \
+                    err "Failed to compile ${base}.c"
+            fi
+            ${LINK_C} -o "${base}" "${base}.o" ${LIBS_C} 1>&2 || \
+                err "Failed to link ${base}"
+            ;;
+        c++)
+            base="${workdir}/cxx_${count}"
+            generate cxx "${count}" "${base}.cpp"
+            if [ ! -f "${base}.o" -o "${base}.cpp" -nt "${base}.o" ]; then
+                ${COMPILE_CXX} -c -o "${base}.o" "${base}.cpp" 1>&2 || \
+                    err "Failed to compile ${base}.cpp"
+            fi
+            ${LINK_CXX} -o "${base}" "${base}.o" ${LIBS_CXX} 1>&2 || \
+                err "Failed to link ${base}"
+            ;;
+        sh)
+            base="${workdir}/sh_${count}"
+            generate sh "${count}" "${base}"
+            chmod +x "${base}"
+            ;;
+    esac
+    echo "${language}:${count}:${base}"
+}
+
+main() {
+    counts="1 10 100 1000 10000"
+    sh_counts=
+    driver_flags=
+    workdir=
+    while getopts ':n:r:s:t:w:' arg; do
+        case "${arg}" in
+            n)
+                counts="${OPTARG}"
+                ;;
+            r|t)
+                driver_flags="${driver_flags} -${arg} ${OPTARG}"
+                ;;
+            s)
+                sh_counts="${OPTARG}"
+                ;;
+            w)
+                workdir="${OPTARG}"
+                ;;
+            :)
+                usage_error "Option -${OPTARG} requires an argument"
+                ;;
+            \?)
+                usage_error "Unknown option -${OPTARG}"
+                ;;
+        esac
+    done
+    shift $((${OPTIND} - 1))
+
+    [ ${#} -eq 0 ] || usage_error "No arguments allowed"
+    [ -n "${workdir}" ] || usage_error "A work directory is required"
+    [ -n "${OVERHEAD}" ] || err "OVERHEAD is not set"
+    mkdir -p "${workdir}" || err "Cannot create ${workdir}"
+
+    specs=
+    for language in c c++ sh; do
+        language_counts="${counts}"
+        [ "${language}" = sh -a -n "${sh_counts}" ] && \
+            language_counts="${sh_counts}"
+        for count in ${language_counts}; do
+            echo "${Prog_Name}: Building ${language} program with" \
+                "${count} test cases" 1>&2
+            spec="$(build "${language}" "${count}" "${workdir}")" || exit 1
+            specs="${specs} ${spec}"
+        done
+    done
+
+    ${OVERHEAD} ${driver_flags} ${specs}
+}
+
+main "${@}"
+
+# vim: syntax=sh:expandtab:shiftwidth=4:softtabstop=4
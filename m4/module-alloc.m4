@@ -0,0 +1,46 @@
+dnl Copyright (c) 2026 The NetBSD Foundation, Inc.
+dnl All rights reserved.
+dnl
+dnl Redistribution and use in source and binary forms, with or without
+dnl modification, are permitted provided that the following conditions
+dnl are met:
+dnl 1. Redistributions of source code must retain the above copyright
+dnl    notice, this list of conditions and the following disclaimer.
+dnl 2. Redistributions in binary form must reproduce the above copyright
+dnl    notice, this list of conditions and the following disclaimer in the
+dnl    documentation and/or other materials provided with the distribution.
+dnl
+dnl THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+dnl CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+dnl INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+dnl MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+dnl IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+dnl DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+dnl DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+dnl GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+dnl INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+dnl IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+dnl OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+dnl IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+dnl Checks how to link programs against libatf-c-alloc.
+dnl
+dnl Programs do not call any function of the allocation interposer, so a
+dnl linker that drops unused libraries by default would not record the
+dnl dependency on it unless told otherwise.  Sets ATF_ALLOC_LDFLAGS to the
+dnl flags that prevent this, if the linker supports them.
+AC_DEFUN([ATF_MODULE_ALLOC], [
+    AC_CACHE_CHECK([whether the linker supports --no-as-needed],
+                   [atf_cv_ld_no_as_needed],
+                   [saved_ldflags="${LDFLAGS}"
+                    LDFLAGS="${LDFLAGS} -Wl,--no-as-needed"
+                    AC_LINK_IFELSE([AC_LANG_PROGRAM([], [])],
+                                   [atf_cv_ld_no_as_needed=yes],
+                                   [atf_cv_ld_no_as_needed=no])
+                    LDFLAGS="${saved_ldflags}"])
+    ATF_ALLOC_LDFLAGS=
+    if test "${atf_cv_ld_no_as_needed}" = yes; then
+        ATF_ALLOC_LDFLAGS=-Wl,--no-as-needed
+    fi
+    AC_SUBST([ATF_ALLOC_LDFLAGS])
+])
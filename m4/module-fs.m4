@@ -46,6 +46,9 @@ AC_DEFUN([ATF_MODULE_FS], [
                   [Define to 1 if dirname takes a constant pointer]),
         AC_MSG_RESULT(no))
 
+    AC_CHECK_FUNCS([chflagsat fchflags])
+    AC_CHECK_HEADERS([linux/fs.h])
+
     AC_CACHE_CHECK(
         [whether getcwd(NULL, 0) works],
         [kyua_cv_getcwd_works], [
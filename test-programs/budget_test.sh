@@ -0,0 +1,138 @@
+# Copyright (c) 2026 The NetBSD Foundation, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+# CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+# INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+# IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+# DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+# GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+# IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+# IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+atf_test_case met
+met_head()
+{
+    atf_set "descr" "Tests that a test case within its budgets passes"
+}
+met_body()
+{
+    srcdir="$(atf_get_srcdir)"
+    for h in $(get_helpers); do
+        atf_check -s eq:0 -o ignore -e ignore "${h}" -s "${srcdir}" \
+            -r resfile budget_met
+        atf_check -o inline:"passed\n" cat resfile
+    done
+}
+
+atf_test_case cpu
+cpu_head()
+{
+    atf_set "descr" "Tests that exceeding X-budget.cpu fails the test case"
+}
+cpu_body()
+{
+    srcdir="$(atf_get_srcdir)"
+    for h in $(get_helpers); do
+        atf_check -s eq:1 -o ignore -e ignore "${h}" -s "${srcdir}" \
+            -r resfile budget_cpu
+        atf_check -o match:"^failed: CPU time of [0-9.]+s exceeds" \
+            -o match:"the budget of 0.01s \(X-budget.cpu\)$" cat resfile
+    done
+}
+
+atf_test_case wall
+wall_head()
+{
+    atf_set "descr" "Tests that exceeding X-budget.wall fails the test case"
+}
+wall_body()
+{
+    srcdir="$(atf_get_srcdir)"
+    for h in $(get_helpers); do
+        atf_check -s eq:1 -o ignore -e ignore "${h}" -s "${srcdir}" \
+            -r resfile budget_wall
+        atf_check -o match:"^failed: Wall time of [0-9.]+s exceeds" \
+            -o match:"the budget of [0-9.]+s \(X-budget.wall\)$" cat resfile
+    done
+}
+
+atf_test_case wall_fraction
+wall_fraction_head()
+{
+    atf_set "descr" "Tests that X-budget.wall can be a fraction of a second" \
+                    "except in shell test cases, which only measure whole" \
+                    "seconds"
+}
+wall_fraction_body()
+{
+    srcdir="$(atf_get_srcdir)"
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        atf_check -s eq:0 -o ignore -e ignore "${h}" -s "${srcdir}" \
+            -r resfile budget_wall_fraction
+        atf_check -o inline:"passed\n" cat resfile
+    done
+
+    atf_check -s eq:1 -o empty -e ignore "$(get_helpers sh_helpers)" \
+        -s "${srcdir}" -r resfile budget_wall_fraction
+    atf_check -o match:"^failed: Invalid X-budget.wall: '1.5' is not a" \
+        -o match:"whole number of seconds$" cat resfile
+}
+
+atf_test_case rss
+rss_head()
+{
+    atf_set "descr" "Tests that exceeding X-budget.rss fails the test case"
+}
+rss_body()
+{
+    srcdir="$(atf_get_srcdir)"
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        atf_check -s eq:1 -o ignore -e ignore "${h}" -s "${srcdir}" \
+            -r resfile budget_rss
+        atf_check -o match:"^failed: Peak RSS of [0-9]+ bytes exceeds" \
+            -o match:"the budget of 1024 bytes \(X-budget.rss\)$" cat resfile
+    done
+}
+
+atf_test_case invalid
+invalid_head()
+{
+    atf_set "descr" "Tests that an invalid budget fails the test case" \
+                    "before running its body"
+}
+invalid_body()
+{
+    srcdir="$(atf_get_srcdir)"
+    for h in $(get_helpers); do
+        atf_check -s eq:1 -o empty -e ignore "${h}" -s "${srcdir}" \
+            -r resfile budget_invalid
+        atf_check -o match:"^failed: Invalid X-budget.cpu: 'abc' is not a" \
+            -o match:"valid number of seconds$" cat resfile
+    done
+}
+
+atf_init_test_cases()
+{
+    atf_add_test_case met
+    atf_add_test_case cpu
+    atf_add_test_case wall
+    atf_add_test_case wall_fraction
+    atf_add_test_case rss
+    atf_add_test_case invalid
+}
+
+# vim: syntax=sh:expandtab:shiftwidth=4:softtabstop=4
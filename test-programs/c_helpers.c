@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <atf-c.h>
 
@@ -447,6 +448,75 @@ ATF_TC_BODY(result_newlines_skip, tc)
     atf_tc_skip("First line\nSecond line");
 }
 
+/* ---------------------------------------------------------------------
+ * Helper tests for "t_budget".
+ * --------------------------------------------------------------------- */
+
+ATF_TC(budget_met);
+ATF_TC_HEAD(budget_met, tc)
+{
+    atf_tc_set_md_var(tc, "X-budget.cpu", "100");
+    atf_tc_set_md_var(tc, "X-budget.wall", "100");
+    atf_tc_set_md_var(tc, "X-budget.rss", "1T");
+    atf_tc_set_md_var(tc, "X-budget.allocs", "1G");
+}
+ATF_TC_BODY(budget_met, tc)
+{
+}
+
+ATF_TC(budget_cpu);
+ATF_TC_HEAD(budget_cpu, tc)
+{
+    atf_tc_set_md_var(tc, "X-budget.cpu", "0.01");
+}
+ATF_TC_BODY(budget_cpu, tc)
+{
+    const clock_t start = clock();
+    volatile unsigned long count = 0;
+
+    while (clock() - start < CLOCKS_PER_SEC / 5)
+        count++;
+}
+
+ATF_TC(budget_wall);
+ATF_TC_HEAD(budget_wall, tc)
+{
+    atf_tc_set_md_var(tc, "X-budget.wall", "0.5");
+}
+ATF_TC_BODY(budget_wall, tc)
+{
+    sleep(1);
+}
+
+ATF_TC(budget_wall_fraction);
+ATF_TC_HEAD(budget_wall_fraction, tc)
+{
+    atf_tc_set_md_var(tc, "X-budget.wall", "1.5");
+}
+ATF_TC_BODY(budget_wall_fraction, tc)
+{
+    usleep(300000);
+}
+
+ATF_TC(budget_rss);
+ATF_TC_HEAD(budget_rss, tc)
+{
+    atf_tc_set_md_var(tc, "X-budget.rss", "1K");
+}
+ATF_TC_BODY(budget_rss, tc)
+{
+}
+
+ATF_TC(budget_invalid);
+ATF_TC_HEAD(budget_invalid, tc)
+{
+    atf_tc_set_md_var(tc, "X-budget.cpu", "abc");
+}
+ATF_TC_BODY(budget_invalid, tc)
+{
+    printf("msg\n");
+}
+
 /* ---------------------------------------------------------------------
  * Main.
  * --------------------------------------------------------------------- */
@@ -499,5 +569,13 @@ ATF_TP_ADD_TCS(tp)
     ATF_TP_ADD_TC(tp, result_newlines_fail);
     ATF_TP_ADD_TC(tp, result_newlines_skip);
 
+    /* Add helper tests for t_budget. */
+    ATF_TP_ADD_TC(tp, budget_met);
+    ATF_TP_ADD_TC(tp, budget_cpu);
+    ATF_TP_ADD_TC(tp, budget_wall);
+    ATF_TP_ADD_TC(tp, budget_wall_fraction);
+    ATF_TP_ADD_TC(tp, budget_rss);
+    ATF_TP_ADD_TC(tp, budget_invalid);
+
     return atf_no_error();
 }
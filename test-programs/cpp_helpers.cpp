@@ -29,6 +29,7 @@ extern "C" {
 }
 
 #include <cstdlib>
+#include <ctime>
 #include <fstream>
 #include <iostream>
 
@@ -307,6 +308,75 @@ ATF_TEST_CASE_BODY(result_exception)
     throw std::runtime_error("This is unhandled");
 }
 
+// ------------------------------------------------------------------------
+// Helper tests for "t_budget".
+// ------------------------------------------------------------------------
+
+ATF_TEST_CASE(budget_met);
+ATF_TEST_CASE_HEAD(budget_met)
+{
+    set_md_var("X-budget.cpu", "100");
+    set_md_var("X-budget.wall", "100");
+    set_md_var("X-budget.rss", "1T");
+    set_md_var("X-budget.allocs", "1G");
+}
+ATF_TEST_CASE_BODY(budget_met)
+{
+}
+
+ATF_TEST_CASE(budget_cpu);
+ATF_TEST_CASE_HEAD(budget_cpu)
+{
+    set_md_var("X-budget.cpu", "0.01");
+}
+ATF_TEST_CASE_BODY(budget_cpu)
+{
+    const std::clock_t start = std::clock();
+    volatile unsigned long count = 0;
+
+    while (std::clock() - start < CLOCKS_PER_SEC / 5)
+        count++;
+}
+
+ATF_TEST_CASE(budget_wall);
+ATF_TEST_CASE_HEAD(budget_wall)
+{
+    set_md_var("X-budget.wall", "0.5");
+}
+ATF_TEST_CASE_BODY(budget_wall)
+{
+    ::sleep(1);
+}
+
+ATF_TEST_CASE(budget_wall_fraction);
+ATF_TEST_CASE_HEAD(budget_wall_fraction)
+{
+    set_md_var("X-budget.wall", "1.5");
+}
+ATF_TEST_CASE_BODY(budget_wall_fraction)
+{
+    ::usleep(300000);
+}
+
+ATF_TEST_CASE(budget_rss);
+ATF_TEST_CASE_HEAD(budget_rss)
+{
+    set_md_var("X-budget.rss", "1K");
+}
+ATF_TEST_CASE_BODY(budget_rss)
+{
+}
+
+ATF_TEST_CASE(budget_invalid);
+ATF_TEST_CASE_HEAD(budget_invalid)
+{
+    set_md_var("X-budget.cpu", "abc");
+}
+ATF_TEST_CASE_BODY(budget_invalid)
+{
+    std::cout << "msg\n";
+}
+
 // ------------------------------------------------------------------------
 // Main.
 // ------------------------------------------------------------------------
@@ -352,4 +422,12 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, result_newlines_fail);
     ATF_ADD_TEST_CASE(tcs, result_newlines_skip);
     ATF_ADD_TEST_CASE(tcs, result_exception);
+
+    // Add helper tests for t_budget.
+    ATF_ADD_TEST_CASE(tcs, budget_met);
+    ATF_ADD_TEST_CASE(tcs, budget_cpu);
+    ATF_ADD_TEST_CASE(tcs, budget_wall);
+    ATF_ADD_TEST_CASE(tcs, budget_wall_fraction);
+    ATF_ADD_TEST_CASE(tcs, budget_rss);
+    ATF_ADD_TEST_CASE(tcs, budget_invalid);
 }
@@ -336,6 +336,64 @@ result_skip_body()
     atf_skip "Skipped reason"
 }
 
+# -------------------------------------------------------------------------
+# Helper tests for "t_budget".
+# -------------------------------------------------------------------------
+
+atf_test_case budget_met
+budget_met_head()
+{
+    atf_set "X-budget.cpu" "100"
+    atf_set "X-budget.wall" "100"
+}
+budget_met_body()
+{
+    :
+}
+
+atf_test_case budget_cpu
+budget_cpu_head()
+{
+    atf_set "X-budget.cpu" "0.01"
+}
+budget_cpu_body()
+{
+    i=0
+    while [ ${i} -lt 100000 ]; do
+        i=$((${i} + 1))
+    done
+}
+
+atf_test_case budget_wall
+budget_wall_head()
+{
+    atf_set "X-budget.wall" "1"
+}
+budget_wall_body()
+{
+    sleep 2
+}
+
+atf_test_case budget_wall_fraction
+budget_wall_fraction_head()
+{
+    atf_set "X-budget.wall" "1.5"
+}
+budget_wall_fraction_body()
+{
+    echo "msg"
+}
+
+atf_test_case budget_invalid
+budget_invalid_head()
+{
+    atf_set "X-budget.cpu" "abc"
+}
+budget_invalid_body()
+{
+    echo "msg"
+}
+
 # -------------------------------------------------------------------------
 # Main.
 # -------------------------------------------------------------------------
@@ -385,6 +443,13 @@ atf_init_test_cases()
     atf_add_test_case result_pass
     atf_add_test_case result_fail
     atf_add_test_case result_skip
+
+    # Add helper tests for t_budget.
+    atf_add_test_case budget_met
+    atf_add_test_case budget_cpu
+    atf_add_test_case budget_wall
+    atf_add_test_case budget_wall_fraction
+    atf_add_test_case budget_invalid
 }
 
 # vim: syntax=sh:expandtab:shiftwidth=4:softtabstop=4
@@ -0,0 +1,146 @@
+# Copyright (c) 2007 The NetBSD Foundation, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+# CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+# INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+# IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+# DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+# GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+# IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+# IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Prints the "ident shard" pairs of the listing of a test program.
+list_shards()
+{
+    "${@}" | awk '/^ident: / { ident = $2 }
+                  /^X-shard: / { split($2, s, "/"); print ident, s[1] }' \
+        | sort
+}
+
+atf_test_case partition
+partition_head()
+{
+    atf_set "descr" "Checks that the shards of a test program hold every" \
+                    "test case exactly once and agree with the annotated" \
+                    "listing"
+}
+partition_body()
+{
+    for hp in $(get_helpers); do
+        "${hp}" -l | sed -n 's,^ident: ,,p' | sort >all
+        list_shards "${hp}" -l -S 4 >annotated
+        atf_check -s eq:0 -o file:all -e empty awk '{ print $1 }' annotated
+
+        rm -f union
+        for i in 1 2 3 4; do
+            "${hp}" -l -S ${i}/4 | sed -n 's,^ident: ,,p' >shard
+            awk "\$2 == ${i} { print \$1 }" annotated >expout
+            atf_check -s eq:0 -o file:expout -e empty sort shard
+            cat shard >>union
+        done
+        atf_check -s eq:0 -o file:all -e empty sort union
+    done
+}
+
+atf_test_case languages
+languages_head()
+{
+    atf_set "descr" "Checks that test programs written in any language" \
+                    "assign the same test cases to the same shards"
+}
+languages_body()
+{
+    # All programs must read the same durations file, which covers the
+    # test cases of all of them, to compute the same assignment.
+    for hp in $(get_helpers); do
+        "${hp}" -l | sed -n 's,^ident: \(.*\),helpers:\1 1.5,p'
+    done | sort -u >durations
+
+    mkdir tmp
+    for hp in $(get_helpers); do
+        h=${hp##*/}
+        cp "${hp}" tmp/helpers
+        list_shards tmp/helpers -l -S 7 >${h}.hash
+        list_shards tmp/helpers -l -S 7 -D durations >${h}.durations
+    done
+
+    for kind in hash durations; do
+        join c_helpers.${kind} sh_helpers.${kind} >c_sh
+        join c_helpers.${kind} cpp_helpers.${kind} >c_cpp
+        atf_check -s eq:0 -o ignore -e empty grep result_pass c_sh
+        atf_check -s eq:0 -o ignore -e empty grep result_pass c_cpp
+        atf_check -s eq:0 -o empty -e empty awk '$2 != $3' c_sh c_cpp
+    done
+}
+
+atf_test_case durations
+durations_head()
+{
+    atf_set "descr" "Checks that the durations file balances the" \
+                    "expected run time of the shards"
+}
+durations_body()
+{
+    for hp in $(get_helpers); do
+        # The greedy assignment puts the longest test case alone in the
+        # first shard and the other two together in the second one.
+        echo "# Longest first." >durations
+        echo "${hp}:result_pass 10" >>durations
+        echo "${hp}:result_fail 6.5s" >>durations
+        echo "${hp}:result_skip 3" >>durations
+        "${hp}" -l -S 1/2 -D durations | sed -n 's,^ident: ,,p' >shard
+        atf_check -s eq:0 -o ignore -e empty grep '^result_pass$' shard
+        atf_check -s eq:1 -o empty -e empty grep '^result_fail$' shard
+        atf_check -s eq:1 -o empty -e empty grep '^result_skip$' shard
+    done
+}
+
+atf_test_case errors
+errors_head()
+{
+    atf_set "descr" "Checks that invalid shard specifications and" \
+                    "durations files are reported"
+}
+errors_body()
+{
+    for hp in $(get_helpers); do
+        for spec in 0 0/4 5/4 1/0 a /4; do
+            atf_check -s eq:1 -o empty -e match:"Invalid shard specification" \
+                "${hp}" -l -S ${spec}
+        done
+        atf_check -s eq:1 -o empty -e match:"-D requires -S" \
+            "${hp}" -l -D durations
+        atf_check -s eq:1 -o empty -e match:"-S can only be used with -l" \
+            "${hp}" -S 1/2 result_pass
+        atf_check -s eq:1 -o empty -e match:"Cannot open durations file" \
+            "${hp}" -l -S 1/2 -D missing
+        echo "helpers:result_pass soon" >durations
+        atf_check -s eq:1 -o empty \
+            -e match:"Invalid line 1 in durations file durations" \
+            "${hp}" -l -S 1/2 -D durations
+    done
+}
+
+atf_init_test_cases()
+{
+    atf_add_test_case partition
+    atf_add_test_case languages
+    atf_add_test_case durations
+    atf_add_test_case errors
+}
+
+# vim: syntax=sh:expandtab:shiftwidth=4:softtabstop=4